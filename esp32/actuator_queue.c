@@ -0,0 +1,130 @@
+#include <string.h>
+
+#include "actuator_queue.h"
+
+void actq_init(actq_t *q)
+{
+    memset(q, 0, sizeof(*q));
+}
+
+void actq_set_state(actq_t *q, act_id_t actuator, int target, int32_t value)
+{
+    q->state[actuator] = (int8_t)target;
+    q->state_value[actuator] = target ? value : 0;
+}
+
+static bool is_state(const actq_t *q, act_id_t actuator, int target, int32_t value)
+{
+    return target == q->state[actuator] && value == q->state_value[actuator];
+}
+
+static void drop_pending(actq_t *q, act_id_t actuator)
+{
+    q->has_pending[actuator] = false;
+    q->depth--;
+}
+
+act_push_result_t actq_push(actq_t *q, act_id_t actuator, int target, int32_t value, act_prio_t priority,
+                            uint8_t source)
+{
+    q->pushed++;
+
+    if (priority < q->hold[actuator] ||
+        (q->has_pending[actuator] && priority < q->pending[actuator].priority)) {
+        q->preempted++;
+        return ACT_PUSH_PREEMPTED;
+    }
+
+    if (target == ACT_TOGGLE) {
+        target = actq_effective(q, actuator) ? 0 : 1;
+    }
+    if (!target) {
+        value = 0;
+    }
+
+    if (q->has_pending[actuator]) {
+        // 대기 명령을 대체. 현재 상태로 되돌리는 명령이면 둘 다 없던 일로 한다.
+        q->coalesced++;
+        if (is_state(q, actuator, target, value)) {
+            drop_pending(q, actuator);
+        } else {
+            act_cmd_t *c = &q->pending[actuator];
+            c->target = (int8_t)target;
+            c->value = value;
+            c->priority = (uint8_t)priority;
+            c->source = source;
+            c->seq = q->next_seq++;
+        }
+        return ACT_PUSH_COALESCED;
+    }
+
+    if (is_state(q, actuator, target, value)) {
+        q->noops++;
+        return ACT_PUSH_NOOP;
+    }
+
+    act_cmd_t *c = &q->pending[actuator];
+    c->actuator = (uint8_t)actuator;
+    c->target = (int8_t)target;
+    c->value = value;
+    c->priority = (uint8_t)priority;
+    c->source = source;
+    c->seq = q->next_seq++;
+    q->has_pending[actuator] = true;
+    q->depth++;
+    if (q->depth > q->max_depth) {
+        q->max_depth = q->depth;
+    }
+    return ACT_PUSH_QUEUED;
+}
+
+bool actq_pop(actq_t *q, act_cmd_t *out)
+{
+    int best = -1;
+    for (int i = 0; i < ACT_COUNT; i++) {
+        if (!q->has_pending[i]) {
+            continue;
+        }
+        if (best < 0 ||
+            q->pending[i].priority > q->pending[best].priority ||
+            (q->pending[i].priority == q->pending[best].priority &&
+             (int32_t)(q->pending[i].seq - q->pending[best].seq) < 0)) {
+            best = i;
+        }
+    }
+    if (best < 0) {
+        return false;
+    }
+
+    *out = q->pending[best];
+    drop_pending(q, (act_id_t)best);
+    q->state[best] = out->target;
+    q->state_value[best] = out->value;
+    q->applied++;
+    return true;
+}
+
+void actq_hold(actq_t *q, act_id_t actuator, act_prio_t priority)
+{
+    q->hold[actuator] = (uint8_t)priority;
+    if (q->has_pending[actuator] && q->pending[actuator].priority < priority) {
+        drop_pending(q, actuator);
+        q->preempted++;
+    }
+}
+
+void actq_release(actq_t *q, act_id_t actuator)
+{
+    q->hold[actuator] = 0;
+}
+
+const char *actq_push_result_name(act_push_result_t r)
+{
+    switch (r) {
+    case ACT_PUSH_QUEUED:    return "queued";
+    case ACT_PUSH_COALESCED: return "coalesced";
+    case ACT_PUSH_NOOP:      return "noop";
+    case ACT_PUSH_PREEMPTED: return "preempted";
+    }
+    return "?";
+}
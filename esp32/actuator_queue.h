@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 액추에이터 명령 큐 (창문, 펌프)
+// MQTT/HTTP/폴링/결정 엔진이 모두 actq_push()로 명령을 넣고, loop()가 actq_pop()으로 꺼내 실행한다.
+//   - 액추에이터마다 대기 슬롯이 하나뿐이라 큐 길이는 ACT_COUNT로 제한된다.
+//   - 같은 액추에이터에 대한 새 명령은 대기 중인 명령을 대체한다 (last-writer-wins).
+//     단, 대기 중인 명령이나 보류(hold) 우선순위보다 낮은 명령은 버린다.
+//   - 이미 그 상태이고 대기 명령이 없으면 실행하지 않는다 (토글 연타, 반복 ON 등).
+//     켜짐(1) 명령은 value(창문 열림 각도, 펌프 분사 시간)까지 같아야 같은 상태다.
+//   - 꺼낼 때는 우선순위가 높은 것부터, 같으면 먼저 들어온 것부터.
+// 시간/하드웨어에 의존하지 않으며 loop() 컨텍스트(단일 태스크)에서만 호출한다.
+
+typedef enum {
+    ACT_WINDOW = 0,     // 1=열림, 0=닫힘
+    ACT_PUMP,           // 1=분사, 0=정지
+    ACT_COUNT,
+} act_id_t;
+
+typedef enum {
+    ACT_PRIO_AUTO = 0,  // 결정 엔진 (환기)
+    ACT_PRIO_USER,      // 앱/서버 명령
+    ACT_PRIO_SAFETY,    // 벌레 감지
+} act_prio_t;
+
+#define ACT_TOGGLE (-1) // 대기 중인 목표(없으면 현재 상태)의 반대로 해석
+
+typedef enum {
+    ACT_PUSH_QUEUED = 0,    // 새로 대기
+    ACT_PUSH_COALESCED,     // 대기 중이던 명령을 대체하거나 취소
+    ACT_PUSH_NOOP,          // 이미 그 상태라 할 일 없음
+    ACT_PUSH_PREEMPTED,     // 더 높은 우선순위가 대기/보류 중이라 버림
+} act_push_result_t;
+
+typedef struct {
+    uint8_t actuator;   // act_id_t
+    int8_t target;
+    uint8_t priority;   // act_prio_t
+    uint8_t source;     // 호출자 정의 (로그용)
+    int32_t value;      // target이 1일 때의 인자 (호출자 정의), 0이면 항상 0
+    uint32_t seq;
+} act_cmd_t;
+
+typedef struct {
+    act_cmd_t pending[ACT_COUNT];
+    bool has_pending[ACT_COUNT];
+    int8_t state[ACT_COUNT];        // 마지막으로 실행한 목표
+    int32_t state_value[ACT_COUNT]; // 그때의 value
+    uint8_t hold[ACT_COUNT];        // 이 우선순위 미만 명령 거부 (0이면 보류 없음)
+    uint32_t next_seq;
+
+    // 통계
+    uint32_t pushed;
+    uint32_t applied;
+    uint32_t coalesced;
+    uint32_t noops;
+    uint32_t preempted;
+    uint8_t depth;
+    uint8_t max_depth;
+} actq_t;
+
+void actq_init(actq_t *q);
+
+// 실제 상태를 큐에 알림 (초기 상태, 펌프 타이머 만료 등 큐 밖에서 바뀐 경우)
+void actq_set_state(actq_t *q, act_id_t actuator, int target, int32_t value);
+
+// value는 target이 1(토글이면 1로 해석된 경우)일 때만 쓰인다
+act_push_result_t actq_push(actq_t *q, act_id_t actuator, int target, int32_t value, act_prio_t priority,
+                            uint8_t source);
+
+// 실행할 명령을 꺼내고 그 목표를 현재 상태로 기록. 대기 명령이 없으면 false.
+bool actq_pop(actq_t *q, act_cmd_t *out);
+
+// priority 미만의 명령을 actq_release() 전까지 거부하고, 대기 중인 그런 명령은 버린다
+void actq_hold(actq_t *q, act_id_t actuator, act_prio_t priority);
+void actq_release(actq_t *q, act_id_t actuator);
+
+// 대기 중이면 그 목표, 아니면 현재 상태
+static inline int actq_effective(const actq_t *q, act_id_t actuator)
+{
+    return q->has_pending[actuator] ? q->pending[actuator].target : q->state[actuator];
+}
+
+const char *actq_push_result_name(act_push_result_t r);
+
+#ifdef __cplusplus
+}
+#endif
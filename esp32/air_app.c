@@ -0,0 +1,1358 @@
+// Firmware body: everything in setup()/loop() that runs on the HAL (see air_app.h).
+// main.c adds the esp_http_server routes and the benchmarks on the ESP32;
+// tools/app_smoke_test.c runs the same code on hal_posix.c.
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "air_app.h"
+#include "hal.h"            // clock, GPIO/servo, SHT31, UART, Wi-Fi, HTTP, MQTT
+#include "servo_motion.h"   // non-blocking servo motion
+#include "esp_command_handler.h" // command registry + actuator hooks
+#include "control_handoff.h" // /control httpd -> loop() handoff
+#include "cmd_latency.h"    // push command latency
+#include "cmd_stream.h"     // push command JSON
+#include "mqtt_ingress.h"   // zero-allocation MQTT parsing
+#include "task_scheduler.h" // cooperative loop() scheduler
+#include "sensor_sampler.h" // background SHT31 sampling
+#include "pms5003.h"        // local PM sensor (UART)
+#include "decision_engine.h" // window rule table
+#include "metrics.h"        // /metrics (Prometheus text)
+#include "dlog.h"           // deferred levelled logging
+#include "conn_manager.h"   // Wi-Fi/MQTT reconnect state machine
+#include "actuator_queue.h" // coalescing window/pump command queue
+#include "state_feed.h"     // versioned /data state + binary deltas
+#include "power_manager.h"  // duty-cycled low-power mode
+#include "durable_state.h"  // NVS state for warm restarts
+#include "device_config.h"  // runtime-reconfigurable settings (NVS)
+#include "esp_http_pull.h"  // POST/pull URL defaults and air_http_set_urls
+#include "hmac_sha256.h"    // signed MQTT config updates
+
+// ---------- Pins / Hardware ----------
+#define SHT31_SDA_PIN  21   // ESP32 default SDA
+#define SHT31_SCL_PIN  22   // ESP32 default SCL
+#define SERVO_PIN      25
+#define WATER_PUMP_PIN 33   // water pump
+#define PMS_RX_PIN     16   // PMS5003 TX -> ESP32 RX2
+#define PMS_TX_PIN     17   // PMS5003 RX <- ESP32 TX2
+
+// ---------- Servo motion ----------
+#define SERVO_OPEN_DEG   0
+#define SERVO_CLOSED_DEG 90
+#define SERVO_VELOCITY_DPS 30.0f   // max velocity, old loop was 1 deg / 40 ms = 25 deg/s
+#define SERVO_ACCEL_DPS2   60.0f
+
+// ---------- Globals ----------
+static float pm25 = 0.0f;     // outdoor reference from MQTT (Pi / OpenWeatherMap)
+static float pm10 = 0.0f;
+static int   aqi  = 0;
+static int   is_window = 0;   // 0=closed, 1=open
+static bool  bug = false;
+static bool  hasSHT31 = false;
+
+// ---------- Wi-Fi ----------
+// Build-time defaults only: the values in use come from the config store
+// (see Configuration below) and can be changed without reflashing.
+#ifndef AIR_WIFI_SSID
+#define AIR_WIFI_SSID     "Hahhhh"
+#endif
+#ifndef AIR_WIFI_PASSWORD
+#define AIR_WIFI_PASSWORD "12051205"
+#endif
+
+// ---------- MQTT ----------
+#ifndef AIR_MQTT_HOST
+#define AIR_MQTT_HOST     "broker.hivemq.com"
+#endif
+#ifndef AIR_MQTT_PORT
+#define AIR_MQTT_PORT     1883
+#endif
+#ifndef AIR_MQTT_USER
+#define AIR_MQTT_USER     ""
+#endif
+#ifndef AIR_MQTT_PASSWORD
+#define AIR_MQTT_PASSWORD ""
+#endif
+#ifndef AIR_TOPIC_ROOT
+#define AIR_TOPIC_ROOT    "s_window"
+#endif
+
+// Topics are namespaced by device ID (hal_device_id(), also the MQTT client ID):
+//   s_window/<id>/pump      Pi bug detector for this window: "ON"/"OFF"
+//   s_window/<id>/command   push commands: "WINDOW_OPEN" or {"command":"WINDOW_OPEN","ts":<epoch ms>}
+//   s_window/<id>/config    signed config updates: {"config":{"pump_ms":2000},"rev":4,"sig":"<hex>"}
+//   s_window/<id>/config/result  outcome of the last config update
+//   s_window/<id>/status    retained "online"/"offline" (last will), read by the gateway
+//   s_window/all/{aqi,pm25,pm10}  outdoor readings fanned out to every node by the gateway
+// Messages are classified by the last path element, so one wildcard per scope covers them;
+// config is taken only from this device's own topic.
+// The mqtt_legacy config field (default AIR_MQTT_LEGACY_TOPICS) also accepts the old shared
+// s_window/<leaf> topics. Every node on the broker gets those, so enable it on one node only
+// (the one the old app and detector drive); the others drop anything published there.
+// The root ("s_window") is the topic_root config field.
+#ifndef AIR_MQTT_LEGACY_TOPICS
+#define AIR_MQTT_LEGACY_TOPICS 0
+#endif
+static const char* TOPIC_BROADCAST = "all";
+
+static const char* clientID;
+static char topicDevice[64];     // <root>/<id>/+
+static char topicBroadcast[48];  // <root>/all/+
+static char topicLegacy[40];     // <root>/+
+static char topicStatus[64];     // <root>/<id>/status
+static char topicConfigResult[72]; // <root>/<id>/config/result
+
+static const char* ntpServer = "pool.ntp.org";
+
+// ---------- PumpInfo ------------
+#define PUMP_RUN_MS 3000   // default for the pump_ms config field
+static unsigned long pumpStart = 0;
+static uint32_t pumpRunMs = 0;     // this run: PUMP_ON value, else pump_ms
+static bool pumpActive = false;
+
+// ---------- Window motion ----------
+static servo_motion_t windowMotion;
+
+// ---------- Actuator commands ----------
+// Every transport and the decider enqueue through actuator_request();
+// task_actuate applies what is left after coalescing, highest priority first.
+static actq_t actuators;
+static int servoAngle = -1;   // last angle written to the servo
+
+// ---------- Sensor sampling ----------
+#define SENSOR_PERIOD_MS    2000   // one combined SHT31 measurement per period
+#define SENSOR_EMA_ALPHA    0.3f
+#define SENSOR_MAX_FAILURES 3      // consecutive failures before the reading is invalid
+static sensor_sampler_t sht31Sampler;
+
+// ---------- PMS5003 ----------
+// The UART driver's ISR fills the RX ring buffer; task_pms drains it into the
+// streaming parser. Local readings win over the MQTT outdoor values while fresh.
+#define PMS_STALE_MS 10000
+static pms5003_parser_t pmsParser;
+
+// ---------- Decision engine ----------
+// task_decide re-evaluates the rule table whenever an input changed
+// (inputsVersion). Only a change of the engine output moves the window, so a
+// manual command holds until the conditions actually flip; the hysteresis bands
+// and the minimum dwell time keep the window from flapping around a threshold.
+#define DECISION_PERIOD_MS    200
+#define DECISION_MIN_DWELL_MS 120000
+// The thresholds here are the defaults; the live ones come from the config
+// store (pm25_close, pm10_close, di_comfort) and are copied into decisionRules.
+#define DECISION_PM25_CLOSE 35.0f
+#define DECISION_PM10_CLOSE 80.0f
+#define DECISION_DI_COMFORT 76.0f
+static const de_rule_t DECISION_RULES[] = {
+  // name              input          compare   threshold            band   action           missing
+  { "pm25 bad",        DE_INPUT_PM25, DE_ABOVE, DECISION_PM25_CLOSE, 5.0f,  DE_WINDOW_CLOSE, false },
+  { "pm10 bad",        DE_INPUT_PM10, DE_ABOVE, DECISION_PM10_CLOSE, 10.0f, DE_WINDOW_CLOSE, false },
+  { "di comfortable",  DE_INPUT_DI,   DE_BELOW, DECISION_DI_COMFORT, 1.0f,  DE_WINDOW_CLOSE, true  },
+};
+#define DECISION_RULE_COUNT (sizeof(DECISION_RULES) / sizeof(DECISION_RULES[0]))
+static de_rule_t decisionRules[DECISION_RULE_COUNT];
+static decision_engine_t decisionEngine;
+static uint32_t inputsVersion = 1;        // bumped on every new reading; starts ahead so boot evaluates once
+static bool     settlePending = false;    // bug_cleared() settle timer
+static uint32_t settleUntil   = 0;
+
+// ---------- Command latency ----------
+// A push command's server timestamp travels with it through the actuator
+// queue; the latency is recorded when task_actuate applies it (pump switched,
+// window move started). 0 = not stamped.
+static cmd_latency_t cmdLatency;
+static uint64_t pushSentMs = 0;              // command being dispatched
+static uint64_t queuedSentMs[ACT_COUNT];     // command waiting in the actuator queue
+
+// ---------- Logging ----------
+// DLOG_* calls only queue a record; task_log formats and writes them to the
+// log UART while its TX buffer has room, so no path blocks on the 115200 baud UART.
+// Build with -DAIR_LOG_BINARY=1 to emit compact frames for tools/dlog_decode.py.
+#ifndef AIR_LOG_BINARY
+#define AIR_LOG_BINARY 0
+#endif
+#define LOG_TX_BUFFER 1024
+#define LOG_LINE_MAX  128
+#define LOG_DRAIN_MAX 8    // records per scheduler pass
+
+// ---------- Power ----------
+// AIR_LOW_POWER=1 boots duty-cycled: the CPU runs at 80 MHz, Wi-Fi stays
+// associated in modem-sleep, the sampling/telemetry tasks run on the slower
+// periods of POWER_PROFILE, and loop() sleeps until the next release instead
+// of spinning. Window moves and pump runs hold a wake lock. While Wi-Fi is
+// down between retries the CPU light-sleeps, woken by the retry timer or a
+// LOW level on AIR_WAKE_GPIO. The currents are datasheet-level estimates for
+// air_power_avg_current_ua, not measurements.
+#ifndef AIR_LOW_POWER
+#define AIR_LOW_POWER 0
+#endif
+#ifndef AIR_WAKE_GPIO
+#define AIR_WAKE_GPIO -1
+#endif
+static const uint32_t CPU_MHZ[PM_MODE_COUNT]          = { 240, 80 };
+static const uint16_t MQTT_KEEPALIVE_S[PM_MODE_COUNT] = { 15, 120 };
+static const pm_config_t POWER_CONFIG = {
+  2,        // busy_wait_ms: same 2 ms yield as before
+  250,      // max_wait_ms: MQTT receive poll while associated
+  100,      // light_min_ms: entry/exit costs about a millisecond
+  60000,    // light_max_ms
+  {
+    //  active   wait    light (uA)
+    { 110000, 95000, 800 },   // PERFORMANCE: radio always listening
+    {  45000, 20000, 800 },   // LOW_POWER: 80 MHz, modem-sleep
+  },
+};
+static power_manager_t power;
+
+// ---------- Durable state ----------
+// The commanded window state, the servo angle, the MQTT decision inputs, the
+// decider output and the power mode survive a reset (durable_state, in NVS).
+// Writes are coalesced to spare the flash: a window command is written at
+// once, angle checkpoints during a move at most every STORE_CHECKPOINT_MS and
+// decision inputs after STORE_INPUTS_MS; a record equal to the last one
+// written is not written again. After a reset the servo is attached on the
+// saved angle and an interrupted move carries on from the last checkpoint.
+// The pump always boots off, and the bug flag is not restored: a BUG_OFF
+// missed while down would otherwise hold the window shut.
+// Local control runs one scheduler pass before the radio and the HTTP server
+// are started; air_boot_control_ready_ms is the time from reset (esp_timer
+// start, after the bootloader) until that pass applied actuator commands.
+#define STORE_CHECKPOINT_MS    500
+#define STORE_INPUTS_MS        60000
+#define BOOT_CONTROL_TARGET_MS 500
+#define BOOT_POWER_MODE (AIR_LOW_POWER ? PM_MODE_LOW_POWER : PM_MODE_PERFORMANCE)
+static durable_state_t store;
+static uint32_t controlReadyMs = 0;
+static bool netStarted = false;
+
+// ---------- Configuration ----------
+// Site settings live in a typed, versioned record in NVS (device_config) and
+// are changed without reflashing through POST /control
+// {"command":"CONFIG","config":{...},"rev":N} or the <root>/<id>/config MQTT
+// topic (see Remote config below). An update is all or nothing: every field is
+// range-checked, the record is written, and only then is the live copy
+// replaced; "rev" (optional) must match the current revision. Hot paths read
+// the fields of `config` directly, so there is no lookup per access.
+// Thresholds, dwell, pump time, servo speed and URLs apply at once; Wi-Fi and
+// MQTT changes reconnect from the net task. If the new network settings do
+// not get MQTT up within CONFIG_NET_PROBATION_MS, the previous settings are
+// restored (not across a reboot: a reset during probation keeps the new ones).
+static const air_config_t CONFIG_DEFAULTS = {
+  DECISION_PM25_CLOSE,
+  DECISION_PM10_CLOSE,
+  DECISION_DI_COMFORT,
+  DECISION_MIN_DWELL_MS,
+  PUMP_RUN_MS,
+  SERVO_VELOCITY_DPS,
+  SERVO_ACCEL_DPS2,
+  AIR_WIFI_SSID,
+  AIR_WIFI_PASSWORD,
+  AIR_MQTT_HOST,
+  AIR_MQTT_PORT,
+  AIR_MQTT_USER,
+  AIR_MQTT_PASSWORD,
+  AIR_TOPIC_ROOT,
+  AIR_QUALITY_POST_URL,
+  AIR_COMMAND_PULL_URL,
+  AIR_MQTT_LEGACY_TOPICS,
+};
+#define CONFIG_NET_PROBATION_MS 300000
+static config_store_t configStore;
+static const air_config_t* const config = &configStore.live;
+static air_config_t configPrevious;        // last config with MQTT up, restored if probation runs out
+static uint32_t configNetPending = 0;      // CFG_APPLY_WIFI/MQTT bits for task_net to apply
+static bool     configProbation  = false;
+static uint32_t configProbationUntil = 0;
+
+// Four log arguments: keep the rest of the record within DLOG_MAX_ARGS
+#define IP4(ip) (unsigned)((ip) & 0xff), (unsigned)((ip) >> 8 & 0xff), (unsigned)((ip) >> 16 & 0xff), (unsigned)((ip) >> 24)
+
+// ---------- Metrics ----------
+// Each metric has a single writer: everything here is written from loop();
+// the HTTP server registers and writes its own latency histograms. /metrics
+// renders them on demand.
+static const uint32_t LOOP_PERIOD_BOUNDS_US[]   = { 1000, 2000, 3000, 5000, 10000, 20000, 50000, 100000, 250000, 1000000 };
+static const uint32_t MQTT_CONNECT_BOUNDS_MS[]  = { 10, 50, 100, 250, 500, 1000, 2000, 5000 };
+static const uint32_t OUTAGE_BOUNDS_MS[]        = { 1000, 2000, 5000, 10000, 30000, 60000, 120000, 300000, 600000 };
+static const uint32_t WAKE_LATENCY_BOUNDS_US[]  = { 50, 100, 250, 500, 1000, 2000, 5000, 10000, 50000 };
+#define METRICS_PERIOD_MS 1000   // gauge refresh
+
+static metric_t mLoopPasses     = METRIC_COUNTER_INIT("air_loop_passes_total", "loop() passes; flat means the loop is stalled", NULL);
+static metric_t mLoopPeriod     = METRIC_HISTOGRAM_INIT("air_loop_period_us", "Time between loop() passes", NULL, LOOP_PERIOD_BOUNDS_US);
+static metric_t mMqttAttempts   = METRIC_COUNTER_INIT("air_mqtt_connect_attempts_total", "MQTT connect attempts", NULL);
+static metric_t mMqttReconnects = METRIC_COUNTER_INIT("air_mqtt_reconnects_total", "Successful MQTT (re)connects", NULL);
+static metric_t mMqttConnect    = METRIC_HISTOGRAM_INIT("air_mqtt_connect_ms", "Duration of one MQTT connect attempt (DNS, TCP, CONNACK)", NULL, MQTT_CONNECT_BOUNDS_MS);
+static metric_t mMqttOutage     = METRIC_HISTOGRAM_INIT("air_mqtt_reconnect_ms", "Time from losing MQTT to reconnecting", NULL, OUTAGE_BOUNDS_MS);
+static metric_t mMqttUp         = METRIC_GAUGE_INIT("air_mqtt_up", "1 while the MQTT session is up", NULL);
+static metric_t mMqttRejected   = METRIC_COUNTER_INIT("air_mqtt_rejected_total", "MQTT messages dropped: payload too long, config on a shared topic, or a legacy topic while mqtt_legacy is off", NULL);
+static metric_t mWifiReconnects = METRIC_COUNTER_INIT("air_wifi_reconnects_total", "Successful Wi-Fi (re)connects", NULL);
+static metric_t mWifiOutage     = METRIC_HISTOGRAM_INIT("air_wifi_reconnect_ms", "Time from losing Wi-Fi to reconnecting", NULL, OUTAGE_BOUNDS_MS);
+static metric_t mWifiUp         = METRIC_GAUGE_INIT("air_wifi_up", "1 while Wi-Fi is associated", NULL);
+static metric_t mServoMoves     = METRIC_COUNTER_INIT("air_servo_moves_total", "Window moves started", NULL);
+static metric_t mPumpRuns       = METRIC_COUNTER_INIT("air_pump_activations_total", "Water pump activations", NULL);
+static metric_t mActQueued      = METRIC_COUNTER_INIT("air_actuator_commands_total", "Actuator commands by queue outcome", "result=\"queued\"");
+static metric_t mActCoalesced   = METRIC_COUNTER_INIT("air_actuator_commands_total", "Actuator commands by queue outcome", "result=\"coalesced\"");
+static metric_t mActNoop        = METRIC_COUNTER_INIT("air_actuator_commands_total", "Actuator commands by queue outcome", "result=\"noop\"");
+static metric_t mActPreempted   = METRIC_COUNTER_INIT("air_actuator_commands_total", "Actuator commands by queue outcome", "result=\"preempted\"");
+static metric_t mActApplied     = METRIC_COUNTER_INIT("air_actuator_applied_total", "Actuator commands applied", NULL);
+static metric_t mActDepth       = METRIC_GAUGE_INIT("air_actuator_queue_depth", "Actuator commands waiting", NULL);
+static metric_t mActMaxDepth    = METRIC_GAUGE_INIT("air_actuator_queue_depth_max", "Deepest actuator queue since boot", NULL);
+static metric_t mHeapFree       = METRIC_GAUGE_INIT("air_heap_free_bytes", "Free heap", NULL);
+static metric_t mHeapMinFree    = METRIC_GAUGE_INIT("air_heap_min_free_bytes", "Lowest free heap since boot", NULL);
+static metric_t mWifiRssi       = METRIC_GAUGE_INIT("air_wifi_rssi_dbm", "Wi-Fi RSSI (0 when disconnected)", NULL);
+static metric_t mUptime         = METRIC_GAUGE_INIT("air_uptime_seconds", "Seconds since boot", NULL);
+static metric_t mLogDropped     = METRIC_GAUGE_INIT("air_log_dropped_total", "Log records dropped because the ring was full", NULL);
+static metric_t mPowerCurrent   = METRIC_GAUGE_INIT("air_power_avg_current_ua", "Estimated average supply current since boot", NULL);
+static metric_t mPowerActive    = METRIC_GAUGE_INIT("air_power_active_permille", "Share of time awake since boot (per mille)", NULL);
+static metric_t mPowerWake      = METRIC_HISTOGRAM_INIT("air_power_wake_latency_us", "Delay from the planned wake-up to running again", NULL, WAKE_LATENCY_BOUNDS_US);
+static metric_t mBootReady      = METRIC_GAUGE_INIT("air_boot_control_ready_ms", "Time from reset until local control first ran", NULL);
+static metric_t mStateWrites    = METRIC_GAUGE_INIT("air_state_writes_total", "Durable state records written to NVS", NULL);
+static metric_t mConfigRev      = METRIC_GAUGE_INIT("air_config_revision", "Revision of the applied configuration (0 = build defaults)", NULL);
+
+// ---------- Forward Declarations ----------
+static void mark_state_dirty(void);
+static void mark_inputs_changed(void);
+static void persist_state(uint32_t max_delay_ms);
+static void priority_decider(bool force);
+static void build_topics(void);
+static void callback(const char* topic, const uint8_t* payload, unsigned int length);
+
+  // ---------- Utility ----------
+  static float di_calculation(float temp, float hum) {
+    return 0.81f * temp + 0.01f * hum * (0.99f * temp - 14.3f) + 46.3f;
+  }
+
+  // PM used for decisions: local PMS5003 average while fresh, else MQTT outdoor.
+  // Returns true when the local sensor was used.
+  static bool decision_pm(float* pm_25, float* pm_10) {
+    if (pms5003_average(&pmsParser, hal_millis(), PMS_STALE_MS, pm_25, pm_10)) return true;
+    *pm_25 = pm25;
+    *pm_10 = pm10;
+    return false;
+  }
+
+     // ---------- Window Control ----------
+// Called only by task_actuate. open_window()/close_window() only set the motion
+// target; handleServo() moves the servo a little on every loop() pass so
+// MQTT/HTTP/pump keep running. is_window tracks the commanded state, so a
+// reverse command mid-move is accepted.
+// opening: degrees open, CMD_WINDOW_MAX_OPEN_DEG = SERVO_OPEN_DEG (fully open)
+static int window_angle(int32_t opening) {
+  return SERVO_CLOSED_DEG + (SERVO_OPEN_DEG - SERVO_CLOSED_DEG) * (int)opening / CMD_WINDOW_MAX_OPEN_DEG;
+}
+static int32_t window_opening(int angle) {
+  return (int32_t)((angle - SERVO_CLOSED_DEG) * CMD_WINDOW_MAX_OPEN_DEG / (SERVO_OPEN_DEG - SERVO_CLOSED_DEG));
+}
+
+static void open_window(int32_t opening) {
+  int angle = window_angle(opening);
+  // 이미 그 각도로 열려있으면 중복 실행 방지
+  if (is_window == 1 && lroundf(windowMotion.target) == angle) {
+    DLOG_D(CTRL, "Window already open, skipping");
+    return;
+  }
+
+  DLOG_I(CTRL, "Opening window by %u deg", (unsigned)opening);
+  // 서보모터를 열림 각도로 이동 (완전히 열면 0도)
+  servo_motion_set_target(&windowMotion, angle, hal_millis());
+  pm_lock(&power, PM_LOCK_MOTION);
+  metric_inc(&mServoMoves);
+  is_window = 1;
+  persist_state(0);
+  mark_state_dirty();
+}
+static void close_window(void) {
+  // 이미 닫혀있으면 중복 실행 방지
+  if (is_window == 0) {
+    DLOG_D(CTRL, "Window already closed, skipping");
+    return;
+  }
+
+  DLOG_I(CTRL, "Closing window");
+  // 서보모터를 90도로 이동 (창문 닫기)
+  servo_motion_set_target(&windowMotion, SERVO_CLOSED_DEG, hal_millis());
+  pm_lock(&power, PM_LOCK_MOTION);
+  metric_inc(&mServoMoves);
+  is_window = 0;
+  persist_state(0);
+  mark_state_dirty();
+}
+
+static void handleServo(void) {
+  if (!servo_motion_tick(&windowMotion, hal_millis())) return;
+
+  int angle = servo_motion_angle(&windowMotion);
+  if (angle != servoAngle) {
+    hal_servo_write(angle);
+    servoAngle = angle;
+    persist_state(STORE_CHECKPOINT_MS);
+    mark_state_dirty();
+  }
+  if (!windowMotion.moving) {
+    pm_unlock(&power, PM_LOCK_MOTION);
+    persist_state(0);
+    DLOG_I(CTRL, "Window %s", is_window == 1 ? "opened" : "closed");
+  }
+}
+
+// ---------- Durable state ----------
+static int store_read(void* ctx, const char* key, void* buf, size_t cap) { (void)ctx; return hal_store_read(key, buf, cap); }
+static bool store_write(void* ctx, const char* key, const void* data, size_t len) { (void)ctx; return hal_store_write(key, data, len); }
+
+// Snapshot of everything restored at boot; written within max_delay_ms
+static void persist_state(uint32_t max_delay_ms) {
+  ds_state_t s = store.state;
+  s.window_open   = (uint8_t)is_window;
+  s.window_angle  = (uint8_t)servoAngle;
+  s.window_target = (uint8_t)lroundf(windowMotion.target);
+  s.decision      = decisionEngine.has_output ? (uint8_t)decisionEngine.output : DS_NONE;
+  s.power_mode    = (uint8_t)power.mode;
+  s.power_default = (uint8_t)BOOT_POWER_MODE;
+  s.pm25 = pm25;
+  s.pm10 = pm10;
+  s.aqi  = aqi;
+  ds_update(&store, &s, max_delay_ms, hal_millis());
+}
+
+// ---------- /data snapshot ----------
+// The HTTP server runs in its own task; /data is served from a pre-serialized
+// snapshot that loop() rebuilds only after a state change. The snapshot
+// carries a state version (stateFeed) that only moves when the displayed state
+// changes, so pollers can revalidate with ?since= or ETag.
+#define SNAPSHOT_REFRESH_MS 5000   // heap/age refresh without a state change
+
+static char          dataSnapshot[AIR_DATA_MAX];
+static size_t        dataSnapshotLen = 0;
+static uint32_t      dataSnapshotVersion = 0;
+static state_feed_t  stateFeed;            // written by loop(), read by httpd; both in a HAL critical section
+static volatile bool stateDirty = true;
+
+static control_handoff_t controlHandoff;
+
+static void mark_state_dirty(void) { stateDirty = true; }
+static void mark_inputs_changed(void) { inputsVersion++; mark_state_dirty(); }
+
+// JSON has no NaN; a missing reading is reported as 0 as before
+static double json_num(float v) { return isfinite(v) ? (double)v : 0.0; }
+static const char* json_bool(bool v) { return v ? "true" : "false"; }
+
+// loop() context only: reads actuator state without locking
+static void build_data_snapshot(void) {
+  sensor_reading_t env;
+  sensor_sampler_get(&sht31Sampler, &env);
+  float cur_temp = env.valid ? env.temperature : NAN;
+  float cur_hum  = env.valid ? env.humidity    : NAN;
+  float di = env.valid ? di_calculation(cur_temp, cur_hum) : 0.0f;
+  float pm_25, pm_10;
+  bool pmLocal = decision_pm(&pm_25, &pm_10);
+  cmd_latency_summary_t lat;
+  cmd_latency_summary(&cmdLatency, &lat);
+
+  state_sample_t s;
+  memset(&s, 0, sizeof(s));
+  s.pm25_x10          = state_feed_x10(pm_25);
+  s.pm10_x10          = state_feed_x10(pm_10);
+  s.pm25_outdoor_x10  = state_feed_x10(pm25);
+  s.pm10_outdoor_x10  = state_feed_x10(pm10);
+  s.temperature_x10   = state_feed_x10(cur_temp);
+  s.humidity_x10      = state_feed_x10(cur_hum);
+  s.di_x10            = state_feed_x10(di);
+  s.flags = (bug                ? STATE_FLAG_BUG : 0)
+          | (is_window == 1     ? STATE_FLAG_WINDOW_OPEN : 0)
+          | (windowMotion.moving ? STATE_FLAG_WINDOW_MOVING : 0)
+          | (pmLocal            ? STATE_FLAG_PM_LOCAL : 0)
+          | (env.valid          ? STATE_FLAG_SENSOR_VALID : 0)
+          | (decisionEngine.pending || settlePending ? STATE_FLAG_DECISION_PENDING : 0);
+  s.window_position    = (uint8_t)servo_motion_angle(&windowMotion);
+  s.window_progress    = servo_motion_progress(&windowMotion);
+  s.decision_reason    = decisionEngine.reason;
+  s.cmd_count          = lat.count;
+  s.cmd_latency_p50_ms = lat.p50_ms;
+  s.cmd_latency_p99_ms = lat.p99_ms;
+
+  hal_critical_enter();
+  state_feed_update(&stateFeed, &s, hal_millis());
+  hal_critical_exit();
+  uint32_t version = stateFeed.version;   // only loop() writes it
+
+  // Heap health: min_free is the high-water mark, frag = 1 - largest block / free
+  hal_heap_stats_t heap;
+  hal_heap_stats(&heap);
+  uint32_t now = hal_millis();
+
+  char buf[sizeof(dataSnapshot)];
+  int len = snprintf(buf, sizeof(buf),
+    "{\"version\":%u,\"device_id\":\"%s\",\"pm25\":%.2f,\"pm10\":%.2f,\"pm_source\":\"%s\","
+    "\"pm25_outdoor\":%.2f,\"pm10_outdoor\":%.2f,\"temperature\":%.2f,\"humidity\":%.2f,\"di\":%.2f,"
+    "\"bug\":%s,\"window\":%s,\"window_moving\":%s,\"window_position\":%d,\"window_progress\":%u,"
+    "\"sensor_control_enabled\":%s,\"decision_reason\":\"%s\",\"decision_pending\":%s,\"config_rev\":%u,"
+    "\"sensor_valid\":%s,\"sensor_age_ms\":%u,"
+    "\"cmd_count\":%u,\"cmd_latency_p50_ms\":%u,\"cmd_latency_p99_ms\":%u,"
+    "\"heap_free\":%u,\"heap_min_free\":%u,\"heap_max_alloc\":%u,\"heap_frag_pct\":%u,\"timestamp\":%u}",
+    (unsigned)version, clientID ? clientID : hal_device_id(), json_num(pm_25), json_num(pm_10), pmLocal ? "local" : "outdoor",
+    json_num(pm25), json_num(pm10), json_num(cur_temp), json_num(cur_hum), json_num(di),
+    json_bool(bug), json_bool(is_window == 1), json_bool(windowMotion.moving),
+    servo_motion_angle(&windowMotion), (unsigned)servo_motion_progress(&windowMotion),
+    json_bool(!bug),  // 벌레 감지 시 센서 제어 비활성화
+    decision_engine_reason(&decisionEngine), json_bool(decisionEngine.pending || settlePending),
+    (unsigned)configStore.rev,
+    json_bool(env.valid), (unsigned)(env.timestamp_ms ? now - env.timestamp_ms : 0),
+    (unsigned)lat.count, (unsigned)lat.p50_ms, (unsigned)lat.p99_ms,
+    (unsigned)heap.free, (unsigned)heap.min_free, (unsigned)heap.max_alloc,
+    (unsigned)(heap.free ? 100 - (heap.max_alloc * 100 / heap.free) : 0), (unsigned)now);
+  if (len < 0 || (size_t)len >= sizeof(buf)) {
+    DLOG_E(HTTP, "/data snapshot does not fit");
+    return;
+  }
+
+  hal_critical_enter();
+  memcpy(dataSnapshot, buf, (size_t)len);
+  dataSnapshotLen = (size_t)len;
+  dataSnapshotVersion = version;
+  hal_critical_exit();
+}
+
+size_t air_app_data_json(char* buf, size_t cap, uint32_t* version) {
+  hal_critical_enter();
+  size_t len = dataSnapshotLen < cap ? dataSnapshotLen : 0;
+  memcpy(buf, dataSnapshot, len);
+  *version = dataSnapshotVersion;
+  hal_critical_exit();
+  return len;
+}
+
+uint32_t air_app_data_state(uint32_t since, state_sample_t* cur, state_sample_t* base, bool* has_base) {
+  hal_critical_enter();
+  uint32_t version = stateFeed.version;
+  *cur      = stateFeed.current;
+  *has_base = since != version && state_feed_lookup(&stateFeed, since, base);
+  hal_critical_exit();
+  return version;
+}
+
+control_handoff_t* air_app_control(void) { return &controlHandoff; }
+
+// ---------- Network (Wi-Fi / MQTT) ----------
+// conn_manager keeps independent state and jittered exponential backoff for
+// each link. An MQTT connect attempt (DNS, TCP, CONNACK) runs on the HAL's
+// connect task and loop() only polls for its result, so a broker that refuses
+// or hangs never stalls actuation, local control or the HTTP server.
+// Wi-Fi is station mode only; the net task associates and retries in the
+// background so boot never waits on the access point.
+#define NET_BACKOFF_MIN_MS      1000
+#define NET_BACKOFF_MAX_MS      60000
+#define WIFI_CONNECT_TIMEOUT_MS 15000
+#define MQTT_POLL_MS            100   // result check while an attempt runs
+
+static conn_manager_t net;
+static uint32_t mqttAttemptStarted = 0;
+
+static void net_wifi_begin(void* ctx) {
+  (void)ctx;
+  DLOG_I(NET, "Connecting to WiFi %s", config->wifi_ssid);
+  hal_wifi_begin(config->wifi_ssid, config->wifi_password);
+}
+
+static bool net_wifi_up(void* ctx) { (void)ctx; return hal_wifi_connected(); }
+
+static bool net_mqtt_begin(void* ctx) {
+  (void)ctx;
+  metric_inc(&mMqttAttempts);
+  mqttAttemptStarted = hal_millis();
+  if (hal_mqtt_connect_start(clientID, config->mqtt_user, config->mqtt_password, topicStatus, "offline")) return true;
+  DLOG_W(NET, "MQTT connect not started");
+  return false;
+}
+
+static conn_attempt_t net_mqtt_poll(void* ctx) {
+  (void)ctx;
+  hal_mqtt_connect_status_t st = hal_mqtt_connect_poll();
+  if (st == HAL_MQTT_CONNECT_PENDING) return CONN_ATTEMPT_PENDING;
+  metric_observe(&mMqttConnect, hal_millis() - mqttAttemptStarted);
+  if (st == HAL_MQTT_CONNECT_OK) return CONN_ATTEMPT_OK;
+  DLOG_W(NET, "MQTT connect failed, rc=%d", hal_mqtt_state());
+  return CONN_ATTEMPT_FAILED;
+}
+
+static bool net_mqtt_up(void* ctx) { (void)ctx; return hal_mqtt_connected(); }
+
+static void net_on_wifi_up(void* ctx, const conn_link_t* link) {
+  (void)ctx;
+  uint32_t ip = hal_wifi_local_ip(), gw = hal_wifi_gateway_ip();
+  DLOG_I(NET, "WiFi connected after %u ms: IP %u.%u.%u.%u", (unsigned)link->last_outage_ms, IP4(ip));
+  DLOG_I(NET, "WiFi gateway %u.%u.%u.%u", IP4(gw));
+  metric_inc(&mWifiReconnects);
+  metric_observe(&mWifiOutage, link->last_outage_ms);
+}
+
+// Clean session: subscriptions are gone after every reconnect, restore them once
+static void net_on_mqtt_up(void* ctx, const conn_link_t* link) {
+  (void)ctx;
+  DLOG_I(NET, "MQTT connected after %u ms (attempt %u)", (unsigned)link->last_outage_ms, (unsigned)link->attempts);
+  hal_mqtt_subscribe(topicDevice);
+  hal_mqtt_subscribe(topicBroadcast);
+  if (config->mqtt_legacy) hal_mqtt_subscribe(topicLegacy);
+  hal_mqtt_publish(topicStatus, (const uint8_t*)"online", 6, true);
+  if (configProbation) {
+    configProbation = false;
+    DLOG_I(SYS, "Network settings of config rev %u confirmed", (unsigned)configStore.rev);
+  }
+  metric_inc(&mMqttReconnects);
+  metric_observe(&mMqttOutage, link->last_outage_ms);
+}
+
+static void net_on_down(void* ctx, bool is_mqtt) {
+  (void)ctx;
+  DLOG_W(NET, "%s connection lost", is_mqtt ? "MQTT" : "WiFi");
+}
+
+static uint32_t net_random(void* ctx) { (void)ctx; return hal_random(); }
+
+// ---------- Configuration ----------
+static servo_motion_profile_t servo_profile(void) {
+  return (servo_motion_profile_t){ config->servo_velocity_dps, config->servo_accel_dps2 };
+}
+
+// Rule table with the configured thresholds
+static void load_decision_rules(void) {
+  for (uint8_t i = 0; i < DECISION_RULE_COUNT; i++) {
+    decisionRules[i] = DECISION_RULES[i];
+    switch (decisionRules[i].input) {
+      case DE_INPUT_PM25: decisionRules[i].threshold = config->pm25_close; break;
+      case DE_INPUT_PM10: decisionRules[i].threshold = config->pm10_close; break;
+      case DE_INPUT_DI:   decisionRules[i].threshold = config->di_comfort; break;
+      default: break;
+    }
+  }
+}
+
+// ---------- Remote config ----------
+// MQTT config updates must carry "rev", the current revision (0 on build
+// defaults), so a captured update cannot be replayed once applied, and "sig",
+// the hex HMAC-SHA256 with
+// AIR_MQTT_CONFIG_KEY over "<device id>\n<rev>\n<config object as sent>".
+// Wi-Fi, MQTT and URL fields are local only (POST /control): a broker that can
+// redirect the node's traffic must not be able to move it to another broker.
+// With no key built in, MQTT config is refused altogether.
+#ifndef AIR_MQTT_CONFIG_KEY
+#define AIR_MQTT_CONFIG_KEY ""
+#endif
+#define CONFIG_REMOTE_FIELDS (CFG_APPLY_DECISION | CFG_APPLY_PUMP | CFG_APPLY_SERVO)
+#define CONFIG_LOCAL_FIELDS  (CONFIG_REMOTE_FIELDS | CFG_APPLY_WIFI | CFG_APPLY_MQTT | CFG_APPLY_HTTP)
+
+static bool config_signed(const cfg_update_t* update) {
+  static const char key[] = AIR_MQTT_CONFIG_KEY;
+  if (key[0] == '\0') return false;
+  char head[48];
+  int n = snprintf(head, sizeof(head), "%s\n%u\n", clientID, (unsigned)update->rev);
+  if (n <= 0 || (size_t)n >= sizeof(head)) return false;
+  hmac_sha256_t h;
+  uint8_t mac[SHA256_SIZE];
+  hmac_sha256_init(&h, key, sizeof(key) - 1);
+  hmac_sha256_update(&h, head, (size_t)n);
+  hmac_sha256_update(&h, update->config, update->config_len);
+  hmac_sha256_final(&h, mac);
+  return hmac_sha256_hex_equal(mac, update->sig, strlen(update->sig));
+}
+
+// Puts a committed config into effect; Wi-Fi/MQTT changes are left to task_net,
+// which must not reconnect from inside the MQTT callback that delivered them.
+// handlePump() reads pump_ms directly.
+static void apply_config(uint32_t changed) {
+  if (changed & CFG_APPLY_DECISION) {
+    load_decision_rules();
+    decisionEngine.min_dwell_ms = config->decision_dwell_ms;
+    mark_inputs_changed();   // re-evaluate against the new thresholds
+  }
+  if (changed & CFG_APPLY_SERVO) windowMotion.profile = servo_profile();
+  if (changed & CFG_APPLY_HTTP)  air_http_set_urls(config->post_url, config->pull_url);
+  configNetPending |= changed & (CFG_APPLY_WIFI | CFG_APPLY_MQTT);
+  metric_set(&mConfigRev, (int32_t)configStore.rev);
+  mark_state_dirty();
+}
+
+// {"config":{"pump_ms":2000,"pm25_close":30},"rev":4} -> every field or none.
+// remote (MQTT) updates are checked against their signature before any field is read.
+// Writes {"ok":..,"result":..,"rev":..[,"field":..]} to reply; values are never echoed.
+static cfg_error_t config_update(const char* json, size_t len, bool remote, char* reply, size_t cap) {
+  static air_config_t staged;   // loop() only
+  cfg_result_t res = { CFG_OK, NULL, configStore.rev, 0 };
+  cfg_update_t update;
+
+  staged = *config;
+  if (remote) {
+    res.error = cfg_parse_update(NULL, json, len, 0, &update);
+    if (res.error == CFG_OK && !config_signed(&update)) res.error = CFG_ERR_AUTH;
+    if (res.error == CFG_OK && update.rev != configStore.rev) res.error = CFG_ERR_CONFLICT;
+  }
+  if (res.error == CFG_OK) {
+    res.error = cfg_parse_update(&staged, json, len, remote ? CONFIG_REMOTE_FIELDS : CONFIG_LOCAL_FIELDS, &update);
+  }
+  if (res.error != CFG_OK) {
+    res.field = update.field;
+    if (res.error != CFG_ERR_FORMAT) configStore.rejects++;
+  } else {
+    // Last known-good network settings, restored if the new ones never get MQTT up
+    bool probation = !configProbation && conn_mqtt_up(&net);
+    if (probation) configPrevious = *config;
+    cfg_commit(&configStore, &staged, update.rev, &res);
+    if (probation && (res.changed & (CFG_APPLY_WIFI | CFG_APPLY_MQTT))) {
+      configProbation = true;
+      configProbationUntil = hal_millis() + CONFIG_NET_PROBATION_MS;
+    }
+  }
+
+  if (res.error == CFG_OK && res.changed) {
+    DLOG_I(SYS, "Config rev %u applied (changes 0x%02x)", (unsigned)res.rev, (unsigned)res.changed);
+    apply_config(res.changed);
+  } else if (res.error != CFG_OK) {
+    DLOG_W(SYS, "Config update rejected: %s %s", cfg_error_name(res.error), res.field ? res.field : "");
+  }
+  int n = snprintf(reply, cap, "{\"ok\":%s,\"result\":\"%s\",\"rev\":%u",
+                   res.error == CFG_OK ? "true" : "false", cfg_error_name(res.error), (unsigned)res.rev);
+  if (res.field && n > 0 && (size_t)n < cap) n += snprintf(reply + n, cap - n, ",\"field\":\"%s\"", res.field);
+  if (n > 0 && (size_t)n < cap - 1) strcpy(reply + n, "}");
+  return res.error;
+}
+
+// Reconnects with changed Wi-Fi/MQTT settings: conn_manager sees the link go
+// down and reconnects (and resubscribes) with the new values.
+static void apply_network_config(void) {
+  uint32_t changed = configNetPending;
+  configNetPending = 0;
+  if (changed & CFG_APPLY_MQTT) {
+    if (conn_mqtt_up(&net)) hal_mqtt_publish(topicStatus, (const uint8_t*)"offline", 7, true);
+    hal_mqtt_disconnect();
+    build_topics();
+    hal_mqtt_setup(config->mqtt_host, config->mqtt_port, callback);
+  }
+  if (changed & CFG_APPLY_WIFI) hal_wifi_disconnect();
+  DLOG_I(NET, "Reconnecting with new %s settings", (changed & CFG_APPLY_WIFI) ? "Wi-Fi" : "MQTT");
+}
+
+// New network settings that never got MQTT up are replaced by the previous ones
+static void check_config_probation(uint32_t now) {
+  if (!configProbation || (int32_t)(now - configProbationUntil) < 0) return;
+  configProbation = false;
+  cfg_result_t res;
+  if (cfg_commit(&configStore, &configPrevious, 0, &res) != CFG_OK) {
+    DLOG_E(SYS, "Config rollback failed: %s", cfg_error_name(res.error));
+    return;
+  }
+  DLOG_W(SYS, "No MQTT with the new network settings, restored them as rev %u", (unsigned)res.rev);
+  apply_config(res.changed);
+}
+
+// Evaluates the rule table; moves the window only when the engine output
+// changes, or unconditionally (bypassing the dwell time) when force is set.
+static void priority_decider(bool force) {
+  // 벌레 감지 중에는 센서 제어 완전 중단
+  if (bug) return;
+
+  sensor_reading_t env;
+  sensor_sampler_get(&sht31Sampler, &env);
+  float pm_25, pm_10;
+  decision_pm(&pm_25, &pm_10);
+
+  de_inputs_t in;
+  in.value[DE_INPUT_PM25] = pm_25;
+  in.valid[DE_INPUT_PM25] = true;
+  in.value[DE_INPUT_PM10] = pm_10;
+  in.valid[DE_INPUT_PM10] = true;
+  in.value[DE_INPUT_DI]   = env.valid ? di_calculation(env.temperature, env.humidity) : 0.0f;
+  in.valid[DE_INPUT_DI]   = env.valid;
+
+  bool changed = decision_engine_evaluate(&decisionEngine, &in, hal_millis(), force);
+  if (!changed && !force) return;
+
+  DLOG_I(CTRL, "Decider: PM2.5=%.1f PM10=%.1f DI=%.1f -> %s (%s)",
+                pm_25, pm_10, in.value[DE_INPUT_DI],
+                decisionEngine.output == DE_WINDOW_OPEN ? "open" : "close",
+                decision_engine_reason(&decisionEngine));
+  persist_state(STORE_INPUTS_MS);
+  actuator_request(ACT_WINDOW, decisionEngine.output == DE_WINDOW_OPEN, 0, ACT_PRIO_AUTO, CMD_SRC_LOCAL);
+}
+
+// loop() context only (MQTT callback, task_control, task_decide)
+bool actuator_request(act_id_t actuator, int target, int32_t value, act_prio_t priority, cmd_source_t source) {
+  static metric_t* const outcome[] = { &mActQueued, &mActCoalesced, &mActNoop, &mActPreempted };
+  // defaults resolved here so "open" and "open 90 deg" coalesce as the same command
+  if (value == 0) value = actuator == ACT_WINDOW ? CMD_WINDOW_MAX_OPEN_DEG : (int32_t)config->pump_ms;
+  act_push_result_t r = actq_push(&actuators, actuator, target, value, priority, (uint8_t)source);
+  metric_inc(outcome[r]);
+  if (r == ACT_PUSH_QUEUED || r == ACT_PUSH_COALESCED) {
+    queuedSentMs[actuator] = actuators.has_pending[actuator] ? pushSentMs : 0;
+  }
+  if (r == ACT_PUSH_PREEMPTED) {
+    DLOG_I(CTRL, "%s command from source %d preempted", actuator == ACT_WINDOW ? "Window" : "Pump", (int)source);
+  } else {
+    DLOG_D(CTRL, "%s command: %s", actuator == ACT_WINDOW ? "Window" : "Pump", actq_push_result_name(r));
+  }
+  return r != ACT_PUSH_PREEMPTED;
+}
+
+static void activatePump(uint32_t runMs) {
+  hal_gpio_write(WATER_PUMP_PIN, true);
+  pumpStart = hal_millis();
+  pumpRunMs = runMs;
+  pumpActive = true;
+  pm_lock(&power, PM_LOCK_PUMP);
+  metric_inc(&mPumpRuns);
+  mark_state_dirty();
+  DLOG_I(CTRL, "Water pump ON - spraying for %u ms", (unsigned)runMs);
+}
+
+static void deactivatePump(void) {
+  if (!pumpActive) return;
+  hal_gpio_write(WATER_PUMP_PIN, false);
+  pumpActive = false;
+  pm_unlock(&power, PM_LOCK_PUMP);
+  mark_state_dirty();
+  DLOG_I(CTRL, "Water pump OFF - stopped");
+}
+
+static void handlePump(void) {
+  if (pumpActive && hal_millis() - pumpStart >= pumpRunMs) {
+    hal_gpio_write(WATER_PUMP_PIN, false);
+    pumpActive = false;
+    pm_unlock(&power, PM_LOCK_PUMP);
+    actq_set_state(&actuators, ACT_PUMP, 0, 0);
+    mark_state_dirty();
+    DLOG_I(CTRL, "Water pump OFF - done");
+  }
+}
+// ---------- Bug detection ----------
+// The detector repeats its state every few seconds; only transitions act.
+// While a bug is present the window is held closed against lower priorities.
+void bug_detected(bool spray) {
+  if (bug) {
+    DLOG_D(CTRL, "Bug detection already ON");
+    return;
+  }
+  if (spray) {
+    DLOG_I(CTRL, "Bug detected, close window and activate pump");
+    actuator_request(ACT_WINDOW, 0, 0, ACT_PRIO_SAFETY, CMD_SRC_LOCAL);   // 창문 닫기
+    actuator_request(ACT_PUMP, 1, 0, ACT_PRIO_SAFETY, CMD_SRC_LOCAL);
+    actq_hold(&actuators, ACT_WINDOW, ACT_PRIO_SAFETY);
+  }
+  bug = true;
+  settlePending = false;
+  mark_state_dirty();
+  DLOG_I(CTRL, "Bug detection ON - sensor control disabled");
+}
+
+void bug_cleared(uint32_t settle_ms) {
+  if (!bug) {
+    DLOG_D(CTRL, "Bug detection already OFF");
+    return;
+  }
+  bug = false;
+  actq_release(&actuators, ACT_WINDOW);
+  mark_state_dirty();
+  DLOG_I(CTRL, "Bug detection OFF - sensor control enabled");
+
+  if (settle_ms > 0) {
+    // 워터펌프 완료 후 대기 (벌레 완전 제거 확인) - task_decide가 타이머 만료 시 실행
+    DLOG_I(CTRL, "Wait %u ms and run priority decider", (unsigned)settle_ms);
+    settleUntil   = hal_millis() + settle_ms;
+    settlePending = true;
+    return;
+  }
+  priority_decider(true);
+}
+
+// ---------- Push commands ----------
+// Dispatched straight from the MQTT callback, i.e. within the loop() pass
+// that received it. If the server stamped the command, the latency is
+// recorded at actuation (record_command_latency).
+static void push_command_parsed(const air_command_t* cmd, void* ctx) {
+  air_command_t* first = (air_command_t*)ctx;
+  if (!first->name[0]) *first = *cmd;   // one command per message
+}
+
+static void handle_push_command(const uint8_t* payload, unsigned int length) {
+  static cmd_stream_t parser;   // loop() only
+  air_command_t cmd;
+  memset(&cmd, 0, sizeof(cmd));
+
+  if (length > 0 && payload[0] == '{') {
+    cmd_stream_init(&parser, push_command_parsed, &cmd);
+    if (!cmd_stream_feed(&parser, (const char*)payload, length) || !cmd_stream_finish(&parser)) {
+      DLOG_W(CMD, "Push command: bad json");
+      return;
+    }
+  } else {
+    size_t n = length < sizeof(cmd.name) - 1 ? length : sizeof(cmd.name) - 1;
+    memcpy(cmd.name, payload, n);
+    cmd.name[n] = '\0';
+  }
+  if (cmd.name[0] == '\0') return;
+
+  cmd_args_t args = { cmd.value, cmd.id };
+  pushSentMs = cmd.ts;
+  command_dispatch(CMD_SRC_MQTT, cmd.name, strlen(cmd.name), &args, NULL);
+  pushSentMs = 0;
+}
+
+static void record_command_latency(uint64_t sentMs) {
+  if (sentMs == 0) return;
+  uint64_t now = hal_epoch_ms();
+  if (now < sentMs) return;
+  cmd_latency_record(&cmdLatency, (uint32_t)(now - sentMs));
+  mark_state_dirty();
+}
+
+// <root>/<leaf>: the shared pre-namespace topics
+static bool is_legacy_topic(const char* topic) {
+  size_t n = strlen(topicLegacy) - 1;   // "<root>/"
+  return strncmp(topic, topicLegacy, n) == 0 && strchr(topic + n, '/') == NULL;
+}
+
+// Parses in place from payload/length into fixed buffers: no String, no heap.
+static void callback(const char* topic, const uint8_t* payload, unsigned int length) {
+  mqtt_topic_t kind = mqtt_topic_classify(topic);
+  DLOG_D(NET, "MQTT message kind=%d len=%u", (int)kind, length);
+  if (!config->mqtt_legacy && is_legacy_topic(topic)) {
+    metric_inc(&mMqttRejected);
+    DLOG_W(NET, "Message on a shared legacy topic ignored (mqtt_legacy off)");
+    return;
+  }
+  if (kind == MQTT_TOPIC_COMMAND) {
+    handle_push_command(payload, length);
+    return;
+  }
+  if (kind == MQTT_TOPIC_CONFIG) {
+    // broadcast and legacy topics are shared by every node: no config from there
+    if (strncmp(topic, topicDevice, strlen(topicDevice) - 1) != 0) {
+      metric_inc(&mMqttRejected);
+      DLOG_W(NET, "Config on a shared topic ignored");
+      return;
+    }
+    char reply[128];
+    config_update((const char*)payload, length, true, reply, sizeof(reply));
+    hal_mqtt_publish(topicConfigResult, (const uint8_t*)reply, strlen(reply), false);
+    return;
+  }
+
+  // every value and pump state fits; a longer payload is dropped, not cut
+  char data[16];
+  if (!mqtt_payload_copy(payload, length, data, sizeof(data))) {
+    metric_inc(&mMqttRejected);
+    DLOG_W(NET, "MQTT message kind=%d dropped: %u bytes", (int)kind, length);
+    return;
+  }
+
+  switch (kind) {
+    // readings only feed the decider; /data picks them up on the next refresh
+    case MQTT_TOPIC_AQI:
+      if (mqtt_parse_int(data, &aqi))    { DLOG_D(NET, "Updated AQI: %d", aqi); persist_state(STORE_INPUTS_MS); }
+      break;
+    case MQTT_TOPIC_PM25:
+      if (mqtt_parse_float(data, &pm25)) { DLOG_D(NET, "Updated PM2.5: %.1f", pm25); mark_inputs_changed(); persist_state(STORE_INPUTS_MS); }
+      break;
+    case MQTT_TOPIC_PM10:
+      if (mqtt_parse_float(data, &pm10)) { DLOG_D(NET, "Updated PM10: %.1f", pm10); mark_inputs_changed(); persist_state(STORE_INPUTS_MS); }
+      break;
+    case MQTT_TOPIC_PUMP: {
+      DLOG_D(CMD, "Pump message: %s", strcmp(data, "ON") == 0 ? "ON" : strcmp(data, "OFF") == 0 ? "OFF" : "?");
+
+      // Pi bug detector: ON = bug seen (close + spray), OFF = clear after 5 s settle.
+      // Repeats are absorbed by bug_detected()/bug_cleared() and the actuator queue.
+      if (strcmp(data, "ON") == 0) {
+        cmd_args_t args = { 1, 0 };
+        command_dispatch(CMD_SRC_MQTT, "BUG_ON", 6, &args, NULL);
+      } else if (strcmp(data, "OFF") == 0) {
+        cmd_args_t args = { 5000, 0 };
+        command_dispatch(CMD_SRC_MQTT, "BUG_OFF", 7, &args, NULL);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+void air_app_mqtt_message(const char* topic, const uint8_t* payload, unsigned int length) {
+  callback(topic, payload, length);
+}
+
+// ---------- Scheduler ----------
+// Each stage gets its own period, priority (lower runs first) and deadline.
+// Tasks must not block; per-task runtime and deadline misses are recorded.
+
+static uint32_t sched_clock_us(void) { return hal_micros(); }
+
+static void task_servo(uint32_t now)  { (void)now; handleServo(); }
+static void task_pump(uint32_t now)   { (void)now; handlePump(); }
+
+// Applies queued actuator commands after this pass's inputs were handled
+static void task_actuate(uint32_t now) {
+  (void)now;
+  if (!controlReadyMs) {
+    controlReadyMs = hal_millis();
+    metric_set(&mBootReady, (int32_t)controlReadyMs);
+    if (controlReadyMs > BOOT_CONTROL_TARGET_MS) {
+      DLOG_W(SYS, "Local control ready %u ms after reset (target %u ms)", (unsigned)controlReadyMs, (unsigned)BOOT_CONTROL_TARGET_MS);
+    } else {
+      DLOG_I(SYS, "Local control ready %u ms after reset", (unsigned)controlReadyMs);
+    }
+  }
+  act_cmd_t c;
+  while (actq_pop(&actuators, &c)) {
+    if (c.actuator == ACT_WINDOW) {
+      if (c.target) open_window(c.value);
+      else          close_window();
+    } else {
+      if (c.target) activatePump((uint32_t)c.value);
+      else          deactivatePump();
+    }
+    record_command_latency(queuedSentMs[c.actuator]);
+    queuedSentMs[c.actuator] = 0;
+    metric_inc(&mActApplied);
+  }
+}
+static bool read_sht31(void* ctx, float* temperature, float* humidity) {
+  (void)ctx;
+  if (!hasSHT31) return false;
+  return hal_env_read(temperature, humidity);  // one combined I2C measurement
+}
+
+static void task_sensor(uint32_t now) {
+  if (sensor_sampler_sample(&sht31Sampler, now)) mark_inputs_changed();
+}
+
+static void task_pms(uint32_t now) {
+  uint8_t buf[64];
+  size_t n;
+  while ((n = hal_uart_read(buf, sizeof(buf))) > 0) {
+    if (pms5003_feed(&pmsParser, buf, n, now) > 0) mark_inputs_changed();
+  }
+}
+
+// Rule evaluation only runs when an input changed or a dwell-held change or
+// the post-bug settle timer is waiting.
+static void task_decide(uint32_t now) {
+  static uint32_t seenVersion = 0;
+  if (settlePending) {
+    if ((int32_t)(now - settleUntil) < 0) return;
+    settlePending = false;
+    seenVersion = inputsVersion;
+    priority_decider(true);
+    return;
+  }
+  if (inputsVersion == seenVersion && !decisionEngine.pending) return;
+  seenVersion = inputsVersion;
+  priority_decider(false);
+}
+
+static void task_snapshot(uint32_t now) {
+  static uint32_t lastBuild = 0;
+  if (!stateDirty && now - lastBuild < SNAPSHOT_REFRESH_MS) return;
+  stateDirty = false;
+  lastBuild  = now;
+  build_data_snapshot();
+}
+
+void air_app_build_snapshot(void) { build_data_snapshot(); }
+
+// Runs one /control request handed over by the httpd task, in loop() context
+static void control_execute(const control_request_t* rq, const char* configJson, size_t configLen,
+                            control_reply_t* reply, void* ctx) {
+  (void)ctx;
+  if (configJson) {
+    reply->config_result = config_update(configJson, configLen, false, reply->config_json, sizeof(reply->config_json));
+    return;
+  }
+  cmd_result_t res;
+  command_dispatch(CMD_SRC_HTTP, rq->command, strlen(rq->command), &rq->args, &res);
+  DLOG_I(CMD, "HTTP command %s: %s", res.name ? res.name : "?", command_status_name(res.status));
+  reply->result = res;
+}
+
+static void task_control(uint32_t now) {
+  (void)now;
+  control_drain(&controlHandoff, control_execute, NULL);
+}
+
+static void task_net(uint32_t now) {
+  if (!netStarted) return;   // boot pass: start_network() runs right after it
+  // the connect task owns the MQTT client until its attempt ends
+  if (configNetPending && !conn_mqtt_connecting(&net)) apply_network_config();
+  check_config_probation(now);
+  conn_manager_tick(&net, now);
+  if (conn_mqtt_up(&net)) hal_mqtt_loop();
+}
+
+// Writes the durable state once its coalescing deadline has passed
+static void task_store(uint32_t now) {
+  if (ds_poll(&store, now)) DLOG_D(SYS, "State saved (%u writes)", (unsigned)store.writes);
+}
+
+// Slow-moving gauges, sampled from loop() so each metric keeps one writer
+static void task_metrics(uint32_t now) {
+  hal_heap_stats_t heap;
+  hal_heap_stats(&heap);
+  metric_set(&mHeapFree,    (int32_t)heap.free);
+  metric_set(&mHeapMinFree, (int32_t)heap.min_free);
+  metric_set(&mWifiRssi,    conn_wifi_up(&net) ? hal_wifi_rssi() : 0);
+  metric_set(&mWifiUp,      conn_wifi_up(&net));
+  metric_set(&mMqttUp,      conn_mqtt_up(&net));
+  metric_set(&mUptime,      (int32_t)(now / 1000));
+  metric_set(&mLogDropped,  (int32_t)dlog_dropped());
+  metric_set(&mActDepth,    actuators.depth);
+  metric_set(&mActMaxDepth, actuators.max_depth);
+  metric_set(&mPowerCurrent, (int32_t)pm_avg_current_ua(&power));
+  metric_set(&mPowerActive, (int32_t)pm_duty_permille(&power));
+  metric_set(&mStateWrites, (int32_t)store.writes);
+}
+
+static void register_metrics(void) {
+  metric_t* all[] = {
+    &mLoopPasses, &mLoopPeriod,
+    &mMqttAttempts, &mMqttReconnects, &mMqttConnect, &mMqttOutage, &mMqttUp, &mMqttRejected,
+    &mWifiReconnects, &mWifiOutage, &mWifiUp,
+    &mServoMoves, &mPumpRuns,
+    &mActQueued, &mActCoalesced, &mActNoop, &mActPreempted,   // same name: keep together
+    &mActApplied, &mActDepth, &mActMaxDepth,
+    &mHeapFree, &mHeapMinFree, &mWifiRssi, &mUptime, &mLogDropped,
+    &mPowerCurrent, &mPowerActive, &mPowerWake,
+    &mBootReady, &mStateWrites, &mConfigRev,
+  };
+  for (size_t i = 0; i < sizeof(all) / sizeof(all[0]); i++) metrics_register(all[i]);
+}
+
+static void task_status(uint32_t now);
+static void task_log(uint32_t now);
+
+static sched_task_t tasks[] = {
+  { .name = "servo",    .fn = task_servo,    .period_ms = 0,                  .deadline_ms = 20,   .priority = 0 },
+  { .name = "pump",     .fn = task_pump,     .period_ms = 10,                 .deadline_ms = 50,   .priority = 1 },
+  { .name = "control",  .fn = task_control,  .period_ms = 0,                  .deadline_ms = 100,  .priority = 2 },
+  { .name = "net",      .fn = task_net,      .period_ms = 0,                  .deadline_ms = 250,  .priority = 3 },
+  { .name = "snapshot", .fn = task_snapshot, .period_ms = 100,                .deadline_ms = 200,  .priority = 4 },
+  { .name = "sensor",   .fn = task_sensor,   .period_ms = SENSOR_PERIOD_MS,   .deadline_ms = 100,  .priority = 5 },
+  { .name = "pms",      .fn = task_pms,      .period_ms = 100,                .deadline_ms = 50,   .priority = 6 },
+  { .name = "decide",   .fn = task_decide,   .period_ms = DECISION_PERIOD_MS, .deadline_ms = 50,   .priority = 7 },
+  { .name = "actuate",  .fn = task_actuate,  .period_ms = 0,                  .deadline_ms = 20,   .priority = 8 },
+  { .name = "metrics",  .fn = task_metrics,  .period_ms = METRICS_PERIOD_MS,  .deadline_ms = 100,  .priority = 9 },
+  { .name = "status",   .fn = task_status,   .period_ms = 10000,              .deadline_ms = 1000, .priority = 10 },
+  { .name = "log",      .fn = task_log,      .period_ms = 0,                  .deadline_ms = 100,  .priority = 11 },
+  { .name = "store",    .fn = task_store,    .period_ms = 0,                  .deadline_ms = 100,  .priority = 12 },
+};
+static scheduler_t scheduler;
+
+static void task_status(uint32_t now) {
+  (void)now;
+  uint32_t ip = hal_wifi_local_ip();
+  DLOG_I(SYS, "WiFi %s, http://%u.%u.%u.%u:%u",
+         hal_wifi_connected() ? "connected" : "disconnected", IP4(ip), (unsigned)AIR_HTTP_PORT);
+  DLOG_I(SYS, "Loop max pass %u us", (unsigned)scheduler.max_pass_us);
+  DLOG_I(SYS, "Power: avg %u uA (estimate), awake %u permille, %u light sleeps",
+         (unsigned)pm_avg_current_ua(&power), (unsigned)pm_duty_permille(&power), (unsigned)power.light_sleeps);
+  for (uint8_t i = 0; i < scheduler.count; i++) {
+    const sched_task_t* t = &scheduler.tasks[i];
+    DLOG_D(SYS, "  %-8s runs=%u max_us=%u misses=%u", t->name,
+           (unsigned)t->runs, (unsigned)t->max_runtime_us, (unsigned)t->deadline_misses);
+  }
+}
+
+// Drains queued log records without ever blocking on the UART
+static void task_log(uint32_t now) {
+  (void)now;
+  dlog_record_t r;
+  for (uint8_t i = 0; i < LOG_DRAIN_MAX && hal_log_writable() >= LOG_LINE_MAX; i++) {
+    if (!dlog_pop(&r)) break;
+#if AIR_LOG_BINARY
+    uint8_t frame[DLOG_FRAME_MAX];
+    int n = dlog_encode(&r, frame, sizeof(frame));
+#else
+    char frame[LOG_LINE_MAX];
+    int n = dlog_format(&r, frame, sizeof(frame));
+#endif
+    if (n > 0) hal_log_write((const uint8_t*)frame, (size_t)n);
+  }
+}
+
+void air_app_run_tasks(void) { sched_run(&scheduler, hal_millis()); }
+
+// ---------- Power modes ----------
+// Task periods per power mode; tasks not listed keep their table period
+// (period 0 tasks run on every wake-up).
+typedef struct {
+  sched_task_fn fn;
+  uint32_t      period_ms[PM_MODE_COUNT];
+} power_profile_t;
+static const power_profile_t POWER_PROFILE[] = {
+  // fn             performance          low power
+  { task_pump,     { 10,                     0 } },   // pump runs hold a wake lock anyway
+  { task_sensor,   { SENSOR_PERIOD_MS,   30000 } },
+  { task_pms,      { 100,                 1000 } },
+  { task_snapshot, { 100,                 1000 } },
+  { task_decide,   { DECISION_PERIOD_MS,  1000 } },
+  { task_metrics,  { METRICS_PERIOD_MS,  10000 } },
+  { task_status,   { 10000,              60000 } },
+};
+
+// The MQTT keep-alive applies from the next connect
+static void set_power_mode(pm_mode_t mode) {
+  uint32_t now = hal_millis();
+  for (size_t i = 0; i < sizeof(POWER_PROFILE) / sizeof(POWER_PROFILE[0]); i++) {
+    sched_set_period(&scheduler, POWER_PROFILE[i].fn, POWER_PROFILE[i].period_ms[mode], now);
+  }
+  hal_set_cpu_mhz(CPU_MHZ[mode]);
+  hal_wifi_set_sleep(mode == PM_MODE_LOW_POWER);
+  hal_mqtt_set_keepalive(MQTT_KEEPALIVE_S[mode]);
+  pm_set_mode(&power, mode);
+  persist_state(STORE_INPUTS_MS);
+  DLOG_I(SYS, "Power mode: %s", mode == PM_MODE_LOW_POWER ? "low power" : "performance");
+}
+
+// Waits out the gap until the next task release or connection retry. Waiting
+// on the control queue lets an HTTP command end the wait early; light sleep
+// only happens while Wi-Fi is down, so no connection is lost to it.
+static void power_idle(void) {
+  uint32_t now  = hal_millis();
+  uint32_t idle = sched_idle_ms(&scheduler, now);
+  uint32_t netIdle = conn_manager_idle_ms(&net, now);
+  if (netIdle < idle) idle = netIdle;
+
+  pm_plan_t plan = pm_plan(&power, idle, conn_wifi_active(&net));
+  uint32_t slept = 0;
+  if (plan.state == PM_STATE_LIGHT) {
+    slept = hal_light_sleep(plan.ms, AIR_WAKE_GPIO);
+  } else if (plan.ms > 0) {
+    uint32_t t0 = hal_micros();
+    control_wait(&controlHandoff, plan.ms);
+    slept = hal_micros() - t0;
+  }
+  pm_account(&power, plan, slept, hal_millis());
+  if (plan.ms > 0) metric_observe(&mPowerWake, power.last_wake_latency_us);
+}
+
+// ---------- Setup / Loop ----------
+// From the configured root; rebuilt when topic_root changes
+static void build_topics(void) {
+  const char* root = config->topic_root;
+  snprintf(topicDevice,       sizeof(topicDevice),       "%s/%s/+", root, clientID);
+  snprintf(topicBroadcast,    sizeof(topicBroadcast),    "%s/%s/+", root, TOPIC_BROADCAST);
+  snprintf(topicLegacy,       sizeof(topicLegacy),       "%s/+", root);
+  snprintf(topicStatus,       sizeof(topicStatus),       "%s/%s/status", root, clientID);
+  snprintf(topicConfigResult, sizeof(topicConfigResult), "%s/%s/config/result", root, clientID);
+}
+
+// Radio and MQTT come up after the first control pass; association itself
+// then runs in the background from the net task.
+static void start_network(void) {
+  hal_wifi_init();
+  hal_time_sync(ntpServer);  // wall clock for command latency; SNTP syncs once Wi-Fi is up
+
+  clientID = hal_device_id();
+  build_topics();
+  DLOG_I(SYS, "Device ID %s", clientID);
+  hal_mqtt_setup(config->mqtt_host, config->mqtt_port, callback);
+  static const conn_ops_t netOps = {
+    net_wifi_begin, net_wifi_up, net_mqtt_begin, net_mqtt_poll, net_mqtt_up,
+    net_on_wifi_up, net_on_mqtt_up, net_on_down, net_random, NULL,
+  };
+  static const conn_config_t netConfig = { NET_BACKOFF_MIN_MS, NET_BACKOFF_MAX_MS, WIFI_CONNECT_TIMEOUT_MS, MQTT_POLL_MS };
+  conn_manager_init(&net, &netOps, &netConfig, hal_millis());
+  netStarted = true;
+}
+
+void air_app_setup(void) {
+  hal_log_begin(LOG_TX_BUFFER);
+  dlog_init(hal_millis);
+
+  // Last saved state first, so the servo starts where it stopped
+  static const ds_ops_t storeOps = { store_read, store_write, NULL };
+  ds_init(&store, &storeOps);
+  ds_state_t saved;
+  ds_restore_t restored = ds_restore(&store, &saved);
+  bool warm = restored != DS_RESTORE_NONE;
+  pm_init(&power, &POWER_CONFIG, PM_MODE_PERFORMANCE, hal_millis());
+
+  // Site configuration: servo speed, thresholds and endpoints depend on it
+  cfg_init(&configStore, &storeOps, &CONFIG_DEFAULTS);
+  ds_restore_t configured = cfg_load(&configStore);
+  if (configured != DS_RESTORE_NONE) {
+    DLOG_I(SYS, "Config rev %u loaded%s", (unsigned)configStore.rev,
+           configured == DS_RESTORE_FALLBACK ? " (previous record, latest was damaged)" : "");
+  }
+  metric_set(&mConfigRev, (int32_t)configStore.rev);
+  air_http_set_urls(config->post_url, config->pull_url);
+
+  // Servo: attached on the saved angle; an interrupted move carries on to its target
+  int angle = warm ? saved.window_angle : SERVO_CLOSED_DEG;
+  hal_servo_attach(SERVO_PIN, 500, 2500, angle);
+  servo_motion_profile_t profile = servo_profile();
+  servo_motion_init(&windowMotion, &profile, angle, hal_millis());
+  servoAngle = angle;
+  if (warm) {
+    is_window = saved.window_open;
+    pm25 = saved.pm25;
+    pm10 = saved.pm10;
+    aqi  = saved.aqi;
+    if (saved.window_target != saved.window_angle) {
+      servo_motion_set_target(&windowMotion, saved.window_target, hal_millis());
+      pm_lock(&power, PM_LOCK_MOTION);
+    }
+    DLOG_I(SYS, "Restored %s state: window %s at %u deg%s, PM2.5=%.1f PM10=%.1f",
+           restored == DS_RESTORE_FALLBACK ? "previous" : "saved", is_window ? "open" : "closed",
+           (unsigned)saved.window_angle, windowMotion.moving ? " (resuming move)" : "", pm25, pm10);
+  }
+
+  // Water pump (always boots off)
+  hal_gpio_output(WATER_PUMP_PIN);
+  hal_gpio_write(WATER_PUMP_PIN, false);
+
+  actq_init(&actuators);
+  actq_set_state(&actuators, ACT_WINDOW, is_window, window_opening(lroundf(windowMotion.target)));
+  actq_set_state(&actuators, ACT_PUMP, pumpActive, 0);
+
+  load_decision_rules();
+  decision_engine_init(&decisionEngine, decisionRules, DECISION_RULE_COUNT,
+                       DE_WINDOW_OPEN, "ventilation needed", config->decision_dwell_ms);
+  if (warm && saved.decision != DS_NONE) {
+    decision_engine_restore(&decisionEngine, (de_action_t)saved.decision, hal_millis());
+  }
+
+  // PMS5003 (9600 8N1, one frame per second)
+  pms5003_init(&pmsParser);
+  hal_uart_begin(9600, PMS_RX_PIN, PMS_TX_PIN, 256);
+
+  // SHT31 on either common address (0x44, 0x45)
+  hasSHT31 = hal_env_begin(SHT31_SDA_PIN, SHT31_SCL_PIN);
+  if (!hasSHT31) {
+    DLOG_W(SENSOR, "SHT31 not found. Continuing without sensor.");
+  }
+  sensor_sampler_init(&sht31Sampler, read_sht31, NULL, SENSOR_EMA_ALPHA, SENSOR_MAX_FAILURES);
+  sensor_sampler_sample(&sht31Sampler, hal_millis());
+
+  // /data, /control
+  state_feed_init(&stateFeed, hal_random());   // versions from a previous boot never match
+  register_metrics();
+  build_data_snapshot();
+  control_handoff_init(&controlHandoff);
+
+  // One pass with local control only, then networking
+  sched_init(&scheduler, tasks, sizeof(tasks) / sizeof(tasks[0]), sched_clock_us, hal_millis());
+  sched_run(&scheduler, hal_millis());
+  start_network();
+
+  // A mode saved under the same build default wins (AIR_LOW_POWER only picks it on a fresh device)
+  pm_mode_t mode = BOOT_POWER_MODE;
+  if (warm && saved.power_default == BOOT_POWER_MODE && saved.power_mode < PM_MODE_COUNT) mode = (pm_mode_t)saved.power_mode;
+  if (mode != PM_MODE_PERFORMANCE) set_power_mode(mode);
+}
+
+void air_app_loop(void) {
+  static uint32_t lastPassUs = 0;
+  uint32_t nowUs = hal_micros();
+  if (lastPassUs) metric_observe(&mLoopPeriod, nowUs - lastPassUs);
+  lastPassUs = nowUs;
+  metric_inc(&mLoopPasses);
+
+  sched_run(&scheduler, hal_millis());
+
+  power_idle();
+}
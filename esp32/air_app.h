@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "control_handoff.h"
+#include "state_feed.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 펌웨어 본체: setup()/loop()에서 보드에 묶이지 않은 부분
+// 창문/펌프 제어, 센서, 판단 엔진, 설정, Wi-Fi/MQTT 연결 관리, /data 스냅샷, 지표를 HAL 위에서 돌린다.
+// main.c(ESP32)는 여기에 HTTP 서버(esp_http_server)와 벤치마크만 더하고, 호스트에서는 같은 코드가
+// hal_posix.c 위에서 돈다 (tools/app_smoke_test.c).
+// 아래 "HTTP 서버" 절을 빼면 모두 loop() 컨텍스트에서 호출한다.
+
+#define AIR_HTTP_PORT 8000
+#define AIR_DATA_MAX  1024      // /data JSON 본문 최대 길이
+
+void air_app_setup(void);
+void air_app_loop(void);
+
+// ---------- HTTP 서버 (다른 태스크에서 호출) ----------
+// /control 요청을 loop()로 넘기는 핸드오프
+control_handoff_t *air_app_control(void);
+
+// 마지막으로 만든 /data JSON을 buf에 복사한다. 길이를 반환하고 *version에 상태 버전을 쓴다.
+size_t air_app_data_json(char *buf, size_t cap, uint32_t *version);
+
+// 바이너리 /data: 현재 상태와, since 버전이 아직 보관 중이면 그 상태(*has_base). 현재 버전을 반환.
+uint32_t air_app_data_state(uint32_t since, state_sample_t *cur, state_sample_t *base, bool *has_base);
+
+// ---------- 벤치마크 (AIR_BENCH) ----------
+void air_app_mqtt_message(const char *topic, const uint8_t *payload, unsigned int length);
+void air_app_build_snapshot(void);
+// 스케줄러 한 패스 (유휴 대기 없이)
+void air_app_run_tasks(void);
+
+#ifdef __cplusplus
+}
+#endif
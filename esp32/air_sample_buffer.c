@@ -0,0 +1,253 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "air_sample_buffer.h"
+
+#define AIR_SPILL_KEY   "tlm_spill"
+#define AIR_SPILL_MAGIC 0x5341   // "AS"
+
+void air_sample_buffer_init(air_sample_buffer_t *b)
+{
+    memset(b, 0, sizeof(*b));
+}
+
+void air_sample_buffer_push(air_sample_buffer_t *b, const air_sample_t *s)
+{
+    uint16_t tail = (uint16_t)((b->head + b->count) % AIR_SAMPLE_BUFFER_CAPACITY);
+    b->items[tail] = *s;
+    if (b->count < AIR_SAMPLE_BUFFER_CAPACITY) {
+        b->count++;
+    } else {
+        // 가득 참: 가장 오래된 샘플을 덮어씀
+        b->head = (uint16_t)((b->head + 1) % AIR_SAMPLE_BUFFER_CAPACITY);
+        b->dropped++;
+    }
+}
+
+uint16_t air_sample_buffer_peek(const air_sample_buffer_t *b, air_sample_t *out, uint16_t max)
+{
+    uint16_t n = b->count < max ? b->count : max;
+    for (uint16_t i = 0; i < n; i++) {
+        out[i] = b->items[(b->head + i) % AIR_SAMPLE_BUFFER_CAPACITY];
+    }
+    return n;
+}
+
+void air_sample_buffer_consume(air_sample_buffer_t *b, uint16_t n)
+{
+    if (n > b->count) n = b->count;
+    b->head = (uint16_t)((b->head + n) % AIR_SAMPLE_BUFFER_CAPACITY);
+    b->count -= n;
+}
+
+// NaN/무한대는 JSON 숫자가 아니므로 null
+static const char *json_num(char *buf, size_t cap, float v)
+{
+    if (!(v - v == 0.0f)) return "null";
+    snprintf(buf, cap, "%.2f", v);
+    return buf;
+}
+
+int air_sample_encode_json(const air_sample_t *s, uint16_t n, uint32_t now_ms, char *out, size_t cap)
+{
+    size_t pos = 0;
+    if (cap < 3) return -1;
+    out[pos++] = '[';
+
+    for (uint16_t i = 0; i < n; i++) {
+        char temp[24], hum[24];
+        int w = snprintf(out + pos, cap - pos,
+                         "%s{\"temperature\":%s,\"humidity\":%s,\"pm25\":%d,\"pm10\":%d,\"bug\":%s,\"age_ms\":%lu}",
+                         i ? "," : "",
+                         json_num(temp, sizeof(temp), s[i].temperature),
+                         json_num(hum, sizeof(hum), s[i].humidity),
+                         s[i].pm25,
+                         s[i].pm10,
+                         s[i].bug ? "true" : "false",
+                         (unsigned long)(now_ms - s[i].timestamp_ms));
+        if (w <= 0 || (size_t)w >= cap - pos) return -1;
+        pos += (size_t)w;
+    }
+
+    if (pos + 2 > cap) return -1;
+    out[pos++] = ']';
+    out[pos] = '\0';
+    return (int)pos;
+}
+
+static uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+    p = put_u16(p, (uint16_t)v);
+    return put_u16(p, (uint16_t)(v >> 16));
+}
+
+static uint16_t clamp_u16(float v)
+{
+    if (!(v > 0.0f)) return 0;     // NaN 포함
+    if (v > 65535.0f) return 65535;
+    return (uint16_t)(v + 0.5f);
+}
+
+static int16_t clamp_i16(float v)
+{
+    if (v != v) return INT16_MIN;  // NaN은 INT16_MIN으로 표시
+    if (v > 32767.0f) return 32767;
+    if (v < -32767.0f) return -32767;
+    return (int16_t)(v < 0 ? v - 0.5f : v + 0.5f);
+}
+
+int air_sample_encode_binary(const air_sample_t *s, uint16_t n, uint32_t now_ms, uint8_t *out, size_t cap)
+{
+    if (n > 255) n = 255;
+    size_t need = AIR_SAMPLE_BINARY_HEADER + (size_t)n * AIR_SAMPLE_BINARY_RECORD;
+    if (need > cap) return -1;
+
+    uint8_t *p = out;
+    *p++ = 'A';
+    *p++ = 'Q';
+    *p++ = AIR_SAMPLE_BINARY_VERSION;
+    *p++ = (uint8_t)n;
+
+    for (uint16_t i = 0; i < n; i++) {
+        p = put_u32(p, now_ms - s[i].timestamp_ms);
+        p = put_u16(p, (uint16_t)clamp_i16(s[i].temperature * 100.0f));
+        p = put_u16(p, clamp_u16(s[i].humidity * 100.0f));
+        p = put_u16(p, (uint16_t)(s[i].pm25 < 0 ? 0 : s[i].pm25));
+        p = put_u16(p, (uint16_t)(s[i].pm10 < 0 ? 0 : s[i].pm10));
+        *p++ = s[i].bug ? 0x01 : 0x00;
+    }
+    return (int)need;
+}
+
+// 저장 레코드: 타임스탬프 대신 보관 시점 기준 age를 기록한다 (재부팅 시 millis가 초기화되므로)
+typedef struct {
+    uint16_t magic;
+    uint16_t count;             // 0이면 무효화된 저장본
+    uint32_t crc;               // items[0..count)
+    air_sample_t items[AIR_SAMPLE_BUFFER_CAPACITY];
+} spill_record_t;
+
+#define SPILL_HEADER offsetof(spill_record_t, items)
+
+static spill_record_t s_record;   // 2 KB 남짓, 스택에 두지 않는다
+
+void air_sample_spill_init(air_sample_spill_t *sp, const ds_ops_t *ops)
+{
+    memset(sp, 0, sizeof(*sp));
+    sp->ops = *ops;
+}
+
+uint16_t air_sample_spill_restore(air_sample_spill_t *sp, air_sample_buffer_t *b, uint32_t now_ms)
+{
+    int len = sp->ops.read(sp->ops.ctx, AIR_SPILL_KEY, &s_record, sizeof(s_record));
+    if (len < (int)SPILL_HEADER || s_record.magic != AIR_SPILL_MAGIC || s_record.count == 0 ||
+        s_record.count > AIR_SAMPLE_BUFFER_CAPACITY ||
+        (size_t)len != SPILL_HEADER + s_record.count * sizeof(air_sample_t) ||
+        s_record.crc != ds_crc32(s_record.items, s_record.count * sizeof(air_sample_t))) {
+        return 0;
+    }
+    for (uint16_t i = 0; i < s_record.count; i++) {
+        air_sample_t s = s_record.items[i];
+        s.timestamp_ms = now_ms - s.timestamp_ms;
+        air_sample_buffer_push(b, &s);
+    }
+    // 보내기 전까지는 저장본을 그대로 둔다. 버퍼와 같은 내용이므로 방금 보관한 것으로 친다.
+    sp->stored = true;
+    sp->spilled = true;
+    sp->last_ms = now_ms;
+    sp->last_dropped = b->dropped;
+    sp->count = s_record.count;
+    sp->buffered = s_record.count;
+    sp->seen_dropped = b->dropped;
+    return s_record.count;
+}
+
+static bool spill_write(air_sample_spill_t *sp, size_t len)
+{
+    sp->writes++;
+    if (!sp->ops.write(sp->ops.ctx, AIR_SPILL_KEY, &s_record, len)) {
+        sp->failures++;
+        return false;
+    }
+    return true;
+}
+
+bool air_sample_spill_poll(air_sample_spill_t *sp, const air_sample_buffer_t *b, uint32_t now_ms)
+{
+    if (b->count < AIR_SAMPLE_BUFFER_CAPACITY) {
+        return false;
+    }
+    if (sp->spilled && (b->dropped == sp->last_dropped || now_ms - sp->last_ms < AIR_SAMPLE_SPILL_INTERVAL_MS)) {
+        return false;
+    }
+    memset(&s_record, 0, sizeof(s_record));
+    uint16_t n = air_sample_buffer_peek(b, s_record.items, AIR_SAMPLE_BUFFER_CAPACITY);
+    for (uint16_t i = 0; i < n; i++) {
+        s_record.items[i].timestamp_ms = now_ms - s_record.items[i].timestamp_ms;
+    }
+    s_record.magic = AIR_SPILL_MAGIC;
+    s_record.count = n;
+    s_record.crc = ds_crc32(s_record.items, n * sizeof(air_sample_t));
+
+    // 실패해도 간격은 지킨다 (장애 중 매 재시도마다 쓰지 않도록)
+    sp->spilled = true;
+    sp->last_ms = now_ms;
+    sp->last_dropped = b->dropped;
+    if (!spill_write(sp, SPILL_HEADER + n * sizeof(air_sample_t))) {
+        return false;
+    }
+    sp->stored = true;
+    sp->stale = false;
+    sp->count = n;
+    sp->buffered = n;
+    sp->seen_dropped = b->dropped;
+    return true;
+}
+
+void air_sample_spill_sent(air_sample_spill_t *sp, const air_sample_buffer_t *b, uint16_t n)
+{
+    if (!sp->stored) {
+        return;
+    }
+    // 보관한 뒤 덮어써진 샘플은 버퍼 앞쪽에서 빠졌지만 저장본에는 남는다
+    uint32_t overwritten = b->dropped - sp->seen_dropped;
+    sp->buffered = overwritten >= sp->buffered ? 0 : (uint16_t)(sp->buffered - overwritten);
+    sp->seen_dropped = b->dropped;
+    uint16_t sent = n < sp->buffered ? n : sp->buffered;
+    if (sent == 0 && !sp->stale) {
+        return;
+    }
+
+    // 저장본 [count - buffered, +sent)가 방금 보낸 샘플. 플래시에서 다시 읽어 빼고 쓴다.
+    // 무엇이 남았는지 모르면(읽기 실패, 앞선 쓰기 실패) 전부 무효화한다: 보낸 샘플을 되살리지 않는 쪽.
+    uint16_t keep = 0;
+    if (!sp->stale &&
+        sp->ops.read(sp->ops.ctx, AIR_SPILL_KEY, &s_record, sizeof(s_record)) ==
+            (int)(SPILL_HEADER + sp->count * sizeof(air_sample_t)) &&
+        s_record.magic == AIR_SPILL_MAGIC && s_record.count == sp->count &&
+        s_record.crc == ds_crc32(s_record.items, sp->count * sizeof(air_sample_t))) {
+        uint16_t first = (uint16_t)(sp->count - sp->buffered);
+        keep = (uint16_t)(sp->count - sent);
+        memmove(&s_record.items[first], &s_record.items[first + sent],
+                (size_t)(keep - first) * sizeof(air_sample_t));
+    }
+    memset(&s_record.items[keep], 0, (size_t)(AIR_SAMPLE_BUFFER_CAPACITY - keep) * sizeof(air_sample_t));
+    s_record.magic = AIR_SPILL_MAGIC;
+    s_record.count = keep;
+    s_record.crc = ds_crc32(s_record.items, keep * sizeof(air_sample_t));
+    if (!spill_write(sp, SPILL_HEADER + keep * sizeof(air_sample_t))) {
+        sp->stale = true;   // 다음 성공 때 다시 시도
+        return;
+    }
+    sp->stale = false;
+    sp->stored = keep > 0;
+    sp->count = keep;
+    sp->buffered = keep > 0 ? (uint16_t)(sp->buffered - sent) : 0;
+}
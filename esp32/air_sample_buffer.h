@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "durable_state.h"  // ds_ops_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 텔레메트리 샘플 링 버퍼와 배치 인코더
+// 전송 실패 시에도 샘플을 잃지 않도록 RAM에 보관하고, 가득 차면 가장 오래된 샘플을 덮어쓴다.
+
+#ifndef AIR_SAMPLE_BUFFER_CAPACITY
+#define AIR_SAMPLE_BUFFER_CAPACITY 120   // 5초 주기 기준 약 10분
+#endif
+
+// 1이면 전송 장애 중 버퍼를 NVS에 보관하고 부팅 시 복원 (air_sample_spill_*)
+#ifndef AIR_SAMPLE_SPILL_NVS
+#define AIR_SAMPLE_SPILL_NVS 0
+#endif
+
+// 버퍼가 가득 찬 채로 장애가 이어질 때 다시 보관하는 최소 간격 (플래시 마모)
+#ifndef AIR_SAMPLE_SPILL_INTERVAL_MS
+#define AIR_SAMPLE_SPILL_INTERVAL_MS (30UL * 60UL * 1000UL)
+#endif
+
+typedef struct {
+    uint32_t timestamp_ms;   // 샘플 시각 (부팅 후 ms)
+    float temperature;
+    float humidity;
+    int16_t pm25;
+    int16_t pm10;
+    bool bug;
+} air_sample_t;
+
+typedef struct {
+    air_sample_t items[AIR_SAMPLE_BUFFER_CAPACITY];
+    uint16_t head;      // 가장 오래된 샘플 위치
+    uint16_t count;
+    uint32_t dropped;   // 덮어써서 잃은 샘플 수
+} air_sample_buffer_t;
+
+void air_sample_buffer_init(air_sample_buffer_t *b);
+void air_sample_buffer_push(air_sample_buffer_t *b, const air_sample_t *s);
+
+// 가장 오래된 샘플부터 최대 max개 복사 (버퍼에서 제거하지 않음)
+uint16_t air_sample_buffer_peek(const air_sample_buffer_t *b, air_sample_t *out, uint16_t max);
+// 전송이 끝난 n개를 제거
+void air_sample_buffer_consume(air_sample_buffer_t *b, uint16_t n);
+
+static inline uint16_t air_sample_buffer_count(const air_sample_buffer_t *b) { return b->count; }
+
+// 배치 인코딩. 성공 시 바이트 수, 버퍼 부족 시 -1.
+// 각 샘플의 age_ms = now_ms - timestamp_ms (서버가 실제 시각을 복원하는 데 사용)
+
+// JSON 배열: [{"temperature":23.50,"humidity":40.20,"pm25":12,"pm10":25,"bug":false,"age_ms":0},...]
+// 측정값이 없는(NaN) 온습도는 null
+int air_sample_encode_json(const air_sample_t *s, uint16_t n, uint32_t now_ms, char *out, size_t cap);
+
+// 바이너리 프레임 (리틀 엔디언)
+//   헤더 4B : 'A' 'Q' version(1) count
+//   샘플 13B: age_ms(u32) temp*100(i16) hum*100(u16) pm25(u16) pm10(u16) flags(u8, bit0=bug)
+#define AIR_SAMPLE_BINARY_VERSION 1
+#define AIR_SAMPLE_BINARY_HEADER  4
+#define AIR_SAMPLE_BINARY_RECORD  13
+int air_sample_encode_binary(const air_sample_t *s, uint16_t n, uint32_t now_ms, uint8_t *out, size_t cap);
+
+// 미전송 샘플의 플래시 보관 (부팅 간 공백 시간은 알 수 없음)
+// 버퍼가 가득 차서 덮어쓰기가 시작될 때만 쓰고, 그 뒤로는 새 샘플이 있어도 interval마다 한 번만 쓴다.
+// 저장본은 복원한 뒤에도 남겨 두고(보내기 전에 다시 재부팅될 수 있음), 배치 전송이 성공하면
+// 저장본에서 방금 보낸 샘플만 지운다. 이미 보낸 샘플은 다음 부팅에 다시 올라가지 않고,
+// 아직 보내지 못한 샘플(보낸 배치 뒤쪽, 또는 버퍼에서 덮어써져 저장본에만 남은 샘플)은 남는다.
+// 레코드는 CRC로 검증하므로 쓰는 도중 끊긴 저장본은 복원하지 않는다.
+typedef struct {
+    ds_ops_t ops;
+    bool stored;            // 보내지 않은 샘플이 저장되어 있을 수 있음
+    bool spilled;           // 이번 부팅에서 보관한 적 있음 (last_ms 유효)
+    uint32_t last_ms;       // 마지막 보관 시각
+    uint32_t last_dropped;  // 그때의 b->dropped (같으면 내용이 그대로)
+    uint16_t count;         // 저장본의 샘플 수
+    uint16_t buffered;      // 그중 아직 버퍼 앞쪽에 있는 샘플 수 (저장본의 뒤쪽 buffered개)
+    uint32_t seen_dropped;  // buffered를 맞춘 시점의 b->dropped
+    bool stale;             // 보낸 샘플을 지우는 쓰기가 실패함: 다음에 전부 무효화
+
+    // 통계
+    uint32_t writes;        // 보관 + 무효화
+    uint32_t failures;
+} air_sample_spill_t;
+
+void air_sample_spill_init(air_sample_spill_t *sp, const ds_ops_t *ops);
+// 부팅 시 저장본을 버퍼에 복원. 복원한 샘플 수.
+uint16_t air_sample_spill_restore(air_sample_spill_t *sp, air_sample_buffer_t *b, uint32_t now_ms);
+// 전송 실패 후 호출: 버퍼가 가득 찼고 마지막 보관 이후 내용이 바뀌었으며 간격이 지났으면 보관. 썼으면 true.
+bool air_sample_spill_poll(air_sample_spill_t *sp, const air_sample_buffer_t *b, uint32_t now_ms);
+// 버퍼 앞쪽 n개를 보낸 뒤 호출 (consume 전후 무관): 그중 저장본에 있는 샘플을 지운다.
+// 지울 것이 있을 때만 쓴다. 한 번의 flush에서 보낸 배치를 모아 한 번 호출하면 쓰기가 준다.
+void air_sample_spill_sent(air_sample_spill_t *sp, const air_sample_buffer_t *b, uint16_t n);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+
+void bench_run(const bench_env_t *env,
+               const char *name,
+               bench_fn fn,
+               void *ctx,
+               uint32_t iterations,
+               bench_result_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->name = name;
+    out->min_ns = UINT32_MAX;
+
+    fn(ctx);   // 워밍업 (캐시, 지연 초기화)
+
+    uint32_t allocs_before = env->alloc_count ? env->alloc_count() : 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        uint64_t t0 = env->now_ns();
+        fn(ctx);
+        uint64_t dt = env->now_ns() - t0;
+        uint32_t ns = dt > UINT32_MAX ? UINT32_MAX : (uint32_t)dt;
+
+        out->total_ns += dt;
+        if (ns < out->min_ns) out->min_ns = ns;
+        if (ns > out->max_ns) out->max_ns = ns;
+        out->samples[i % BENCH_MAX_SAMPLES] = ns;
+    }
+    out->allocs = env->alloc_count ? (int32_t)(env->alloc_count() - allocs_before) : -1;
+    out->iterations = iterations;
+    if (iterations == 0) {
+        out->min_ns = 0;
+        return;
+    }
+
+    // 보관된 최근 샘플을 삽입 정렬해 백분위 계산
+    uint32_t n = iterations < BENCH_MAX_SAMPLES ? iterations : BENCH_MAX_SAMPLES;
+    for (uint32_t i = 1; i < n; i++) {
+        uint32_t v = out->samples[i];
+        uint32_t j = i;
+        while (j > 0 && out->samples[j - 1] > v) {
+            out->samples[j] = out->samples[j - 1];
+            j--;
+        }
+        out->samples[j] = v;
+    }
+    out->p50_ns = out->samples[(n - 1) * 50 / 100];
+    out->p99_ns = out->samples[(n - 1) * 99 / 100];
+}
+
+int bench_format_json(const bench_result_t *r, char *out, size_t cap)
+{
+    uint64_t per_op = r->iterations ? r->total_ns / r->iterations : 0;
+    char allocs_per_op[16] = "null";
+    if (r->allocs >= 0) {
+        snprintf(allocs_per_op, sizeof(allocs_per_op), "%.3f",
+                 r->iterations ? (double)r->allocs / r->iterations : 0.0);
+    }
+    int n = snprintf(out, cap,
+                     "{\"bench\":\"%s\",\"iterations\":%lu,\"ns_per_op\":%llu,\"min_ns\":%lu,"
+                     "\"p50_ns\":%lu,\"p99_ns\":%lu,\"max_ns\":%lu,\"jitter_ns\":%lu,\"allocs_per_op\":%s}",
+                     r->name,
+                     (unsigned long)r->iterations,
+                     (unsigned long long)per_op,
+                     (unsigned long)r->min_ns,
+                     (unsigned long)r->p50_ns,
+                     (unsigned long)r->p99_ns,
+                     (unsigned long)r->max_ns,
+                     (unsigned long)(r->max_ns - r->p50_ns),
+                     allocs_per_op);
+    return (n > 0 && (size_t)n < cap) ? n : -1;
+}
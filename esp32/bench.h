@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 마이크로벤치마크 하네스
+// 시계(ns)와 할당 카운터는 호출자가 넘겨준다: 장치에서는 CPU 사이클 카운터/힙 할당 훅,
+// 호스트에서는 clock_gettime/malloc 래퍼를 쓸 수 있다 (tools/bench_host.c).
+// 할당 카운터는 malloc 호출 누적 수다. 해제를 빼는 순 블록 수로는 매번 할당하고 해제하는
+// 경로가 0으로 보인다.
+// 결과는 JSON 한 줄로 직렬화해서 릴리스 간 비교에 사용한다.
+
+#ifndef BENCH_MAX_SAMPLES
+#define BENCH_MAX_SAMPLES 256   // 백분위 계산용으로 보관하는 최근 반복 수
+#endif
+
+typedef struct {
+    uint64_t (*now_ns)(void);
+    uint32_t (*alloc_count)(void);  // 지금까지의 할당 호출 수. NULL이면 측정하지 않음
+} bench_env_t;
+
+typedef struct {
+    const char *name;
+    uint32_t iterations;
+    uint64_t total_ns;
+    uint32_t min_ns;
+    uint32_t p50_ns;
+    uint32_t p99_ns;
+    uint32_t max_ns;
+    int32_t allocs;                 // 전체 반복 동안의 할당 호출 수 (-1이면 측정 안 함)
+    uint32_t samples[BENCH_MAX_SAMPLES];
+} bench_result_t;
+
+typedef void (*bench_fn)(void *ctx);
+
+// 한 번 워밍업 후 iterations번 실행하며 반복별 시간을 잰다
+void bench_run(const bench_env_t *env,
+               const char *name,
+               bench_fn fn,
+               void *ctx,
+               uint32_t iterations,
+               bench_result_t *out);
+
+// {"bench":...,"iterations":...,"ns_per_op":...,"p50_ns":...,"p99_ns":...,"max_ns":...,"jitter_ns":...,"allocs_per_op":...}
+// 할당 수를 측정하지 않았으면 allocs_per_op는 null
+int bench_format_json(const bench_result_t *r, char *out, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
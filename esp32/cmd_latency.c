@@ -0,0 +1,42 @@
+#include <string.h>
+
+#include "cmd_latency.h"
+
+void cmd_latency_record(cmd_latency_t *l, uint32_t latency_ms)
+{
+    l->samples[l->next] = latency_ms;
+    l->next = (uint16_t)((l->next + 1) % CMD_LATENCY_WINDOW);
+    if (l->filled < CMD_LATENCY_WINDOW) {
+        l->filled++;
+    }
+    l->count++;
+    if (latency_ms > l->max_ms) {
+        l->max_ms = latency_ms;
+    }
+}
+
+void cmd_latency_summary(const cmd_latency_t *l, cmd_latency_summary_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->count = l->count;
+    out->max_ms = l->max_ms;
+    if (l->filled == 0) {
+        return;
+    }
+
+    // 창 크기가 작으므로 복사 후 삽입 정렬
+    uint32_t sorted[CMD_LATENCY_WINDOW];
+    uint16_t n = l->filled;
+    for (uint16_t i = 0; i < n; i++) {
+        uint32_t v = l->samples[i];
+        uint16_t j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+
+    out->p50_ms = sorted[(n - 1) * 50 / 100];
+    out->p99_ms = sorted[(n - 1) * 99 / 100];
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 명령 지연 시간(서버 타임스탬프 → 구동) 기록기
+// 최근 CMD_LATENCY_WINDOW개의 샘플만 고정 배열에 보관하고, 백분위는 조회할 때 계산한다.
+
+#ifndef CMD_LATENCY_WINDOW
+#define CMD_LATENCY_WINDOW 128
+#endif
+
+typedef struct {
+    uint32_t samples[CMD_LATENCY_WINDOW];
+    uint16_t next;
+    uint16_t filled;
+    uint32_t count;    // 누적 기록 수
+    uint32_t max_ms;   // 누적 최대값
+} cmd_latency_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t p50_ms;
+    uint32_t p99_ms;
+    uint32_t max_ms;
+} cmd_latency_summary_t;
+
+void cmd_latency_record(cmd_latency_t *l, uint32_t latency_ms);
+void cmd_latency_summary(const cmd_latency_t *l, cmd_latency_summary_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,217 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmd_stream.h"
+
+enum {
+    FIELD_NONE = 0,
+    FIELD_COMMAND,
+    FIELD_VALUE,
+    FIELD_SEQ,
+    FIELD_ID,
+    FIELD_TS,
+    FIELD_COMMANDS,
+};
+
+// 멤버를 추적 중인 가장 안쪽 객체가 depth 깊이의 객체이면 그것 (아니면 NULL)
+static cmd_stream_object_t *object_at(cmd_stream_t *s, uint8_t depth)
+{
+    if (s->object_count == 0) {
+        return NULL;
+    }
+    cmd_stream_object_t *o = &s->objects[s->object_count - 1];
+    return o->depth == depth ? o : NULL;
+}
+
+// 값이 들어갈 멤버의 객체. 컨테이너 이벤트에서는 json.depth가 이미 그 컨테이너의 깊이다
+static cmd_stream_object_t *current_object(cmd_stream_t *s)
+{
+    return object_at(s, s->json.depth);
+}
+
+static uint8_t field_for_key(const char *key, uint8_t len)
+{
+    if (len == 7 && memcmp(key, "command", 7) == 0) return FIELD_COMMAND;
+    if (len == 5 && memcmp(key, "value", 5) == 0)   return FIELD_VALUE;
+    if (len == 3 && memcmp(key, "seq", 3) == 0)     return FIELD_SEQ;
+    if (len == 2 && memcmp(key, "id", 2) == 0)      return FIELD_ID;
+    if (len == 2 && memcmp(key, "ts", 2) == 0)      return FIELD_TS;
+    if (len == 8 && memcmp(key, "commands", 8) == 0) return FIELD_COMMANDS;
+    return FIELD_NONE;
+}
+
+// 문자열/토큰이 아닌 값(또는 잘못된 타입)이 command 자리에 오면 그 명령은 버린다.
+// depth는 그 값을 가진 객체의 깊이
+static void reject_command_value(cmd_stream_t *s, uint8_t depth)
+{
+    if (s->field == FIELD_COMMAND) {
+        cmd_stream_object_t *o = object_at(s, depth);
+        if (o) {
+            o->bad = true;
+        }
+    }
+    s->field = FIELD_NONE;
+}
+
+// 인자는 정수만 받는다. 소수/지수 표기("1.5", "1e3")는 잘라 쓰지 않고 그 명령을 버린다.
+static bool integer_token(const char *text)
+{
+    return strpbrk(text, ".eE") == NULL;
+}
+
+static uint32_t parse_u32(const char *text)
+{
+    long long v = strtoll(text, NULL, 10);
+    if (v < 0) return 0;
+    if (v > 0xFFFFFFFFLL) return 0xFFFFFFFFu;
+    return (uint32_t)v;
+}
+
+static uint64_t parse_u64(const char *text)
+{
+    if (text[0] == '-') return 0;
+    return strtoull(text, NULL, 10);     // 넘치면 ULLONG_MAX
+}
+
+static int32_t parse_i32(const char *text)
+{
+    long long v = strtoll(text, NULL, 10);
+    if (v < INT32_MIN) return INT32_MIN;
+    if (v > INT32_MAX) return INT32_MAX;
+    return (int32_t)v;
+}
+
+static void token_done(cmd_stream_t *s, const char *text)
+{
+    cmd_stream_object_t *o = current_object(s);
+    bool number = text[0] == '-' || (text[0] >= '0' && text[0] <= '9');
+    bool argument = s->field == FIELD_VALUE || s->field == FIELD_SEQ || s->field == FIELD_ID || s->field == FIELD_TS;
+    if (o && number && argument && !integer_token(text)) {
+        o->bad = true;
+    } else if (o && number) {
+        switch (s->field) {
+        case FIELD_VALUE: o->cmd.value = parse_i32(text); break;
+        case FIELD_SEQ:   o->cmd.seq = parse_u32(text);   break;
+        case FIELD_ID:    o->cmd.id = parse_u32(text);    break;
+        case FIELD_TS:    o->cmd.ts = parse_u64(text);    break;
+        default: break;
+        }
+    }
+    reject_command_value(s, s->json.depth);
+}
+
+static void string_done(cmd_stream_t *s, const char *text, uint16_t len)
+{
+    if (s->field == FIELD_COMMAND) {
+        cmd_stream_object_t *o = current_object(s);
+        if (o) {
+            size_t n = len < CMD_STREAM_NAME_MAX ? len : CMD_STREAM_NAME_MAX - 1;
+            memcpy(o->cmd.name, text, n);
+            o->cmd.name[n] = '\0';
+            if (len == 0 || len >= CMD_STREAM_NAME_MAX) {
+                o->bad = true;
+            } else {
+                o->has_name = true;
+            }
+        }
+    }
+    s->field = FIELD_NONE;
+}
+
+// 명령 객체가 올 수 있는 자리: 최상위 객체, 최상위 배열의 원소,
+// 최상위 객체의 "commands" 배열 원소. 그 밖의 객체(중첩된 값)는 "command"가 있어도 명령이 아니다.
+static bool command_position(const cmd_stream_t *s)
+{
+    switch (s->json.depth) {
+    case 1:
+        return true;
+    case 2:
+        return s->json.stack[0] == '[';
+    case 3:
+        return s->commands_array && s->json.stack[1] == '[';
+    default:
+        return false;
+    }
+}
+
+static void open_container(cmd_stream_t *s, json_event_t ev)
+{
+    const json_stream_t *j = &s->json;
+    bool commands = s->field == FIELD_COMMANDS && ev == JSON_EV_ARRAY && j->depth == 2 && j->stack[0] == '{';
+    reject_command_value(s, (uint8_t)(j->depth - 1));
+    if (commands) {
+        s->commands_array = true;
+    }
+    if (ev == JSON_EV_OBJECT && command_position(s) && s->object_count < CMD_STREAM_MAX_OBJECTS) {
+        cmd_stream_object_t *o = &s->objects[s->object_count++];
+        memset(o, 0, sizeof(*o));
+        o->depth = j->depth;
+    }
+}
+
+static void close_container(cmd_stream_t *s)
+{
+    if (s->json.stack[s->json.depth - 1] == '{') {
+        cmd_stream_object_t *o = current_object(s);
+        if (o) {
+            if (o->has_name && !o->bad) {
+                s->commands++;
+                if (s->on_command) {
+                    s->on_command(&o->cmd, s->ctx);
+                }
+            } else if (o->bad) {
+                s->dropped++;
+            }
+            s->object_count--;
+        }
+    } else if (s->json.depth == 2) {
+        s->commands_array = false;
+    }
+    s->field = FIELD_NONE;
+}
+
+static void on_event(json_stream_t *j, json_event_t ev, void *ctx)
+{
+    cmd_stream_t *s = (cmd_stream_t *)ctx;
+    switch (ev) {
+    case JSON_EV_OBJECT:
+    case JSON_EV_ARRAY:
+        open_container(s, ev);
+        break;
+    case JSON_EV_END:
+        close_container(s);
+        break;
+    case JSON_EV_KEY:
+        s->field = current_object(s) && j->text_len < CMD_STREAM_KEY_MAX
+                   ? field_for_key(j->text, (uint8_t)j->text_len) : FIELD_NONE;
+        break;
+    case JSON_EV_STRING:
+        string_done(s, j->text, j->text_len);
+        break;
+    case JSON_EV_TOKEN:
+        token_done(s, j->text);
+        break;
+    }
+}
+
+void cmd_stream_init(cmd_stream_t *s, cmd_stream_fn on_command, void *ctx)
+{
+    memset(s, 0, sizeof(*s));
+    s->on_command = on_command;
+    s->ctx = ctx;
+    json_stream_init(&s->json, s->text, sizeof(s->text), on_event, s);
+}
+
+bool cmd_stream_feed(cmd_stream_t *s, const char *data, size_t len)
+{
+    bool ok = json_stream_feed(&s->json, data, len);
+    s->error = (cmd_stream_error_t)s->json.error;
+    return ok;
+}
+
+bool cmd_stream_finish(cmd_stream_t *s)
+{
+    bool ok = json_stream_finish(&s->json);
+    s->error = (cmd_stream_error_t)s->json.error;
+    return ok;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "json_stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 명령 폴링 응답용 스트리밍 JSON 파서 (힙 할당 없음, 본문 전체를 버퍼링하지 않음). 토큰은 json_stream.c가 읽는다.
+// HTTP 본문 조각을 받는 대로 cmd_stream_feed()에 넣으면, 명령 자리에 있는 객체 중
+// "command" 문자열 멤버를 가진 객체가 닫힐 때마다 on_command가 호출된다. 명령 자리는
+// 최상위 객체, 최상위 배열의 원소, 최상위 객체의 "commands" 배열 원소뿐이다.
+//   {"command":"PUMP_ON"}
+//   {"status":"ok","commands":[{"command":"WINDOW_OPEN","seq":41},{"command":"PUMP_ON","value":3000,"seq":42}]}
+//   [{"command":"WINDOW_CLOSE","id":7}, ...]
+// 그 밖의 중첩 객체({"meta":{"command":"X"}} 등)와 모르는 멤버는 건너뛴다.
+// 인식하는 숫자 멤버: value, seq, id, ts. 정수만 받으며 소수/지수 표기면 그 명령을 버린다 (dropped).
+
+#ifndef CMD_STREAM_NAME_MAX
+#define CMD_STREAM_NAME_MAX 32      // 명령 이름 최대 길이 (NUL 포함). 넘으면 그 명령은 버림
+#endif
+
+#define CMD_STREAM_MAX_DEPTH JSON_STREAM_MAX_DEPTH     // 이보다 깊게 중첩되면 구문 오류
+
+#ifndef CMD_STREAM_MAX_OBJECTS
+#define CMD_STREAM_MAX_OBJECTS 2    // 동시에 멤버를 추적하는 명령 객체 수 (최상위 객체 + "commands" 원소)
+#endif
+
+#define CMD_STREAM_KEY_MAX   12     // "command", "commands", "value", "seq", "id", "ts"만 구분하면 됨
+#define CMD_STREAM_TOKEN_MAX JSON_STREAM_TOKEN_MAX     // 숫자/리터럴 최대 길이
+#define CMD_STREAM_TEXT_MAX (CMD_STREAM_NAME_MAX > JSON_STREAM_TOKEN_MAX ? CMD_STREAM_NAME_MAX : JSON_STREAM_TOKEN_MAX)
+
+typedef struct {
+    char name[CMD_STREAM_NAME_MAX];
+    int32_t value;      // 명령별 인자 (목표 각도, 분사 시간 등, 없으면 0)
+    uint32_t seq;       // 서버 발급 순번 (없으면 0)
+    uint32_t id;        // 멱등 키 (없으면 0)
+    uint64_t ts;        // 서버가 보낸 시각 (epoch ms, 없으면 0). 명령 지연 측정용
+} air_command_t;
+
+typedef void (*cmd_stream_fn)(const air_command_t *cmd, void *ctx);
+
+typedef enum {
+    CMD_STREAM_OK = JSON_STREAM_OK,
+    CMD_STREAM_SYNTAX = JSON_STREAM_SYNTAX,     // 잘못된 JSON (이후 입력은 무시)
+    CMD_STREAM_TOO_DEEP = JSON_STREAM_TOO_DEEP,
+} cmd_stream_error_t;
+
+typedef struct {
+    air_command_t cmd;
+    uint8_t depth;          // 이 객체의 중첩 깊이
+    bool has_name;
+    bool bad;               // 이름이 너무 길거나 command가 문자열이 아님
+} cmd_stream_object_t;
+
+typedef struct {
+    cmd_stream_fn on_command;
+    void *ctx;
+
+    json_stream_t json;
+    char text[CMD_STREAM_TEXT_MAX];
+    cmd_stream_object_t objects[CMD_STREAM_MAX_OBJECTS];
+    uint8_t object_count;
+
+    uint8_t field;          // 현재 값이 채울 멤버 (내부용)
+    bool commands_array;    // 최상위 객체의 "commands" 배열 안 (깊이 2)
+
+    cmd_stream_error_t error;
+    uint32_t commands;      // 전달한 명령 수
+    uint32_t dropped;       // 잘못된 명령 객체 수
+} cmd_stream_t;
+
+void cmd_stream_init(cmd_stream_t *s, cmd_stream_fn on_command, void *ctx);
+
+// 오류가 나면 false를 반환하고 이후 입력은 무시한다 (이미 전달한 명령은 유효).
+bool cmd_stream_feed(cmd_stream_t *s, const char *data, size_t len);
+
+// 본문이 끝났을 때 호출. 최상위 값이 완결되었으면 true.
+bool cmd_stream_finish(cmd_stream_t *s);
+
+#ifdef __cplusplus
+}
+#endif
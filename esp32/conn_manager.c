@@ -0,0 +1,170 @@
+#include <string.h>
+
+#include "conn_manager.h"
+
+void conn_manager_init(conn_manager_t *m, const conn_ops_t *ops, const conn_config_t *cfg, uint32_t now_ms)
+{
+    memset(m, 0, sizeof(*m));
+    m->ops = *ops;
+    m->cfg = *cfg;
+    // 부팅 직후 바로 시도하며, 부팅도 첫 번째 끊김으로 계산한다
+    m->wifi.next_attempt_ms = now_ms;
+    m->wifi.down_since_ms = now_ms;
+    m->mqtt.next_attempt_ms = now_ms;
+    m->mqtt.down_since_ms = now_ms;
+}
+
+static bool due(uint32_t now_ms, uint32_t at_ms)
+{
+    return (int32_t)(now_ms - at_ms) >= 0;
+}
+
+// 지수 백오프 + 절반 지터: [b/2, b] 구간에서 무작위
+static void schedule_retry(conn_manager_t *m, conn_link_t *l, uint32_t now_ms)
+{
+    l->failures++;
+    uint32_t b = l->backoff_ms ? l->backoff_ms : m->cfg.min_ms;
+    uint32_t half = b / 2;
+    uint32_t jitter = m->ops.random ? m->ops.random(m->ops.ctx) % (half + 1) : half;
+    l->next_attempt_ms = now_ms + half + jitter;
+    l->backoff_ms = b >= m->cfg.max_ms / 2 ? m->cfg.max_ms : b * 2;
+    l->state = CONN_DOWN;
+}
+
+static void link_up(conn_link_t *l, uint32_t now_ms)
+{
+    l->state = CONN_UP;
+    l->connects++;
+    l->backoff_ms = 0;
+    l->last_outage_ms = now_ms - l->down_since_ms;
+    if (l->last_outage_ms > l->max_outage_ms) {
+        l->max_outage_ms = l->last_outage_ms;
+    }
+}
+
+// 연결이 끊긴 것을 발견: 첫 재시도는 최소 간격 후
+static void link_lost(conn_manager_t *m, conn_link_t *l, bool is_mqtt, uint32_t now_ms)
+{
+    l->state = CONN_DOWN;
+    l->down_since_ms = now_ms;
+    l->backoff_ms = 0;
+    l->next_attempt_ms = now_ms + m->cfg.min_ms / 2;
+    if (m->ops.on_down) {
+        m->ops.on_down(m->ops.ctx, is_mqtt);
+    }
+}
+
+static void tick_wifi(conn_manager_t *m, uint32_t now_ms)
+{
+    conn_link_t *l = &m->wifi;
+    bool up = m->ops.wifi_up(m->ops.ctx);
+
+    switch (l->state) {
+    case CONN_UP:
+        if (!up) {
+            link_lost(m, l, false, now_ms);
+        }
+        break;
+    case CONN_CONNECTING:
+        if (up) {
+            link_up(l, now_ms);
+            if (m->ops.on_wifi_up) {
+                m->ops.on_wifi_up(m->ops.ctx, l);
+            }
+        } else if (now_ms - l->attempt_started_ms >= m->cfg.wifi_connect_timeout_ms) {
+            schedule_retry(m, l, now_ms);
+        }
+        break;
+    case CONN_DOWN:
+        if (up) {
+            // 드라이버가 스스로 재연결한 경우
+            link_up(l, now_ms);
+            if (m->ops.on_wifi_up) {
+                m->ops.on_wifi_up(m->ops.ctx, l);
+            }
+        } else if (due(now_ms, l->next_attempt_ms)) {
+            l->attempts++;
+            l->attempt_started_ms = now_ms;
+            l->state = CONN_CONNECTING;
+            m->ops.wifi_begin(m->ops.ctx);
+        }
+        break;
+    }
+}
+
+static void tick_mqtt(conn_manager_t *m, uint32_t now_ms)
+{
+    conn_link_t *l = &m->mqtt;
+
+    if (l->state == CONN_UP) {
+        if (!conn_wifi_up(m) || !m->ops.mqtt_up(m->ops.ctx)) {
+            link_lost(m, l, true, now_ms);
+        }
+        return;
+    }
+    if (l->state == CONN_CONNECTING) {
+        // 도중에 Wi-Fi가 끊겨도 시도가 끝날 때까지 기다린다 (그동안 클라이언트는 연결 태스크 것)
+        conn_attempt_t r = m->ops.mqtt_poll(m->ops.ctx);
+        if (r == CONN_ATTEMPT_PENDING) {
+            return;
+        }
+        if (r == CONN_ATTEMPT_OK && conn_wifi_up(m)) {
+            link_up(l, now_ms);
+            if (m->ops.on_mqtt_up) {
+                m->ops.on_mqtt_up(m->ops.ctx, l);
+            }
+        } else {
+            schedule_retry(m, l, now_ms);
+        }
+        return;
+    }
+    // Wi-Fi가 없으면 시도하지 않고, Wi-Fi가 올라오면 바로 한 번 시도
+    if (!conn_wifi_up(m)) {
+        l->next_attempt_ms = now_ms;
+        return;
+    }
+    if (!due(now_ms, l->next_attempt_ms)) {
+        return;
+    }
+
+    l->attempts++;
+    l->attempt_started_ms = now_ms;
+    if (m->ops.mqtt_begin(m->ops.ctx)) {
+        l->state = CONN_CONNECTING;
+    } else {
+        schedule_retry(m, l, now_ms);
+    }
+}
+
+void conn_manager_tick(conn_manager_t *m, uint32_t now_ms)
+{
+    tick_wifi(m, now_ms);
+    tick_mqtt(m, now_ms);
+}
+
+static uint32_t until(uint32_t now_ms, uint32_t at_ms)
+{
+    return due(now_ms, at_ms) ? 0 : at_ms - now_ms;
+}
+
+uint32_t conn_manager_idle_ms(const conn_manager_t *m, uint32_t now_ms)
+{
+    uint32_t idle;
+    switch (m->wifi.state) {
+    case CONN_DOWN:
+        idle = until(now_ms, m->wifi.next_attempt_ms);
+        break;
+    case CONN_CONNECTING:
+        idle = until(now_ms, m->wifi.attempt_started_ms + m->cfg.wifi_connect_timeout_ms);
+        break;
+    case CONN_UP:
+    default:
+        idle = m->mqtt.state == CONN_DOWN ? until(now_ms, m->mqtt.next_attempt_ms) : UINT32_MAX;
+        break;
+    }
+    // 백그라운드 MQTT 시도는 Wi-Fi 상태와 상관없이 결과를 확인해야 한다
+    if (m->mqtt.state == CONN_CONNECTING && m->cfg.mqtt_poll_ms < idle) {
+        idle = m->cfg.mqtt_poll_ms;
+    }
+    return idle;
+}
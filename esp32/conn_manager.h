@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Wi-Fi / MQTT 연결 관리자 (비차단 상태 기계)
+// loop()가 conn_manager_tick()을 호출하면 각 링크의 상태를 한 단계씩 진행한다.
+// Wi-Fi와 MQTT는 상태와 백오프를 따로 가지며, MQTT는 Wi-Fi가 올라와 있을 때만 시도한다.
+// 실패할 때마다 재시도 간격을 두 배로 늘리고(상한 max_ms), 절반은 무작위 지터로 흩뜨린다.
+// MQTT 연결(DNS, TCP, CONNACK)은 mqtt_begin()이 백그라운드에서 시작하고, tick마다 mqtt_poll()로
+// 결과만 확인하므로 브로커가 응답하지 않아도 loop()는 막히지 않는다.
+// 실제 연결 동작은 콜백으로 주입하므로 하드웨어 없이도 구동할 수 있다.
+
+typedef enum {
+    CONN_DOWN = 0,      // 끊김, next_attempt_ms에 재시도
+    CONN_CONNECTING,    // 시도 중 (Wi-Fi 연결 대기 / MQTT 백그라운드 연결)
+    CONN_UP,
+} conn_state_t;
+
+typedef enum {
+    CONN_ATTEMPT_PENDING = 0,
+    CONN_ATTEMPT_OK,
+    CONN_ATTEMPT_FAILED,
+} conn_attempt_t;
+
+typedef struct {
+    conn_state_t state;
+    uint32_t backoff_ms;        // 다음 실패 시 기준 간격 (0이면 min_ms부터)
+    uint32_t next_attempt_ms;
+    uint32_t attempt_started_ms;
+    uint32_t down_since_ms;
+
+    // 통계
+    uint32_t attempts;
+    uint32_t connects;
+    uint32_t failures;
+    uint32_t last_outage_ms;    // 가장 최근 끊김부터 재연결까지 걸린 시간
+    uint32_t max_outage_ms;
+} conn_link_t;
+
+typedef struct {
+    void (*wifi_begin)(void *ctx);      // 연결 시작만 하고 바로 반환
+    bool (*wifi_up)(void *ctx);
+    bool (*mqtt_begin)(void *ctx);      // 백그라운드 연결 시작만 하고 바로 반환 (시작 못 하면 false)
+    conn_attempt_t (*mqtt_poll)(void *ctx);   // 시작한 시도의 결과. 끝날 때까지 클라이언트를 쓰지 않는다
+    bool (*mqtt_up)(void *ctx);
+    void (*on_wifi_up)(void *ctx, const conn_link_t *link);
+    void (*on_mqtt_up)(void *ctx, const conn_link_t *link);   // 재구독은 여기서 한 번
+    void (*on_down)(void *ctx, bool is_mqtt);
+    uint32_t (*random)(void *ctx);
+    void *ctx;
+} conn_ops_t;
+
+typedef struct {
+    uint32_t min_ms;
+    uint32_t max_ms;
+    uint32_t wifi_connect_timeout_ms;   // 이 시간 안에 연결되지 않으면 실패로 보고 백오프
+    uint32_t mqtt_poll_ms;              // MQTT 시도 중 결과를 확인하는 간격 (idle_ms의 상한)
+} conn_config_t;
+
+typedef struct {
+    conn_ops_t ops;
+    conn_config_t cfg;
+    conn_link_t wifi;
+    conn_link_t mqtt;
+} conn_manager_t;
+
+void conn_manager_init(conn_manager_t *m, const conn_ops_t *ops, const conn_config_t *cfg, uint32_t now_ms);
+void conn_manager_tick(conn_manager_t *m, uint32_t now_ms);
+
+// 다음 재시도/타임아웃까지 남은 시간 (ms, 할 일이 없으면 UINT32_MAX). 전력 관리자가 잠들 시간을 정할 때 쓴다.
+uint32_t conn_manager_idle_ms(const conn_manager_t *m, uint32_t now_ms);
+
+static inline bool conn_wifi_up(const conn_manager_t *m) { return m->wifi.state == CONN_UP; }
+static inline bool conn_mqtt_up(const conn_manager_t *m) { return m->mqtt.state == CONN_UP; }
+// MQTT 연결 시도가 백그라운드에서 진행 중 (클라이언트 설정을 바꾸면 안 됨)
+static inline bool conn_mqtt_connecting(const conn_manager_t *m) { return m->mqtt.state == CONN_CONNECTING; }
+// Wi-Fi가 연결되어 있거나 연결 시도 중 (라디오를 끄면 안 됨)
+static inline bool conn_wifi_active(const conn_manager_t *m) { return m->wifi.state != CONN_DOWN; }
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,75 @@
+#include <string.h>
+#include <strings.h>
+
+#include "control_handoff.h"
+
+bool control_handoff_init(control_handoff_t *h)
+{
+    memset(h, 0, sizeof(*h));
+    h->queue = hal_queue_create(CONTROL_QUEUE_DEPTH, sizeof(control_request_t));
+    return h->queue != NULL;
+}
+
+bool control_is_config(const char *command)
+{
+    return strcasecmp(command, "CONFIG") == 0;
+}
+
+control_status_t control_submit(control_handoff_t *h, control_request_t *rq, const char *body, size_t len,
+                                uint32_t timeout_ms, control_reply_t *out)
+{
+    bool config = control_is_config(rq->command);
+    if (config) {
+        if (h->config_busy || len > sizeof(h->config_body)) {
+            return CONTROL_BUSY;
+        }
+        memcpy(h->config_body, body, len);
+        h->config_len = len;
+        h->config_busy = true;
+    }
+
+    rq->seq = ++h->next_seq;
+    rq->waiter = hal_task_current();
+    if (!hal_queue_send(h->queue, rq)) {
+        if (config) {
+            h->config_busy = false;
+        }
+        return CONTROL_BUSY;
+    }
+
+    // 시간 초과된 이전 요청의 늦은 응답도 깨우므로 seq를 확인한다.
+    // 기다리는 동안 남은 시간만 기다려 늦은 응답이 여러 번 와도 timeout_ms를 넘기지 않는다.
+    uint32_t start = hal_millis();
+    while (__atomic_load_n(&h->reply.seq, __ATOMIC_ACQUIRE) != rq->seq) {
+        uint32_t waited = hal_millis() - start;
+        if (waited >= timeout_ms || !hal_task_wait(timeout_ms - waited)) {
+            return CONTROL_TIMEOUT;
+        }
+    }
+    // 제출하는 태스크가 하나이므로 loop()는 다음 요청을 받기 전까지 reply를 다시 쓰지 않는다
+    *out = h->reply;
+    return CONTROL_DONE;
+}
+
+uint32_t control_drain(control_handoff_t *h, control_exec_fn exec, void *ctx)
+{
+    control_request_t rq;
+    uint32_t n = 0;
+    while (hal_queue_receive(h->queue, &rq)) {
+        bool config = control_is_config(rq.command);
+        exec(&rq, config ? h->config_body : NULL, config ? h->config_len : 0, &h->reply, ctx);
+        if (config) {
+            h->config_busy = false;
+        }
+        __atomic_store_n(&h->reply.seq, rq.seq, __ATOMIC_RELEASE);
+        hal_task_notify(rq.waiter);
+        n++;
+    }
+    return n;
+}
+
+bool control_wait(control_handoff_t *h, uint32_t timeout_ms)
+{
+    control_request_t rq;
+    return hal_queue_peek(h->queue, &rq, timeout_ms);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "device_config.h"
+#include "esp_command_handler.h"
+#include "hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// HTTP /control 요청을 httpd 태스크에서 loop()로 넘기고 결과를 기다리는 핸드오프
+// httpd 태스크(제출하는 태스크는 하나뿐)가 control_submit()으로 요청을 큐에 넣고
+// 태스크 알림을 기다리며, loop()는 control_drain()에서 요청을 실행해 응답 슬롯에
+// 결과를 쓴 뒤 알린다. 응답은 seq로 짝을 맞추므로 시간 초과된 요청의 늦은 응답이
+// 다음 요청의 응답으로 읽히지 않는다. CONFIG 본문은 큐에 넣기에 커서 config_body에
+// 두며, config_busy 동안은 loop()가 소유하므로 한 번에 하나만 처리된다.
+
+#ifndef CONTROL_QUEUE_DEPTH
+#define CONTROL_QUEUE_DEPTH 8
+#endif
+
+#define CONTROL_BODY_MAX 768       // CONFIG JSON 본문 (HTTP 본문, MQTT payload와 같은 상한)
+
+typedef enum {
+    CONTROL_DONE = 0,              // loop()가 실행했고 reply가 채워졌다
+    CONTROL_BUSY,                  // 큐가 가득 찼거나 CONFIG가 이미 처리 중 (503)
+    CONTROL_TIMEOUT,               // 시간 안에 실행되지 않음 (504). 요청은 큐에 남아 나중에 실행될 수 있다.
+} control_status_t;
+
+typedef struct {
+    char command[32];
+    cmd_args_t args;
+    uint32_t seq;
+    hal_task_t waiter;
+} control_request_t;
+
+typedef struct {
+    uint32_t seq;                  // 마지막으로 실행한 요청 (loop()가 release로 쓴다)
+    cmd_result_t result;
+    cfg_error_t config_result;     // CONFIG 요청
+    char config_json[128];
+} control_reply_t;
+
+typedef struct {
+    hal_queue_t *queue;
+    control_reply_t reply;
+    char config_body[CONTROL_BODY_MAX];
+    size_t config_len;
+    volatile bool config_busy;
+    uint32_t next_seq;             // 제출하는 태스크만 쓴다
+} control_handoff_t;
+
+// loop()에서 요청 하나를 실행해 reply를 채운다. CONFIG면 config/config_len에 본문이 온다.
+typedef void (*control_exec_fn)(const control_request_t *rq, const char *config, size_t config_len,
+                                control_reply_t *reply, void *ctx);
+
+bool control_handoff_init(control_handoff_t *h);
+
+bool control_is_config(const char *command);
+
+// httpd 태스크: rq(command, args)를 넘기고 최대 timeout_ms 기다린다.
+// CONFIG면 body/len을 config_body로 복사한다. CONTROL_DONE이면 *out에 결과를 복사한다.
+control_status_t control_submit(control_handoff_t *h, control_request_t *rq, const char *body, size_t len,
+                                uint32_t timeout_ms, control_reply_t *out);
+
+// loop(): 쌓인 요청을 모두 실행하고 기다리는 태스크를 깨운다. 실행한 수를 반환.
+uint32_t control_drain(control_handoff_t *h, control_exec_fn exec, void *ctx);
+
+// loop()의 유휴 대기: 요청이 들어오거나 timeout_ms가 지날 때까지. 요청이 있으면 true.
+bool control_wait(control_handoff_t *h, uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,81 @@
+#include <string.h>
+
+#include "decision_engine.h"
+
+void decision_engine_init(decision_engine_t *e,
+                          const de_rule_t *rules,
+                          uint8_t rule_count,
+                          de_action_t default_action,
+                          const char *default_name,
+                          uint32_t min_dwell_ms)
+{
+    memset(e, 0, sizeof(*e));
+    e->rules = rules;
+    e->rule_count = rule_count > DE_MAX_RULES ? DE_MAX_RULES : rule_count;
+    e->default_action = default_action;
+    e->default_name = default_name;
+    e->min_dwell_ms = min_dwell_ms;
+    e->reason = -1;
+}
+
+void decision_engine_restore(decision_engine_t *e, de_action_t output, uint32_t now_ms)
+{
+    e->has_output = true;
+    e->output = output;
+    e->output_since_ms = now_ms - e->min_dwell_ms;
+}
+
+// 래치 상태를 고려한 규칙 활성 여부
+static bool rule_active(const de_rule_t *r, bool latched, const de_inputs_t *in)
+{
+    if (!in->valid[r->input]) {
+        return r->active_when_missing;
+    }
+    float v = in->value[r->input];
+    if (r->compare == DE_ABOVE) {
+        return latched ? v > r->threshold - r->hysteresis : v > r->threshold;
+    }
+    return latched ? v < r->threshold + r->hysteresis : v < r->threshold;
+}
+
+bool decision_engine_evaluate(decision_engine_t *e, const de_inputs_t *in, uint32_t now_ms, bool bypass_dwell)
+{
+    e->evaluations++;
+
+    // 래치는 dwell과 무관하게 항상 갱신
+    int8_t winner = -1;
+    for (uint8_t i = 0; i < e->rule_count; i++) {
+        e->latched[i] = rule_active(&e->rules[i], e->latched[i], in);
+        if (winner < 0 && e->latched[i]) {
+            winner = (int8_t)i;
+        }
+    }
+    de_action_t want = winner >= 0 ? e->rules[winner].action : e->default_action;
+
+    if (e->has_output && want == e->output) {
+        e->reason = winner;
+        e->pending = false;
+        return false;
+    }
+    if (e->has_output && !bypass_dwell && now_ms - e->output_since_ms < e->min_dwell_ms) {
+        e->pending = true;
+        e->suppressed++;
+        return false;
+    }
+
+    e->has_output = true;
+    e->output = want;
+    e->output_since_ms = now_ms;
+    e->reason = winner;
+    e->pending = false;
+    e->changes++;
+    return true;
+}
+
+const char *decision_engine_reason(const decision_engine_t *e)
+{
+    if (e->reason >= 0 && e->reason < e->rule_count) {
+        return e->rules[e->reason].name;
+    }
+    return e->default_name;
+}
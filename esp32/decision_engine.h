@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 창문 자동 제어 규칙 엔진
+// 규칙 테이블을 위에서부터 평가해 처음으로 활성인 규칙의 동작을 택한다(없으면 기본 동작).
+// 각 규칙은 히스테리시스 밴드로 래치되어 임계값 근처에서 흔들리지 않고,
+// 출력(창문 상태)은 최소 유지 시간(dwell)이 지나기 전에는 바뀌지 않는다.
+
+#define DE_MAX_RULES 8
+
+typedef enum {
+    DE_INPUT_PM25 = 0,
+    DE_INPUT_PM10,
+    DE_INPUT_DI,
+    DE_INPUT_COUNT,
+} de_input_t;
+
+typedef enum {
+    DE_ABOVE = 0,   // value > threshold 이면 활성, threshold - hysteresis 아래로 내려가야 해제
+    DE_BELOW,       // value < threshold 이면 활성, threshold + hysteresis 위로 올라가야 해제
+} de_compare_t;
+
+typedef enum {
+    DE_WINDOW_CLOSE = 0,
+    DE_WINDOW_OPEN  = 1,
+} de_action_t;
+
+typedef struct {
+    const char *name;
+    de_input_t input;
+    de_compare_t compare;
+    float threshold;
+    float hysteresis;
+    de_action_t action;
+    bool active_when_missing;   // 입력이 없을 때(센서 무효) 활성으로 볼지
+} de_rule_t;
+
+typedef struct {
+    float value[DE_INPUT_COUNT];
+    bool valid[DE_INPUT_COUNT];
+} de_inputs_t;
+
+typedef struct {
+    // 설정
+    const de_rule_t *rules;
+    uint8_t rule_count;
+    de_action_t default_action;
+    const char *default_name;
+    uint32_t min_dwell_ms;
+
+    // 상태
+    bool latched[DE_MAX_RULES];
+    bool has_output;
+    de_action_t output;
+    uint32_t output_since_ms;
+    int8_t reason;              // 출력을 결정한 규칙 인덱스, -1이면 기본 동작
+    bool pending;               // dwell 때문에 보류된 변경이 있음
+
+    // 통계
+    uint32_t evaluations;
+    uint32_t changes;
+    uint32_t suppressed;        // dwell로 보류된 평가 수
+} decision_engine_t;
+
+void decision_engine_init(decision_engine_t *e,
+                          const de_rule_t *rules,
+                          uint8_t rule_count,
+                          de_action_t default_action,
+                          const char *default_name,
+                          uint32_t min_dwell_ms);
+
+// 재시작 전의 출력을 되살린다. 같은 결론이면 다시 명령하지 않으므로 수동 명령이 유지되고,
+// dwell은 이미 지난 것으로 보아 조건이 바뀌었으면 첫 평가에서 바로 반영한다.
+void decision_engine_restore(decision_engine_t *e, de_action_t output, uint32_t now_ms);
+
+// 입력으로 규칙을 다시 평가. 출력이 바뀌었으면 true.
+// bypass_dwell이면 최소 유지 시간을 무시한다 (벌레 감지 해제 직후 등 강제 재평가용).
+bool decision_engine_evaluate(decision_engine_t *e, const de_inputs_t *in, uint32_t now_ms, bool bypass_dwell);
+
+const char *decision_engine_reason(const decision_engine_t *e);
+
+#ifdef __cplusplus
+}
+#endif
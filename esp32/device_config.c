@@ -0,0 +1,505 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "device_config.h"
+#include "json_stream.h"
+
+#define CFG_MAGIC 0x4643u       // "CF"
+
+static const char *const CFG_KEYS[2] = { "cfg0", "cfg1" };
+
+typedef enum {
+    F_FLOAT = 0,
+    F_U32,
+    F_U16,
+    F_TEXT,     // 길이만 검사 (min = 최소 길이)
+    F_PSK,      // 비어 있거나 WPA2 길이 (8~64)
+    F_HOST,     // 공백/제어 문자 없음
+    F_TOPIC,    // 와일드카드 없음, '/'로 시작/끝나지 않음
+    F_URL,      // http(s)://, 변환은 %s 하나까지 (snprintf 형식으로 쓰인다)
+} field_type_t;
+
+typedef struct {
+    const char *name;
+    uint8_t type;
+    uint8_t apply;              // cfg_apply_t
+    uint16_t offset;
+    uint16_t size;
+    float min, max;
+} cfg_field_t;
+
+#define FIELD(f, type, apply, min, max) \
+    { #f, type, apply, offsetof(air_config_t, f), sizeof(((air_config_t *)0)->f), min, max }
+
+// 갱신 경로에서만 찾으므로 선형 탐색
+static const cfg_field_t s_fields[] = {
+    FIELD(pm25_close,         F_FLOAT, CFG_APPLY_DECISION, 1, 500),
+    FIELD(pm10_close,         F_FLOAT, CFG_APPLY_DECISION, 1, 1000),
+    FIELD(di_comfort,         F_FLOAT, CFG_APPLY_DECISION, 50, 90),
+    FIELD(decision_dwell_ms,  F_U32,   CFG_APPLY_DECISION, 0, 3600000),
+    FIELD(pump_ms,            F_U32,   CFG_APPLY_PUMP,     100, 60000),
+    FIELD(servo_velocity_dps, F_FLOAT, CFG_APPLY_SERVO,    5, 180),
+    FIELD(servo_accel_dps2,   F_FLOAT, CFG_APPLY_SERVO,    0, 1000),
+    FIELD(wifi_ssid,          F_TEXT,  CFG_APPLY_WIFI,     1, 0),
+    FIELD(wifi_password,      F_PSK,   CFG_APPLY_WIFI,     0, 0),
+    FIELD(mqtt_host,          F_HOST,  CFG_APPLY_MQTT,     1, 0),
+    FIELD(mqtt_port,          F_U16,   CFG_APPLY_MQTT,     1, 65535),
+    FIELD(mqtt_user,          F_TEXT,  CFG_APPLY_MQTT,     0, 0),
+    FIELD(mqtt_password,      F_TEXT,  CFG_APPLY_MQTT,     0, 0),
+    FIELD(topic_root,         F_TOPIC, CFG_APPLY_MQTT,     1, 0),
+    FIELD(post_url,           F_URL,   CFG_APPLY_HTTP,     0, 0),
+    FIELD(pull_url,           F_URL,   CFG_APPLY_HTTP,     0, 0),
+    FIELD(mqtt_legacy,        F_U16,   CFG_APPLY_MQTT,     0, 1),
+};
+
+#define FIELD_COUNT (sizeof(s_fields) / sizeof(s_fields[0]))
+
+// 저장 형식: 헤더 + air_config_t(size 바이트) + CRC-32(앞의 모든 바이트)
+typedef struct {
+    uint16_t magic;
+    uint8_t schema;
+    uint8_t reserved;
+    uint16_t size;              // 저장 당시 sizeof(air_config_t)
+    uint16_t reserved2;
+    uint32_t rev;
+} cfg_header_t;
+
+#define CFG_RECORD_MAX (sizeof(cfg_header_t) + sizeof(air_config_t) + sizeof(uint32_t))
+
+static const cfg_field_t *find(const char *name)
+{
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        if (strcmp(s_fields[i].name, name) == 0) {
+            return &s_fields[i];
+        }
+    }
+    return NULL;
+}
+
+static bool is_text(const cfg_field_t *f)
+{
+    return f->type >= F_TEXT;
+}
+
+static bool plain_chars(const char *s)
+{
+    for (; *s; s++) {
+        if ((unsigned char)*s <= ' ' || *s == 0x7f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 장치 ID 자리의 %s 하나와 %%만 허용
+static bool url_ok(const char *s)
+{
+    if (strncmp(s, "http://", 7) != 0 && strncmp(s, "https://", 8) != 0) {
+        return false;
+    }
+    int conversions = 0;
+    for (const char *p = s; *p; p++) {
+        if (*p != '%') {
+            continue;
+        }
+        p++;
+        if (*p == 's') {
+            conversions++;
+        } else if (*p != '%') {
+            return false;
+        }
+    }
+    return conversions <= 1 && plain_chars(s);
+}
+
+static bool topic_ok(const char *s)
+{
+    size_t n = strlen(s);
+    return n > 0 && s[0] != '/' && s[n - 1] != '/' && strpbrk(s, "+#") == NULL && plain_chars(s);
+}
+
+static cfg_error_t check_text(const cfg_field_t *f, const char *s)
+{
+    size_t n = strlen(s);
+    if (n >= f->size || n < (size_t)f->min) {
+        return CFG_ERR_RANGE;
+    }
+    switch (f->type) {
+    case F_PSK:
+        return n == 0 || n >= 8 ? CFG_OK : CFG_ERR_RANGE;
+    case F_HOST:
+        return plain_chars(s) ? CFG_OK : CFG_ERR_FORMAT;
+    case F_TOPIC:
+        return topic_ok(s) ? CFG_OK : CFG_ERR_FORMAT;
+    case F_URL:
+        return url_ok(s) ? CFG_OK : CFG_ERR_FORMAT;
+    default:
+        return CFG_OK;
+    }
+}
+
+static cfg_error_t check_number(const cfg_field_t *f, double v)
+{
+    if (isnan(v) || v < f->min || v > f->max) {
+        return CFG_ERR_RANGE;
+    }
+    if (f->type != F_FLOAT && v != floor(v)) {
+        return CFG_ERR_TYPE;
+    }
+    return CFG_OK;
+}
+
+static double get_number(const air_config_t *c, const cfg_field_t *f)
+{
+    const uint8_t *p = (const uint8_t *)c + f->offset;
+    switch (f->type) {
+    case F_FLOAT: { float v; memcpy(&v, p, sizeof(v)); return v; }
+    case F_U32:   { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+    default:      { uint16_t v; memcpy(&v, p, sizeof(v)); return v; }
+    }
+}
+
+// 모든 필드 검사 (로드한 레코드에도 쓴다)
+static cfg_error_t validate(const air_config_t *c, const char **field)
+{
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        const cfg_field_t *f = &s_fields[i];
+        const char *text = (const char *)c + f->offset;
+        cfg_error_t e;
+        if (!is_text(f)) {
+            e = check_number(f, get_number(c, f));
+        } else if (memchr(text, '\0', f->size) == NULL) {
+            e = CFG_ERR_RANGE;
+        } else {
+            e = check_text(f, text);
+        }
+        if (e != CFG_OK) {
+            *field = f->name;
+            return e;
+        }
+    }
+    return CFG_OK;
+}
+
+static uint32_t diff(const air_config_t *a, const air_config_t *b)
+{
+    uint32_t changed = 0;
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        const cfg_field_t *f = &s_fields[i];
+        const char *x = (const char *)a + f->offset;
+        const char *y = (const char *)b + f->offset;
+        if (is_text(f) ? strcmp(x, y) != 0 : memcmp(x, y, f->size) != 0) {
+            changed |= f->apply;
+        }
+    }
+    return changed;
+}
+
+void cfg_init(config_store_t *cfg, const ds_ops_t *ops, const air_config_t *defaults)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->ops = *ops;
+    cfg->defaults = *defaults;
+    cfg->live = *defaults;
+}
+
+// 1: 유효 (*out에 기본값 위로 덮은 설정), 0: 있지만 손상/무효, -1: 없음
+static int load(const config_store_t *cfg, int slot, air_config_t *out, uint32_t *rev)
+{
+    uint8_t buf[CFG_RECORD_MAX];
+    int n = cfg->ops.read(cfg->ops.ctx, CFG_KEYS[slot], buf, sizeof(buf));
+    if (n < 0) {
+        return -1;
+    }
+    cfg_header_t h;
+    if (n < (int)(sizeof(h) + sizeof(uint32_t))) {
+        return 0;
+    }
+    memcpy(&h, buf, sizeof(h));
+    size_t body = (size_t)n - sizeof(h) - sizeof(uint32_t);
+    uint32_t crc;
+    memcpy(&crc, buf + n - sizeof(crc), sizeof(crc));
+    if (h.magic != CFG_MAGIC || h.schema != CFG_SCHEMA || h.size != body || body > sizeof(air_config_t) ||
+        crc != ds_crc32(buf, (size_t)n - sizeof(crc))) {
+        return 0;
+    }
+    // 이전 펌웨어가 쓴 짧은 레코드: 뒤에 추가된 필드는 기본값
+    *out = cfg->defaults;
+    memcpy(out, buf + sizeof(h), body);
+    const char *field;
+    if (validate(out, &field) != CFG_OK) {
+        return 0;
+    }
+    *rev = h.rev;
+    return 1;
+}
+
+ds_restore_t cfg_load(config_store_t *cfg)
+{
+    air_config_t c[2];
+    uint32_t rev[2] = { 0, 0 };
+    int st[2] = { load(cfg, 0, &c[0], &rev[0]), load(cfg, 1, &c[1], &rev[1]) };
+    if (st[0] != 1 && st[1] != 1) {
+        return DS_RESTORE_NONE;
+    }
+    int best = st[0] != 1 ? 1 : st[1] != 1 ? 0 : (int32_t)(rev[1] - rev[0]) > 0 ? 1 : 0;
+    cfg->live = c[best];
+    cfg->rev = rev[best];
+    return st[best ^ 1] == 0 ? DS_RESTORE_FALLBACK : DS_RESTORE_LATEST;
+}
+
+static bool save(const config_store_t *cfg, const air_config_t *c, uint32_t rev)
+{
+    uint8_t buf[CFG_RECORD_MAX];
+    cfg_header_t h;
+    memset(&h, 0, sizeof(h));
+    h.magic = CFG_MAGIC;
+    h.schema = CFG_SCHEMA;
+    h.size = sizeof(air_config_t);
+    h.rev = rev;
+    memcpy(buf, &h, sizeof(h));
+    memcpy(buf + sizeof(h), c, sizeof(*c));
+    uint32_t crc = ds_crc32(buf, sizeof(h) + sizeof(*c));
+    memcpy(buf + sizeof(h) + sizeof(*c), &crc, sizeof(crc));
+    // 직전 리비전이 든 사본은 건드리지 않는다
+    return cfg->ops.write(cfg->ops.ctx, CFG_KEYS[rev & 1], buf, sizeof(buf));
+}
+
+cfg_error_t cfg_set_number(air_config_t *staged, const char *name, double value)
+{
+    const cfg_field_t *f = find(name);
+    if (f == NULL) {
+        return CFG_ERR_UNKNOWN;
+    }
+    if (is_text(f)) {
+        return CFG_ERR_TYPE;
+    }
+    cfg_error_t e = check_number(f, value);
+    if (e != CFG_OK) {
+        return e;
+    }
+    uint8_t *p = (uint8_t *)staged + f->offset;
+    switch (f->type) {
+    case F_FLOAT: { float v = (float)value; memcpy(p, &v, sizeof(v)); break; }
+    case F_U32:   { uint32_t v = (uint32_t)value; memcpy(p, &v, sizeof(v)); break; }
+    default:      { uint16_t v = (uint16_t)value; memcpy(p, &v, sizeof(v)); break; }
+    }
+    return CFG_OK;
+}
+
+cfg_error_t cfg_set_text(air_config_t *staged, const char *name, const char *value)
+{
+    const cfg_field_t *f = find(name);
+    if (f == NULL) {
+        return CFG_ERR_UNKNOWN;
+    }
+    if (!is_text(f)) {
+        return CFG_ERR_TYPE;
+    }
+    cfg_error_t e = check_text(f, value);
+    if (e != CFG_OK) {
+        return e;
+    }
+    char *p = (char *)staged + f->offset;
+    memset(p, 0, f->size);
+    memcpy(p, value, strlen(value));
+    return CFG_OK;
+}
+
+cfg_error_t cfg_commit(config_store_t *cfg, const air_config_t *staged, uint32_t expect_rev, cfg_result_t *out)
+{
+    cfg_result_t r = { CFG_OK, NULL, cfg->rev, 0 };
+    if (expect_rev != 0 && expect_rev != cfg->rev) {
+        r.error = CFG_ERR_CONFLICT;
+    } else {
+        r.error = validate(staged, &r.field);
+    }
+    if (r.error == CFG_OK) {
+        r.changed = diff(&cfg->live, staged);
+    }
+    if (r.changed) {
+        // 저장이 끝난 설정만 라이브가 된다: 재시작 후에도 같은 설정
+        if (!save(cfg, staged, cfg->rev + 1)) {
+            r.error = CFG_ERR_STORAGE;
+            r.changed = 0;
+        } else {
+            cfg->live = *staged;
+            cfg->rev++;
+            cfg->commits++;
+            r.rev = cfg->rev;
+        }
+    }
+    if (r.error != CFG_OK) {
+        cfg->rejects++;
+    }
+    if (out) {
+        *out = r;
+    }
+    return r.error;
+}
+
+// ---------- 갱신 메시지 (JSON) ----------
+// json_stream.c의 이벤트를 따라 읽는다: 값은 문자열/숫자만 쓰고 나머지는 구조만 확인하며 건너뛴다.
+#define CFG_TEXT_MAX 160        // 가장 긴 필드(URL 128)보다 크다
+
+enum { MEMBER_OTHER = 0, MEMBER_CONFIG, MEMBER_REV, MEMBER_SIG };
+
+typedef struct {
+    air_config_t *staged;
+    uint32_t allowed;
+    cfg_update_t *out;
+    const char *json;
+    cfg_error_t error;          // 첫 오류. 그 뒤의 이벤트는 무시한다
+    uint8_t member;             // 지금 값이 오는 최상위 멤버
+    bool in_config;             // "config" 객체 안 (깊이 2)
+    bool has_config;
+    char name[24];              // 지금 값이 오는 "config" 멤버 (어떤 필드 이름보다 길면 빈 문자열: 모르는 필드)
+} cfg_parse_t;
+
+static bool key_is(const json_stream_t *j, const char *key)
+{
+    return j->text_len == strlen(key) && strcmp(j->text, key) == 0;
+}
+
+// 숫자 하나 (strtod가 토큰 전체를 읽어야 한다)
+static bool token_number(const json_stream_t *j, double *out)
+{
+    char *end;
+    if (j->text[0] != '-' && (j->text[0] < '0' || j->text[0] > '9')) {
+        return false;
+    }
+    *out = strtod(j->text, &end);
+    return *end == '\0';
+}
+
+// "config" 멤버 하나의 값: staged에 쓴다
+static cfg_error_t config_member(cfg_parse_t *p, const json_stream_t *j, json_event_t ev)
+{
+    const cfg_field_t *f = find(p->name);
+    p->out->field = f ? f->name : NULL;
+    if (f && !(f->apply & p->allowed)) {
+        return CFG_ERR_LOCAL_ONLY;
+    }
+    if (ev == JSON_EV_STRING) {
+        if (j->text_len >= CFG_TEXT_MAX) {
+            return f ? CFG_ERR_RANGE : CFG_ERR_UNKNOWN;
+        }
+        return cfg_set_text(p->staged, p->name, j->text);
+    }
+    double v;
+    if (ev == JSON_EV_TOKEN && token_number(j, &v)) {
+        return cfg_set_number(p->staged, p->name, v);
+    }
+    if (ev == JSON_EV_TOKEN && j->text[0] >= 'a' && j->text[0] <= 'z') {
+        return f ? CFG_ERR_TYPE : CFG_ERR_UNKNOWN;      // true/false/null
+    }
+    if (ev == JSON_EV_TOKEN) {
+        return CFG_ERR_FORMAT;      // 숫자 모양이지만 숫자가 아님 ("1.2.3")
+    }
+    return f ? CFG_ERR_TYPE : CFG_ERR_UNKNOWN;          // 객체/배열
+}
+
+// 최상위 멤버 하나의 값. 깊이 1의 문자열/토큰, 또는 깊이 2에서 열린 컨테이너
+static cfg_error_t top_member(cfg_parse_t *p, const json_stream_t *j, json_event_t ev)
+{
+    double v;
+    switch (p->member) {
+    case MEMBER_CONFIG:
+        if (ev != JSON_EV_OBJECT) {
+            return CFG_ERR_FORMAT;
+        }
+        p->in_config = true;
+        p->out->config = p->json + j->pos;
+        return CFG_OK;
+    case MEMBER_REV:
+        if (ev != JSON_EV_TOKEN || !token_number(j, &v) || v < 0 || v > UINT32_MAX || v != floor(v)) {
+            return CFG_ERR_FORMAT;
+        }
+        p->out->rev = (uint32_t)v;
+        return CFG_OK;
+    case MEMBER_SIG:
+        if (ev != JSON_EV_STRING || j->text_len >= sizeof(p->out->sig)) {
+            return CFG_ERR_FORMAT;
+        }
+        memcpy(p->out->sig, j->text, (size_t)j->text_len + 1);
+        return CFG_OK;
+    default:
+        return CFG_OK;
+    }
+}
+
+static void parse_event(json_stream_t *j, json_event_t ev, void *ctx)
+{
+    cfg_parse_t *p = (cfg_parse_t *)ctx;
+    bool container = ev == JSON_EV_OBJECT || ev == JSON_EV_ARRAY;
+    bool scalar = ev == JSON_EV_STRING || ev == JSON_EV_TOKEN;
+    if (p->error != CFG_OK) {
+        return;
+    }
+    if (j->depth == 0 || (j->depth == 1 && ev == JSON_EV_ARRAY)) {
+        p->error = CFG_ERR_FORMAT;      // 최상위는 객체여야 한다
+    } else if (j->depth == 1 && ev == JSON_EV_KEY) {
+        p->member = key_is(j, "config") ? MEMBER_CONFIG : key_is(j, "rev") ? MEMBER_REV
+                    : key_is(j, "sig") ? MEMBER_SIG : MEMBER_OTHER;
+    } else if ((j->depth == 1 && scalar) || (j->depth == 2 && container)) {
+        p->error = top_member(p, j, ev);
+    } else if (!p->in_config) {
+        return;
+    } else if (j->depth == 2 && ev == JSON_EV_END) {
+        p->out->config_len = (size_t)(p->json + j->pos + 1 - p->out->config);
+        p->out->field = NULL;
+        p->in_config = false;
+        p->has_config = true;
+    } else if (j->depth == 2 && ev == JSON_EV_KEY) {
+        bool fits = j->text_len < sizeof(p->name);
+        memcpy(p->name, fits ? j->text : "", fits ? (size_t)j->text_len + 1 : 1);
+    } else if (p->staged && ((j->depth == 2 && scalar) || (j->depth == 3 && container))) {
+        p->error = config_member(p, j, ev);
+    }
+}
+
+cfg_error_t cfg_parse_update(air_config_t *staged, const char *json, size_t len, uint32_t allowed, cfg_update_t *out)
+{
+    cfg_parse_t p;
+    json_stream_t js;
+    char text[CFG_TEXT_MAX];
+    memset(&p, 0, sizeof(p));
+    p.staged = staged;
+    p.allowed = allowed;
+    p.out = out;
+    p.json = json;
+    out->rev = 0;
+    out->field = NULL;
+    out->config = NULL;
+    out->config_len = 0;
+    out->sig[0] = '\0';
+    json_stream_init(&js, text, sizeof(text), parse_event, &p);
+    bool ok = json_stream_feed(&js, json, len) && json_stream_finish(&js);
+    if (p.error != CFG_OK) {
+        return p.error;
+    }
+    return ok && p.has_config ? CFG_OK : CFG_ERR_FORMAT;
+}
+
+const char *cfg_field_name(const char *name)
+{
+    const cfg_field_t *f = find(name);
+    return f ? f->name : NULL;
+}
+
+const char *cfg_error_name(cfg_error_t error)
+{
+    switch (error) {
+    case CFG_OK:              return "OK";
+    case CFG_ERR_UNKNOWN:     return "UNKNOWN_FIELD";
+    case CFG_ERR_TYPE:        return "BAD_TYPE";
+    case CFG_ERR_RANGE:       return "OUT_OF_RANGE";
+    case CFG_ERR_FORMAT:      return "BAD_FORMAT";
+    case CFG_ERR_CONFLICT:    return "CONFLICT";
+    case CFG_ERR_STORAGE:     return "STORAGE";
+    case CFG_ERR_LOCAL_ONLY:  return "LOCAL_ONLY";
+    case CFG_ERR_AUTH:        return "UNAUTHORIZED";
+    }
+    return "?";
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "durable_state.h"  // ds_ops_t, ds_restore_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 현장 설정 (재플래시 없이 바꾸는 값)
+// 타입이 정해진 고정 크기 구조체 하나이며, 이름으로 찾는 필드 테이블로 갱신한다.
+// 갱신은 트랜잭션이다: 현재 설정을 복사한 사본(staged)에 필드를 쓰고, cfg_commit()이 전체를 검증해
+// NVS에 쓴 다음에만 라이브 설정(cfg->live)에 한 번에 복사한다. 하나라도 틀리면 아무것도 바뀌지 않는다.
+// 핫 패스는 cfg->live의 필드를 직접 읽으므로 접근 비용이 없다 (이름 조회는 갱신 경로에서만).
+// 레코드는 durable_state와 같은 방식으로 두 키("cfg0"/"cfg1")에 번갈아 쓰고 리비전과 CRC로 검증한다.
+// 필드는 구조체 끝에만 추가한다: 이전 펌웨어의 짧은 레코드는 앞부분만 읽고 나머지는 기본값을 쓴다.
+// 호환되지 않게 바꿀 때만 CFG_SCHEMA를 올린다 (이전 레코드는 버리고 기본값으로 시작).
+// loop() 컨텍스트(단일 태스크)에서만 호출한다.
+
+#define CFG_SCHEMA 1
+
+typedef struct {
+    // 판단 규칙 (decision_engine)
+    float pm25_close;           // PM2.5가 넘으면 닫기 (µg/m³)
+    float pm10_close;
+    float di_comfort;           // 불쾌지수가 이보다 낮으면 닫기 (환기 불필요)
+    uint32_t decision_dwell_ms; // 자동 판단 출력의 최소 유지 시간
+
+    // 액추에이터
+    uint32_t pump_ms;           // 펌프 1회 분사 시간
+    float servo_velocity_dps;   // 창문 서보 최대 각속도
+    float servo_accel_dps2;     // 가감속, 0이면 등속
+
+    // 네트워크
+    char wifi_ssid[33];
+    char wifi_password[65];     // 비어 있으면 개방 AP
+    char mqtt_host[64];
+    uint16_t mqtt_port;
+    char mqtt_user[32];
+    char mqtt_password[64];
+    char topic_root[24];        // <root>/<장치 ID>/+, <root>/all/+
+
+    // HTTP 엔드포인트 (%s 자리에 장치 ID)
+    char post_url[128];
+    char pull_url[128];
+
+    // 1이면 예전 공용 토픽(<root>/<leaf>)도 받는다. 공용 토픽은 같은 브로커의 모든 노드가 받으므로
+    // 예전 앱/감지기를 쓰는 노드 하나에만 켠다.
+    uint16_t mqtt_legacy;
+} air_config_t;
+
+// 바뀐 필드가 영향을 주는 곳 (cfg_result_t.changed 비트)
+typedef enum {
+    CFG_APPLY_DECISION = 1 << 0,
+    CFG_APPLY_PUMP     = 1 << 1,
+    CFG_APPLY_SERVO    = 1 << 2,
+    CFG_APPLY_WIFI     = 1 << 3,    // 다시 연결해야 적용
+    CFG_APPLY_MQTT     = 1 << 4,    // 다시 연결해야 적용 (토픽 포함)
+    CFG_APPLY_HTTP     = 1 << 5,
+} cfg_apply_t;
+
+typedef enum {
+    CFG_OK = 0,
+    CFG_ERR_UNKNOWN,            // 없는 필드
+    CFG_ERR_TYPE,               // 숫자 자리에 문자열 등
+    CFG_ERR_RANGE,              // 숫자 범위 또는 문자열 길이 밖
+    CFG_ERR_FORMAT,             // URL/토픽 형식
+    CFG_ERR_CONFLICT,           // 기대한 리비전이 현재와 다름 (다른 갱신이 먼저 적용됨)
+    CFG_ERR_STORAGE,            // NVS 쓰기 실패 (적용하지 않음)
+    CFG_ERR_LOCAL_ONLY,         // 이 경로로는 바꿀 수 없는 필드 (네트워크/URL은 로컬 /control만)
+    CFG_ERR_AUTH,               // 서명이 없거나 맞지 않음
+} cfg_error_t;
+
+typedef struct {
+    cfg_error_t error;
+    const char *field;          // 실패한 필드 이름 (없으면 NULL)
+    uint32_t rev;               // 적용 후 (실패면 현재) 리비전
+    uint32_t changed;           // cfg_apply_t 비트, 0이면 바뀐 값 없음 (쓰지 않음)
+} cfg_result_t;
+
+typedef struct {
+    ds_ops_t ops;
+    air_config_t live;          // 현재 설정. 읽기 전용으로 쓴다.
+    air_config_t defaults;
+    uint32_t rev;               // 적용된 리비전, 0이면 저장된 설정 없음 (기본값)
+
+    // 통계
+    uint32_t commits;
+    uint32_t rejects;
+} config_store_t;
+
+void cfg_init(config_store_t *cfg, const ds_ops_t *ops, const air_config_t *defaults);
+
+// 저장된 설정을 읽어 cfg->live에 적용. 없거나 검증에 실패하면 기본값을 유지한다.
+ds_restore_t cfg_load(config_store_t *cfg);
+
+// 필드 하나를 staged에 쓴다 (범위/형식 검사 포함). 문자열은 잘리지 않고 거부된다.
+cfg_error_t cfg_set_number(air_config_t *staged, const char *name, double value);
+cfg_error_t cfg_set_text(air_config_t *staged, const char *name, const char *value);
+
+// 갱신 메시지 {"config":{"pump_ms":2000,"mqtt_host":"10.0.0.2"},"rev":4,"sig":"..."}를 읽는다.
+// "config" 객체의 멤버(문자열 또는 숫자)를 차례로 cfg_set_text/cfg_set_number로 staged에 쓰고,
+// 다른 최상위 멤버("command" 등)는 건너뛴다. 실패하면 그 자리에서 멈추고 field에 필드 이름을 남긴다.
+// allowed(cfg_apply_t 비트)에 없는 필드는 CFG_ERR_LOCAL_ONLY로 거부한다.
+// staged가 NULL이면 아무것도 쓰지 않고 구조만 읽는다 (서명 확인 전에 config/sig 위치를 얻을 때).
+typedef struct {
+    uint32_t rev;               // "rev" (없으면 0: 리비전 검사 없음)
+    const char *field;          // 실패한 필드의 정적 이름 (없거나 모르는 필드면 NULL)
+    const char *config;         // json 안의 "config" 객체 원문 (서명 대상)
+    size_t config_len;
+    char sig[65];               // "sig" (HMAC-SHA256 16진, 없으면 빈 문자열)
+} cfg_update_t;
+
+cfg_error_t cfg_parse_update(air_config_t *staged, const char *json, size_t len, uint32_t allowed, cfg_update_t *out);
+
+// staged 전체를 검증하고 저장한 뒤 라이브로 바꾼다.
+// expect_rev가 0이 아니면 현재 리비전과 같을 때만 적용한다 (읽고-고치고-쓰기 경합 방지).
+cfg_error_t cfg_commit(config_store_t *cfg, const air_config_t *staged, uint32_t expect_rev, cfg_result_t *out);
+
+// 테이블에 있는 필드의 정적 이름 (로그/응답용), 없으면 NULL
+const char *cfg_field_name(const char *name);
+
+const char *cfg_error_name(cfg_error_t error);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,260 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dlog.h"
+
+#define DLOG_MASK (DLOG_RING_SIZE - 1)
+
+volatile uint8_t dlog_levels[DLOG_MOD_COUNT] = {
+    DLOG_DEBUG, DLOG_DEBUG, DLOG_DEBUG, DLOG_DEBUG, DLOG_DEBUG, DLOG_DEBUG,
+};
+
+static const char *const s_module_names[DLOG_MOD_COUNT] = {
+    [DLOG_MOD_SYS]    = "SYS",
+    [DLOG_MOD_NET]    = "NET",
+    [DLOG_MOD_HTTP]   = "HTTP",
+    [DLOG_MOD_CTRL]   = "CTRL",
+    [DLOG_MOD_SENSOR] = "SENSOR",
+    [DLOG_MOD_CMD]    = "CMD",
+};
+
+static const char s_level_chars[] = "-EWID";
+
+// 유한 링 MPMC 큐 (Vyukov): 슬롯의 seq로 생산자/소비자 차례를 구분
+static dlog_record_t s_ring[DLOG_RING_SIZE];
+static uint32_t s_head;   // 생산자가 CAS로 차지
+static uint32_t s_tail;   // 소비자 전용
+static uint32_t s_dropped;
+static dlog_clock_fn s_clock;
+
+void dlog_init(dlog_clock_fn clock_ms)
+{
+    s_clock = clock_ms;
+    s_head = 0;
+    s_tail = 0;
+    s_dropped = 0;
+    for (uint32_t i = 0; i < DLOG_RING_SIZE; i++) {
+        s_ring[i].seq = i;
+    }
+}
+
+void dlog_set_level(dlog_module_t module, uint8_t level)
+{
+    if (module < DLOG_MOD_COUNT) {
+        dlog_levels[module] = level;
+    }
+}
+
+// 포맷 문자열을 훑어 변환 문자를 차례로 돌려준다 (없으면 0)
+static char next_conversion(const char **p, bool *is_long_long)
+{
+    const char *s = *p;
+    while (*s) {
+        if (*s++ != '%') {
+            continue;
+        }
+        if (*s == '%') {
+            s++;
+            continue;
+        }
+        while (*s && strchr("-+ #0123456789.", *s)) {
+            s++;
+        }
+        int longs = 0;
+        while (*s && strchr("hlzjtL", *s)) {
+            longs += *s == 'l';
+            s++;
+        }
+        if (*s == '\0') {
+            break;
+        }
+        *is_long_long = longs >= 2;
+        *p = s + 1;
+        return *s;
+    }
+    *p = s;
+    return 0;
+}
+
+static uintptr_t float_bits(double d)
+{
+    float f = (float)d;
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+static double bits_float(uintptr_t v)
+{
+    uint32_t bits = (uint32_t)v;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+void dlog_write(dlog_module_t module, uint8_t level, const char *fmt, ...)
+{
+    uint32_t pos = __atomic_load_n(&s_head, __ATOMIC_RELAXED);
+    dlog_record_t *slot;
+    for (;;) {
+        slot = &s_ring[pos & DLOG_MASK];
+        uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&s_head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            __atomic_fetch_add(&s_dropped, 1, __ATOMIC_RELAXED);   // 가득 참
+            return;
+        } else {
+            pos = __atomic_load_n(&s_head, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->timestamp_ms = s_clock ? s_clock() : 0;
+    slot->fmt = fmt;
+    slot->module = (uint8_t)module;
+    slot->level = level;
+
+    va_list ap;
+    va_start(ap, fmt);
+    const char *p = fmt;
+    uint8_t n = 0;
+    bool ll = false;
+    char c;
+    while (n < DLOG_MAX_ARGS && (c = next_conversion(&p, &ll)) != 0) {
+        switch (c) {
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+            slot->args[n++] = float_bits(va_arg(ap, double));
+            break;
+        case 's': case 'p':
+            slot->args[n++] = (uintptr_t)va_arg(ap, const void *);
+            break;
+        default:
+            slot->args[n++] = ll ? (uintptr_t)va_arg(ap, long long) : (uintptr_t)va_arg(ap, unsigned int);
+            break;
+        }
+    }
+    va_end(ap);
+    slot->nargs = n;
+
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+bool dlog_pop(dlog_record_t *out)
+{
+    dlog_record_t *slot = &s_ring[s_tail & DLOG_MASK];
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != s_tail + 1) {
+        return false;
+    }
+    *out = *slot;
+    __atomic_store_n(&slot->seq, s_tail + DLOG_RING_SIZE, __ATOMIC_RELEASE);
+    s_tail++;
+    return true;
+}
+
+uint32_t dlog_dropped(void)
+{
+    return __atomic_load_n(&s_dropped, __ATOMIC_RELAXED);
+}
+
+int dlog_format(const dlog_record_t *r, char *out, size_t cap)
+{
+    if (cap < 2) {
+        return -1;
+    }
+    int w = snprintf(out, cap, "[%8lu] %c %-6s ",
+                     (unsigned long)r->timestamp_ms,
+                     r->level < sizeof(s_level_chars) - 1 ? s_level_chars[r->level] : '?',
+                     r->module < DLOG_MOD_COUNT ? s_module_names[r->module] : "?");
+    size_t pos = (w > 0 && (size_t)w < cap) ? (size_t)w : cap - 1;
+
+    // 변환 지정자 하나씩 잘라서 해당 인자 타입으로 snprintf
+    const char *p = r->fmt;
+    uint8_t i = 0;
+    while (*p && pos < cap - 1) {
+        const char *spec = strchr(p, '%');
+        const char *lit_end = spec ? spec : p + strlen(p);
+        size_t lit = (size_t)(lit_end - p);
+        if (lit > cap - 1 - pos) lit = cap - 1 - pos;
+        memcpy(out + pos, p, lit);
+        pos += lit;
+        if (!spec) {
+            break;
+        }
+
+        if (spec[1] == '%') {
+            out[pos++] = '%';
+            p = spec + 2;
+            continue;
+        }
+        const char *q = spec;
+        bool ll = false;
+        char c = next_conversion(&q, &ll);
+        if (c == 0 || q - spec >= 16) {
+            break;
+        }
+
+        char one[16];
+        memcpy(one, spec, (size_t)(q - spec));
+        one[q - spec] = '\0';
+        uintptr_t a = i < r->nargs ? r->args[i] : 0;
+        i++;
+
+        switch (c) {
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+            w = snprintf(out + pos, cap - pos, one, bits_float(a));
+            break;
+        case 's':
+            w = snprintf(out + pos, cap - pos, one, a ? (const char *)a : "(null)");
+            break;
+        case 'p':
+            w = snprintf(out + pos, cap - pos, one, (void *)a);
+            break;
+        default:
+            w = ll ? snprintf(out + pos, cap - pos, one, (long long)a)
+                   : snprintf(out + pos, cap - pos, one, (unsigned int)a);
+            break;
+        }
+        if (w > 0) {
+            pos += (size_t)w < cap - pos ? (size_t)w : cap - 1 - pos;
+        }
+        p = q;
+    }
+
+    if (pos > cap - 2) pos = cap - 2;
+    out[pos++] = '\n';
+    out[pos] = '\0';
+    return (int)pos;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+int dlog_encode(const dlog_record_t *r, uint8_t *out, size_t cap)
+{
+    size_t body = 10 + 4 * (size_t)r->nargs;
+    if (cap < 3 + body) {
+        return -1;
+    }
+    uint8_t *p = out;
+    *p++ = 0xA5;
+    *p++ = 0x5A;
+    *p++ = (uint8_t)body;
+    p = put_u32(p, r->timestamp_ms);
+    p = put_u32(p, (uint32_t)(uintptr_t)r->fmt);
+    *p++ = (uint8_t)(r->module << 4 | (r->level & 0x0f));
+    *p++ = r->nargs;
+    for (uint8_t i = 0; i < r->nargs; i++) {
+        p = put_u32(p, (uint32_t)r->args[i]);
+    }
+    return (int)(p - out);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 지연(deferred) 레벨 로그
+// 호출 지점에서는 포맷 문자열 포인터(=포맷 ID)와 인자만 락프리 링 버퍼에 넣고,
+// 실제 포맷/시리얼 출력은 낮은 우선순위 태스크가 dlog_pop()으로 꺼내서 처리한다.
+//   - DLOG_LEVEL보다 상세한 호출은 컴파일 단계에서 사라진다 (릴리스 빌드는 NDEBUG → WARN).
+//   - 모듈별 레벨은 런타임에 dlog_set_level()로 조정한다.
+//   - %s 인자는 정적 문자열(리터럴, 상수 테이블)만 허용: 포인터만 저장하고 나중에 읽는다.
+//   - 인자는 최대 DLOG_MAX_ARGS개(넘으면 컴파일 오류)이며 float/double은 float로 저장한다.
+// 바이너리 출력(dlog_encode)은 tools/dlog_decode.py가 펌웨어 ELF로 포맷을 복원한다.
+
+#define DLOG_NONE  0
+#define DLOG_ERROR 1
+#define DLOG_WARN  2
+#define DLOG_INFO  3
+#define DLOG_DEBUG 4
+
+#ifndef DLOG_LEVEL
+#ifdef NDEBUG
+#define DLOG_LEVEL DLOG_WARN
+#else
+#define DLOG_LEVEL DLOG_INFO
+#endif
+#endif
+
+#ifndef DLOG_RING_SIZE
+#define DLOG_RING_SIZE 64   // 2의 거듭제곱
+#endif
+
+#define DLOG_MAX_ARGS 6
+
+typedef enum {
+    DLOG_MOD_SYS = 0,   // 부팅, 스케줄러 상태
+    DLOG_MOD_NET,       // Wi-Fi, MQTT
+    DLOG_MOD_HTTP,      // HTTP 서버
+    DLOG_MOD_CTRL,      // 창문, 펌프, 판단 엔진
+    DLOG_MOD_SENSOR,    // SHT31, PMS5003
+    DLOG_MOD_CMD,       // 명령 수신/처리
+    DLOG_MOD_COUNT,
+} dlog_module_t;
+
+typedef struct {
+    volatile uint32_t seq;     // 링 슬롯 순번 (내부용)
+    uint32_t timestamp_ms;
+    const char *fmt;
+    uint8_t module;
+    uint8_t level;
+    uint8_t nargs;
+    uintptr_t args[DLOG_MAX_ARGS];
+} dlog_record_t;
+
+extern volatile uint8_t dlog_levels[DLOG_MOD_COUNT];
+
+// 인자 개수 (0~15). 넘치는 인자는 dlog_write()가 버리고 0으로 찍히므로 컴파일 단계에서 막는다.
+#define DLOG_NARGS(...) DLOG_NARGS_(0, ##__VA_ARGS__, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define DLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, n, ...) n
+
+#ifdef __cplusplus
+#define DLOG_STATIC_ASSERT static_assert
+#else
+#define DLOG_STATIC_ASSERT _Static_assert
+#endif
+
+#define DLOG_AT(mod, lvl, fmt, ...)                                              \
+    do {                                                                         \
+        DLOG_STATIC_ASSERT(DLOG_NARGS(__VA_ARGS__) <= DLOG_MAX_ARGS,             \
+                           "too many log arguments (DLOG_MAX_ARGS)");            \
+        if ((lvl) <= DLOG_LEVEL && (lvl) <= dlog_levels[mod]) {                  \
+            dlog_write((mod), (lvl), (fmt), ##__VA_ARGS__);                      \
+        }                                                                        \
+    } while (0)
+
+#define DLOG_E(mod, fmt, ...) DLOG_AT(DLOG_MOD_##mod, DLOG_ERROR, fmt, ##__VA_ARGS__)
+#define DLOG_W(mod, fmt, ...) DLOG_AT(DLOG_MOD_##mod, DLOG_WARN,  fmt, ##__VA_ARGS__)
+#define DLOG_I(mod, fmt, ...) DLOG_AT(DLOG_MOD_##mod, DLOG_INFO,  fmt, ##__VA_ARGS__)
+#define DLOG_D(mod, fmt, ...) DLOG_AT(DLOG_MOD_##mod, DLOG_DEBUG, fmt, ##__VA_ARGS__)
+
+typedef uint32_t (*dlog_clock_fn)(void);
+
+void dlog_init(dlog_clock_fn clock_ms);
+void dlog_set_level(dlog_module_t module, uint8_t level);
+
+// 링이 가득 차면 기록을 버리고 dropped를 증가시킨다 (여러 태스크에서 호출 가능)
+void dlog_write(dlog_module_t module, uint8_t level, const char *fmt, ...);
+
+// 소비자(단일 태스크) 전용
+bool dlog_pop(dlog_record_t *out);
+uint32_t dlog_dropped(void);
+
+// "[   12345] I CTRL  message" 형태의 한 줄 (개행 포함). 잘리면 cap - 1 바이트까지.
+int dlog_format(const dlog_record_t *r, char *out, size_t cap);
+
+// 바이너리 프레임: A5 5A len | ts u32 | fmt u32 | (module << 4 | level) | nargs | args u32 x nargs
+#define DLOG_FRAME_MAX (3 + 10 + 4 * DLOG_MAX_ARGS)
+int dlog_encode(const dlog_record_t *r, uint8_t *out, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
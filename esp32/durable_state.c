@@ -0,0 +1,116 @@
+#include <string.h>
+
+#include "durable_state.h"
+
+#define DS_MAGIC    0x5341u     // "AS"
+#define DS_VERSION  1
+#define DS_RETRY_MS 1000        // 쓰기 실패 후 재시도 간격
+
+static const char *const DS_KEYS[2] = { "state0", "state1" };
+
+// 저장 형식: 사본마다 순번과 CRC-32
+typedef struct {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t size;               // sizeof(ds_state_t)
+    uint32_t seq;
+    ds_state_t state;
+    uint32_t crc;               // 앞의 모든 바이트
+} ds_record_t;
+
+uint32_t ds_crc32(const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t crc = 0xffffffffu;
+    while (len--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+void ds_init(durable_state_t *ds, const ds_ops_t *ops)
+{
+    memset(ds, 0, sizeof(*ds));
+    ds->ops = *ops;
+    ds->state.decision = DS_NONE;
+    ds->state.power_mode = DS_NONE;
+    ds->state.power_default = DS_NONE;
+    ds->written = ds->state;
+}
+
+// 1: 유효, 0: 있지만 손상, -1: 없음
+static int load(const durable_state_t *ds, int slot, ds_record_t *r)
+{
+    int n = ds->ops.read(ds->ops.ctx, DS_KEYS[slot], r, sizeof(*r));
+    if (n < 0) {
+        return -1;
+    }
+    return n == (int)sizeof(*r) &&
+           r->magic == DS_MAGIC && r->version == DS_VERSION && r->size == sizeof(ds_state_t) &&
+           r->crc == ds_crc32(r, offsetof(ds_record_t, crc));
+}
+
+ds_restore_t ds_restore(durable_state_t *ds, ds_state_t *out)
+{
+    ds_record_t r[2];
+    int st[2] = { load(ds, 0, &r[0]), load(ds, 1, &r[1]) };
+    if (st[0] != 1 && st[1] != 1) {
+        return DS_RESTORE_NONE;
+    }
+    // 둘 다 유효하면 순번이 큰 쪽 (래핑 고려)
+    int best = st[0] != 1 ? 1 : st[1] != 1 ? 0 : (int32_t)(r[1].seq - r[0].seq) > 0 ? 1 : 0;
+    ds->state = r[best].state;
+    ds->written = r[best].state;
+    ds->seq = r[best].seq;
+    ds->dirty = false;
+    *out = r[best].state;
+    // 다른 사본이 있는데 손상이면 그 자리에 쓰던 더 새 레코드가 중간에 끊긴 것
+    return st[best ^ 1] == 0 ? DS_RESTORE_FALLBACK : DS_RESTORE_LATEST;
+}
+
+void ds_update(durable_state_t *ds, const ds_state_t *s, uint32_t max_delay_ms, uint32_t now_ms)
+{
+    if (memcmp(s, &ds->state, sizeof(*s)) != 0) {
+        ds->state = *s;
+        ds->updates++;
+    }
+    if (memcmp(&ds->state, &ds->written, sizeof(ds->state)) == 0) {
+        ds->dirty = false;      // 쓴 내용으로 되돌아옴
+        return;
+    }
+    uint32_t due = now_ms + max_delay_ms;
+    if (!ds->dirty || (int32_t)(due - ds->due_ms) < 0) {
+        ds->due_ms = due;
+    }
+    ds->dirty = true;
+}
+
+bool ds_poll(durable_state_t *ds, uint32_t now_ms)
+{
+    if (!ds->dirty || (int32_t)(now_ms - ds->due_ms) < 0) {
+        return false;
+    }
+    ds_record_t r;
+    memset(&r, 0, sizeof(r));
+    r.magic = DS_MAGIC;
+    r.version = DS_VERSION;
+    r.size = sizeof(ds_state_t);
+    r.seq = ds->seq + 1;
+    r.state = ds->state;
+    r.crc = ds_crc32(&r, offsetof(ds_record_t, crc));
+
+    // 직전 레코드가 든 사본은 건드리지 않는다
+    if (!ds->ops.write(ds->ops.ctx, DS_KEYS[r.seq & 1], &r, sizeof(r))) {
+        ds->failures++;
+        ds->due_ms = now_ms + DS_RETRY_MS;
+        return false;
+    }
+    ds->seq = r.seq;
+    ds->written = r.state;
+    ds->dirty = false;
+    ds->writes++;
+    return true;
+}
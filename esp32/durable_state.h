@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 재시작 후에도 유지되는 장치 상태 (창문/서보, 판단 입력, 설정)
+// 레코드 하나를 키 두 개("state0"/"state1")에 번갈아 쓴다. 각 사본은 순번과 CRC를 가지므로
+// 쓰는 도중 전원이 끊겨 한쪽이 깨져도 다른 쪽(직전 레코드)으로 복원된다.
+// 쓰기는 모아서 한다(플래시 마모): ds_update()는 RAM의 레코드만 바꾸고 늦어도 max_delay_ms 뒤에
+// 쓰도록 예약하며, ds_poll()이 기한이 된 레코드를 한 번에 쓴다. 마지막으로 쓴 내용과 같으면 쓰지 않는다.
+// 저장소 접근은 콜백으로 주입하므로(ESP32: NVS, 호스트: 파일/메모리) 하드웨어 없이 구동할 수 있다.
+// loop() 컨텍스트(단일 태스크)에서만 호출한다.
+
+#define DS_NONE 0xff    // 값 없음 (판단 출력 미정, 설정 미지정)
+
+typedef struct {
+    uint8_t window_open;        // 명령된 창문 상태 (0 닫힘, 1 열림)
+    uint8_t window_angle;       // 마지막으로 기록한 서보 각도
+    uint8_t window_target;      // 이동 목표 각도. window_angle과 다르면 이동 중에 기록된 것
+    uint8_t decision;           // 규칙 엔진 출력 (de_action_t), DS_NONE이면 아직 없음
+    uint8_t power_mode;         // pm_mode_t, DS_NONE이면 빌드 기본값
+    uint8_t power_default;      // 저장 당시의 빌드 기본 모드 (빌드 설정이 바뀌면 저장값을 버린다)
+    uint8_t reserved[2];
+    float pm25;                 // MQTT 외부 기준값 (판단 입력)
+    float pm10;
+    int32_t aqi;
+} ds_state_t;
+
+typedef struct {
+    // 읽은 바이트 수, 없으면 -1
+    int (*read)(void *ctx, const char *key, void *buf, size_t cap);
+    // 한 키의 쓰기는 원자적이라고 가정하지 않는다 (CRC로 검증)
+    bool (*write)(void *ctx, const char *key, const void *data, size_t len);
+    void *ctx;
+} ds_ops_t;
+
+typedef enum {
+    DS_RESTORE_NONE = 0,        // 유효한 레코드 없음 (첫 부팅 또는 둘 다 손상)
+    DS_RESTORE_LATEST,          // 가장 최근 레코드
+    DS_RESTORE_FALLBACK,        // 최근 사본이 손상되어 직전 레코드
+} ds_restore_t;
+
+typedef struct {
+    ds_ops_t ops;
+    ds_state_t state;           // 최신 상태 (RAM)
+    ds_state_t written;         // 마지막으로 쓴 상태
+    uint32_t seq;               // 마지막으로 쓴 레코드 순번
+    bool dirty;
+    uint32_t due_ms;            // dirty일 때 쓰기 기한
+
+    // 통계
+    uint32_t updates;           // 내용이 바뀐 ds_update() 호출
+    uint32_t writes;
+    uint32_t failures;
+} durable_state_t;
+
+void ds_init(durable_state_t *ds, const ds_ops_t *ops);
+
+// 저장된 레코드를 읽어 ds->state와 *out에 채운다. 없으면 *out은 건드리지 않는다.
+ds_restore_t ds_restore(durable_state_t *ds, ds_state_t *out);
+
+// 상태를 갱신하고 늦어도 max_delay_ms 뒤에 쓰도록 예약 (0이면 다음 ds_poll()에서 즉시).
+// 이미 더 이른 기한이 잡혀 있으면 그 기한을 유지한다. 내용은 바이트 단위로 비교하므로
+// s는 ds->state를 복사해 필요한 필드만 바꿔 만든다 (reserved는 0으로 둔다).
+void ds_update(durable_state_t *ds, const ds_state_t *s, uint32_t max_delay_ms, uint32_t now_ms);
+
+// 기한이 된 레코드를 쓴다. 썼으면 true. 실패하면 잠시 뒤 다시 시도한다.
+bool ds_poll(durable_state_t *ds, uint32_t now_ms);
+
+// 레코드 검증용 CRC-32 (IEEE). 같은 저장소를 쓰는 다른 레코드(device_config)도 쓴다.
+uint32_t ds_crc32(const void *data, size_t len);
+
+static inline bool ds_pending(const durable_state_t *ds) { return ds->dirty; }
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,44 +1,217 @@
 #include <string.h>
-#include "esp_log.h"
-#include "esp_http_pull.h"  // esp_handle_command weak 심볼을 오버라이드
+#include "dlog.h"
+#include "esp_command_handler.h"  // actuator_request/bug_detected (air_app.c), esp_http_pull.c의 약한 esp_handle_command 대체
 
-static const char *TAG_CMD = "CMD";
+typedef struct {
+	const char *name;
+	cmd_id_t id;
+	uint8_t sources;
+} cmd_entry_t;
 
-// esp32.c에 정의된 함수/변수들을 extern으로 참조(esp32.c는 수정하지 않음)
-extern void open_window(void);
-extern void close_window(void);
-extern void activatePump(void);
+// 반드시 이름(대문자 기준) 오름차순으로 유지할 것 - 이진 탐색에 사용
+// "ON"/"OFF"는 기존 앱의 HTTP 어휘(ON=창문 닫기, OFF=창문 열기)라서 HTTP에서만 허용
+static const cmd_entry_t s_commands[] = {
+	{ "BUG_OFF",       CMD_BUG_OFF,       CMD_SRC_ALL  },
+	{ "BUG_ON",        CMD_BUG_ON,        CMD_SRC_ALL  },
+	{ "OFF",           CMD_WINDOW_OPEN,   CMD_SRC_HTTP },
+	{ "ON",            CMD_WINDOW_CLOSE,  CMD_SRC_HTTP },
+	{ "PUMP_OFF",      CMD_PUMP_OFF,      CMD_SRC_ALL  },
+	{ "PUMP_ON",       CMD_PUMP_ON,       CMD_SRC_ALL  },
+	{ "WINDOW_CLOSE",  CMD_WINDOW_CLOSE,  CMD_SRC_ALL  },
+	{ "WINDOW_OPEN",   CMD_WINDOW_OPEN,   CMD_SRC_ALL  },
+	{ "WINDOW_TOGGLE", CMD_WINDOW_TOGGLE, CMD_SRC_ALL  },
+};
 
-extern int is_window;     // 0=닫힘, 1=열림
-extern char pump;         // "ON" 또는 "OFF"의 첫 글자만 참조할 수 있으므로 주의
+#define CMD_COUNT (sizeof(s_commands) / sizeof(s_commands[0]))
 
-// 약한 기본 구현을 대체하여 실제 하드웨어 동작 수행
-void esp_handle_command(const char *command)
+// 정식 이름 (cmd_id_t 순서)
+static const char *const s_canonical[] = {
+	[CMD_NONE]          = "NONE",
+	[CMD_WINDOW_OPEN]   = "WINDOW_OPEN",
+	[CMD_WINDOW_CLOSE]  = "WINDOW_CLOSE",
+	[CMD_WINDOW_TOGGLE] = "WINDOW_TOGGLE",
+	[CMD_PUMP_ON]       = "PUMP_ON",
+	[CMD_PUMP_OFF]      = "PUMP_OFF",
+	[CMD_BUG_ON]        = "BUG_ON",
+	[CMD_BUG_OFF]       = "BUG_OFF",
+};
+
+// 최근에 실행한 (경로, 멱등 키). 키는 경로마다 따로 발급되므로 경로도 함께 비교한다.
+#define CMD_RECENT_KEYS 16
+typedef struct {
+	uint32_t key;
+	uint8_t source;
+} recent_key_t;
+static recent_key_t s_recent_keys[CMD_RECENT_KEYS];
+static uint8_t s_recent_next = 0;
+
+static int upper(int c)
 {
-	if (command == NULL) {
-		ESP_LOGW(TAG_CMD, "NULL command");
-		return;
+	return (c >= 'a' && c <= 'z') ? c - ('a' - 'A') : c;
+}
+
+// 대소문자 무시 비교. name은 NUL 종료가 아닐 수 있음
+static int compare_name(const char *entry, const char *name, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		int a = (unsigned char)entry[i];
+		int b = upper((unsigned char)name[i]);
+		if (a == '\0' || a != b) {
+			return a - b;
+		}
 	}
+	return (unsigned char)entry[len];
+}
 
-	ESP_LOGI(TAG_CMD, "Handle command: %s", command);
+static const cmd_entry_t *lookup(const char *name, size_t len)
+{
+	size_t lo = 0, hi = CMD_COUNT;
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		int c = compare_name(s_commands[mid].name, name, len);
+		if (c == 0) {
+			return &s_commands[mid];
+		}
+		if (c < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return NULL;
+}
 
-	if (strcmp(command, "WINDOW_OPEN") == 0) {
-		open_window();
-		return;
+static bool seen_key(cmd_source_t source, uint32_t key)
+{
+	if (key == 0) {
+		return false;
 	}
-	if (strcmp(command, "WINDOW_CLOSE") == 0) {
-		close_window();
-		return;
+	for (int i = 0; i < CMD_RECENT_KEYS; i++) {
+		if (s_recent_keys[i].key == key && s_recent_keys[i].source == source) {
+			return true;
+		}
 	}
-	if (strcmp(command, "PUMP_ON") == 0) {
-		activatePump();
+	return false;
+}
+
+// 실행된 명령만 기록한다. 거부/선점된 명령은 같은 키로 다시 보내면 다시 시도한다.
+static void remember_key(cmd_source_t source, uint32_t key)
+{
+	if (key == 0) {
 		return;
 	}
-	if (strcmp(command, "PUMP_OFF") == 0) {
-		// esp32.c에 펌프 OFF 구현이 별도로 없으므로 로그만 표시
-		ESP_LOGI(TAG_CMD, "Pump OFF requested (no-op; implement if needed)");
+	s_recent_keys[s_recent_next] = (recent_key_t){ key, (uint8_t)source };
+	s_recent_next = (uint8_t)((s_recent_next + 1) % CMD_RECENT_KEYS);
+}
+
+// value를 받지 않는 명령은 0만, 받는 명령은 범위 안만 허용
+static bool value_ok(cmd_id_t id, int32_t value)
+{
+	switch (id) {
+	case CMD_WINDOW_OPEN:
+		return value >= 0 && value <= CMD_WINDOW_MAX_OPEN_DEG;
+	case CMD_PUMP_ON:
+		return value >= 0 && value <= CMD_PUMP_MAX_MS;
+	case CMD_BUG_ON:
+	case CMD_BUG_OFF:
+		return true;
+	default:
+		return value == 0;
+	}
+}
+
+// 창문/펌프는 큐에 넣기만 한다 (토글은 대기 중인 목표 기준으로 큐가 해석)
+static cmd_status_t execute(cmd_source_t source, cmd_id_t id, int32_t value)
+{
+	bool accepted = true;
+	switch (id) {
+	case CMD_WINDOW_OPEN:
+		accepted = actuator_request(ACT_WINDOW, 1, value, ACT_PRIO_USER, source);
+		break;
+	case CMD_WINDOW_CLOSE:
+		accepted = actuator_request(ACT_WINDOW, 0, 0, ACT_PRIO_USER, source);
+		break;
+	case CMD_WINDOW_TOGGLE:
+		accepted = actuator_request(ACT_WINDOW, ACT_TOGGLE, 0, ACT_PRIO_USER, source);
+		break;
+	case CMD_PUMP_ON:
+		accepted = actuator_request(ACT_PUMP, 1, value, ACT_PRIO_USER, source);
+		break;
+	case CMD_PUMP_OFF:
+		accepted = actuator_request(ACT_PUMP, 0, 0, ACT_PRIO_USER, source);
+		break;
+	case CMD_BUG_ON:
+		bug_detected(value != 0);
+		break;
+	case CMD_BUG_OFF:
+		bug_cleared(value <= 0 ? 0 : value > CMD_BUG_OFF_MAX_SETTLE_MS ? CMD_BUG_OFF_MAX_SETTLE_MS : (uint32_t)value);
+		break;
+	default:
+		break;
+	}
+	return accepted ? CMD_RESULT_OK : CMD_RESULT_PREEMPTED;
+}
+
+cmd_status_t command_dispatch(cmd_source_t source,
+                              const char *name,
+                              size_t len,
+                              const cmd_args_t *args,
+                              cmd_result_t *result)
+{
+	cmd_result_t res = { CMD_RESULT_UNKNOWN, CMD_NONE, NULL };
+
+	const cmd_entry_t *entry = (name && len) ? lookup(name, len) : NULL;
+	if (entry == NULL) {
+		// 이름은 수신 버퍼를 가리키므로 로그에 남기지 않는다 (dlog는 %s 포인터만 저장)
+		DLOG_W(CMD, "Unknown command (%u bytes)", (unsigned)len);
+	} else {
+		res.id = entry->id;
+		res.name = s_canonical[entry->id];
+		if ((entry->sources & source) == 0) {
+			res.status = CMD_RESULT_NOT_ALLOWED;
+			DLOG_W(CMD, "Command %s not allowed from source %d", res.name, (int)source);
+		} else if (args && !value_ok(entry->id, args->value)) {
+			res.status = CMD_RESULT_BAD_VALUE;
+			DLOG_W(CMD, "Command %s: value %ld out of range", res.name, (long)args->value);
+		} else if (args && seen_key(source, args->idempotency_key)) {
+			res.status = CMD_RESULT_DUPLICATE;
+			DLOG_I(CMD, "Duplicate command %s (key=%u) ignored", res.name, (unsigned)args->idempotency_key);
+		} else {
+			DLOG_I(CMD, "Handle command: %s", res.name);
+			res.status = execute(source, entry->id, args ? args->value : 0);
+			if (res.status == CMD_RESULT_OK && args) {
+				remember_key(source, args->idempotency_key);
+			}
+		}
+	}
+
+	if (result) {
+		*result = res;
+	}
+	return res.status;
+}
+
+const char *command_status_name(cmd_status_t status)
+{
+	switch (status) {
+	case CMD_RESULT_OK:          return "ok";
+	case CMD_RESULT_DUPLICATE:   return "duplicate";
+	case CMD_RESULT_UNKNOWN:     return "unknown command";
+	case CMD_RESULT_NOT_ALLOWED: return "not allowed";
+	case CMD_RESULT_PREEMPTED:   return "preempted";
+	case CMD_RESULT_BAD_VALUE:   return "bad value";
+	}
+	return "error";
+}
+
+// 약한 기본 구현을 대체하여 실제 하드웨어 동작 수행
+void esp_handle_command(const air_command_t *cmd)
+{
+	if (cmd == NULL) {
+		DLOG_W(CMD, "NULL command");
 		return;
 	}
 
-	ESP_LOGW(TAG_CMD, "Unknown command: %s", command);
-}
\ No newline at end of file
+	cmd_args_t args = { cmd->value, cmd->id ? cmd->id : cmd->seq };
+	command_dispatch(CMD_SRC_PULL, cmd->name, strlen(cmd->name), &args, NULL);
+}
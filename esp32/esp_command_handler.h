@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "actuator_queue.h"
+#include "cmd_stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 통합 명령 레지스트리
+// MQTT(air_app.c callback), HTTP /control(main.c), HTTP 폴링(esp_http_pull.c) 모두
+// command_dispatch()로 들어오며, 명령 이름은 정렬된 테이블에서 이진 탐색으로 찾는다.
+
+typedef enum {
+	CMD_SRC_LOCAL = 0,       // 펌웨어 내부 (결정 엔진, 벌레 대응) - 명령 테이블로는 들어오지 않음
+	CMD_SRC_MQTT = 1 << 0,
+	CMD_SRC_HTTP = 1 << 1,
+	CMD_SRC_PULL = 1 << 2,
+	CMD_SRC_ALL  = CMD_SRC_MQTT | CMD_SRC_HTTP | CMD_SRC_PULL,
+} cmd_source_t;
+
+typedef enum {
+	CMD_NONE = 0,
+	CMD_WINDOW_OPEN,    // value = 열림 각도(도), 0이면 완전히 (CMD_WINDOW_MAX_OPEN_DEG)
+	CMD_WINDOW_CLOSE,
+	CMD_WINDOW_TOGGLE,  // 열 때는 완전히
+	CMD_PUMP_ON,        // value = 분사 시간(ms), 0이면 설정값 pump_ms. CMD_PUMP_MAX_MS 이하
+	CMD_PUMP_OFF,
+	CMD_BUG_ON,     // value != 0 이면 창문 닫기 + 펌프 분사
+	CMD_BUG_OFF,    // value = 센서 제어 재개 전 대기 시간(ms), CMD_BUG_OFF_MAX_SETTLE_MS로 제한
+} cmd_id_t;
+// 위에 적지 않은 명령은 value가 0이어야 한다 (아니면 CMD_RESULT_BAD_VALUE)
+
+#define CMD_WINDOW_MAX_OPEN_DEG 90
+#ifndef CMD_PUMP_MAX_MS
+#define CMD_PUMP_MAX_MS 60000
+#endif
+
+// BUG_OFF 대기 시간 상한. 원격 인자가 크면 그동안 자동 환기가 멈추므로 이 값으로 자른다.
+#ifndef CMD_BUG_OFF_MAX_SETTLE_MS
+#define CMD_BUG_OFF_MAX_SETTLE_MS 600000    // 10분
+#endif
+
+typedef struct {
+	int32_t value;            // 명령별 인자 (없으면 0)
+	uint32_t idempotency_key; // 0이 아니면 같은 경로에서 최근 실행한 키와 비교해 중복 실행 방지
+} cmd_args_t;
+
+typedef enum {
+	CMD_RESULT_OK = 0,
+	CMD_RESULT_DUPLICATE,     // 같은 경로, 같은 키로 이미 실행됨 (다시 실행하지 않음)
+	CMD_RESULT_UNKNOWN,       // 테이블에 없는 명령
+	CMD_RESULT_NOT_ALLOWED,   // 해당 경로에서는 허용되지 않는 명령
+	CMD_RESULT_PREEMPTED,     // 더 높은 우선순위 동작(벌레 대응 등)이 액추에이터를 잡고 있음
+	CMD_RESULT_BAD_VALUE,     // 명령이 받지 않는 value이거나 범위를 벗어남 (실행하지 않음)
+} cmd_status_t;
+
+typedef struct {
+	cmd_status_t status;
+	cmd_id_t id;
+	const char *name;         // 정식 명령 이름 (UNKNOWN이면 NULL)
+} cmd_result_t;
+
+// name은 NUL 종료가 필요 없으며 대소문자를 구분하지 않는다. args는 NULL 가능.
+cmd_status_t command_dispatch(cmd_source_t source,
+                              const char *name,
+                              size_t len,
+                              const cmd_args_t *args,
+                              cmd_result_t *result);
+
+const char *command_status_name(cmd_status_t status);
+
+// 서버/앱에서 받은 명령 처리 (esp_http_pull.c의 약한 기본 구현을 대체)
+// 폴링 경로용 래퍼: command_dispatch(CMD_SRC_PULL, ...). 멱등 키는 id, 없으면 seq.
+void esp_handle_command(const air_command_t *cmd);
+
+// 실제 하드웨어 동작은 air_app.c가 제공 (C 링크로 노출)
+// 창문/펌프 명령은 액추에이터 큐에 넣기만 하며, 실행은 loop()가 한다. 큐가 거부하면 false.
+// value는 켤 때의 열림 각도/분사 시간이며 0이면 기본값 (완전히 열기, 설정값 pump_ms).
+bool actuator_request(act_id_t actuator, int target, int32_t value, act_prio_t priority, cmd_source_t source);
+void bug_detected(bool spray);
+void bug_cleared(uint32_t settle_ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,172 +2,398 @@
 #include <string.h>
 #include <stdbool.h>
 
-#include "esp_err.h"
-#include "esp_log.h"
-#include "esp_http_client.h"
+#include "dlog.h"
 #include "esp_http_pull.h"
+#include "hal.h"
+#include "air_sample_buffer.h"
+#include "cmd_stream.h"
+#include "rtt_estimator.h"
+#include "telemetry_policy.h"
 
 // Flutter 서버(또는 백엔드) HTTP 엔드포인트 URL을 설정하세요.
 // 예: http://192.168.0.10:8080/air-quality 또는 https://your.domain/api/air
 // URL 매크로는 esp_http_pull.h에서 기본값을 제공합니다.
 
-static const char *TAG = "AIR_HTTP";
+static air_sample_buffer_t s_samples;
+static bool s_samples_ready = false;
 
-// temperature, humidity, pm25, pm10, bug 값을 JSON으로 POST 전송
-esp_err_t send_air_quality_data(float temperature,
-                                float humidity,
-                                int pm25,
-                                int pm10,
-                                bool bug)
+#if AIR_SAMPLE_SPILL_NVS
+static int spill_read(void *ctx, const char *key, void *buf, size_t cap)
 {
-    // JSON 페이로드 구성
-    // {"temperature": 23.5, "humidity": 40.2, "pm25": 12, "pm10": 25, "bug": false}
-    char json_payload[192];
-    int written = snprintf(
-        json_payload,
-        sizeof(json_payload),
-        "{\"temperature\":%.2f,\"humidity\":%.2f,\"pm25\":%d,\"pm10\":%d,\"bug\":%s}",
-        temperature,
-        humidity,
-        pm25,
-        pm10,
-        bug ? "true" : "false");
-
-    if (written <= 0 || written >= (int)sizeof(json_payload)) {
-        ESP_LOGE(TAG, "JSON 직렬화 실패 또는 버퍼 초과");
-        return ESP_FAIL;
-    }
-
-    esp_http_client_config_t config = {
-        .url = AIR_QUALITY_POST_URL,
-        .method = HTTP_METHOD_POST,
-        .timeout_ms = 5000,
-    };
+    (void)ctx;
+    return hal_store_read(key, buf, cap);
+}
+static bool spill_write(void *ctx, const char *key, const void *data, size_t len)
+{
+    (void)ctx;
+    return hal_store_write(key, data, len);
+}
+static const ds_ops_t SPILL_OPS = { spill_read, spill_write, NULL };
+static air_sample_spill_t s_spill;
+#endif
+
+// 배치 전송 상태
+static uint32_t s_last_flush_ms = 0;
+static uint32_t s_next_retry_ms = 0;
+static uint32_t s_backoff_ms = 0;
+static uint32_t s_posts = 0;
 
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (client == NULL) {
-        ESP_LOGE(TAG, "HTTP 클라이언트 초기화 실패");
-        return ESP_FAIL;
+static const tp_config_t TELEMETRY_POLICY = {
+    AIR_TELEMETRY_DEADBAND_TEMP_C,
+    AIR_TELEMETRY_DEADBAND_HUM_PCT,
+    AIR_TELEMETRY_DEADBAND_PM,
+    AIR_TELEMETRY_DEADBAND_PM_PCT,
+    AIR_TELEMETRY_HEARTBEAT_MS,
+    AIR_TELEMETRY_MIN_INTERVAL_MS,
+};
+static telemetry_policy_t s_policy;
+
+static const rtt_config_t HTTP_RTT = {
+    AIR_HTTP_TIMEOUT_INITIAL_MS,
+    AIR_HTTP_TIMEOUT_MIN_MS,
+    AIR_HTTP_TIMEOUT_MAX_MS,
+};
+static rtt_estimator_t s_rtt;
+
+#if AIR_TELEMETRY_FORMAT == AIR_TELEMETRY_FORMAT_BINARY
+static uint8_t s_payload[AIR_SAMPLE_BINARY_HEADER + AIR_TELEMETRY_BATCH_SIZE * AIR_SAMPLE_BINARY_RECORD];
+#else
+static char s_payload[AIR_TELEMETRY_BATCH_SIZE * 112 + 4];
+#endif
+
+static uint32_t now_ms(void)
+{
+    return hal_millis();
+}
+
+// URL 형식의 %s를 장치 ID로 채워 한 번만 만든다 (형식이 바뀌면 다시)
+static const char *device_url(char *buf, size_t cap, const char *fmt)
+{
+    if (buf[0] == '\0') {
+        snprintf(buf, cap, fmt, hal_device_id());
     }
+    return buf;
+}
 
-    esp_err_t err = ESP_OK;
+static const char *s_post_fmt = AIR_QUALITY_POST_URL;
+static const char *s_pull_fmt = AIR_COMMAND_PULL_URL;
+static char s_post_url[160];
+static char s_pull_url[160];
 
-    // 헤더 및 바디 설정
-    ESP_ERROR_CHECK_WITHOUT_ABORT(esp_http_client_set_header(client, "Content-Type", "application/json"));
-    ESP_ERROR_CHECK_WITHOUT_ABORT(esp_http_client_set_post_field(client, json_payload, strlen(json_payload)));
+void air_http_set_urls(const char *post_fmt, const char *pull_fmt)
+{
+    s_post_fmt = post_fmt;
+    s_pull_fmt = pull_fmt;
+    s_post_url[0] = '\0';
+    s_pull_url[0] = '\0';
+}
 
-    err = esp_http_client_perform(client);
-    if (err == ESP_OK) {
-        int status_code = esp_http_client_get_status_code(client);
-        int content_length = esp_http_client_get_content_length(client);
-        ESP_LOGI(TAG, "POST 완료, status=%d, length=%d", status_code, content_length);
-        if (status_code < 200 || status_code >= 300) {
-            ESP_LOGW(TAG, "서버 비정상 응답 코드: %d", status_code);
-            err = ESP_FAIL;
-        }
+static void samples_ensure(void)
+{
+    if (s_samples_ready) {
+        return;
+    }
+    air_sample_buffer_init(&s_samples);
+    tp_init(&s_policy, &TELEMETRY_POLICY);
+    rtt_init(&s_rtt, &HTTP_RTT);
+#if AIR_SAMPLE_SPILL_NVS
+    // 이전 부팅에서 보내지 못한 샘플 복원 (저장본은 첫 전송 성공 때 무효화)
+    air_sample_spill_init(&s_spill, &SPILL_OPS);
+    uint16_t restored = air_sample_spill_restore(&s_spill, &s_samples, now_ms());
+    if (restored > 0) {
+        DLOG_I(NET, "NVS에서 미전송 샘플 %u개 복원", restored);
+    }
+#endif
+    s_last_flush_ms = now_ms();
+    s_samples_ready = true;
+}
+
+// 적응형 타임아웃으로 요청하고, 성공하면 소요 시간을 RTT 표본으로 반영
+static int timed_request(hal_http_method_t method, const char *url, const char *body, int body_len,
+                         const char *content_type, hal_http_body_cb on_body, void *ctx, int *status_code)
+{
+    uint32_t timeout = rtt_timeout_ms(&s_rtt);
+    uint32_t t0 = now_ms();
+    int rc = hal_http_request(method, url, body, body_len, content_type, (int)timeout, on_body, ctx, status_code);
+    if (rc != 0) {
+        rtt_fail(&s_rtt);
+        DLOG_W(NET, "HTTP 실패 (timeout=%lu ms), 다음 타임아웃 %lu ms",
+                 (unsigned long)timeout, (unsigned long)rtt_timeout_ms(&s_rtt));
     } else {
-        ESP_LOGE(TAG, "HTTP 요청 실패: %s", esp_err_to_name(err));
+        rtt_observe(&s_rtt, now_ms() - t0);
+    }
+    return rc;
+}
+
+// 가장 오래된 배치 하나를 인코딩해서 POST
+static bool post_one_batch(uint16_t *sent)
+{
+    air_sample_t batch[AIR_TELEMETRY_BATCH_SIZE];
+    uint16_t n = air_sample_buffer_peek(&s_samples, batch, AIR_TELEMETRY_BATCH_SIZE);
+    uint32_t now = now_ms();
+
+#if AIR_TELEMETRY_FORMAT == AIR_TELEMETRY_FORMAT_BINARY
+    int written = air_sample_encode_binary(batch, n, now, s_payload, sizeof(s_payload));
+    const char *content_type = "application/octet-stream";
+#else
+    int written = air_sample_encode_json(batch, n, now, s_payload, sizeof(s_payload));
+    const char *content_type = "application/json";
+#endif
+    if (written <= 0) {
+        DLOG_E(NET, "배치 직렬화 실패 또는 버퍼 초과");
+        return false;
+    }
+
+    // 장수명 세션으로 전송: 이전 요청의 연결이 살아있으면 재사용
+    int status_code = 0;
+    if (timed_request(HAL_HTTP_POST,
+                      device_url(s_post_url, sizeof(s_post_url), s_post_fmt),
+                      (const char *)s_payload,
+                      written,
+                      content_type,
+                      NULL,
+                      NULL,
+                      &status_code) != 0) {
+        DLOG_E(NET, "HTTP 요청 실패");
+        return false;
+    }
+
+    hal_http_stats_t stats;
+    hal_http_get_stats(&stats);
+    DLOG_I(NET, "POST 완료, status=%d, samples=%u, bytes=%d", status_code, n, written);
+    DLOG_I(NET, "HTTP 연결: requests=%u, handshakes=%u, reused=%u, srtt=%lu ms",
+             (unsigned)stats.requests, (unsigned)stats.handshakes, (unsigned)stats.reused,
+             (unsigned long)rtt_srtt_ms(&s_rtt));
+    if (status_code < 200 || status_code >= 300) {
+        DLOG_W(NET, "서버 비정상 응답 코드: %d", status_code);
+        return false;
     }
 
-    esp_http_client_cleanup(client);
-    if (err != ESP_OK) {
-        return err;
+    air_sample_buffer_consume(&s_samples, n);
+    s_posts++;
+    *sent = n;
+    return true;
+}
+
+bool air_telemetry_flush(bool force)
+{
+    samples_ensure();
+
+    uint32_t now = now_ms();
+    uint16_t pending = air_sample_buffer_count(&s_samples);
+    if (pending == 0) {
+        return true;
     }
+    if (!force) {
+        bool due = pending >= AIR_TELEMETRY_BATCH_SIZE ||
+                   now - s_last_flush_ms >= AIR_TELEMETRY_FLUSH_INTERVAL_MS;
+        if (!due || (int32_t)(now - s_next_retry_ms) < 0) {
+            return true;
+        }
+    }
+
+    // 장애 복구 후에는 여러 배치를 연달아 보내되, 한 번에 보내는 양은 제한
+    bool ok = true;
+    uint16_t sent_total = 0;
+    for (int i = 0; i < AIR_TELEMETRY_MAX_BATCHES_PER_FLUSH && air_sample_buffer_count(&s_samples) > 0; i++) {
+        uint16_t sent = 0;
+        ok = post_one_batch(&sent);
+        if (!ok) {
+            break;
+        }
+        sent_total += sent;
+    }
+    s_last_flush_ms = now;
+#if AIR_SAMPLE_SPILL_NVS
+    // 보낸 샘플만 NVS 저장본에서 지운다 (flush당 한 번 쓰기)
+    air_sample_spill_sent(&s_spill, &s_samples, sent_total);
+#else
+    (void)sent_total;
+#endif
+
+    if (!ok) {
+        // 지수 백오프: 실패할수록 재시도 간격을 늘림
+        s_backoff_ms = s_backoff_ms ? s_backoff_ms * 2 : AIR_TELEMETRY_BACKOFF_MIN_MS;
+        if (s_backoff_ms > AIR_TELEMETRY_BACKOFF_MAX_MS) {
+            s_backoff_ms = AIR_TELEMETRY_BACKOFF_MAX_MS;
+        }
+        s_next_retry_ms = now + s_backoff_ms;
+        DLOG_W(NET, "배치 전송 실패, %u개 보관 중, %lu ms 후 재시도",
+                 air_sample_buffer_count(&s_samples), (unsigned long)s_backoff_ms);
+#if AIR_SAMPLE_SPILL_NVS
+        // 덮어쓰기가 시작될 때만, 그 뒤로는 간격을 두고 보관
+        if (air_sample_spill_poll(&s_spill, &s_samples, now)) {
+            DLOG_I(NET, "미전송 샘플 %u개를 NVS에 보관", air_sample_buffer_count(&s_samples));
+        }
+#endif
+        return false;
+    }
+
+    s_backoff_ms = 0;
+    s_next_retry_ms = now;
 
 #if AIR_POLL_AFTER_POST
     // POST 성공 시 즉시 명령 폴링 시도
-    esp_err_t poll_res = poll_command_and_handle();
-    if (poll_res != ESP_OK) {
-        ESP_LOGW(TAG, "Command poll after POST failed: %s", esp_err_to_name(poll_res));
+    if (!poll_command_and_handle()) {
+        DLOG_W(NET, "Command poll after POST failed");
+    }
+#endif
+
+    return true;
+}
+
+// 장애 중 가득 찬 버퍼에 넣을 때는 덮어쓰기 전에 보관한다. 다음 재시도(백오프 최대
+// AIR_TELEMETRY_BACKOFF_MAX_MS)까지 기다리면 그 사이에 덮어쓴 샘플은 어디에도 남지 않는다.
+static void push_sample(const air_sample_t *sample)
+{
+#if AIR_SAMPLE_SPILL_NVS
+    if (s_backoff_ms != 0 && air_sample_buffer_count(&s_samples) == AIR_SAMPLE_BUFFER_CAPACITY &&
+        air_sample_spill_poll(&s_spill, &s_samples, sample->timestamp_ms)) {
+        DLOG_I(NET, "미전송 샘플 %u개를 NVS에 보관", air_sample_buffer_count(&s_samples));
     }
 #endif
+    air_sample_buffer_push(&s_samples, sample);
+}
+
+// temperature, humidity, pm25, pm10, bug 샘플을 정책에 따라 버퍼에 넣고, 배치 조건이 되면 POST 전송
+bool send_air_quality_data(float temperature,
+                           float humidity,
+                           int pm25,
+                           int pm10,
+                           bool bug)
+{
+    samples_ensure();
+
+    air_sample_t sample = {
+        .timestamp_ms = now_ms(),
+        .temperature = temperature,
+        .humidity = humidity,
+        .pm25 = (int16_t)pm25,
+        .pm10 = (int16_t)pm10,
+        .bug = bug,
+    };
 
-    return ESP_OK;
+#if AIR_TELEMETRY_DEADBAND
+    tp_reason_t reason = tp_offer(&s_policy, &sample);
+    if (reason == TP_SKIP) {
+        // 보낼 샘플은 없어도 실패로 남아 있던 배치의 재시도는 진행
+        return air_telemetry_flush(false);
+    }
+    push_sample(&sample);
+    // 벌레 감지 변화는 배치 주기를 기다리지 않는다
+    return air_telemetry_flush(reason == TP_SEND_EVENT);
+#else
+    tp_offer(&s_policy, &sample);   // 통계만
+    push_sample(&sample);
+    return air_telemetry_flush(false);
+#endif
+}
+
+void air_telemetry_get_stats(air_telemetry_stats_t *out)
+{
+    samples_ensure();
+    out->offered = s_policy.offered;
+#if AIR_TELEMETRY_DEADBAND
+    out->reported = s_policy.offered - s_policy.sent[TP_SKIP];
+#else
+    out->reported = s_policy.offered;
+#endif
+    out->heartbeats = s_policy.sent[TP_SEND_HEARTBEAT];
+    out->posts = s_posts;
+    out->http_timeout_ms = rtt_timeout_ms(&s_rtt);
+    out->http_srtt_ms = rtt_srtt_ms(&s_rtt);
+    out->http_failures = s_rtt.failures;
 }
 
 // 사용 예시
-// esp_err_t res = send_air_quality_data(temperature, humidity, pm25, pm10, bug);
-// if (res != ESP_OK) { /* 재시도 또는 오류 처리 */ }
+// if (!send_air_quality_data(temperature, humidity, pm25, pm10, bug)) { /* 샘플은 버퍼에 남아 있으며 백오프 후 다시 전송됨 */ }
 
 // ========== 명령 폴링 구현(GET) ==========
-// 기대 JSON: {"command":"PUMP_ON"} 등. 여기서는 문자열 비교만 수행.
-// 실제 하드웨어 제어 함수는 상위(esp32.c)에서 제공된다고 가정하지 않고,
-// 우선은 로그만 남기도록 기본 구현. 필요 시 약한 심볼(weak) 훅으로 연결 가능.
+// 응답 본문은 버퍼에 모으지 않고 조각마다 cmd_stream으로 바로 해석한다.
+// 한 번의 응답에 명령 배열이 올 수 있으며, 완결된 명령 객체만 모아 두었다가
+// 응답이 성공(2xx)일 때 순서대로 실행한다. 본문 뒷부분이 잘리거나 깨져도 앞의 명령은 유효.
 
 // 약한 훅: 상위 애플리케이션이 구현하면 해당 함수를 호출해 실제 동작
-__attribute__((weak)) void esp_handle_command(const char *command) {
-    // 기본 구현: 로그만 출력
-    ESP_LOGI(TAG, "Received command (default handler): %s", command);
+__attribute__((weak)) void esp_handle_command(const air_command_t *cmd) {
+    // 기본 구현: 로그만 출력 (이름은 응답 버퍼에 있으므로 %s로 남기지 않는다)
+    DLOG_I(NET, "Received command (default handler), seq=%u", (unsigned)cmd->seq);
 }
 
-esp_err_t poll_command_and_handle(void)
-{
-    esp_http_client_config_t config = {
-        .url = AIR_COMMAND_PULL_URL,
-        .method = HTTP_METHOD_GET,
-        .timeout_ms = 4000,
-    };
+typedef struct {
+    cmd_stream_t parser;
+    air_command_t cmds[AIR_POLL_MAX_COMMANDS];
+    int count;
+    int overflow;   // 용량을 넘어 버린 명령 수
+    int bytes;
+} poll_ctx_t;
 
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (client == NULL) {
-        ESP_LOGE(TAG, "HTTP client init failed (poll)");
-        return ESP_FAIL;
+static poll_ctx_t s_poll;   // 폴링은 한 태스크에서만 수행
+
+static void poll_collect(const air_command_t *cmd, void *ctx)
+{
+    poll_ctx_t *p = (poll_ctx_t *)ctx;
+    if (p->count < AIR_POLL_MAX_COMMANDS) {
+        p->cmds[p->count++] = *cmd;
+    } else {
+        p->overflow++;
     }
+}
+
+static void poll_body_feed(const char *data, int len, void *ctx)
+{
+    poll_ctx_t *p = (poll_ctx_t *)ctx;
+    p->bytes += len;
+    cmd_stream_feed(&p->parser, data, (size_t)len);
+}
+
+bool poll_command_and_handle(void)
+{
+    poll_ctx_t *p = &s_poll;
+    cmd_stream_init(&p->parser, poll_collect, p);
+    p->count = 0;
+    p->overflow = 0;
+    p->bytes = 0;
+    int status_code = 0;
 
-    esp_err_t err = esp_http_client_perform(client);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "HTTP GET failed: %s", esp_err_to_name(err));
-        esp_http_client_cleanup(client);
-        return err;
+    // POST와 같은 세션(연결)을 재사용
+    samples_ensure();
+    if (timed_request(HAL_HTTP_GET,
+                      device_url(s_pull_url, sizeof(s_pull_url), s_pull_fmt),
+                      NULL,
+                      0,
+                      NULL,
+                      poll_body_feed,
+                      p,
+                      &status_code) != 0) {
+        DLOG_E(NET, "HTTP GET failed");
+        return false;
     }
 
-    int status_code = esp_http_client_get_status_code(client);
-    int content_length = esp_http_client_get_content_length(client);
-    ESP_LOGI(TAG, "POLL status=%d, length=%d", status_code, content_length);
+    DLOG_I(NET, "POLL status=%d, length=%d, commands=%d", status_code, p->bytes, p->count);
 
     if (status_code == 204) { // No Content
-        esp_http_client_cleanup(client);
-        return ESP_OK;
-    }
-
-    // 본문 읽기
-    char buf[256];
-    int total_read = 0;
-    while (1) {
-        int r = esp_http_client_read(client, buf + total_read, sizeof(buf) - 1 - total_read);
-        if (r <= 0) break;
-        total_read += r;
-        if (total_read >= (int)sizeof(buf) - 1) break;
-    }
-    buf[total_read] = '\0';
-
-    ESP_LOGI(TAG, "POLL body: %s", buf);
-
-    // 매우 단순한 파싱: "command":"XXXX" 검색
-    const char *key = "\"command\"\s*:\s*\"";
-    const char *p = strstr(buf, "\"command\"");
-    if (p) {
-        p = strchr(p, '"'); // 첫 따옴표
-        if (p) p = strchr(p + 1, '"'); // key 끝 따옴표
-        if (p) {
-            p = strchr(p + 1, '"'); // 값 시작 따옴표
-            if (p) {
-                const char *start = p + 1;
-                const char *end = strchr(start, '"');
-                if (end && end > start) {
-                    char cmd[64];
-                    size_t n = (size_t)(end - start);
-                    if (n >= sizeof(cmd)) n = sizeof(cmd) - 1;
-                    memcpy(cmd, start, n);
-                    cmd[n] = '\0';
-                    esp_handle_command(cmd);
-                }
-            }
-        }
-    } else {
-        ESP_LOGW(TAG, "No 'command' field in response");
+        return true;
+    }
+    if (status_code < 200 || status_code >= 300) {
+        DLOG_W(NET, "POLL rejected by server (status=%d)", status_code);
+        return true;
     }
 
-    esp_http_client_cleanup(client);
-    return ESP_OK;
-}
\ No newline at end of file
+    if (!cmd_stream_finish(&p->parser)) {
+        DLOG_W(NET, "POLL body malformed at %d bytes (error=%d), using %d complete command(s)",
+                 p->bytes, (int)p->parser.error, p->count);
+    }
+    if (p->parser.dropped > 0 || p->overflow > 0) {
+        DLOG_W(NET, "POLL dropped %u invalid and %d excess command(s)",
+                 (unsigned)p->parser.dropped, p->overflow);
+    }
+    if (p->count == 0 && p->parser.error == CMD_STREAM_OK) {
+        DLOG_W(NET, "No 'command' field in response");
+    }
+
+    for (int i = 0; i < p->count; i++) {
+        esp_handle_command(&p->cmds[i]);
+    }
+
+    return true;
+}
@@ -1,38 +1,144 @@
 #pragma once
 
 #include <stdbool.h>
-#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+#include "cmd_stream.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// URL의 %s 자리에는 장치 ID(hal_device_id())가 들어간다. 여러 대가 같은 서버를 쓸 수 있도록
+// 장치별 경로를 쓴다.
 #ifndef AIR_QUALITY_POST_URL
-#define AIR_QUALITY_POST_URL "http://YOUR_SERVER_HOST:PORT/air-quality"
+#define AIR_QUALITY_POST_URL "http://YOUR_SERVER_HOST:PORT/air-quality?device_id=%s"
 #endif
 
 // Flutter/백엔드에서 ESP 명령을 가져오는 엔드포인트 (GET)
-// 예: http://YOUR_SERVER_HOST:PORT/esp/command?device_id=esp0001
+// 예: http://YOUR_SERVER_HOST:PORT/esp/command?device_id=esp-a1b2c3
 #ifndef AIR_COMMAND_PULL_URL
-#define AIR_COMMAND_PULL_URL "http://YOUR_SERVER_HOST:PORT/esp/command?device_id=esp0001"
+#define AIR_COMMAND_PULL_URL "http://YOUR_SERVER_HOST:PORT/esp/command?device_id=%s"
 #endif
 
+// 실행 중에 엔드포인트를 바꾼다 (device_config). 형식 문자열은 호출자가 계속 유지해야 하며
+// %s는 하나까지만 허용된다(검증은 호출자 몫). 다음 요청부터 적용.
+void air_http_set_urls(const char *post_fmt, const char *pull_fmt);
+
 // POST 이후 GET 폴링 자동 수행 여부
+// 명령은 MQTT 명령 토픽(air_app.c)으로도 푸시되지만, 푸시를 받지 못하는 서버/브로커 설정에서도
+// 명령이 전달되도록 기본값은 켬. 푸시만 쓰는 배포에서는 0으로 꺼서 GET을 줄일 수 있다.
 #ifndef AIR_POLL_AFTER_POST
 #define AIR_POLL_AFTER_POST 1
 #endif
 
-// temperature, humidity, pm25, pm10, bug 값을 서버로 POST 전송
-esp_err_t send_air_quality_data(float temperature,
-                                float humidity,
-                                int pm25,
-                                int pm10,
-                                bool bug);
+// 한 번의 폴링 응답에서 실행할 최대 명령 수 (넘는 명령은 버리고 경고)
+#ifndef AIR_POLL_MAX_COMMANDS
+#define AIR_POLL_MAX_COMMANDS 8
+#endif
+
+// 배치 전송 설정: 샘플을 링 버퍼에 모았다가 한 번의 POST로 보낸다
+#define AIR_TELEMETRY_FORMAT_JSON   0   // JSON 배열
+#define AIR_TELEMETRY_FORMAT_BINARY 1   // air_sample_buffer.h의 바이너리 프레임
+
+#ifndef AIR_TELEMETRY_FORMAT
+#define AIR_TELEMETRY_FORMAT AIR_TELEMETRY_FORMAT_JSON
+#endif
+
+#ifndef AIR_TELEMETRY_BATCH_SIZE
+#define AIR_TELEMETRY_BATCH_SIZE 10           // 배치당 최대 샘플 수 (이만큼 모이면 즉시 전송)
+#endif
+
+#ifndef AIR_TELEMETRY_FLUSH_INTERVAL_MS
+#define AIR_TELEMETRY_FLUSH_INTERVAL_MS 60000 // 덜 모였어도 이 간격이 지나면 전송
+#endif
+
+#ifndef AIR_TELEMETRY_BACKOFF_MIN_MS
+#define AIR_TELEMETRY_BACKOFF_MIN_MS 2000
+#endif
+
+#ifndef AIR_TELEMETRY_BACKOFF_MAX_MS
+#define AIR_TELEMETRY_BACKOFF_MAX_MS 120000
+#endif
+
+#ifndef AIR_TELEMETRY_MAX_BATCHES_PER_FLUSH
+#define AIR_TELEMETRY_MAX_BATCHES_PER_FLUSH 4 // 장애 복구 후 한 번에 밀어낼 최대 배치 수
+#endif
+
+// 변화 기반 보고 (telemetry_policy.h): 마지막 보고값에서 데드밴드를 넘게 바뀐 샘플과
+// 하트비트만 버퍼에 넣는다. 0이면 예전처럼 모든 샘플을 보낸다.
+#ifndef AIR_TELEMETRY_DEADBAND
+#define AIR_TELEMETRY_DEADBAND 1
+#endif
+
+#ifndef AIR_TELEMETRY_DEADBAND_TEMP_C
+#define AIR_TELEMETRY_DEADBAND_TEMP_C 0.3f
+#endif
+
+#ifndef AIR_TELEMETRY_DEADBAND_HUM_PCT
+#define AIR_TELEMETRY_DEADBAND_HUM_PCT 2.0f
+#endif
+
+#ifndef AIR_TELEMETRY_DEADBAND_PM
+#define AIR_TELEMETRY_DEADBAND_PM 5           // µg/m³, 또는 마지막 값의 PM_PCT% 중 큰 쪽
+#endif
+
+#ifndef AIR_TELEMETRY_DEADBAND_PM_PCT
+#define AIR_TELEMETRY_DEADBAND_PM_PCT 15
+#endif
+
+#ifndef AIR_TELEMETRY_HEARTBEAT_MS
+#define AIR_TELEMETRY_HEARTBEAT_MS 300000     // 변화가 없어도 이 간격마다 한 샘플
+#endif
+
+#ifndef AIR_TELEMETRY_MIN_INTERVAL_MS
+#define AIR_TELEMETRY_MIN_INTERVAL_MS 15000   // 변화 샘플 사이 최소 간격 (벌레 감지 변화는 예외)
+#endif
+
+// HTTP 타임아웃은 측정한 RTT로 정한다 (rtt_estimator.h). POST와 GET이 같은 서버/연결을 쓰므로 공유.
+#ifndef AIR_HTTP_TIMEOUT_INITIAL_MS
+#define AIR_HTTP_TIMEOUT_INITIAL_MS 5000      // 첫 응답 전 (예전 고정값)
+#endif
+
+#ifndef AIR_HTTP_TIMEOUT_MIN_MS
+#define AIR_HTTP_TIMEOUT_MIN_MS 1000
+#endif
+
+#ifndef AIR_HTTP_TIMEOUT_MAX_MS
+#define AIR_HTTP_TIMEOUT_MAX_MS 8000
+#endif
+
+// temperature, humidity, pm25, pm10, bug 샘플을 버퍼에 넣고, 배치 조건이 되면 서버로 POST 전송
+// 전송 실패 시 false. 샘플은 버퍼에 남고 백오프 후 재전송된다.
+bool send_air_quality_data(float temperature,
+                           float humidity,
+                           int pm25,
+                           int pm10,
+                           bool bug);
+
+typedef struct {
+    uint32_t offered;       // send_air_quality_data()로 들어온 샘플
+    uint32_t reported;      // 그중 버퍼에 넣은 샘플
+    uint32_t heartbeats;
+    uint32_t posts;         // 성공한 POST
+    uint32_t http_timeout_ms;   // 다음 요청의 타임아웃
+    uint32_t http_srtt_ms;      // 0이면 아직 표본 없음
+    uint32_t http_failures;
+} air_telemetry_stats_t;
+
+void air_telemetry_get_stats(air_telemetry_stats_t *out);
+
+// 버퍼에 쌓인 샘플 전송. force=false면 배치 크기/주기/백오프 조건을 확인한다. 전송 실패 시 false.
+bool air_telemetry_flush(bool force);
 
 // 명령 폴링: 서버에서 JSON 명령을 GET으로 수신 후 처리
-// 기대 JSON 예시: {"command":"PUMP_ON"} 또는 {"command":"WINDOW_OPEN"}
-// 처리 결과를 로그로 남기며, 인식 불가 시 ESP_OK로 반환하되 경고 로그 출력
-esp_err_t poll_command_and_handle(void);
+// 기대 JSON 예시: {"command":"PUMP_ON"} 또는
+//   {"commands":[{"command":"WINDOW_OPEN","seq":41},{"command":"PUMP_ON","value":3000,"seq":42}]}
+// 형식은 cmd_stream.h 참고. 요청 자체가 실패하면 false, 인식 불가 응답은 true로 반환하되 경고 로그 출력
+bool poll_command_and_handle(void);
+
+// 폴링으로 받은 명령 하나를 실행 (약한 기본 구현은 로그만 남김)
+void esp_handle_command(const air_command_t *cmd);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,131 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_http_client.h"
+#include "esp_http_session.h"
+
+static const char *TAG = "AIR_HTTP_SESSION";
+
+static esp_http_client_handle_t s_client = NULL;
+static air_http_stats_t s_stats;
+
+// 진행 중인 요청의 본문 콜백과 연결 여부 (이벤트 핸들러에서 사용)
+static air_http_body_cb s_on_body = NULL;
+static void *s_body_ctx = NULL;
+static bool s_connected_now = false;
+
+static esp_err_t session_event_handler(esp_http_client_event_t *evt)
+{
+    switch (evt->event_id) {
+    case HTTP_EVENT_ON_CONNECTED:
+        // keep-alive 연결을 재사용하면 이 이벤트가 발생하지 않는다
+        s_connected_now = true;
+        s_stats.handshakes++;
+        break;
+    case HTTP_EVENT_ON_DATA:
+        if (s_on_body && evt->data_len > 0) {
+            s_on_body((const char *)evt->data, evt->data_len, s_body_ctx);
+        }
+        break;
+    default:
+        break;
+    }
+    return ESP_OK;
+}
+
+static void session_reset(void)
+{
+    if (s_client) {
+        esp_http_client_cleanup(s_client);
+        s_client = NULL;
+        s_stats.resets++;
+    }
+}
+
+static esp_err_t session_ensure(const char *url, int timeout_ms)
+{
+    if (s_client) {
+        return ESP_OK;
+    }
+
+    esp_http_client_config_t config = {
+        .url = url,
+        .timeout_ms = timeout_ms,
+        .keep_alive_enable = true,
+        .event_handler = session_event_handler,
+    };
+
+    s_client = esp_http_client_init(&config);
+    if (s_client == NULL) {
+        ESP_LOGE(TAG, "HTTP 클라이언트 초기화 실패");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t air_http_request(esp_http_client_method_t method,
+                           const char *url,
+                           const char *body,
+                           int body_len,
+                           const char *content_type,
+                           int timeout_ms,
+                           air_http_body_cb on_body,
+                           void *ctx,
+                           int *status_code)
+{
+    esp_err_t err = session_ensure(url, timeout_ms);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // 같은 호스트면 esp_http_client가 기존 연결을 유지한다
+    esp_http_client_set_url(s_client, url);
+    esp_http_client_set_method(s_client, method);
+    esp_http_client_set_timeout_ms(s_client, timeout_ms);
+    if (body) {
+        esp_http_client_set_header(s_client, "Content-Type", content_type);
+        esp_http_client_set_post_field(s_client, body, body_len);
+    } else {
+        esp_http_client_delete_header(s_client, "Content-Type");
+        esp_http_client_set_post_field(s_client, NULL, 0);
+    }
+
+    s_on_body = on_body;
+    s_body_ctx = ctx;
+    s_connected_now = false;
+    s_stats.requests++;
+
+    err = esp_http_client_perform(s_client);
+
+    s_on_body = NULL;
+    s_body_ctx = NULL;
+
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "요청 실패, 세션 폐기: %s", esp_err_to_name(err));
+        session_reset();
+        return err;
+    }
+
+    if (!s_connected_now) {
+        s_stats.reused++;
+    }
+    if (status_code) {
+        *status_code = esp_http_client_get_status_code(s_client);
+    }
+    return ESP_OK;
+}
+
+void air_http_close(void)
+{
+    if (s_client) {
+        esp_http_client_cleanup(s_client);
+        s_client = NULL;
+    }
+}
+
+void air_http_get_stats(air_http_stats_t *out)
+{
+    *out = s_stats;
+}
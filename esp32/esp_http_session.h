@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_client.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 장수명(keep-alive) HTTP 클라이언트 세션
+// POST(텔레메트리)와 GET(명령 폴링)이 하나의 esp_http_client 핸들과 연결을 공유한다.
+// 연결이 끊기거나 요청이 실패하면 핸들을 폐기하고, 다음 요청 때 다시 연결한다(lazy reconnect).
+// 단일 태스크에서만 호출한다고 가정한다.
+
+typedef struct {
+    uint32_t requests;    // 수행한 요청 수
+    uint32_t handshakes;  // 새로 맺은 TCP(/TLS) 연결 수
+    uint32_t reused;      // 기존 연결을 재사용한 요청 수
+    uint32_t resets;      // 오류로 세션을 폐기한 횟수
+} air_http_stats_t;
+
+// 응답 본문 조각을 받을 때마다 호출 (NULL이면 본문 무시)
+typedef void (*air_http_body_cb)(const char *data, int len, void *ctx);
+
+// body가 NULL이면 본문 없이 요청(content_type 무시). status_code는 NULL 가능.
+esp_err_t air_http_request(esp_http_client_method_t method,
+                           const char *url,
+                           const char *body,
+                           int body_len,
+                           const char *content_type,
+                           int timeout_ms,
+                           air_http_body_cb on_body,
+                           void *ctx,
+                           int *status_code);
+
+// 세션 연결을 명시적으로 닫음 (다음 요청 시 재연결)
+void air_http_close(void);
+
+void air_http_get_stats(air_http_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
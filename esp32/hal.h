@@ -0,0 +1,204 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 하드웨어 추상화 계층 (HAL)
+// air_app.c와 esp_http_pull.c는 시계, GPIO/서보, I2C 온습도 센서, UART, Wi-Fi, HTTP 클라이언트,
+// MQTT 클라이언트를 이 인터페이스로만 사용한다.
+//   - hal_esp32.cpp: Arduino/ESP-IDF 백엔드 (ARDUINO가 정의된 빌드)
+//   - hal_posix.c:   리눅스 호스트 백엔드 (시뮬레이션 센서, 소켓 기반 HTTP/MQTT)
+// Task handoff 절을 빼면 모든 함수는 loop() 컨텍스트(단일 태스크)에서 호출한다고 가정한다.
+
+// ---------- Clock ----------
+uint32_t hal_millis(void);
+uint32_t hal_micros(void);
+
+// 벽시계 (epoch ms). hal_time_sync() 뒤 SNTP로 맞춰지기 전까지 0.
+void hal_time_sync(const char *ntp_server);
+uint64_t hal_epoch_ms(void);
+
+// ---------- Power ----------
+// light sleep: CPU와 라디오를 멈추고 ms가 지나거나 wake_gpio(-1이면 없음)가 LOW가 되면 깨어난다.
+// Wi-Fi 연결은 유지되지 않으므로 링크가 끊겨 있을 때만 쓴다. 실제로 멈춰 있던 시간(us)을 반환.
+uint32_t hal_light_sleep(uint32_t ms, int wake_gpio);
+
+void hal_set_cpu_mhz(uint32_t mhz);
+
+// ---------- System ----------
+uint32_t hal_random(void);
+
+typedef struct {
+    uint32_t free;
+    uint32_t min_free;      // 부팅 이후 최저
+    uint32_t max_alloc;     // 한 번에 할당할 수 있는 가장 큰 블록
+} hal_heap_stats_t;
+
+void hal_heap_stats(hal_heap_stats_t *out);
+
+// 태스크 사이에 작은 구조체를 복사할 때 쓰는 전역 임계 구역 (중첩 불가, 안에서 블로킹 금지)
+void hal_critical_enter(void);
+void hal_critical_exit(void);
+
+// ---------- Identity ----------
+// 토픽/URL 네임스페이스와 MQTT client ID로 쓰는 장치 ID.
+// AIR_DEVICE_ID로 고정할 수 있고, 없으면 ESP32는 MAC 하위 3바이트("esp-a1b2c3"),
+// 호스트는 환경 변수 AIR_DEVICE_ID 또는 호스트 이름을 쓴다.
+const char *hal_device_id(void);
+
+// ---------- GPIO / Servo ----------
+void hal_gpio_output(int pin);
+void hal_gpio_write(int pin, bool level);
+
+// initial_deg로 바로 펄스를 내보낸다 (부팅 시 마지막 위치에서 시작해 서보가 튀지 않도록)
+bool hal_servo_attach(int pin, int min_pulse_us, int max_pulse_us, int initial_deg);
+void hal_servo_write(int angle_deg);
+
+// ---------- I2C temperature/humidity sensor (SHT31) ----------
+// 버스를 초기화하고 0x44, 0x45 순서로 센서를 찾는다
+bool hal_env_begin(int sda_pin, int scl_pin);
+// 한 번의 측정으로 온도/습도를 함께 읽는다
+bool hal_env_read(float *temperature, float *humidity);
+
+// ---------- UART ----------
+// 로그 출력 (UART0). 쓰기 전에 hal_log_writable()로 자리를 확인하면 기다리지 않는다.
+void hal_log_begin(size_t tx_buffer);
+int  hal_log_writable(void);
+void hal_log_write(const uint8_t *data, size_t len);
+
+// PMS5003 포트 (UART2, 8N1). read는 이미 받은 바이트만 꺼내고 기다리지 않는다.
+void hal_uart_begin(uint32_t baud, int rx_pin, int tx_pin, size_t rx_buffer);
+size_t hal_uart_read(uint8_t *buf, size_t cap);
+
+// ---------- Wi-Fi (station) ----------
+// 연결과 재시도 정책은 호출자(conn_manager)가 가진다: 자동 재연결과 절전은 꺼진 채로 시작한다.
+void hal_wifi_init(void);
+void hal_wifi_begin(const char *ssid, const char *password);
+void hal_wifi_disconnect(void);
+bool hal_wifi_connected(void);
+int  hal_wifi_rssi(void);               // 연결돼 있지 않으면 0
+uint32_t hal_wifi_local_ip(void);       // IPv4, 첫 옥텟이 하위 바이트
+uint32_t hal_wifi_gateway_ip(void);
+void hal_wifi_set_sleep(bool modem_sleep);
+
+// ---------- Persistent storage ----------
+// 작은 blob 키-값 저장소 (ESP32: NVS 네임스페이스 "air", 호스트: AIR_STORE_DIR 디렉터리의 파일).
+// read는 읽은 바이트 수(값이 cap보다 크면 0), 키가 없으면 -1을 반환한다.
+int  hal_store_read(const char *key, void *buf, size_t cap);
+bool hal_store_write(const char *key, const void *data, size_t len);
+
+// ---------- HTTP client ----------
+typedef enum {
+    HAL_HTTP_GET = 0,
+    HAL_HTTP_POST,
+} hal_http_method_t;
+
+typedef struct {
+    uint32_t requests;    // 수행한 요청 수
+    uint32_t handshakes;  // 새로 맺은 연결 수
+    uint32_t reused;      // 기존 연결을 재사용한 요청 수
+    uint32_t resets;      // 오류로 연결을 폐기한 횟수
+} hal_http_stats_t;
+
+// 응답 본문 조각을 받을 때마다 호출 (NULL이면 본문 무시)
+typedef void (*hal_http_body_cb)(const char *data, int len, void *ctx);
+
+// body가 NULL이면 본문 없이 요청. 성공하면 0, 전송 오류면 음수. status_code는 NULL 가능.
+int hal_http_request(hal_http_method_t method,
+                     const char *url,
+                     const char *body,
+                     int body_len,
+                     const char *content_type,
+                     int timeout_ms,
+                     hal_http_body_cb on_body,
+                     void *ctx,
+                     int *status_code);
+
+void hal_http_get_stats(hal_http_stats_t *out);
+
+// ---------- MQTT client ----------
+typedef void (*hal_mqtt_message_cb)(const char *topic, const uint8_t *payload, unsigned int length);
+
+void hal_mqtt_setup(const char *host, uint16_t port, hal_mqtt_message_cb on_message);
+// keep-alive 간격 (다음 연결부터 적용). 길수록 유휴 중 PINGREQ 송신이 줄어든다.
+void hal_mqtt_set_keepalive(uint16_t seconds);
+// 한 번만 시도 (재시도는 호출자가 담당).
+// will_topic이 NULL이 아니면 비정상 종료 시 브로커가 will_message를 retain으로 발행한다.
+bool hal_mqtt_connect(const char *client_id, const char *user, const char *password,
+                      const char *will_topic, const char *will_message);
+bool hal_mqtt_connected(void);
+// 연결을 끊는다 (서버/계정이 바뀐 뒤 호출자가 다시 연결하도록)
+void hal_mqtt_disconnect(void);
+int  hal_mqtt_state(void);   // 마지막 연결 결과 (PubSubClient의 rc 값 체계)
+bool hal_mqtt_subscribe(const char *topic);
+bool hal_mqtt_publish(const char *topic, const uint8_t *payload, unsigned int length, bool retain);
+// 수신 메시지를 처리하고 keep-alive를 유지. 블로킹하지 않는다.
+void hal_mqtt_loop(void);
+
+// 백그라운드 연결: hal_mqtt_connect()를 연결 태스크에서 실행하고 바로 반환한다. DNS 조회, TCP 연결,
+// CONNACK 대기가 loop()를 막지 않는다. 인자는 복사한다. 이전 시도가 아직 진행 중이면 false.
+// 시도가 끝날 때까지(poll이 PENDING이 아닐 때까지) 연결 태스크가 클라이언트를 가지며,
+// 그동안 setup/disconnect/subscribe/publish/loop는 아무 일도 하지 않고 connected는 false다.
+typedef enum {
+    HAL_MQTT_CONNECT_IDLE = 0,      // 시작한 적 없음
+    HAL_MQTT_CONNECT_PENDING,
+    HAL_MQTT_CONNECT_OK,
+    HAL_MQTT_CONNECT_FAILED,        // 원인은 hal_mqtt_state()
+} hal_mqtt_connect_status_t;
+
+bool hal_mqtt_connect_start(const char *client_id, const char *user, const char *password,
+                            const char *will_topic, const char *will_message);
+// 마지막 시도의 결과 (다음 start까지 그대로). 어느 태스크에서나 호출할 수 있다.
+hal_mqtt_connect_status_t hal_mqtt_connect_poll(void);
+
+// ---------- Task handoff ----------
+// 다른 태스크(httpd 등)와 loop() 사이의 고정 크기 FIFO 큐와 태스크 알림.
+// ESP32: FreeRTOS 큐와 태스크 알림, 호스트: pthread. 이 절의 함수는 어느 태스크에서나 호출할 수 있다.
+typedef struct hal_queue hal_queue_t;
+typedef void *hal_task_t;
+
+hal_queue_t *hal_queue_create(unsigned int depth, size_t item_size);
+// 가득 차 있거나 비어 있으면 기다리지 않고 false
+bool hal_queue_send(hal_queue_t *queue, const void *item);
+bool hal_queue_receive(hal_queue_t *queue, void *item);
+// 항목이 들어올 때까지 최대 timeout_ms 기다려 맨 앞 항목을 꺼내지 않고 복사한다. 있으면 true.
+bool hal_queue_peek(hal_queue_t *queue, void *item, uint32_t timeout_ms);
+
+hal_task_t hal_task_current(void);
+// task를 깨운다. 기다리고 있지 않으면 다음 hal_task_wait()가 바로 돌아온다.
+void hal_task_notify(hal_task_t task);
+// 알림을 받으면 (모두 소모하고) true, timeout_ms가 지나면 false
+bool hal_task_wait(uint32_t timeout_ms);
+
+#if !defined(ARDUINO)
+// ---------- Host-only simulation hooks (hal_posix.c) ----------
+// ok=false면 SHT31이 버스에 없다 (주소 NACK)
+void hal_sim_set_env(float temperature, float humidity, bool ok);
+typedef enum {
+    HAL_SIM_I2C_OK = 0,
+    HAL_SIM_I2C_NACK,       // 센서가 응답하지 않음
+    HAL_SIM_I2C_CRC,        // 데이터 비트 하나가 뒤집혀 CRC가 맞지 않음
+    HAL_SIM_I2C_STUCK,      // SDA/SCL이 붙잡혀 버스 타임아웃까지 기다림
+} hal_sim_i2c_fault_t;
+// 다음 reads번의 hal_env_read()에 고장을 넣는다 (UINT32_MAX면 풀 때까지)
+void hal_sim_env_fault(hal_sim_i2c_fault_t fault, uint32_t reads);
+bool hal_sim_gpio_level(int pin);
+int  hal_sim_servo_angle(void);
+// 시뮬레이션 시계: 켜면 hal_millis()/hal_micros()는 이 값을 돌려주고
+// hal_light_sleep()은 실제로 자지 않고 시계를 (ms + wake_latency_us)만큼 앞당긴다.
+void hal_sim_clock_enable(uint32_t start_ms, uint32_t wake_latency_us);
+void hal_sim_clock_advance_us(uint32_t us);
+// AP가 사라지면 hal_wifi_connected()가 false, 돌아오면 다음 hal_wifi_begin()부터 연결된다
+void hal_sim_set_wifi(bool available);
+// PMS5003 포트로 들어올 바이트 (hal_uart_read()가 꺼낸다)
+void hal_sim_uart_feed(const uint8_t *data, size_t len);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,352 @@
+// HAL의 ESP32(Arduino) 백엔드
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Wire.h>
+#include <PubSubClient.h>   // MQTT
+#include <esp_random.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <sys/time.h>       // gettimeofday (SNTP epoch)
+#include <driver/gpio.h>
+#include <nvs.h>
+#include <nvs_flash.h>
+#include "Adafruit_SHT31.h" // SHT31
+#include <ESP32Servo.h>     // Servo
+#include "dlog.h"
+#include "esp_http_session.h"
+#include "hal.h"
+
+static Adafruit_SHT31 sht31;
+static Servo          servo;
+static WiFiClient     mqttNet;
+static PubSubClient   mqtt(mqttNet);
+
+// PubSubClient waits this long for CONNACK (library default is 15 s)
+#define HAL_MQTT_SOCKET_TIMEOUT_S 2
+// Largest packet in or out; config updates carry URLs (library default is 256)
+#define HAL_MQTT_BUFFER_SIZE 1024
+// DNS lookup and WiFiClient::connect() run on this stack
+#define HAL_MQTT_CONNECT_STACK 4096
+
+static bool hasSHT31 = false;
+static hal_mqtt_message_cb mqttHandler = NULL;
+// PubSubClient keeps the host pointer and the connect task reads it later, so it
+// gets its own copy: the caller's buffer (the live config) may be replaced meanwhile.
+static char mqttHost[128];
+
+// ---------- Clock ----------
+uint32_t hal_millis(void) { return millis(); }
+uint32_t hal_micros(void) { return micros(); }
+
+void hal_time_sync(const char* ntp_server) { configTime(0, 0, ntp_server); }
+
+uint64_t hal_epoch_ms(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  if (tv.tv_sec < 1600000000) return 0;   // not synced yet
+  return (uint64_t)tv.tv_sec * 1000ULL + tv.tv_usec / 1000;
+}
+
+// ---------- Power ----------
+// Pending UART output is flushed first: the UART stops while the clocks are gated.
+uint32_t hal_light_sleep(uint32_t ms, int wake_gpio) {
+  Serial.flush();
+  esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000ULL);
+  if (wake_gpio >= 0) {
+    gpio_wakeup_enable((gpio_num_t)wake_gpio, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+  }
+  int64_t t0 = esp_timer_get_time();
+  esp_light_sleep_start();
+  int64_t slept = esp_timer_get_time() - t0;   // esp_timer keeps counting across light sleep
+  if (wake_gpio >= 0) gpio_wakeup_disable((gpio_num_t)wake_gpio);
+  esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+  return (uint32_t)slept;
+}
+
+void hal_set_cpu_mhz(uint32_t mhz) { setCpuFrequencyMhz(mhz); }
+
+// ---------- System ----------
+uint32_t hal_random(void) { return esp_random(); }
+
+void hal_heap_stats(hal_heap_stats_t* out) {
+  out->free      = ESP.getFreeHeap();
+  out->min_free  = ESP.getMinFreeHeap();
+  out->max_alloc = ESP.getMaxAllocHeap();
+}
+
+static portMUX_TYPE criticalMux = portMUX_INITIALIZER_UNLOCKED;
+void hal_critical_enter(void) { portENTER_CRITICAL(&criticalMux); }
+void hal_critical_exit(void)  { portEXIT_CRITICAL(&criticalMux); }
+
+// ---------- Identity ----------
+const char* hal_device_id(void) {
+#ifdef AIR_DEVICE_ID
+  return AIR_DEVICE_ID;
+#else
+  static char id[12];
+  if (!id[0]) {
+    uint64_t mac = ESP.getEfuseMac();   // octet 0 in the low byte
+    snprintf(id, sizeof(id), "esp-%02x%02x%02x",
+             (unsigned)(mac >> 24) & 0xFF, (unsigned)(mac >> 32) & 0xFF, (unsigned)(mac >> 40) & 0xFF);
+  }
+  return id;
+#endif
+}
+
+// ---------- GPIO / Servo ----------
+void hal_gpio_output(int pin) { pinMode(pin, OUTPUT); }
+void hal_gpio_write(int pin, bool level) { digitalWrite(pin, level ? HIGH : LOW); }
+
+// attach() starts on the library default (1500 us); the write lands before the
+// first 20 ms frame ends, too short for the horn to move.
+bool hal_servo_attach(int pin, int min_pulse_us, int max_pulse_us, int initial_deg) {
+  if (servo.attach(pin, min_pulse_us, max_pulse_us) < 0) return false;
+  servo.write(initial_deg);
+  return true;
+}
+void hal_servo_write(int angle_deg) { servo.write(angle_deg); }
+
+// ---------- I2C sensor ----------
+bool hal_env_begin(int sda_pin, int scl_pin) {
+  Wire.begin(sda_pin, scl_pin);
+  Wire.setClock(100000); // 100kHz for stability
+
+  // Try SHT31 on both common addresses
+  hasSHT31 = sht31.begin(0x44);
+  if (!hasSHT31) {
+    DLOG_I(SENSOR, "SHT31 @0x44 not found, trying 0x45");
+    hasSHT31 = sht31.begin(0x45);
+  }
+  return hasSHT31;
+}
+
+bool hal_env_read(float* temperature, float* humidity) {
+  if (!hasSHT31) return false;
+  return sht31.readBoth(temperature, humidity);  // one combined I2C measurement
+}
+
+// ---------- UART ----------
+void hal_log_begin(size_t tx_buffer) {
+  Serial.setTxBufferSize(tx_buffer);
+  Serial.begin(115200, SERIAL_8N1);
+}
+int  hal_log_writable(void) { return Serial.availableForWrite(); }
+void hal_log_write(const uint8_t* data, size_t len) { Serial.write(data, len); }
+
+// The UART driver's ISR fills the RX ring buffer
+void hal_uart_begin(uint32_t baud, int rx_pin, int tx_pin, size_t rx_buffer) {
+  Serial2.setRxBufferSize(rx_buffer);
+  Serial2.begin(baud, SERIAL_8N1, rx_pin, tx_pin);
+}
+
+size_t hal_uart_read(uint8_t* buf, size_t cap) {
+  int avail = Serial2.available();
+  if (avail <= 0) return 0;
+  return Serial2.readBytes(buf, (size_t)avail < cap ? (size_t)avail : cap);
+}
+
+// ---------- Wi-Fi ----------
+void hal_wifi_init(void) {
+  WiFi.mode(WIFI_STA);
+  WiFi.setSleep(false);           // hal_wifi_set_sleep() enables modem-sleep for low power
+  WiFi.setAutoReconnect(false);   // conn_manager owns the retry policy
+}
+
+void hal_wifi_begin(const char* ssid, const char* password) {
+  WiFi.disconnect();
+  WiFi.begin(ssid, password);
+}
+
+void hal_wifi_disconnect(void) { WiFi.disconnect(); }
+bool hal_wifi_connected(void)  { return WiFi.status() == WL_CONNECTED; }
+int  hal_wifi_rssi(void)       { return hal_wifi_connected() ? WiFi.RSSI() : 0; }
+uint32_t hal_wifi_local_ip(void)   { return WiFi.localIP(); }
+uint32_t hal_wifi_gateway_ip(void) { return WiFi.gatewayIP(); }
+void hal_wifi_set_sleep(bool modem_sleep) { WiFi.setSleep(modem_sleep); }
+
+// ---------- Persistent storage (NVS) ----------
+// One handle for the whole run. nvs_set_blob + nvs_commit replace the entry as a
+// whole; NVS spreads the writes over its pages itself.
+static nvs_handle_t storeHandle;
+static bool storeOpen = false;
+
+static bool store_open() {
+  if (storeOpen) return true;
+  esp_err_t err = nvs_flash_init();   // already done by the Arduino core; cheap if so
+  if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+    nvs_flash_erase();
+    err = nvs_flash_init();
+  }
+  if (err == ESP_OK) err = nvs_open("air", NVS_READWRITE, &storeHandle);
+  if (err != ESP_OK) {
+    DLOG_E(SYS, "NVS open failed: %s", esp_err_to_name(err));
+    return false;
+  }
+  storeOpen = true;
+  return true;
+}
+
+int hal_store_read(const char* key, void* buf, size_t cap) {
+  if (!store_open()) return -1;
+  size_t len = cap;
+  esp_err_t err = nvs_get_blob(storeHandle, key, buf, &len);
+  if (err == ESP_ERR_NVS_NOT_FOUND) return -1;
+  if (err == ESP_ERR_NVS_INVALID_LENGTH) return 0;
+  return err == ESP_OK ? (int)len : -1;
+}
+
+bool hal_store_write(const char* key, const void* data, size_t len) {
+  if (!store_open()) return false;
+  esp_err_t err = nvs_set_blob(storeHandle, key, data, len);
+  if (err == ESP_OK) err = nvs_commit(storeHandle);
+  if (err != ESP_OK) DLOG_W(SYS, "NVS write %s failed: %s", key, esp_err_to_name(err));
+  return err == ESP_OK;
+}
+
+// ---------- HTTP client ----------
+// Shares the keep-alive esp_http_client session
+int hal_http_request(hal_http_method_t method, const char* url, const char* body, int body_len,
+                     const char* content_type, int timeout_ms, hal_http_body_cb on_body, void* ctx,
+                     int* status_code) {
+  esp_http_client_method_t m = method == HAL_HTTP_POST ? HTTP_METHOD_POST : HTTP_METHOD_GET;
+  esp_err_t err = air_http_request(m, url, body, body_len, content_type, timeout_ms,
+                                   on_body, ctx, status_code);
+  return err == ESP_OK ? 0 : -1;
+}
+
+void hal_http_get_stats(hal_http_stats_t* out) {
+  air_http_stats_t s;
+  air_http_get_stats(&s);
+  out->requests   = s.requests;
+  out->handshakes = s.handshakes;
+  out->reused     = s.reused;
+  out->resets     = s.resets;
+}
+
+// ---------- MQTT client ----------
+static void mqtt_dispatch(char* topic, uint8_t* payload, unsigned int length) {
+  if (mqttHandler) mqttHandler(topic, payload, length);
+}
+
+// The connect task owns the client while an attempt is pending
+static hal_mqtt_connect_status_t mqttConnectStatus = HAL_MQTT_CONNECT_IDLE;
+
+static bool mqtt_busy(void) {
+  return __atomic_load_n(&mqttConnectStatus, __ATOMIC_ACQUIRE) == HAL_MQTT_CONNECT_PENDING;
+}
+
+void hal_mqtt_setup(const char* host, uint16_t port, hal_mqtt_message_cb on_message) {
+  if (mqtt_busy()) return;
+  mqttHandler = on_message;
+  snprintf(mqttHost, sizeof(mqttHost), "%s", host);
+  mqtt.setServer(mqttHost, port);
+  mqtt.setCallback(mqtt_dispatch);
+  mqtt.setSocketTimeout(HAL_MQTT_SOCKET_TIMEOUT_S);   // bounds how long a connect attempt can block
+  mqtt.setBufferSize(HAL_MQTT_BUFFER_SIZE);
+}
+
+// Only stored here: the client may belong to the connect task, and the interval
+// of a live session was agreed at CONNECT. hal_mqtt_connect() applies it.
+static uint16_t mqttKeepAliveS = MQTT_KEEPALIVE;
+
+void hal_mqtt_set_keepalive(uint16_t seconds) {
+  __atomic_store_n(&mqttKeepAliveS, seconds, __ATOMIC_RELAXED);
+}
+
+// The caller owns the client: the connect task, or loop() with no attempt pending
+bool hal_mqtt_connect(const char* client_id, const char* user, const char* password,
+                      const char* will_topic, const char* will_message) {
+  mqtt.setKeepAlive(__atomic_load_n(&mqttKeepAliveS, __ATOMIC_RELAXED));
+  if (will_topic) return mqtt.connect(client_id, user, password, will_topic, 0, true, will_message);
+  return mqtt.connect(client_id, user, password);
+}
+
+bool hal_mqtt_connected(void) { return !mqtt_busy() && mqtt.connected(); }
+void hal_mqtt_disconnect(void) { if (!mqtt_busy()) mqtt.disconnect(); }
+int  hal_mqtt_state(void)     { return mqtt.state(); }
+bool hal_mqtt_subscribe(const char* topic) { return !mqtt_busy() && mqtt.subscribe(topic); }
+
+bool hal_mqtt_publish(const char* topic, const uint8_t* payload, unsigned int length, bool retain) {
+  return !mqtt_busy() && mqtt.publish(topic, payload, length, retain);
+}
+
+void hal_mqtt_loop(void) { if (!mqtt_busy()) mqtt.loop(); }
+
+// ---------- MQTT background connect ----------
+static TaskHandle_t mqttConnectTask = NULL;
+static struct {
+  char client_id[32];
+  char user[32];
+  char password[64];
+  char will_topic[96];
+  char will_message[16];
+  bool has_user, has_password, has_will;
+} mqttConnectArgs;
+
+static void mqtt_connect_task(void* arg) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    const auto& a = mqttConnectArgs;
+    bool ok = hal_mqtt_connect(a.client_id, a.has_user ? a.user : NULL, a.has_password ? a.password : NULL,
+                               a.has_will ? a.will_topic : NULL, a.has_will ? a.will_message : NULL);
+    __atomic_store_n(&mqttConnectStatus, ok ? HAL_MQTT_CONNECT_OK : HAL_MQTT_CONNECT_FAILED, __ATOMIC_RELEASE);
+  }
+}
+
+static bool copy_arg(char* dst, size_t cap, const char* src, bool* present) {
+  if (present) *present = src != NULL;
+  if (!src) src = "";
+  return (size_t)snprintf(dst, cap, "%s", src) < cap;
+}
+
+bool hal_mqtt_connect_start(const char* client_id, const char* user, const char* password,
+                            const char* will_topic, const char* will_message) {
+  if (mqtt_busy()) return false;
+  if (!mqttConnectTask &&
+      xTaskCreate(mqtt_connect_task, "mqtt_connect", HAL_MQTT_CONNECT_STACK, NULL, 1, &mqttConnectTask) != pdPASS) {
+    mqttConnectTask = NULL;
+    return false;
+  }
+  auto& a = mqttConnectArgs;
+  if (!copy_arg(a.client_id, sizeof(a.client_id), client_id, NULL) ||
+      !copy_arg(a.user, sizeof(a.user), user, &a.has_user) ||
+      !copy_arg(a.password, sizeof(a.password), password, &a.has_password) ||
+      !copy_arg(a.will_topic, sizeof(a.will_topic), will_topic, &a.has_will) ||
+      !copy_arg(a.will_message, sizeof(a.will_message), will_message, NULL)) {
+    __atomic_store_n(&mqttConnectStatus, HAL_MQTT_CONNECT_FAILED, __ATOMIC_RELEASE);
+    return false;
+  }
+  __atomic_store_n(&mqttConnectStatus, HAL_MQTT_CONNECT_PENDING, __ATOMIC_RELEASE);
+  xTaskNotifyGive(mqttConnectTask);
+  return true;
+}
+
+hal_mqtt_connect_status_t hal_mqtt_connect_poll(void) {
+  return __atomic_load_n(&mqttConnectStatus, __ATOMIC_ACQUIRE);
+}
+
+// ---------- Task handoff (FreeRTOS) ----------
+hal_queue_t* hal_queue_create(unsigned int depth, size_t item_size) {
+  return (hal_queue_t*)xQueueCreate(depth, item_size);
+}
+
+bool hal_queue_send(hal_queue_t* queue, const void* item) {
+  return xQueueSend((QueueHandle_t)queue, item, 0) == pdTRUE;
+}
+
+bool hal_queue_receive(hal_queue_t* queue, void* item) {
+  return xQueueReceive((QueueHandle_t)queue, item, 0) == pdTRUE;
+}
+
+bool hal_queue_peek(hal_queue_t* queue, void* item, uint32_t timeout_ms) {
+  return xQueuePeek((QueueHandle_t)queue, item, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+hal_task_t hal_task_current(void) { return (hal_task_t)xTaskGetCurrentTaskHandle(); }
+void hal_task_notify(hal_task_t task) { xTaskNotifyGive((TaskHandle_t)task); }
+bool hal_task_wait(uint32_t timeout_ms) { return ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms)) != 0; }
+
+#endif // ARDUINO
@@ -0,0 +1,1292 @@
+// HAL의 POSIX(리눅스 호스트) 백엔드
+// 센서는 시뮬레이션 값을, HTTP/MQTT는 실제 소켓을 사용하므로
+// 로컬 브로커(mosquitto 등)와 스텁 HTTP 서버를 상대로 펌웨어 로직을 돌릴 수 있다.
+#if !defined(ARDUINO)
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hal.h"
+
+// ---------- Clock ----------
+static bool s_sim_clock;
+static uint64_t s_sim_us;
+static uint32_t s_sim_wake_latency_us;
+
+void hal_sim_clock_enable(uint32_t start_ms, uint32_t wake_latency_us)
+{
+    s_sim_clock = true;
+    s_sim_us = (uint64_t)start_ms * 1000u;
+    s_sim_wake_latency_us = wake_latency_us;
+}
+
+void hal_sim_clock_advance_us(uint32_t us)
+{
+    s_sim_us += us;
+}
+
+static uint64_t mono_us(void)
+{
+    static uint64_t base = 0;
+    if (s_sim_clock) {
+        return s_sim_us;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t us = (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+    if (base == 0) {
+        base = us;
+    }
+    return us - base;
+}
+
+uint32_t hal_millis(void)
+{
+    return (uint32_t)(mono_us() / 1000);
+}
+
+uint32_t hal_micros(void)
+{
+    return (uint32_t)mono_us();
+}
+
+// 호스트 시계는 이미 맞춰져 있다
+void hal_time_sync(const char *ntp_server)
+{
+    (void)ntp_server;
+}
+
+uint64_t hal_epoch_ms(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000ULL + (uint64_t)tv.tv_usec / 1000;
+}
+
+// ---------- Power ----------
+// 호스트에는 light sleep이 없으므로 그냥 잔다 (wake_gpio는 무시)
+uint32_t hal_light_sleep(uint32_t ms, int wake_gpio)
+{
+    (void)wake_gpio;
+    uint64_t t0 = mono_us();
+    if (s_sim_clock) {
+        s_sim_us += (uint64_t)ms * 1000u + s_sim_wake_latency_us;
+    } else {
+        struct timespec ts = { (time_t)(ms / 1000), (long)(ms % 1000) * 1000000L };
+        while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+        }
+    }
+    return (uint32_t)(mono_us() - t0);
+}
+
+void hal_set_cpu_mhz(uint32_t mhz)
+{
+    (void)mhz;
+}
+
+// ---------- System ----------
+uint32_t hal_random(void)
+{
+    static bool seeded;
+    if (!seeded) {
+        srandom((unsigned)(mono_us() ^ (uint64_t)getpid()));
+        seeded = true;
+    }
+    return ((uint32_t)random() << 16) ^ (uint32_t)random();
+}
+
+// 호스트 힙은 보고하지 않는다 (0)
+void hal_heap_stats(hal_heap_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+}
+
+static pthread_mutex_t s_critical = PTHREAD_MUTEX_INITIALIZER;
+
+void hal_critical_enter(void)
+{
+    pthread_mutex_lock(&s_critical);
+}
+
+void hal_critical_exit(void)
+{
+    pthread_mutex_unlock(&s_critical);
+}
+
+// ---------- Identity ----------
+const char *hal_device_id(void)
+{
+#ifdef AIR_DEVICE_ID
+    return AIR_DEVICE_ID;
+#else
+    static char id[32];
+    if (!id[0]) {
+        const char *env = getenv("AIR_DEVICE_ID");
+        if (env && env[0]) {
+            snprintf(id, sizeof(id), "%s", env);
+        } else if (gethostname(id, sizeof(id) - 1) != 0 || !id[0]) {
+            snprintf(id, sizeof(id), "host-%d", (int)getpid());
+        }
+    }
+    return id;
+#endif
+}
+
+// ---------- GPIO / Servo ----------
+#define SIM_GPIO_COUNT 40
+
+static bool s_gpio[SIM_GPIO_COUNT];
+static int s_servo_angle = -1;
+
+void hal_gpio_output(int pin)
+{
+    (void)pin;
+}
+
+void hal_gpio_write(int pin, bool level)
+{
+    if (pin >= 0 && pin < SIM_GPIO_COUNT) {
+        s_gpio[pin] = level;
+    }
+}
+
+bool hal_sim_gpio_level(int pin)
+{
+    return pin >= 0 && pin < SIM_GPIO_COUNT && s_gpio[pin];
+}
+
+bool hal_servo_attach(int pin, int min_pulse_us, int max_pulse_us, int initial_deg)
+{
+    (void)pin;
+    (void)min_pulse_us;
+    (void)max_pulse_us;
+    s_servo_angle = initial_deg;
+    return true;
+}
+
+void hal_servo_write(int angle_deg)
+{
+    s_servo_angle = angle_deg;
+}
+
+int hal_sim_servo_angle(void)
+{
+    return s_servo_angle;
+}
+
+// ---------- I2C sensor (simulated) ----------
+// 가짜 I2C 버스 위의 SHT31. hal_env_read()는 ESP32의 Adafruit_SHT31::readBoth()와 같은 순서로
+// 측정 명령을 쓰고, 측정 시간을 기다린 뒤 6바이트(온도, CRC, 습도, CRC)를 읽어 CRC를 확인한다.
+// hal_sim_env_fault()로 NACK, CRC 오류, 멈춘 버스(타임아웃)를 넣을 수 있고,
+// 시뮬레이션 시계가 켜져 있으면 버스에서 보낸 시간만큼 시계가 간다.
+#define SIM_SHT31_ADDR      0x44
+#define SIM_SHT31_MEASURE   0x2400      // 고반복도, 클럭 스트레칭 없음
+#define SIM_SHT31_WAIT_US   20000       // readBoth()의 delay(20)
+#define SIM_I2C_XFER_US     700         // 100 kHz에서 주소 + 6바이트
+#define SIM_I2C_TIMEOUT_US  50000       // Wire의 기본 타임아웃
+
+static float s_env_temperature = 26.0f;
+static float s_env_humidity = 60.0f;
+static bool s_env_ok = true;
+static hal_sim_i2c_fault_t s_i2c_fault;
+static uint32_t s_i2c_fault_reads;
+static uint16_t s_env_addr;
+static bool s_env_measuring;        // 측정 명령을 받았고 결과를 아직 읽지 않음
+
+static void i2c_spend_us(uint32_t us)
+{
+    if (s_sim_clock) {
+        s_sim_us += us;
+    }
+}
+
+static uint8_t sht31_crc(const uint8_t *data)
+{
+    uint8_t crc = 0xFF;
+    for (int i = 0; i < 2; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (uint8_t)(crc & 0x80 ? (crc << 1) ^ 0x31 : crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint16_t sht31_raw(float v, float offset, float span)
+{
+    float r = (v - offset) / span * 65535.0f + 0.5f;
+    return (uint16_t)(r < 0.0f ? 0.0f : r > 65535.0f ? 65535.0f : r);
+}
+
+// 가짜 버스의 한 트랜잭션 (tx를 쓰거나 rx를 읽음). 장치가 응답하지 않거나 버스가 멈추면 false.
+static bool i2c_transfer(uint16_t addr, const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len)
+{
+    hal_sim_i2c_fault_t fault = s_i2c_fault_reads ? s_i2c_fault : HAL_SIM_I2C_OK;
+    if (fault == HAL_SIM_I2C_STUCK) {
+        i2c_spend_us(SIM_I2C_TIMEOUT_US);
+        return false;
+    }
+    i2c_spend_us(SIM_I2C_XFER_US);
+    if (!s_env_ok || addr != SIM_SHT31_ADDR || fault == HAL_SIM_I2C_NACK) {
+        return false;
+    }
+    if (tx_len == 2) {
+        s_env_measuring = ((tx[0] << 8) | tx[1]) == SIM_SHT31_MEASURE;
+        return s_env_measuring;
+    }
+    if (rx_len == 6) {
+        if (!s_env_measuring) {
+            return false;
+        }
+        s_env_measuring = false;
+        uint16_t t = sht31_raw(s_env_temperature, -45.0f, 175.0f);
+        uint16_t h = sht31_raw(s_env_humidity, 0.0f, 100.0f);
+        rx[0] = (uint8_t)(t >> 8);
+        rx[1] = (uint8_t)t;
+        rx[2] = sht31_crc(rx);
+        rx[3] = (uint8_t)(h >> 8);
+        rx[4] = (uint8_t)h;
+        rx[5] = sht31_crc(rx + 3);
+        if (fault == HAL_SIM_I2C_CRC) {
+            rx[0] ^= 0x80;      // 비트 하나가 뒤집혀 도착 (온도 +-87.5 C)
+        }
+    }
+    return true;
+}
+
+bool hal_env_begin(int sda_pin, int scl_pin)
+{
+    (void)sda_pin;
+    (void)scl_pin;
+    static const uint16_t addrs[] = { 0x44, 0x45 };
+    s_env_addr = 0;
+    for (size_t i = 0; i < sizeof(addrs) / sizeof(addrs[0]) && !s_env_addr; i++) {
+        if (i2c_transfer(addrs[i], NULL, 0, NULL, 0)) {
+            s_env_addr = addrs[i];
+        }
+    }
+    return s_env_addr != 0;
+}
+
+bool hal_env_read(float *temperature, float *humidity)
+{
+    static const uint8_t measure[2] = { SIM_SHT31_MEASURE >> 8, SIM_SHT31_MEASURE & 0xFF };
+    uint8_t rx[6];
+    bool ok = s_env_addr && i2c_transfer(s_env_addr, measure, sizeof(measure), NULL, 0);
+    if (ok) {
+        i2c_spend_us(SIM_SHT31_WAIT_US);
+        ok = i2c_transfer(s_env_addr, NULL, 0, rx, sizeof(rx));
+    }
+    if (s_i2c_fault_reads && s_i2c_fault_reads != UINT32_MAX) {
+        s_i2c_fault_reads--;
+    }
+    if (!ok || sht31_crc(rx) != rx[2] || sht31_crc(rx + 3) != rx[5]) {
+        return false;
+    }
+    *temperature = -45.0f + 175.0f * (float)((rx[0] << 8) | rx[1]) / 65535.0f;
+    *humidity = 100.0f * (float)((rx[3] << 8) | rx[4]) / 65535.0f;
+    return true;
+}
+
+void hal_sim_set_env(float temperature, float humidity, bool ok)
+{
+    s_env_temperature = temperature;
+    s_env_humidity = humidity;
+    s_env_ok = ok;
+}
+
+void hal_sim_env_fault(hal_sim_i2c_fault_t fault, uint32_t reads)
+{
+    s_i2c_fault = fault;
+    s_i2c_fault_reads = fault == HAL_SIM_I2C_OK ? 0 : reads;
+}
+
+// ---------- UART ----------
+// 로그는 stderr로 바로 쓴다. PMS5003 포트는 hal_sim_uart_feed()가 채우는 링 버퍼.
+#define SIM_UART_CAP 1024
+
+static uint8_t s_uart_rx[SIM_UART_CAP];
+static size_t s_uart_head, s_uart_len;
+static pthread_mutex_t s_uart_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void hal_log_begin(size_t tx_buffer)
+{
+    (void)tx_buffer;
+}
+
+int hal_log_writable(void)
+{
+    return 4096;
+}
+
+void hal_log_write(const uint8_t *data, size_t len)
+{
+    fwrite(data, 1, len, stderr);
+}
+
+void hal_uart_begin(uint32_t baud, int rx_pin, int tx_pin, size_t rx_buffer)
+{
+    (void)baud;
+    (void)rx_pin;
+    (void)tx_pin;
+    (void)rx_buffer;
+}
+
+size_t hal_uart_read(uint8_t *buf, size_t cap)
+{
+    pthread_mutex_lock(&s_uart_lock);
+    size_t n = s_uart_len < cap ? s_uart_len : cap;
+    for (size_t i = 0; i < n; i++) {
+        buf[i] = s_uart_rx[(s_uart_head + i) % SIM_UART_CAP];
+    }
+    s_uart_head = (s_uart_head + n) % SIM_UART_CAP;
+    s_uart_len -= n;
+    pthread_mutex_unlock(&s_uart_lock);
+    return n;
+}
+
+// 넘치는 바이트는 실제 UART 드라이버처럼 버린다
+void hal_sim_uart_feed(const uint8_t *data, size_t len)
+{
+    pthread_mutex_lock(&s_uart_lock);
+    for (size_t i = 0; i < len && s_uart_len < SIM_UART_CAP; i++) {
+        s_uart_rx[(s_uart_head + s_uart_len) % SIM_UART_CAP] = data[i];
+        s_uart_len++;
+    }
+    pthread_mutex_unlock(&s_uart_lock);
+}
+
+// ---------- Wi-Fi (simulated) ----------
+// 호스트는 이미 네트워크에 붙어 있다: begin이 곧 연결이고, hal_sim_set_wifi(false)로 AP를 없앤다.
+static bool s_wifi_available = true;
+static bool s_wifi_joined;
+
+void hal_wifi_init(void)
+{
+    s_wifi_joined = false;
+}
+
+void hal_wifi_begin(const char *ssid, const char *password)
+{
+    (void)ssid;
+    (void)password;
+    s_wifi_joined = s_wifi_available;
+}
+
+void hal_wifi_disconnect(void)
+{
+    s_wifi_joined = false;
+}
+
+bool hal_wifi_connected(void)
+{
+    return s_wifi_joined && s_wifi_available;
+}
+
+int hal_wifi_rssi(void)
+{
+    return hal_wifi_connected() ? -50 : 0;
+}
+
+uint32_t hal_wifi_local_ip(void)
+{
+    return hal_wifi_connected() ? 0x0100007fu : 0;     // 127.0.0.1
+}
+
+uint32_t hal_wifi_gateway_ip(void)
+{
+    return hal_wifi_local_ip();
+}
+
+void hal_wifi_set_sleep(bool modem_sleep)
+{
+    (void)modem_sleep;
+}
+
+void hal_sim_set_wifi(bool available)
+{
+    s_wifi_available = available;
+    if (!available) {
+        s_wifi_joined = false;
+    }
+}
+
+// ---------- Sockets ----------
+static int tcp_connect(const char *host, uint16_t port, int timeout_ms)
+{
+    char service[8];
+    snprintf(service, sizeof(service), "%u", (unsigned)port);
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(host, service, &hints, &res) != 0) {
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        struct timeval tv = { timeout_ms / 1000, (timeout_ms % 1000) * 1000 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        // 헤더와 본문을 따로 보내므로 Nagle이 delayed ACK를 기다리지 않게 한다
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+static bool send_all(int fd, const void *data, size_t len)
+{
+    const char *p = (const char *)data;
+    while (len > 0) {
+        ssize_t w = send(fd, p, len, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) {
+            continue;
+        }
+        if (w <= 0) {
+            return false;
+        }
+        p += w;
+        len -= (size_t)w;
+    }
+    return true;
+}
+
+// ---------- Persistent storage (files) ----------
+// AIR_STORE_DIR/<key>.bin (기본: 현재 디렉터리). 임시 파일에 쓰고 rename으로 바꿔치기한다.
+static void store_path(char *buf, size_t cap, const char *key, const char *suffix)
+{
+    const char *dir = getenv("AIR_STORE_DIR");
+    snprintf(buf, cap, "%s/%s.bin%s", dir && *dir ? dir : ".", key, suffix);
+}
+
+int hal_store_read(const char *key, void *buf, size_t cap)
+{
+    char path[256];
+    store_path(path, sizeof(path), key, "");
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return -1;
+    }
+    size_t n = fread(buf, 1, cap, f);
+    bool longer = fgetc(f) != EOF;
+    fclose(f);
+    return longer ? 0 : (int)n;
+}
+
+bool hal_store_write(const char *key, const void *data, size_t len)
+{
+    char path[256], tmp[256];
+    store_path(path, sizeof(path), key, "");
+    store_path(tmp, sizeof(tmp), key, ".tmp");
+    FILE *f = fopen(tmp, "wb");
+    if (!f) {
+        return false;
+    }
+    bool ok = fwrite(data, 1, len, f) == len;
+    ok = fclose(f) == 0 && ok;
+    return ok && rename(tmp, path) == 0;
+}
+
+// ---------- HTTP client ----------
+// HTTP/1.1 keep-alive: 같은 host:port로 가는 요청은 연결 하나를 재사용한다 (ESP32의
+// esp_http_session과 같은 동작). 오류가 나면 연결을 버리고 다음 요청에서 다시 맺는다.
+// 응답 본문은 Content-Length, chunked, 또는 연결 종료까지를 지원한다.
+// 재사용한 연결이 응답 첫 바이트 전에 끊기면(서버의 유휴 연결 종료) 요청이 처리되지 않은
+// 것이므로 새 연결로 한 번만 다시 보낸다.
+static hal_http_stats_t s_http_stats;
+static int s_http_fd = -1;
+static char s_http_host[128];
+static uint16_t s_http_port;
+
+typedef struct {
+    int fd;
+    char buf[1024];
+    size_t pos, len;
+    size_t got;         // 받은 바이트 수 (0이면 응답이 전혀 오지 않음)
+} http_reader_t;
+
+// 받은 바이트 수, 연결 종료면 0, 오류(타임아웃 포함)면 -1
+static int reader_fill(http_reader_t *r)
+{
+    for (;;) {
+        ssize_t n = recv(r->fd, r->buf, sizeof(r->buf), 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n > 0) {
+            r->pos = 0;
+            r->len = (size_t)n;
+            r->got += (size_t)n;
+        }
+        return n < 0 ? -1 : (int)n;
+    }
+}
+
+// CRLF로 끝나는 한 줄 (CRLF는 뺀다). cap보다 길면 실패
+static bool reader_line(http_reader_t *r, char *line, size_t cap)
+{
+    size_t n = 0;
+    for (;;) {
+        if (r->pos == r->len && reader_fill(r) <= 0) {
+            return false;
+        }
+        char c = r->buf[r->pos++];
+        if (c == '\n') {
+            if (n > 0 && line[n - 1] == '\r') {
+                n--;
+            }
+            line[n] = '\0';
+            return true;
+        }
+        if (n + 1 >= cap) {
+            return false;
+        }
+        line[n++] = c;
+    }
+}
+
+// 본문 len바이트를 콜백으로 넘긴다. len < 0이면 연결이 닫힐 때까지.
+static bool reader_body(http_reader_t *r, long len, hal_http_body_cb on_body, void *ctx)
+{
+    while (len != 0) {
+        if (r->pos == r->len) {
+            int n = reader_fill(r);
+            if (n < 0) {
+                return false;
+            }
+            if (n == 0) {
+                return len < 0;
+            }
+        }
+        size_t take = r->len - r->pos;
+        if (len > 0 && (size_t)len < take) {
+            take = (size_t)len;
+        }
+        if (on_body) {
+            on_body(r->buf + r->pos, (int)take, ctx);
+        }
+        r->pos += take;
+        if (len > 0) {
+            len -= (long)take;
+        }
+    }
+    return true;
+}
+
+static bool reader_chunked(http_reader_t *r, hal_http_body_cb on_body, void *ctx)
+{
+    char line[64];
+    for (;;) {
+        if (!reader_line(r, line, sizeof(line))) {
+            return false;
+        }
+        char *end;
+        long size = strtol(line, &end, 16);
+        if (end == line || size < 0) {
+            return false;
+        }
+        if (size == 0) {
+            break;
+        }
+        if (!reader_body(r, size, on_body, ctx) || !reader_line(r, line, sizeof(line)) || line[0] != '\0') {
+            return false;
+        }
+    }
+    // trailer 헤더는 무시하고 빈 줄까지 읽는다
+    do {
+        if (!reader_line(r, line, sizeof(line))) {
+            return false;
+        }
+    } while (line[0] != '\0');
+    return true;
+}
+
+static void http_drop(void)
+{
+    if (s_http_fd >= 0) {
+        close(s_http_fd);
+        s_http_fd = -1;
+    }
+}
+
+// "http://host[:port]/path" 만 지원
+static bool parse_url(const char *url, char *host, size_t host_cap, uint16_t *port, const char **path)
+{
+    const char *p = strncmp(url, "http://", 7) == 0 ? url + 7 : NULL;
+    if (p == NULL) {
+        return false;
+    }
+    const char *end = p + strcspn(p, ":/");
+    size_t n = (size_t)(end - p);
+    if (n == 0 || n >= host_cap) {
+        return false;
+    }
+    memcpy(host, p, n);
+    host[n] = '\0';
+
+    *port = 80;
+    if (*end == ':') {
+        *port = (uint16_t)strtoul(end + 1, (char **)&end, 10);
+    }
+    *path = *end == '/' ? end : "/";
+    return true;
+}
+
+typedef enum {
+    HTTP_DONE = 0,
+    HTTP_FAILED,
+    HTTP_STALE,     // 재사용한 연결이 응답 없이 끊김: 다시 보내도 된다
+} http_outcome_t;
+
+// 열린 연결(s_http_fd)로 요청 하나를 보내고 응답을 끝까지 읽는다
+static http_outcome_t http_exchange(hal_http_method_t method, const char *host, const char *path,
+                                    const char *body, int body_len, const char *content_type,
+                                    int timeout_ms, hal_http_body_cb on_body, void *ctx,
+                                    int *status, bool *keep)
+{
+    struct timeval tv = { timeout_ms / 1000, (timeout_ms % 1000) * 1000 };
+    setsockopt(s_http_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(s_http_fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    char head[512];
+    int n = snprintf(head, sizeof(head), "%s %s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n",
+                     method == HAL_HTTP_POST ? "POST" : "GET", path, host);
+    if (body) {
+        n += snprintf(head + n, sizeof(head) - (size_t)n, "Content-Type: %s\r\nContent-Length: %d\r\n",
+                      content_type ? content_type : "application/octet-stream", body_len);
+    }
+    n += snprintf(head + n, sizeof(head) - (size_t)n, "\r\n");
+    if (n >= (int)sizeof(head)) {
+        return HTTP_FAILED;
+    }
+    http_reader_t r = { s_http_fd, { 0 }, 0, 0, 0 };
+    if (!send_all(s_http_fd, head, (size_t)n) || (body && !send_all(s_http_fd, body, (size_t)body_len))) {
+        return HTTP_STALE;
+    }
+
+    // 상태 줄
+    char line[256];
+    int minor = 0;
+    if (!reader_line(&r, line, sizeof(line))) {
+        return r.got == 0 ? HTTP_STALE : HTTP_FAILED;
+    }
+    if (sscanf(line, "HTTP/1.%d %d", &minor, status) != 2) {
+        return HTTP_FAILED;
+    }
+
+    // 헤더
+    long length = -1;
+    bool chunked = false;
+    *keep = minor >= 1;
+    for (;;) {
+        if (!reader_line(&r, line, sizeof(line))) {
+            return HTTP_FAILED;
+        }
+        if (line[0] == '\0') {
+            break;
+        }
+        char *value = strchr(line, ':');
+        if (value == NULL) {
+            continue;
+        }
+        *value++ = '\0';
+        value += strspn(value, " \t");
+        if (strcasecmp(line, "Content-Length") == 0) {
+            length = strtol(value, NULL, 10);
+        } else if (strcasecmp(line, "Transfer-Encoding") == 0) {
+            chunked = strcasecmp(value, "chunked") == 0;
+        } else if (strcasecmp(line, "Connection") == 0) {
+            *keep = strcasecmp(value, "close") != 0 && (minor >= 1 || strcasecmp(value, "keep-alive") == 0);
+        }
+    }
+
+    // 본문
+    bool ok;
+    if (*status == 204 || *status == 304 || (*status >= 100 && *status < 200)) {
+        ok = true;
+    } else if (chunked) {
+        ok = reader_chunked(&r, on_body, ctx);
+    } else if (length >= 0) {
+        ok = reader_body(&r, length, on_body, ctx);
+    } else {
+        ok = reader_body(&r, -1, on_body, ctx);    // 연결 종료까지
+        *keep = false;
+    }
+    if (r.pos != r.len) {
+        *keep = false;  // 요청하지 않은 바이트가 더 왔다
+    }
+    return ok ? HTTP_DONE : HTTP_FAILED;
+}
+
+int hal_http_request(hal_http_method_t method,
+                     const char *url,
+                     const char *body,
+                     int body_len,
+                     const char *content_type,
+                     int timeout_ms,
+                     hal_http_body_cb on_body,
+                     void *ctx,
+                     int *status_code)
+{
+    char host[128];
+    uint16_t port;
+    const char *path;
+    if (!parse_url(url, host, sizeof(host), &port, &path)) {
+        return -1;
+    }
+    if (s_http_fd >= 0 && (port != s_http_port || strcmp(host, s_http_host) != 0)) {
+        http_drop();    // 다른 서버
+    }
+
+    s_http_stats.requests++;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = s_http_fd >= 0;
+        if (!reused) {
+            s_http_fd = tcp_connect(host, port, timeout_ms);
+            if (s_http_fd < 0) {
+                s_http_stats.resets++;
+                return -1;
+            }
+            snprintf(s_http_host, sizeof(s_http_host), "%s", host);
+            s_http_port = port;
+            s_http_stats.handshakes++;
+        }
+
+        int status = 0;
+        bool keep = false;
+        http_outcome_t rc = http_exchange(method, host, path, body, body_len, content_type,
+                                          timeout_ms, on_body, ctx, &status, &keep);
+        if (rc == HTTP_STALE && reused) {
+            http_drop();    // 서버가 닫아 둔 유휴 연결: 새 연결로 다시
+            continue;
+        }
+        if (rc != HTTP_DONE) {
+            http_drop();
+            s_http_stats.resets++;
+            return -1;
+        }
+        if (reused) {
+            s_http_stats.reused++;
+        }
+        if (!keep) {
+            http_drop();
+        }
+        if (status_code) {
+            *status_code = status;
+        }
+        return 0;
+    }
+    s_http_stats.resets++;
+    return -1;
+}
+
+void hal_http_get_stats(hal_http_stats_t *out)
+{
+    *out = s_http_stats;
+}
+
+// ---------- MQTT client (3.1.1, QoS 0) ----------
+#define MQTT_KEEPALIVE_S    15
+#define MQTT_CONNECT_TIMEOUT_MS 3000
+#define MQTT_RX_CAP         1024
+
+// PubSubClient와 같은 상태 코드
+#define MQTT_CONNECTION_TIMEOUT -4
+#define MQTT_CONNECTION_LOST    -3
+#define MQTT_CONNECT_FAILED     -2
+#define MQTT_DISCONNECTED       -1
+#define MQTT_CONNECTED           0
+
+static char s_mqtt_host[128];
+static uint16_t s_mqtt_port;
+static hal_mqtt_message_cb s_mqtt_handler;
+static int s_mqtt_fd = -1;
+static int s_mqtt_state = MQTT_DISCONNECTED;
+static uint32_t s_mqtt_last_out_ms;
+static uint16_t s_mqtt_packet_id;
+static uint16_t s_mqtt_keepalive_s = MQTT_KEEPALIVE_S;         // 다음 연결에 쓸 값 (어느 스레드에서나 씀)
+static uint16_t s_mqtt_session_keepalive_s = MQTT_KEEPALIVE_S; // 지금 연결이 CONNECT에서 정한 값
+static uint8_t s_mqtt_rx[MQTT_RX_CAP];
+static size_t s_mqtt_rx_len;
+static hal_mqtt_connect_status_t s_mqtt_connect_status = HAL_MQTT_CONNECT_IDLE;
+
+// 백그라운드 연결 중에는 연결 스레드가 소켓과 상태를 가진다
+static bool mqtt_busy(void)
+{
+    return __atomic_load_n(&s_mqtt_connect_status, __ATOMIC_ACQUIRE) == HAL_MQTT_CONNECT_PENDING;
+}
+
+static void mqtt_close(int state)
+{
+    if (s_mqtt_fd >= 0) {
+        close(s_mqtt_fd);
+        s_mqtt_fd = -1;
+    }
+    s_mqtt_state = state;
+    s_mqtt_rx_len = 0;
+}
+
+static size_t put_remaining_length(uint8_t *p, size_t len)
+{
+    size_t n = 0;
+    do {
+        uint8_t b = (uint8_t)(len % 128);
+        len /= 128;
+        p[n++] = len ? (uint8_t)(b | 0x80) : b;
+    } while (len > 0 && n < 4);
+    return n;
+}
+
+static size_t put_string(uint8_t *p, const char *s)
+{
+    size_t n = strlen(s);
+    p[0] = (uint8_t)(n >> 8);
+    p[1] = (uint8_t)n;
+    memcpy(p + 2, s, n);
+    return n + 2;
+}
+
+// 고정 헤더 + 가변부를 한 번에 전송
+static bool mqtt_send(uint8_t type, const uint8_t *var, size_t var_len)
+{
+    uint8_t pkt[MQTT_RX_CAP + 8];
+    if (var_len > MQTT_RX_CAP) {
+        return false;
+    }
+    pkt[0] = type;
+    size_t n = 1 + put_remaining_length(pkt + 1, var_len);
+    if (var_len > 0) {
+        memcpy(pkt + n, var, var_len);
+    }
+    if (!send_all(s_mqtt_fd, pkt, n + var_len)) {
+        mqtt_close(MQTT_CONNECTION_LOST);
+        return false;
+    }
+    s_mqtt_last_out_ms = hal_millis();
+    return true;
+}
+
+void hal_mqtt_setup(const char *host, uint16_t port, hal_mqtt_message_cb on_message)
+{
+    if (mqtt_busy()) {
+        return;
+    }
+    snprintf(s_mqtt_host, sizeof(s_mqtt_host), "%s", host);
+    s_mqtt_port = port;
+    s_mqtt_handler = on_message;
+}
+
+// 연결 태스크가 클라이언트를 가진 동안에도 부를 수 있도록 값만 저장한다
+void hal_mqtt_set_keepalive(uint16_t seconds)
+{
+    __atomic_store_n(&s_mqtt_keepalive_s, seconds, __ATOMIC_RELAXED);
+}
+
+bool hal_mqtt_connect(const char *client_id, const char *user, const char *password,
+                      const char *will_topic, const char *will_message)
+{
+    mqtt_close(MQTT_DISCONNECTED);
+    s_mqtt_fd = tcp_connect(s_mqtt_host, s_mqtt_port, MQTT_CONNECT_TIMEOUT_MS);
+    if (s_mqtt_fd < 0) {
+        s_mqtt_state = MQTT_CONNECT_FAILED;
+        return false;
+    }
+
+    uint8_t var[256];
+    size_t n = put_string(var, "MQTT");
+    uint8_t flags = 0x02;   // clean session
+    bool has_user = user && user[0];
+    bool has_pass = password && password[0];
+    bool has_will = will_topic != NULL;
+    if (has_user) flags |= 0x80;
+    if (has_pass) flags |= 0x40;
+    if (has_will) flags |= 0x24;    // will flag + will retain, QoS 0
+    var[n++] = 4;           // protocol level 3.1.1
+    var[n++] = flags;
+    s_mqtt_session_keepalive_s = __atomic_load_n(&s_mqtt_keepalive_s, __ATOMIC_RELAXED);
+    var[n++] = (uint8_t)(s_mqtt_session_keepalive_s >> 8);
+    var[n++] = (uint8_t)s_mqtt_session_keepalive_s;
+    size_t will_len = has_will ? strlen(will_topic) + strlen(will_message) + 4 : 0;
+    if (strlen(client_id) + (has_user ? strlen(user) : 0) + (has_pass ? strlen(password) : 0) + will_len + 16 > sizeof(var)) {
+        mqtt_close(MQTT_CONNECT_FAILED);
+        return false;
+    }
+    n += put_string(var + n, client_id);
+    if (has_will) {
+        n += put_string(var + n, will_topic);
+        n += put_string(var + n, will_message);
+    }
+    if (has_user) n += put_string(var + n, user);
+    if (has_pass) n += put_string(var + n, password);
+    if (!mqtt_send(0x10, var, n)) {
+        s_mqtt_state = MQTT_CONNECT_FAILED;
+        return false;
+    }
+
+    // CONNACK: 20 02 00 rc (SO_RCVTIMEO로 대기 시간 제한)
+    uint8_t ack[4];
+    size_t got = 0;
+    while (got < sizeof(ack)) {
+        ssize_t r = recv(s_mqtt_fd, ack + got, sizeof(ack) - got, 0);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r <= 0) {
+            mqtt_close(MQTT_CONNECTION_TIMEOUT);
+            return false;
+        }
+        got += (size_t)r;
+    }
+    if (ack[0] != 0x20 || ack[3] != 0) {
+        mqtt_close(ack[0] == 0x20 ? ack[3] : MQTT_CONNECT_FAILED);
+        return false;
+    }
+
+    fcntl(s_mqtt_fd, F_SETFL, fcntl(s_mqtt_fd, F_GETFL) | O_NONBLOCK);
+    s_mqtt_state = MQTT_CONNECTED;
+    return true;
+}
+
+bool hal_mqtt_connected(void)
+{
+    return !mqtt_busy() && s_mqtt_state == MQTT_CONNECTED;
+}
+
+void hal_mqtt_disconnect(void)
+{
+    if (mqtt_busy()) {
+        return;
+    }
+    if (hal_mqtt_connected()) {
+        mqtt_send(0xE0, NULL, 0);   // DISCONNECT
+    }
+    mqtt_close(MQTT_DISCONNECTED);
+}
+
+int hal_mqtt_state(void)
+{
+    return s_mqtt_state;
+}
+
+bool hal_mqtt_subscribe(const char *topic)
+{
+    if (!hal_mqtt_connected() || strlen(topic) + 5 > MQTT_RX_CAP) {
+        return false;
+    }
+    uint8_t var[MQTT_RX_CAP];
+    s_mqtt_packet_id = (uint16_t)(s_mqtt_packet_id + 1 ? s_mqtt_packet_id + 1 : 1);
+    var[0] = (uint8_t)(s_mqtt_packet_id >> 8);
+    var[1] = (uint8_t)s_mqtt_packet_id;
+    size_t n = 2 + put_string(var + 2, topic);
+    var[n++] = 0;           // QoS 0
+    return mqtt_send(0x82, var, n);
+}
+
+bool hal_mqtt_publish(const char *topic, const uint8_t *payload, unsigned int length, bool retain)
+{
+    size_t tlen = strlen(topic);
+    if (!hal_mqtt_connected() || tlen + 2 + length > MQTT_RX_CAP) {
+        return false;
+    }
+    uint8_t var[MQTT_RX_CAP];
+    size_t n = put_string(var, topic);
+    memcpy(var + n, payload, length);
+    return mqtt_send(retain ? 0x31 : 0x30, var, n + length);
+}
+
+// 완전한 패킷 하나를 처리하고 소비한 바이트 수를 반환 (불완전하면 0)
+static size_t mqtt_handle_packet(const uint8_t *p, size_t len)
+{
+    size_t rem = 0, mult = 1, i = 1;
+    for (;;) {
+        if (i >= len || i > 4) {
+            return 0;
+        }
+        rem += (size_t)(p[i] & 0x7f) * mult;
+        mult *= 128;
+        if ((p[i++] & 0x80) == 0) {
+            break;
+        }
+    }
+    if (len < i + rem) {
+        return 0;
+    }
+
+    if ((p[0] & 0xf0) == 0x30 && rem >= 2) {   // PUBLISH
+        const uint8_t *v = p + i;
+        size_t tlen = ((size_t)v[0] << 8) | v[1];
+        size_t off = 2 + tlen + (((p[0] >> 1) & 0x03) ? 2 : 0);
+        if (off <= rem && tlen < 128 && s_mqtt_handler) {
+            char topic[128];
+            memcpy(topic, v + 2, tlen);
+            topic[tlen] = '\0';
+            s_mqtt_handler(topic, v + off, (unsigned int)(rem - off));
+        }
+    }
+    // CONNACK/SUBACK/PINGRESP 등은 무시
+    return i + rem;
+}
+
+void hal_mqtt_loop(void)
+{
+    if (!hal_mqtt_connected()) {
+        return;
+    }
+
+    for (;;) {
+        if (s_mqtt_rx_len == sizeof(s_mqtt_rx)) {
+            mqtt_close(MQTT_CONNECTION_LOST);   // 버퍼보다 큰 패킷
+            return;
+        }
+        ssize_t r = recv(s_mqtt_fd, s_mqtt_rx + s_mqtt_rx_len, sizeof(s_mqtt_rx) - s_mqtt_rx_len, 0);
+        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            break;
+        }
+        if (r <= 0) {
+            mqtt_close(MQTT_CONNECTION_LOST);
+            return;
+        }
+        s_mqtt_rx_len += (size_t)r;
+
+        size_t used;
+        while ((used = mqtt_handle_packet(s_mqtt_rx, s_mqtt_rx_len)) > 0) {
+            memmove(s_mqtt_rx, s_mqtt_rx + used, s_mqtt_rx_len - used);
+            s_mqtt_rx_len -= used;
+        }
+    }
+
+    if (hal_millis() - s_mqtt_last_out_ms >= s_mqtt_session_keepalive_s * 1000u / 2) {
+        mqtt_send(0xc0, NULL, 0);   // PINGREQ
+    }
+}
+
+// ---------- MQTT background connect ----------
+typedef struct {
+    char client_id[64];
+    char user[64];
+    char password[64];
+    char will_topic[128];
+    char will_message[32];
+    bool has_user, has_password, has_will;
+} mqtt_connect_args_t;
+
+static mqtt_connect_args_t s_mqtt_connect_args;
+
+static void *mqtt_connect_main(void *arg)
+{
+    const mqtt_connect_args_t *a = (const mqtt_connect_args_t *)arg;
+    bool ok = hal_mqtt_connect(a->client_id, a->has_user ? a->user : NULL, a->has_password ? a->password : NULL,
+                               a->has_will ? a->will_topic : NULL, a->has_will ? a->will_message : NULL);
+    __atomic_store_n(&s_mqtt_connect_status, ok ? HAL_MQTT_CONNECT_OK : HAL_MQTT_CONNECT_FAILED, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static bool copy_arg(char *dst, size_t cap, const char *src, bool *present)
+{
+    if (present) {
+        *present = src != NULL;
+    }
+    return (size_t)snprintf(dst, cap, "%s", src ? src : "") < cap;
+}
+
+bool hal_mqtt_connect_start(const char *client_id, const char *user, const char *password,
+                            const char *will_topic, const char *will_message)
+{
+    if (mqtt_busy()) {
+        return false;
+    }
+    mqtt_connect_args_t *a = &s_mqtt_connect_args;
+    if (!copy_arg(a->client_id, sizeof(a->client_id), client_id, NULL) ||
+        !copy_arg(a->user, sizeof(a->user), user, &a->has_user) ||
+        !copy_arg(a->password, sizeof(a->password), password, &a->has_password) ||
+        !copy_arg(a->will_topic, sizeof(a->will_topic), will_topic, &a->has_will) ||
+        !copy_arg(a->will_message, sizeof(a->will_message), will_message, NULL)) {
+        __atomic_store_n(&s_mqtt_connect_status, HAL_MQTT_CONNECT_FAILED, __ATOMIC_RELEASE);
+        return false;
+    }
+    __atomic_store_n(&s_mqtt_connect_status, HAL_MQTT_CONNECT_PENDING, __ATOMIC_RELEASE);
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_t th;
+    int err = pthread_create(&th, &attr, mqtt_connect_main, a);
+    pthread_attr_destroy(&attr);
+    if (err != 0) {
+        __atomic_store_n(&s_mqtt_connect_status, HAL_MQTT_CONNECT_FAILED, __ATOMIC_RELEASE);
+        return false;
+    }
+    return true;
+}
+
+hal_mqtt_connect_status_t hal_mqtt_connect_poll(void)
+{
+    return __atomic_load_n(&s_mqtt_connect_status, __ATOMIC_ACQUIRE);
+}
+
+// ---------- Task handoff (pthread) ----------
+struct hal_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t nonempty;
+    unsigned int depth;
+    unsigned int head;
+    unsigned int count;
+    size_t item_size;
+    uint8_t items[];
+};
+
+// timeout_ms 뒤의 CLOCK_MONOTONIC 시각
+static struct timespec deadline_after(uint32_t timeout_ms)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += timeout_ms / 1000;
+    ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return ts;
+}
+
+static void cond_init_monotonic(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+hal_queue_t *hal_queue_create(unsigned int depth, size_t item_size)
+{
+    hal_queue_t *q = calloc(1, sizeof(*q) + (size_t)depth * item_size);
+    if (q == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&q->lock, NULL);
+    cond_init_monotonic(&q->nonempty);
+    q->depth = depth;
+    q->item_size = item_size;
+    return q;
+}
+
+bool hal_queue_send(hal_queue_t *queue, const void *item)
+{
+    pthread_mutex_lock(&queue->lock);
+    bool ok = queue->count < queue->depth;
+    if (ok) {
+        unsigned int tail = (queue->head + queue->count) % queue->depth;
+        memcpy(queue->items + (size_t)tail * queue->item_size, item, queue->item_size);
+        queue->count++;
+        pthread_cond_broadcast(&queue->nonempty);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return ok;
+}
+
+bool hal_queue_receive(hal_queue_t *queue, void *item)
+{
+    pthread_mutex_lock(&queue->lock);
+    bool ok = queue->count > 0;
+    if (ok) {
+        memcpy(item, queue->items + (size_t)queue->head * queue->item_size, queue->item_size);
+        queue->head = (queue->head + 1) % queue->depth;
+        queue->count--;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return ok;
+}
+
+bool hal_queue_peek(hal_queue_t *queue, void *item, uint32_t timeout_ms)
+{
+    struct timespec deadline = deadline_after(timeout_ms);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) {
+        if (pthread_cond_timedwait(&queue->nonempty, &queue->lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    bool ok = queue->count > 0;
+    if (ok) {
+        memcpy(item, queue->items + (size_t)queue->head * queue->item_size, queue->item_size);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return ok;
+}
+
+// 스레드마다 하나 (FreeRTOS의 태스크 알림 값에 해당)
+typedef struct {
+    bool ready;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t pending;
+} task_notify_t;
+
+static __thread task_notify_t s_task_notify;
+
+hal_task_t hal_task_current(void)
+{
+    task_notify_t *t = &s_task_notify;
+    if (!t->ready) {
+        pthread_mutex_init(&t->lock, NULL);
+        cond_init_monotonic(&t->cond);
+        t->ready = true;
+    }
+    return t;
+}
+
+void hal_task_notify(hal_task_t task)
+{
+    task_notify_t *t = (task_notify_t *)task;
+    pthread_mutex_lock(&t->lock);
+    t->pending++;
+    pthread_cond_signal(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+}
+
+bool hal_task_wait(uint32_t timeout_ms)
+{
+    task_notify_t *t = (task_notify_t *)hal_task_current();
+    struct timespec deadline = deadline_after(timeout_ms);
+    pthread_mutex_lock(&t->lock);
+    while (t->pending == 0) {
+        if (pthread_cond_timedwait(&t->cond, &t->lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    bool got = t->pending > 0;
+    t->pending = 0;
+    pthread_mutex_unlock(&t->lock);
+    return got;
+}
+
+#endif // !ARDUINO
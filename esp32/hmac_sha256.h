@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// SHA-256 (FIPS 180-4)과 HMAC-SHA256 (RFC 2104). 힙 할당 없음, 플랫폼 의존 없음.
+// 원격 설정 메시지의 서명 확인에 쓴다 (device_config / air_app.c). 메시지는 조각으로 나눠 넣어도 된다.
+
+#define SHA256_SIZE 32
+#define SHA256_BLOCK 64
+
+typedef struct {
+    uint32_t h[8];
+    uint64_t bytes;             // 지금까지 넣은 길이
+    uint8_t block[SHA256_BLOCK];
+    uint8_t used;               // block에 쌓인 바이트
+} sha256_t;
+
+void sha256_init(sha256_t *s);
+void sha256_update(sha256_t *s, const void *data, size_t len);
+void sha256_final(sha256_t *s, uint8_t out[SHA256_SIZE]);
+
+typedef struct {
+    sha256_t inner;
+    uint8_t okey[SHA256_BLOCK]; // 키 ^ opad
+} hmac_sha256_t;
+
+void hmac_sha256_init(hmac_sha256_t *h, const void *key, size_t key_len);
+void hmac_sha256_update(hmac_sha256_t *h, const void *data, size_t len);
+void hmac_sha256_final(hmac_sha256_t *h, uint8_t out[SHA256_SIZE]);
+
+// 16진 문자열(64자, 대소문자 무관)과 상수 시간에 비교한다
+bool hmac_sha256_hex_equal(const uint8_t mac[SHA256_SIZE], const char *hex, size_t hex_len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,289 @@
+#include <string.h>
+
+#include "json_stream.h"
+
+enum {
+    ST_VALUE = 0,       // 값 기대
+    ST_VALUE_OR_END,    // '[' 직후: 값 또는 ']'
+    ST_KEY_OR_END,      // '{' 직후: 키 또는 '}'
+    ST_KEY,             // ',' 직후 객체 안: 키
+    ST_KEY_STRING,
+    ST_COLON,
+    ST_STRING,
+    ST_TOKEN,           // 숫자 / true / false / null
+    ST_AFTER,           // 값 뒤: ',' 또는 닫는 괄호
+    ST_END,             // 최상위 값 완료: 공백만 허용
+    ST_ERROR,
+};
+
+void json_stream_init(json_stream_t *s, char *text, size_t text_cap, json_stream_fn on_event, void *ctx)
+{
+    memset(s, 0, sizeof(*s));
+    s->on_event = on_event;
+    s->ctx = ctx;
+    s->text = text;
+    s->text_cap = (uint16_t)(text_cap < 0xFFFF ? text_cap : 0xFFFF);
+    s->text[0] = '\0';
+    s->state = ST_VALUE;
+}
+
+static bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static void fail(json_stream_t *s, json_stream_error_t err)
+{
+    s->error = err;
+    s->state = ST_ERROR;
+}
+
+static void emit(json_stream_t *s, json_event_t ev)
+{
+    if (s->on_event) {
+        s->on_event(s, ev, s->ctx);
+    }
+}
+
+static void text_start(json_stream_t *s)
+{
+    s->text_len = 0;
+    s->escape = 0;
+}
+
+static void text_byte(json_stream_t *s, char c)
+{
+    if (s->text_len < s->text_cap - 1) {
+        s->text[s->text_len] = c;
+    }
+    if (s->text_len < 0xFFFF) {
+        s->text_len++;
+    }
+}
+
+static void text_end(json_stream_t *s)
+{
+    s->text[s->text_len < s->text_cap ? s->text_len : s->text_cap - 1] = '\0';
+}
+
+// \uXXXX 하나를 UTF-8로 (서로게이트 쌍은 잇지 않는다)
+static void text_code(json_stream_t *s, uint16_t cp)
+{
+    if (cp == 0 || (cp >= 0xd800 && cp <= 0xdfff)) {
+        text_byte(s, '?');
+    } else if (cp < 0x80) {
+        text_byte(s, (char)cp);
+    } else if (cp < 0x800) {
+        text_byte(s, (char)(0xc0 | cp >> 6));
+        text_byte(s, (char)(0x80 | (cp & 0x3f)));
+    } else {
+        text_byte(s, (char)(0xe0 | cp >> 12));
+        text_byte(s, (char)(0x80 | (cp >> 6 & 0x3f)));
+        text_byte(s, (char)(0x80 | (cp & 0x3f)));
+    }
+}
+
+static int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool valid_token(const char *t, uint16_t len)
+{
+    if (len == 4 && (memcmp(t, "true", 4) == 0 || memcmp(t, "null", 4) == 0)) return true;
+    if (len == 5 && memcmp(t, "false", 5) == 0) return true;
+    if (t[0] != '-' && (t[0] < '0' || t[0] > '9')) return false;
+    for (uint16_t i = 1; i < len; i++) {
+        char c = t[i];
+        if (!((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-')) {
+            return false;
+        }
+    }
+    return t[len - 1] >= '0' && t[len - 1] <= '9';
+}
+
+// 값 하나가 끝남: 최상위 값이었으면 본문 완료
+static void value_done(json_stream_t *s)
+{
+    if (s->depth == 0) {
+        s->done = true;
+        s->state = ST_END;
+    } else {
+        s->state = ST_AFTER;
+    }
+}
+
+static void token_done(json_stream_t *s)
+{
+    text_end(s);
+    emit(s, JSON_EV_TOKEN);
+    value_done(s);
+}
+
+static void open_container(json_stream_t *s, char c)
+{
+    if (s->depth >= JSON_STREAM_MAX_DEPTH) {
+        fail(s, JSON_STREAM_TOO_DEEP);
+        return;
+    }
+    s->stack[s->depth++] = (uint8_t)c;
+    emit(s, c == '{' ? JSON_EV_OBJECT : JSON_EV_ARRAY);
+    s->state = c == '{' ? ST_KEY_OR_END : ST_VALUE_OR_END;
+}
+
+static void close_container(json_stream_t *s, char c)
+{
+    char open = c == '}' ? '{' : '[';
+    if (s->depth == 0 || s->stack[s->depth - 1] != (uint8_t)open) {
+        fail(s, JSON_STREAM_SYNTAX);
+        return;
+    }
+    emit(s, JSON_EV_END);
+    s->depth--;
+    value_done(s);
+}
+
+static void start_value(json_stream_t *s, char c)
+{
+    if (c == '{' || c == '[') {
+        open_container(s, c);
+    } else if (c == '"') {
+        text_start(s);
+        s->state = ST_STRING;
+    } else if (c == '-' || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z')) {
+        text_start(s);
+        text_byte(s, c);
+        s->state = ST_TOKEN;
+    } else {
+        fail(s, JSON_STREAM_SYNTAX);
+    }
+}
+
+static void step(json_stream_t *s, char c)
+{
+    switch (s->state) {
+    case ST_VALUE_OR_END:
+        if (is_space(c)) return;
+        if (c == ']') { close_container(s, c); return; }
+        start_value(s, c);
+        return;
+
+    case ST_VALUE:
+        if (is_space(c)) return;
+        start_value(s, c);
+        return;
+
+    case ST_KEY_OR_END:
+        if (is_space(c)) return;
+        if (c == '}') { close_container(s, c); return; }
+        /* fall through */
+    case ST_KEY:
+        if (is_space(c)) return;
+        if (c != '"') { fail(s, JSON_STREAM_SYNTAX); return; }
+        text_start(s);
+        s->state = ST_KEY_STRING;
+        return;
+
+    case ST_COLON:
+        if (is_space(c)) return;
+        if (c != ':') { fail(s, JSON_STREAM_SYNTAX); return; }
+        s->state = ST_VALUE;
+        return;
+
+    case ST_KEY_STRING:
+    case ST_STRING:
+        if (s->escape == 1) {
+            s->escape = 0;
+            switch (c) {
+            case '"': case '\\': case '/': text_byte(s, c); return;
+            case 'b': text_byte(s, '\b'); return;
+            case 'f': text_byte(s, '\f'); return;
+            case 'n': text_byte(s, '\n'); return;
+            case 'r': text_byte(s, '\r'); return;
+            case 't': text_byte(s, '\t'); return;
+            case 'u': s->escape = 2; s->code = 0; return;
+            default: fail(s, JSON_STREAM_SYNTAX); return;
+            }
+        }
+        if (s->escape >= 2) {
+            int d = hex_digit(c);
+            if (d < 0) { fail(s, JSON_STREAM_SYNTAX); return; }
+            s->code = (uint16_t)(s->code << 4 | d);
+            if (++s->escape == 6) {
+                s->escape = 0;
+                text_code(s, s->code);
+            }
+            return;
+        }
+        if (c == '\\') { s->escape = 1; return; }
+        if ((unsigned char)c < 0x20) { fail(s, JSON_STREAM_SYNTAX); return; }
+        if (c == '"') {
+            text_end(s);
+            if (s->state == ST_KEY_STRING) {
+                emit(s, JSON_EV_KEY);
+                s->state = ST_COLON;
+            } else {
+                emit(s, JSON_EV_STRING);
+                value_done(s);
+            }
+            return;
+        }
+        text_byte(s, c);
+        return;
+
+    case ST_TOKEN:
+        if (is_space(c) || c == ',' || c == '}' || c == ']') {
+            if (!valid_token(s->text, s->text_len)) { fail(s, JSON_STREAM_SYNTAX); return; }
+            token_done(s);
+            step(s, c);     // 구분자는 ST_AFTER에서 다시 처리
+            return;
+        }
+        if (s->text_len >= JSON_STREAM_TOKEN_MAX - 1) { fail(s, JSON_STREAM_SYNTAX); return; }
+        text_byte(s, c);
+        return;
+
+    case ST_AFTER:
+        if (is_space(c)) return;
+        if (c == ',') {
+            s->state = s->stack[s->depth - 1] == '{' ? ST_KEY : ST_VALUE;
+            return;
+        }
+        if (c == '}' || c == ']') { close_container(s, c); return; }
+        fail(s, JSON_STREAM_SYNTAX);
+        return;
+
+    case ST_END:
+        if (!is_space(c)) fail(s, JSON_STREAM_SYNTAX);
+        return;
+
+    default:
+        return;
+    }
+}
+
+bool json_stream_feed(json_stream_t *s, const char *data, size_t len)
+{
+    for (size_t i = 0; i < len && s->state != ST_ERROR; i++, s->pos++) {
+        step(s, data[i]);
+    }
+    return s->state != ST_ERROR;
+}
+
+bool json_stream_finish(json_stream_t *s)
+{
+    // 최상위가 숫자 하나인 본문 ("42")은 구분자 없이 끝난다
+    if (s->state == ST_TOKEN && s->depth == 0) {
+        if (!valid_token(s->text, s->text_len)) {
+            fail(s, JSON_STREAM_SYNTAX);
+            return false;
+        }
+        token_done(s);
+    }
+    if (s->state != ST_ERROR && !s->done) {
+        fail(s, JSON_STREAM_SYNTAX);
+    }
+    return s->done && s->state != ST_ERROR;
+}
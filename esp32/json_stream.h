@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 스트리밍 JSON 토크나이저 (힙 할당 없음, 본문 전체를 버퍼링하지 않음)
+// 입력을 조각으로 받는 대로 json_stream_feed()에 넣으면 구조를 따라가며 이벤트마다 on_event를 부른다.
+// 값을 해석하는 쪽은 그 위의 계층이다: 명령 폴링 응답은 cmd_stream.c, 설정 갱신은 device_config.c.
+//   JSON_EV_OBJECT/ARRAY  여는 괄호. depth는 그 컨테이너의 깊이 (최상위 컨테이너가 1)
+//   JSON_EV_END           닫는 괄호. depth는 닫히는 컨테이너의 깊이, stack[depth - 1]로 종류를 안다
+//   JSON_EV_KEY           멤버 이름 (text). depth는 그 멤버를 가진 객체의 깊이
+//   JSON_EV_STRING        문자열 값 (text)
+//   JSON_EV_TOKEN         숫자 또는 true/false/null (text, 구분자가 나와야 끝남)
+// 문자열/토큰은 init에서 받은 버퍼에 NUL로 끝나게 담고, 넘치는 뒷부분은 버리되 text_len에는 원래
+// 길이(바이트, 0xFFFF까지)를 센다. \uXXXX는 UTF-8로 바꾸며 NUL과 서로게이트 반쪽은 '?'로 남긴다.
+// 숫자는 구분자까지를 한 토큰으로 보는 느슨한 규칙이다 ("1.2.3"도 통과): 값으로 쓰는 쪽이 다시 확인한다.
+// pos는 지금 처리 중인 문자의 입력 내 위치: OBJECT/END에서 읽으면 괄호 자리다 (원문 구간을 얻을 때).
+
+#ifndef JSON_STREAM_MAX_DEPTH
+#define JSON_STREAM_MAX_DEPTH 8     // 이보다 깊게 중첩되면 JSON_STREAM_TOO_DEEP
+#endif
+
+#define JSON_STREAM_TOKEN_MAX 24    // 숫자/리터럴 최대 길이 (NUL 포함). 텍스트 버퍼는 이보다 작으면 안 된다
+
+typedef enum {
+    JSON_EV_OBJECT = 0,
+    JSON_EV_ARRAY,
+    JSON_EV_END,
+    JSON_EV_KEY,
+    JSON_EV_STRING,
+    JSON_EV_TOKEN,
+} json_event_t;
+
+typedef enum {
+    JSON_STREAM_OK = 0,
+    JSON_STREAM_SYNTAX,     // 잘못된 JSON (이후 입력은 무시)
+    JSON_STREAM_TOO_DEEP,
+} json_stream_error_t;
+
+typedef struct json_stream json_stream_t;
+
+typedef void (*json_stream_fn)(json_stream_t *s, json_event_t ev, void *ctx);
+
+struct json_stream {
+    json_stream_fn on_event;
+    void *ctx;
+    char *text;             // 문자열/키/토큰 (NUL로 끝남)
+    uint16_t text_cap;
+    uint16_t text_len;      // 원래 길이 (text_cap - 1보다 길면 잘린 것)
+
+    uint8_t state;
+    uint8_t depth;
+    uint8_t stack[JSON_STREAM_MAX_DEPTH];   // '{' 또는 '['
+    uint8_t escape;         // 0=없음, 1='\\' 다음, 2..5=\uXXXX 진행 중
+    uint16_t code;          // \uXXXX 코드 포인트
+    bool done;              // 최상위 값 하나를 끝까지 읽음
+    uint32_t pos;
+
+    json_stream_error_t error;
+};
+
+// text는 JSON_STREAM_TOKEN_MAX 이상이어야 한다.
+void json_stream_init(json_stream_t *s, char *text, size_t text_cap, json_stream_fn on_event, void *ctx);
+
+// 오류가 나면 false를 반환하고 이후 입력은 무시한다 (이미 보낸 이벤트는 유효).
+bool json_stream_feed(json_stream_t *s, const char *data, size_t len);
+
+// 입력이 끝났을 때 호출. 최상위 값이 완결되었으면 true.
+bool json_stream_finish(json_stream_t *s);
+
+#ifdef __cplusplus
+}
+#endif
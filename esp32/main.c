@@ -1,314 +1,286 @@
-#include <WiFi.h>
+#include <Arduino.h>
 #include <Wire.h>
-#include <PubSubClient.h>   // MQTT
 #include <ArduinoJson.h>    // JSON
-#include "Adafruit_SHT31.h" // SHT31
-#include <ESP32Servo.h>     // Servo
-#include <WebServer.h>      // HTTP
-
-// If you actually need this header, keep it. Otherwise you can remove the include.
-// #include "esp_http_pull.h"
-
-// ---------- Pins / Hardware ----------
-const int SHT31_SDA_PIN = 21;   // ESP32 default SDA
-const int SHT31_SCL_PIN = 22;   // ESP32 default SCL
-const int SERVO_PIN      = 25;
-const int WATER_PUMP_PIN = 33;  // water pump
-
-// ---------- Globals ----------
-Adafruit_SHT31 sht31;
-Servo           myservo;
-WebServer       server(8000);
-
-float pm25 = 0.0f;
-float pm10 = 0.0f;
-int   aqi  = 0;
-int   is_window = 0;   // 0=closed, 1=open
-bool  bug = false;
-bool  hasSHT31 = false;
-
-// ---------- Wi-Fi ----------
-const char* ssid     = "Hahhhh";
-const char* password = "12051205";
-
-// ---------- MQTT ----------
-const char* mqttServer   = "broker.hivemq.com";
-const char* mqttUserName = "";
-const char* mqttPwd      = "";
-const char* clientID     = "esp0001";
-
-const char* topic_pump = "s_window/pump";
-const char* topic_aqi  = "s_window/aqi";
-const char* topic_pm25 = "s_window/pm25";
-const char* topic_pm10 = "s_window/pm10";
-
-WiFiClient       espClient;
-PubSubClient     client(espClient);
-
-// ---------- PumpInfo ------------
-unsigned long pumpStart = 0;
-bool pumpActive = false;
+#include <esp_http_server.h> // HTTP (own task, keep-alive)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "air_app.h"        // setup()/loop() body on the HAL: control, sensors, network, /data
+#include "hal.h"            // clock
+#include "esp_command_handler.h" // command results
+#include "control_handoff.h" // /control httpd -> loop() handoff
+#include "state_feed.h"     // binary /data deltas
+#include "metrics.h"        // /metrics (Prometheus text)
+#include "dlog.h"           // deferred levelled logging
+#include "device_config.h"  // CONFIG results
+#ifdef AIR_BENCH
+#include <esp_heap_caps.h>
+#include "bench.h"          // on-device microbenchmarks
+#include "cmd_stream.h"      // pull-response parser (bench)
+#endif
+
+// The firmware itself (window/pump control, sensors, decision engine, config,
+// Wi-Fi/MQTT, /data snapshot, metrics) is air_app.c, which only talks to the
+// HAL and also runs on the host (tools/app_smoke_test.c). What stays here is
+// tied to the ESP-IDF: the HTTP server, the I2C scanner and the benchmarks.
+
+// ---------- Metrics ----------
+// The HTTP latency histograms are written by the httpd task; everything else
+// is written from loop() (air_app.c). /metrics renders them on demand.
+const uint32_t HTTP_LATENCY_BOUNDS_US[]  = { 250, 500, 1000, 2500, 5000, 10000, 25000, 100000, 250000, 1000000 };
+
+metric_t mHttpRoot       = METRIC_HISTOGRAM_INIT("air_http_request_us", "HTTP handler latency per route", "route=\"/\"", HTTP_LATENCY_BOUNDS_US);
+metric_t mHttpData       = METRIC_HISTOGRAM_INIT("air_http_request_us", "HTTP handler latency per route", "route=\"/data\"", HTTP_LATENCY_BOUNDS_US);
+metric_t mHttpControl    = METRIC_HISTOGRAM_INIT("air_http_request_us", "HTTP handler latency per route", "route=\"/control\"", HTTP_LATENCY_BOUNDS_US);
+metric_t mHttpMetrics    = METRIC_HISTOGRAM_INIT("air_http_request_us", "HTTP handler latency per route", "route=\"/metrics\"", HTTP_LATENCY_BOUNDS_US);
+metric_t mHttpNotModified = METRIC_COUNTER_INIT("air_http_not_modified_total", "/data polls answered with 304", NULL);
 
 // ---------- Forward Declarations ----------
-void setup_wifi();
-void close_window();
-void open_window();
-float di_calculation(float temp, float hum);
-void handle_http_data();
-void handle_http_control();
-void reconnect();
-void priority_decider(int aqi, float pm_25, float pm_10);
-void activatePump();
-void callback(char* topic, byte* payload, unsigned int length);
+void start_http_server();
 void i2cScan();
 
-  // ---------- Utility ----------
-  float di_calculation(float temp, float hum) {
-    return 0.81f * temp + 0.01f * hum * (0.99f * temp - 14.3f) + 46.3f;
-  }
+// ---------- HTTP Server (esp_http_server) ----------
+// Runs in its own task with several sockets and HTTP/1.1 keep-alive, so clients
+// never queue behind loop(). /data is served from the pre-serialized snapshot
+// that loop() rebuilds only after a state change; /control hands the command to loop()
+// through control_handoff and waits for the structured result; a CONFIG body
+// waits in the handoff's config slot, so only one update is in flight.
+// The snapshot carries a state version that only moves when the displayed
+// state changes, so pollers can revalidate with ?since= or ETag.
+const uint32_t CONTROL_TIMEOUT_MS      = 1000;
+const uint32_t CONTROL_BODY_TIMEOUT_MS = 3000;               // whole body, however slowly it arrives
+const size_t   CONFIG_BODY_MAX         = CONTROL_BODY_MAX;   // JSON update or HTTP body
+
+httpd_handle_t httpServer = NULL;
+
+esp_err_t http_send_json(httpd_req_t* req, const char* status, const char* body) {
+  httpd_resp_set_status(req, status);
+  httpd_resp_set_type(req, "application/json");
+  return httpd_resp_send(req, body, HTTPD_RESP_USE_STRLEN);
+}
 
-  // ---------- Wi-Fi ----------
-  void setup_wifi() {
-    Serial.print("Connecting to WiFi");
-    WiFi.mode(WIFI_STA);
-    WiFi.setSleep(false);
-    WiFi.begin(ssid, password);
-    while (WiFi.status() != WL_CONNECTED) {
-      delay(500);
-      Serial.print(".");
-    }
-    Serial.println("\nWiFi connected!");
-    Serial.print("WiFi SSID: ");   Serial.println(ssid);
-    Serial.print("IP Address: ");  Serial.println(WiFi.localIP());
-    Serial.print("Gateway: ");     Serial.println(WiFi.gatewayIP());
-    Serial.print("Subnet: ");      Serial.println(WiFi.subnetMask());
-  }
+esp_err_t http_root(httpd_req_t* req) {
+  httpd_resp_set_type(req, "text/plain");
+  return httpd_resp_send(req, "ok", 2);
+}
 
-     // ---------- Window Control ----------
-void open_window() {
-  // 이미 열려있으면 중복 실행 방지
-  if (is_window == 1) {
-    Serial.println("⚠️ Window already open, skipping");
-    return;
+// Accepts W/"123" or "123"
+bool parse_etag(const char* text, uint32_t* version) {
+  if (text[0] == 'W' && text[1] == '/') text += 2;
+  if (*text == '"') text++;
+  char* end;
+  unsigned long v = strtoul(text, &end, 10);
+  if (end == text) return false;
+  *version = (uint32_t)v;
+  return true;
+}
+
+// /data[?since=<version>][&format=bin]
+// 304 when the client already has the current version (since= or If-None-Match).
+// format=bin answers with the state_feed binary encoding: only the fields that
+// changed since `since` while that version is still in the history, else all.
+esp_err_t http_data(httpd_req_t* req) {
+  uint32_t since = 0;
+  bool hasSince = false, binary = false;
+  char query[48], val[16];
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+    if (httpd_query_key_value(query, "since", val, sizeof(val)) == ESP_OK) hasSince = parse_etag(val, &since);
+    if (httpd_query_key_value(query, "format", val, sizeof(val)) == ESP_OK) binary = strcmp(val, "bin") == 0;
   }
-  
-  Serial.println("🔄 Opening window...");
-  // 서보모터를 0도로 이동 (창문 열기)
-  for (int i = 90; i >= 0; i--) {
-    myservo.write(i);  // 90도 → 0도
-    delay(40);
+  if (!hasSince && httpd_req_get_hdr_value_str(req, "If-None-Match", val, sizeof(val)) == ESP_OK) {
+    hasSince = parse_etag(val, &since);
   }
-  is_window = 1;  // 루프 밖에서 한 번만 설정
-  Serial.println("✅ Window opened");
-}
-void close_window() {
-  // 이미 닫혀있으면 중복 실행 방지
-  if (is_window == 0) {
-    Serial.println("⚠️ Window already closed, skipping");
-    return;
+
+  char body[AIR_DATA_MAX];
+  size_t len = 0;
+  uint32_t version;
+  state_sample_t cur, base;
+  bool hasBase = false;
+
+  if (binary) {
+    version = air_app_data_state(since, &cur, &base, &hasBase);
+    hasBase = hasSince && hasBase;
+  } else {
+    len = air_app_data_json(body, sizeof(body), &version);
+  }
+
+  char etag[16];
+  snprintf(etag, sizeof(etag), "W/\"%u\"", (unsigned)version);
+  httpd_resp_set_hdr(req, "ETag", etag);
+  httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+
+  if (hasSince && since == version) {
+    metric_inc(&mHttpNotModified);
+    httpd_resp_set_status(req, "304 Not Modified");
+    return httpd_resp_send(req, NULL, 0);
   }
-  
-  Serial.println("🔄 Closing window...");
-  // 서보모터를 90도로 이동 (창문 닫기)
-  for (int i = 0; i <= 90; i++) {
-    myservo.write(i);  // 0도 → 90도
-    delay(40);
+  if (binary) {
+    len = state_feed_encode(&cur, hasBase ? &base : NULL, version, hal_millis(), (uint8_t*)body, sizeof(body));
+    httpd_resp_set_type(req, "application/octet-stream");
+    return httpd_resp_send(req, body, len);
   }
-  is_window = 0;  // 루프 밖에서 한 번만 설정
-  Serial.println("✅ Window closed");
+  httpd_resp_set_type(req, "application/json");
+  return httpd_resp_send(req, body, len);
 }
 
-// ---------- HTTP Handlers (define ONCE) ----------
-void handle_http_data() {
-  float cur_temp = NAN, cur_hum = NAN, di = 0.0f;
+esp_err_t send_command_result(httpd_req_t* req, const cmd_result_t& res) {
+  bool ok = true;
+  const char* status = HTTPD_200;
+  if (res.status == CMD_RESULT_UNKNOWN)     { ok = false; status = HTTPD_400; }
+  if (res.status == CMD_RESULT_NOT_ALLOWED) { ok = false; status = "403 Forbidden"; }
+  if (res.status == CMD_RESULT_PREEMPTED)   { ok = false; status = "409 Conflict"; }
+  if (res.status == CMD_RESULT_BAD_VALUE)   { ok = false; status = HTTPD_400; }
+
+  char body[96];
+  snprintf(body, sizeof(body), "{\"ok\":%s,\"result\":\"%s\",\"command\":\"%s\"}",
+           ok ? "true" : "false",
+           command_status_name(res.status),
+           res.name ? res.name : "");
+  return http_send_json(req, status, body);
+}
 
-  if (hasSHT31) {
-    cur_temp = sht31.readTemperature();
-    cur_hum  = sht31.readHumidity();
-    if (!isnan(cur_temp) && !isnan(cur_hum)) {
-      di = di_calculation(cur_temp, cur_hum);
-    }
-  }
+esp_err_t send_config_result(httpd_req_t* req, const control_reply_t& reply) {
+  const char* status = HTTPD_400;
+  if (reply.config_result == CFG_OK)           status = HTTPD_200;
+  if (reply.config_result == CFG_ERR_CONFLICT) status = "409 Conflict";
+  if (reply.config_result == CFG_ERR_STORAGE)  status = HTTPD_500;
+  return http_send_json(req, status, reply.config_json);
+}
 
-  StaticJsonDocument<256> doc;
-   doc["pm25"]        = pm25;
-   doc["pm10"]        = pm10;
-   doc["temperature"] = isnan(cur_temp) ? 0.0 : cur_temp;
-   doc["humidity"]    = isnan(cur_hum)  ? 0.0 : cur_hum;
-   doc["di"]          = di;
-   doc["bug"]         = bug;
-   doc["window"]      = (is_window == 1);
-   doc["sensor_control_enabled"] = !bug;  // 벌레 감지 시 센서 제어 비활성화
-   doc["timestamp"]   = millis();
-
-  String resp;
-  serializeJson(doc, resp);
-  server.send(200, "application/json", resp);
+// {"command":"WINDOW_OPEN","value":0,"id":123} -> command name + args
+// The filter skips a "config" object, which loop() parses from the config slot.
+bool parse_control_body(const char* body, size_t len, control_request_t* rq) {
+  StaticJsonDocument<64> filter;
+  filter["command"] = true;
+  filter["value"]   = true;
+  filter["id"]      = true;
+  StaticJsonDocument<128> doc;
+  if (deserializeJson(doc, body, len, DeserializationOption::Filter(filter))) return false;
+  strlcpy(rq->command, doc["command"] | "", sizeof(rq->command));
+  rq->args.value           = doc["value"] | 0;
+  rq->args.idempotency_key = doc["id"] | 0u;
+  return true;
 }
 
-void handle_http_control() {
-  if (!server.hasArg("plain")) {
-    server.send(400, "application/json", "{\"ok\":false,\"error\":\"no body\"}");
-    return;
+esp_err_t http_control(httpd_req_t* req) {
+  char body[CONFIG_BODY_MAX];
+  if (req->content_len == 0) {
+    return http_send_json(req, HTTPD_400, "{\"ok\":false,\"error\":\"no body\"}");
+  }
+  if (req->content_len >= sizeof(body)) {
+    return http_send_json(req, HTTPD_400, "{\"ok\":false,\"error\":\"body too large\"}");
   }
 
-  StaticJsonDocument<128> doc;
-  DeserializationError err = deserializeJson(doc, server.arg("plain"));
-  if (err) {
-    server.send(400, "application/json", "{\"ok\":false,\"error\":\"bad json\"}");
-    return;
+  // A client that stops sending (or trickles) must not hold the httpd task:
+  // give up after CONTROL_BODY_TIMEOUT_MS, answer 408 and close the socket,
+  // since the rest of the body would otherwise be read as the next request.
+  size_t got = 0;
+  uint32_t t0 = hal_millis();
+  while (got < req->content_len) {
+    if (hal_millis() - t0 > CONTROL_BODY_TIMEOUT_MS) {
+      DLOG_W(HTTP, "/control body timed out");
+      http_send_json(req, "408 Request Timeout", "{\"ok\":false,\"error\":\"body timeout\"}");
+      return ESP_FAIL;
+    }
+    int r = httpd_req_recv(req, body + got, req->content_len - got);
+    if (r == HTTPD_SOCK_ERR_TIMEOUT) continue;
+    if (r <= 0) return ESP_FAIL;
+    got += r;
+  }
+  body[got] = '\0';
+
+  control_request_t rq;
+  if (!parse_control_body(body, got, &rq)) {
+    return http_send_json(req, HTTPD_400, "{\"ok\":false,\"error\":\"bad json\"}");
   }
 
-  const char* command = doc["command"] | "";
-  Serial.print("HTTP command: "); Serial.println(command);
-
-     if (strcmp(command, "ON") == 0 || strcmp(command, "window_close") == 0) {
-     close_window(); is_window = 0;
-   } else if (strcmp(command, "OFF") == 0 || strcmp(command, "window_open") == 0) {
-     open_window();  is_window = 1;
-   } else if (strcmp(command, "window_toggle") == 0) {
-     if (is_window == 1) { close_window(); is_window = 0; }
-     else                { open_window();  is_window = 1; }
-   } else if (strcmp(command, "bug_on") == 0) {
-     bug = true;  
-     Serial.println("=== Bug detection ON - Sensor control disabled ===");
-     Serial.println("창문이 벌레 감지로 인해 닫혀있습니다. 센서 제어가 중단됩니다.");
-   } else if (strcmp(command, "bug_off") == 0) {
-     bug = false; 
-     Serial.println("=== Bug detection OFF - Sensor control enabled ===");
-     Serial.println("벌레 감지 해제. 센서 기반 창문 제어가 재개됩니다.");
-     // 벌레 감지 해제 시 우선순위 판단 실행
-     Serial.println("Execute priority decider after bug detection OFF");
-     priority_decider(aqi, pm25, pm10);
-   }
-
-  server.send(200, "application/json", "{\"ok\":true}");
+  control_reply_t reply;
+  switch (control_submit(air_app_control(), &rq, body, got, CONTROL_TIMEOUT_MS, &reply)) {
+    case CONTROL_BUSY:
+      return http_send_json(req, "503 Service Unavailable", "{\"ok\":false,\"error\":\"busy\"}");
+    case CONTROL_TIMEOUT:
+      return http_send_json(req, "504 Gateway Timeout", "{\"ok\":false,\"error\":\"timeout\"}");
+    case CONTROL_DONE:
+      break;
+  }
+  if (control_is_config(rq.command)) return send_config_result(req, reply);
+  return send_command_result(req, reply.result);
 }
 
-// ---------- MQTT ----------
-void reconnect() {
-  while (!client.connected()) {
-    if (client.connect(clientID, mqttUserName, mqttPwd)) {
-      Serial.println("MQTT connected");
-      client.subscribe(topic_pump); Serial.println("Subscribed Pump");
-      client.subscribe(topic_aqi);  Serial.println("Subscribed AQI");
-      client.subscribe(topic_pm25); Serial.println("Subscribed PM2.5");
-      client.subscribe(topic_pm10); Serial.println("Subscribed PM10");
-    } else {
-      Serial.print("failed, rc="); Serial.print(client.state());
-      Serial.println(" try again in 1 second");
-      delay(1000);
-    }
+// Streams the exposition in chunks so no full-size buffer is needed
+struct MetricsChunk {
+  httpd_req_t* req;
+  char         buf[512];
+  size_t       len;
+};
+
+int metrics_write_chunk(void* ctx, const char* data, size_t len) {
+  MetricsChunk* c = (MetricsChunk*)ctx;
+  if (c->len + len > sizeof(c->buf)) {
+    if (httpd_resp_send_chunk(c->req, c->buf, c->len) != ESP_OK) return -1;
+    c->len = 0;
   }
+  memcpy(c->buf + c->len, data, len);
+  c->len += len;
+  return 0;
 }
 
- void priority_decider(int aqi, float pm_25, float pm_10) {
-   Serial.println("=== Priority decider started ===");
-   
-   // 벌레 감지 상태 확인 - 벌레 감지 중에는 센서 제어 완전 중단
-   if (bug) {
-     Serial.println("🚫 Bug detected - Sensor control DISABLED");
-     Serial.println("창문이 벌레 감지로 인해 닫혀있습니다. 센서 제어가 중단됩니다.");
-     Serial.println("Flutter 앱에서 '벌레 감지 OFF' 버튼을 눌러야 센서 제어가 재개됩니다.");
-     return;
-   }
-   
-   Serial.println("✅ Bug not detected - Sensor control ENABLED");
-
-   float calc_temp = NAN, calc_hum = NAN;
-
-   if (hasSHT31) {
-     calc_temp = sht31.readTemperature();
-     calc_hum  = sht31.readHumidity();
-   }
-
-   if (!isnan(calc_temp)) { Serial.print("Temp C = "); Serial.print(calc_temp); Serial.print("\t"); }
-   else                   { Serial.println("Temp read failed"); }
-
-   if (!isnan(calc_hum))  { Serial.print("Hum %  = ");  Serial.println(calc_hum); }
-   else                   { Serial.println("Hum read failed"); }
-
-   float di_in = (!isnan(calc_temp) && !isnan(calc_hum)) ? di_calculation(calc_temp, calc_hum) : 0.0f;
-   Serial.print("DI: "); Serial.println(di_in);
-   Serial.print("PM2.5: "); Serial.print(pm_25); Serial.print(", PM10: "); Serial.println(pm_10);
-
-   if (pm_25 > 35 || pm_10 > 80) { 
-     Serial.println("PM2.5 or PM10 is bad -> close the window");
-     close_window(); is_window = 0; 
-   }
-   else if (di_in < 76) { 
-     Serial.println("DI is comfortable -> close the window");
-     close_window(); is_window = 0; 
-   }
-   else { 
-     Serial.println("Ventilation needed -> open the window");
-     open_window(); is_window = 1;  
-   }
-   
-   Serial.println("Priority decider done");
- }
-
-void activatePump() {
-  digitalWrite(WATER_PUMP_PIN, HIGH);
-  pumpStart = millis();
-  pumpActive = true;
-  Serial.println("Water pump ON - spraying");
+esp_err_t http_metrics(httpd_req_t* req) {
+  static MetricsChunk chunk;   // only the httpd task renders
+  chunk.req = req;
+  chunk.len = 0;
+  httpd_resp_set_type(req, "text/plain; version=0.0.4");
+  if (metrics_render(metrics_write_chunk, &chunk) != 0) return ESP_FAIL;
+  if (chunk.len && httpd_resp_send_chunk(req, chunk.buf, chunk.len) != ESP_OK) return ESP_FAIL;
+  return httpd_resp_send_chunk(req, NULL, 0);
 }
 
-void handlePump() {
-  if (pumpActive && millis() - pumpStart >= 3000) {
-    digitalWrite(WATER_PUMP_PIN, LOW);
-    pumpActive = false;
-    Serial.println("Water pump OFF - done");
-  }
+// Every route goes through http_timed, which records its handler latency
+struct TimedRoute {
+  esp_err_t (*handler)(httpd_req_t*);
+  metric_t*  latency;
+};
+
+esp_err_t http_timed(httpd_req_t* req) {
+  const TimedRoute* route = (const TimedRoute*)req->user_ctx;
+  uint32_t t0 = hal_micros();
+  esp_err_t err = route->handler(req);
+  metric_observe(route->latency, hal_micros() - t0);
+  return err;
 }
-void callback(char* topic, byte* payload, unsigned int length) {
-  Serial.print("Message topic: "); Serial.println(topic);
-
-  String data;
-  data.reserve(length);
-  for (unsigned int i = 0; i < length; i++) data += (char)payload[i];
-  data.trim();
-  Serial.print("Message: "); Serial.println(data);
-
-  if      (strcmp(topic, "s_window/aqi")  == 0) { aqi  = data.toInt();   Serial.print("Updated AQI: ");  Serial.println(aqi);  }
-  else if (strcmp(topic, "s_window/pm25") == 0) { pm25 = data.toFloat(); Serial.print("Updated PM2.5: ");Serial.println(pm25); }
-  else if (strcmp(topic, "s_window/pm10") == 0) { pm10 = data.toFloat(); Serial.print("Updated PM10: "); Serial.println(pm10); }
-     else if (strcmp(topic, "s_window/pump") == 0) {
-     // 중복 메시지 처리 방지
-     static String lastPumpState = "";
-     String currentPumpState = String(data);
-     
-     if (lastPumpState == currentPumpState) {
-       Serial.println("🔄 Duplicate pump message ignored: " + currentPumpState);
-       return;
-     }
-     
-     lastPumpState = currentPumpState;
-     Serial.println("📨 New pump message received: " + currentPumpState);
-     
-     if (data.equals("ON")) {
-       Serial.println("=== MQTT: Bug detected, close window and activate pump ===");
-       is_window = 0; 
-       close_window();     // 창문 닫기
-       activatePump(); 
-       bug = true;
-       Serial.println("Bug detected: true - Sensor control DISABLED");
-       Serial.println("창문이 벌레 감지로 인해 닫혀있습니다. 센서 제어가 중단됩니다.");
-     } else if (data.equals("OFF")) {
-       Serial.println("=== MQTT: Bug detection OFF ===");
-       bug = false; 
-       Serial.println("Bug detected: false - Sensor control ENABLED");
-       Serial.println("벌레 감지 해제. 센서 기반 창문 제어가 재개됩니다.");
-       
-       // 워터펌프 완료 후 5초 대기 (벌레 완전 제거 확인)
-       Serial.println("Wait 5 seconds and run priority decider");
-       delay(5000);
-       
-       Serial.println("Execute priority decider");
-       priority_decider(aqi, pm25, pm10);
-     }
-   }
+
+void start_http_server() {
+  static metric_t* const httpMetrics[] = {
+    &mHttpRoot, &mHttpData, &mHttpControl, &mHttpMetrics,   // same name: keep together
+    &mHttpNotModified,
+  };
+  for (metric_t* m : httpMetrics) metrics_register(m);
+
+  httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+  config.server_port      = AIR_HTTP_PORT;
+  config.stack_size       = 6144;
+  config.max_open_sockets = 7;
+  config.lru_purge_enable = true;   // drop the idlest keep-alive socket when full
+  config.recv_wait_timeout = 1;     // s per recv, so http_control checks its body deadline
+
+  if (httpd_start(&httpServer, &config) != ESP_OK) {
+    DLOG_E(HTTP, "HTTP server start failed");
+    return;
+  }
+
+  static const TimedRoute rootRoute    = { http_root,    &mHttpRoot };
+  static const TimedRoute dataRoute    = { http_data,    &mHttpData };
+  static const TimedRoute controlRoute = { http_control, &mHttpControl };
+  static const TimedRoute metricsRoute = { http_metrics, &mHttpMetrics };
+  static const httpd_uri_t routes[] = {
+    { "/",        HTTP_GET,  http_timed, (void*)&rootRoute },
+    { "/data",    HTTP_GET,  http_timed, (void*)&dataRoute },
+    { "/control", HTTP_POST, http_timed, (void*)&controlRoute },
+    { "/metrics", HTTP_GET,  http_timed, (void*)&metricsRoute },
+  };
+  for (const httpd_uri_t& route : routes) {
+    httpd_register_uri_handler(httpServer, &route);
+  }
+  DLOG_I(HTTP, "HTTP server on port %u (/, /data, /control, /metrics)", (unsigned)AIR_HTTP_PORT);
 }
 
 // ---------- Optional: I2C scanner ----------
@@ -326,68 +298,129 @@ void i2cScan() {
   Serial.println("I2C scan done");
 }
 
-// ---------- Setup / Loop ----------
-void setup() {
-  Serial.begin(115200, SERIAL_8N1);
-  delay(300);
+// ---------- Benchmarks (build with -DAIR_BENCH) ----------
+// Times the hot paths with the CPU cycle counter right after setup() and prints
+// one JSON line per benchmark prefixed with "BENCH ". tools/bench_capture.py
+// collects them from the serial port into a .jsonl file; tools/bench_host.c
+// runs the portable part of the same paths on the host.
+#ifdef AIR_BENCH
+const uint32_t BENCH_ITERATIONS      = 1000;
+const uint32_t BENCH_LOOP_ITERATIONS = 2000;
+
+uint64_t bench_now_ns() {
+  // extend the 32-bit cycle counter; called often enough never to miss a wrap
+  static uint32_t last = 0;
+  static uint64_t high = 0;
+  uint32_t c = ESP.getCycleCount();
+  if (c < last) high += 1ULL << 32;
+  last = c;
+  return (high + c) * 1000ULL / ESP.getCpuFreqMHz();
+}
+
+// Allocation calls made by the benchmark task, counted by the heap allocation
+// hook. The hook needs CONFIG_HEAP_USE_HOOKS=y in sdkconfig; without it
+// allocs_per_op is reported as null rather than guessed from heap totals
+// (a path that frees what it allocates would show 0).
+#ifdef CONFIG_HEAP_USE_HOOKS
+TaskHandle_t      benchTask = NULL;
+volatile uint32_t benchAllocs = 0;
+
+extern "C" void esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps) {
+  if (benchTask != NULL && xTaskGetCurrentTaskHandle() == benchTask) benchAllocs++;
+}
 
-  // Servo
-  myservo.attach(SERVO_PIN, 500, 2500);
+uint32_t bench_alloc_count() { return benchAllocs; }
+#define BENCH_ALLOC_COUNT bench_alloc_count
+#else
+#define BENCH_ALLOC_COUNT NULL
+#endif
 
-  // Water pump
-  pinMode(WATER_PUMP_PIN, OUTPUT);
-  digitalWrite(WATER_PUMP_PIN, LOW);
+void bench_mqtt_callback(void* ctx) {
+  static const uint8_t payload[] = "42.5";
+  air_app_mqtt_message("s_window/pm25", payload, sizeof(payload) - 1);
+}
 
-  // I2C
-  Wire.begin(SHT31_SDA_PIN, SHT31_SCL_PIN);
-  Wire.setClock(100000); // 100kHz for stability
+void bench_http_data(void* ctx) { air_app_build_snapshot(); }
 
-  setup_wifi();
+void bench_http_control(void* ctx) {
+  static const char body[] = "{\"command\":\"WINDOW_OPEN\",\"value\":0,\"id\":12345}";
+  control_request_t rq;
+  parse_control_body(body, sizeof(body) - 1, &rq);
+}
 
-  client.setServer(mqttServer, 1883);
-  client.setCallback(callback);
+void bench_poll_count(const air_command_t* cmd, void* ctx) { (*(uint32_t*)ctx)++; }
 
-  // Try SHT31 on both common addresses
-  hasSHT31 = sht31.begin(0x44);
-  if (!hasSHT31) {
-    Serial.println("SHT31 @0x44 not found, trying 0x45...");
-    hasSHT31 = sht31.begin(0x45);
+// Same body as the strchr parser it replaced, so --compare shows the cost
+void bench_poll_parse(void* ctx) {
+  static const char body[] = "{\"status\":\"ok\",\"command\":\"PUMP_ON\",\"ts\":1700000000000}";
+  static cmd_stream_t parser;
+  uint32_t n = 0;
+  cmd_stream_init(&parser, bench_poll_count, &n);
+  cmd_stream_feed(&parser, body, sizeof(body) - 1);
+  cmd_stream_finish(&parser);
+}
+
+// Four commands with arguments, fed in the 64-byte pieces the HTTP client hands over
+void bench_poll_parse_batch(void* ctx) {
+  static const char body[] =
+    "{\"status\":\"ok\",\"commands\":["
+    "{\"command\":\"WINDOW_OPEN\",\"seq\":41},"
+    "{\"command\":\"PUMP_ON\",\"value\":3000,\"seq\":42},"
+    "{\"command\":\"WINDOW_CLOSE\",\"seq\":43,\"id\":9001},"
+    "{\"command\":\"PUMP_OFF\",\"seq\":44}"
+    "],\"ts\":1700000000000}";
+  static cmd_stream_t parser;
+  uint32_t n = 0;
+  cmd_stream_init(&parser, bench_poll_count, &n);
+  for (size_t off = 0; off < sizeof(body) - 1; off += 64) {
+    size_t len = sizeof(body) - 1 - off;
+    cmd_stream_feed(&parser, body + off, len < 64 ? len : 64);
   }
-  if (!hasSHT31) {
-    Serial.println("WARN: SHT31 not found. Continuing without sensor.");
-    // i2cScan(); // uncomment if you want to scan the bus once
+  cmd_stream_finish(&parser);
+}
+
+void bench_loop_pass(void* ctx) { air_app_run_tasks(); }
+
+void run_benchmarks() {
+  static const struct {
+    const char* name;
+    bench_fn    fn;
+    uint32_t    iterations;
+  } benches[] = {
+    { "mqtt_callback",       bench_mqtt_callback, BENCH_ITERATIONS },
+    { "http_data_serialize", bench_http_data,     BENCH_ITERATIONS },
+    { "http_control_parse",  bench_http_control,  BENCH_ITERATIONS },
+    { "poll_parse",          bench_poll_parse,    BENCH_ITERATIONS },
+    { "poll_parse_batch",    bench_poll_parse_batch, BENCH_ITERATIONS },
+    { "loop_pass",           bench_loop_pass,     BENCH_LOOP_ITERATIONS },
+  };
+#ifdef CONFIG_HEAP_USE_HOOKS
+  benchTask = xTaskGetCurrentTaskHandle();
+#endif
+  const bench_env_t env = { bench_now_ns, BENCH_ALLOC_COUNT };
+  static bench_result_t result;   // samples are too big for the loop task stack
+  char line[320];
+
+  for (const auto& b : benches) {
+    bench_run(&env, b.name, b.fn, NULL, b.iterations, &result);
+    if (bench_format_json(&result, line, sizeof(line)) > 0) {
+      Serial.print("BENCH "); Serial.println(line);
+    }
   }
+  Serial.println("BENCH done");
+}
+#endif
 
-  // HTTP routes
-  server.on("/",        HTTP_GET,  [](){ server.send(200, "text/plain", "ok"); });
-  server.on("/data",    HTTP_GET,  handle_http_data);
-  server.on("/control", HTTP_POST, handle_http_control);
-  server.begin();
+// ---------- Setup / Loop ----------
+void setup() {
+  air_app_setup();
+  start_http_server();
 
-  Serial.println("HTTP server started!");
-  Serial.print("HTTP URL: http://"); Serial.print(WiFi.localIP()); Serial.println(":8000");
-  Serial.println("Endpoints: /, /data, /control");
-  Serial.println("========================");
+#ifdef AIR_BENCH
+  run_benchmarks();
+#endif
 }
 
 void loop() {
-  if (!client.connected()) reconnect();
-  client.loop();
-
-  server.handleClient();
-
-  handlePump();
-
-  // Optional periodic status
-  static unsigned long lastStatus = 0;
-  if (millis() - lastStatus > 10000) {
-    Serial.println("=== HTTP server status ===");
-    Serial.print("WiFi: ");  Serial.println(WiFi.status() == WL_CONNECTED ? "connected" : "disconnected");
-    Serial.print("IP: ");    Serial.println(WiFi.localIP());
-    Serial.print("HTTP: ");  Serial.println("http://" + WiFi.localIP().toString() + ":8000");
-    Serial.println("========================");
-    lastStatus = millis();
-  }
-
-  delay(2); // keep loop responsive
+  air_app_loop();
 }
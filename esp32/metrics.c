@@ -0,0 +1,133 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "metrics.h"
+
+static metric_t *s_metrics[METRICS_MAX];
+static uint8_t s_count = 0;
+
+void metrics_register(metric_t *m)
+{
+    if (s_count < METRICS_MAX) {
+        s_metrics[s_count++] = m;
+    }
+}
+
+void metric_observe(metric_t *m, uint32_t v)
+{
+    uint8_t i = 0;
+    while (i < m->bucket_count && v > m->bounds[i]) {
+        i++;
+    }
+    // 시퀀스 락: 홀수로 올리고, 값을 바꾸고, 다시 짝수로
+    uint32_t seq = m->seq;
+    __atomic_store_n(&m->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    m->buckets[i] = m->buckets[i] + 1;
+    m->count = m->count + 1;
+    m->sum = m->sum + v;
+    __atomic_store_n(&m->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+typedef struct {
+    uint32_t buckets[METRICS_MAX_BUCKETS + 1];
+    uint32_t count;
+    uint64_t sum;
+} histogram_copy_t;
+
+// 기록 중이 아닐 때의 값을 복사한다. 기록 태스크가 이 태스크에 선점된 채로 멈춰 있으면
+// 끝나지 않으므로 재시도 횟수를 제한하고, 실패하면 false (그 히스토그램은 이번에 건너뜀)
+#define METRICS_READ_RETRIES 64
+
+static bool histogram_read(const metric_t *m, histogram_copy_t *out)
+{
+    for (int attempt = 0; attempt < METRICS_READ_RETRIES; attempt++) {
+        uint32_t before = __atomic_load_n(&m->seq, __ATOMIC_ACQUIRE);
+        if (before & 1u) {
+            continue;
+        }
+        for (uint8_t i = 0; i <= m->bucket_count; i++) {
+            out->buckets[i] = m->buckets[i];
+        }
+        out->count = m->count;
+        out->sum = m->sum;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&m->seq, __ATOMIC_RELAXED) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static const char *type_name(metric_type_t t)
+{
+    switch (t) {
+    case METRIC_COUNTER:   return "counter";
+    case METRIC_GAUGE:     return "gauge";
+    case METRIC_HISTOGRAM: return "histogram";
+    }
+    return "untyped";
+}
+
+// name{labels,extra} 형태의 라벨 블록 (둘 다 없으면 빈 문자열)
+static void format_labels(char *out, size_t cap, const char *labels, const char *extra)
+{
+    bool has_labels = labels && labels[0];
+    if (!has_labels && !extra) {
+        out[0] = '\0';
+    } else if (has_labels && extra) {
+        snprintf(out, cap, "{%s,%s}", labels, extra);
+    } else {
+        snprintf(out, cap, "{%s}", has_labels ? labels : extra);
+    }
+}
+
+int metrics_render(metrics_write_fn write, void *ctx)
+{
+    char line[160];
+    char lbl[80];
+    int n, err;
+
+#define EMIT(...)                                                         \
+    do {                                                                  \
+        n = snprintf(line, sizeof(line), __VA_ARGS__);                    \
+        if (n > 0 && (err = write(ctx, line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1)) != 0) \
+            return err;                                                   \
+    } while (0)
+
+    for (uint8_t k = 0; k < s_count; k++) {
+        const metric_t *m = s_metrics[k];
+        if (k == 0 || strcmp(s_metrics[k - 1]->name, m->name) != 0) {
+            EMIT("# HELP %s %s\n# TYPE %s %s\n", m->name, m->help, m->name, type_name(m->type));
+        }
+
+        if (m->type != METRIC_HISTOGRAM) {
+            format_labels(lbl, sizeof(lbl), m->labels, NULL);
+            EMIT("%s%s %ld\n", m->name, lbl, (long)m->value);
+            continue;
+        }
+
+        histogram_copy_t h;
+        if (!histogram_read(m, &h)) {
+            continue;
+        }
+        uint32_t cumulative = 0;
+        char le[24];
+        for (uint8_t i = 0; i <= m->bucket_count; i++) {
+            cumulative += h.buckets[i];
+            if (i < m->bucket_count) {
+                snprintf(le, sizeof(le), "le=\"%lu\"", (unsigned long)m->bounds[i]);
+            } else {
+                snprintf(le, sizeof(le), "le=\"+Inf\"");
+            }
+            format_labels(lbl, sizeof(lbl), m->labels, le);
+            EMIT("%s_bucket%s %lu\n", m->name, lbl, (unsigned long)cumulative);
+        }
+        format_labels(lbl, sizeof(lbl), m->labels, NULL);
+        EMIT("%s_sum%s %llu\n", m->name, lbl, (unsigned long long)h.sum);
+        EMIT("%s_count%s %lu\n", m->name, lbl, (unsigned long)h.count);
+    }
+#undef EMIT
+    return 0;
+}
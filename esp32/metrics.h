@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 정적 메모리 기반 런타임 지표 (카운터/게이지/고정 버킷 히스토그램)
+// 지표는 전역 변수로 정의해 metrics_register_*()로 등록하고, 기록은 힙/락 없이 값만 갱신한다.
+// 지표마다 기록하는 태스크는 하나여야 한다. 렌더링은 어느 태스크에서나 가능하다: 카운터/게이지는
+// 32비트 정렬 읽기라 원자적이고, 히스토그램은 seq(시퀀스 락)로 버킷/count/64비트 sum을 한 번에 읽는다.
+// metrics_render()는 Prometheus 텍스트 형식으로 출력한다.
+
+#ifndef METRICS_MAX
+#define METRICS_MAX 48
+#endif
+
+#define METRICS_MAX_BUCKETS 12
+
+typedef enum {
+    METRIC_COUNTER = 0,
+    METRIC_GAUGE,
+    METRIC_HISTOGRAM,
+} metric_type_t;
+
+typedef struct {
+    // 설정
+    const char *name;
+    const char *help;
+    const char *labels;             // 예: "route=\"/data\"" (NULL이면 라벨 없음)
+    metric_type_t type;
+    const uint32_t *bounds;         // 히스토그램 버킷 상한 (오름차순)
+    uint8_t bucket_count;
+
+    // 값
+    volatile int32_t value;         // 카운터/게이지
+    volatile uint32_t buckets[METRICS_MAX_BUCKETS + 1];  // 마지막은 +Inf
+    volatile uint32_t count;
+    volatile uint64_t sum;          // 32비트 CPU에서는 두 번에 나눠 쓰이므로 seq 없이 읽지 않는다
+    uint32_t seq;                   // 홀수면 metric_observe()가 갱신 중
+} metric_t;
+
+// 값 필드까지 모두 채운다 (-Wextra의 필드 초기화 누락 경고 없이 C/C++ 양쪽에서 쓰도록)
+#define METRIC_VALUES_INIT                    0, { 0 }, 0, 0, 0
+#define METRIC_COUNTER_INIT(n, h, l)          { (n), (h), (l), METRIC_COUNTER, NULL, 0, METRIC_VALUES_INIT }
+#define METRIC_GAUGE_INIT(n, h, l)            { (n), (h), (l), METRIC_GAUGE, NULL, 0, METRIC_VALUES_INIT }
+// 버킷 수가 METRICS_MAX_BUCKETS를 넘으면 컴파일 오류 (음수 크기 배열)
+#define METRIC_BUCKET_COUNT(b) \
+    (sizeof(b) / sizeof((b)[0]) + 0 * sizeof(char[sizeof(b) / sizeof((b)[0]) <= METRICS_MAX_BUCKETS ? 1 : -1]))
+#define METRIC_HISTOGRAM_INIT(n, h, l, b)     { (n), (h), (l), METRIC_HISTOGRAM, (b), METRIC_BUCKET_COUNT(b), METRIC_VALUES_INIT }
+
+// 같은 이름(라벨만 다른) 지표는 연달아 등록해야 HELP/TYPE이 한 번만 출력된다
+void metrics_register(metric_t *m);
+
+static inline void metric_inc(metric_t *m) { m->value = m->value + 1; }
+static inline void metric_set(metric_t *m, int32_t v) { m->value = v; }
+void metric_observe(metric_t *m, uint32_t v);
+
+// 출력 조각마다 write를 호출 (HTTP chunk 전송 등). write가 0이 아니면 중단하고 그 값을 반환.
+typedef int (*metrics_write_fn)(void *ctx, const char *data, size_t len);
+int metrics_render(metrics_write_fn write, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
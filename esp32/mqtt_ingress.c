@@ -0,0 +1,90 @@
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mqtt_ingress.h"
+
+typedef struct {
+    const char *suffix;
+    mqtt_topic_t topic;
+} topic_entry_t;
+
+static const topic_entry_t s_topics[] = {
+    { "aqi",     MQTT_TOPIC_AQI },
+    { "pm25",    MQTT_TOPIC_PM25 },
+    { "pm10",    MQTT_TOPIC_PM10 },
+    { "pump",    MQTT_TOPIC_PUMP },
+    { "command", MQTT_TOPIC_COMMAND },
+    { "config",  MQTT_TOPIC_CONFIG },
+};
+
+mqtt_topic_t mqtt_topic_classify(const char *topic)
+{
+    if (topic == NULL) {
+        return MQTT_TOPIC_UNKNOWN;
+    }
+    const char *slash = strrchr(topic, '/');
+    const char *leaf = slash ? slash + 1 : topic;
+
+    for (size_t i = 0; i < sizeof(s_topics) / sizeof(s_topics[0]); i++) {
+        if (strcmp(leaf, s_topics[i].suffix) == 0) {
+            return s_topics[i].topic;
+        }
+    }
+    return MQTT_TOPIC_UNKNOWN;
+}
+
+static bool is_space(uint8_t c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool mqtt_payload_copy(const uint8_t *payload, unsigned int length, char *out, size_t cap)
+{
+    if (cap == 0) {
+        return false;
+    }
+    unsigned int start = 0;
+    unsigned int end = length;
+    while (start < end && is_space(payload[start])) start++;
+    while (end > start && is_space(payload[end - 1])) end--;
+
+    size_t n = end - start;
+    if (n > cap - 1) {
+        out[0] = '\0';
+        return false;
+    }
+    memcpy(out, payload + start, n);
+    out[n] = '\0';
+    return true;
+}
+
+bool mqtt_parse_float(const char *text, float *out)
+{
+    char *end = NULL;
+    if (text == NULL || text[0] == '\0') {
+        return false;
+    }
+    float v = strtof(text, &end);
+    if (end == text || *end != '\0' || !(v - v == 0.0f)) {
+        return false;
+    }
+    *out = v;
+    return true;
+}
+
+bool mqtt_parse_int(const char *text, int *out)
+{
+    char *end = NULL;
+    if (text == NULL || text[0] == '\0') {
+        return false;
+    }
+    errno = 0;
+    long v = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || v < INT_MIN || v > INT_MAX) {
+        return false;
+    }
+    *out = (int)v;
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// MQTT 수신 메시지 파서 (힙 할당 없음)
+// PubSubClient가 넘겨주는 payload/length를 호출자의 고정 버퍼에서 바로 해석한다.
+
+typedef enum {
+    MQTT_TOPIC_UNKNOWN = 0,
+    MQTT_TOPIC_AQI,
+    MQTT_TOPIC_PM25,
+    MQTT_TOPIC_PM10,
+    MQTT_TOPIC_PUMP,
+    MQTT_TOPIC_COMMAND,
+    MQTT_TOPIC_CONFIG,      // 설정 갱신 (JSON, device_config.h)
+} mqtt_topic_t;
+
+// 토픽의 마지막 경로 요소("…/pm25")로 종류를 판별
+mqtt_topic_t mqtt_topic_classify(const char *topic);
+
+// 앞뒤 공백을 제거하고 NUL 종료 문자열로 복사.
+// 종료 문자까지 cap에 들어가지 않으면 잘라 쓰지 않고 false (out은 빈 문자열):
+// 잘린 숫자가 다른 값으로 해석되지 않도록 한다.
+bool mqtt_payload_copy(const uint8_t *payload, unsigned int length, char *out, size_t cap);
+
+// 문자열 전체가 숫자일 때만 true (잘못된 값으로 기존 값을 덮어쓰지 않도록)
+// 범위를 벗어난 정수, NaN/무한대도 거부한다.
+bool mqtt_parse_float(const char *text, float *out);
+bool mqtt_parse_int(const char *text, int *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,130 @@
+#include <string.h>
+
+#include "pms5003.h"
+
+#define PMS5003_START1 0x42
+#define PMS5003_START2 0x4D
+
+void pms5003_init(pms5003_parser_t *p)
+{
+    memset(p, 0, sizeof(*p));
+}
+
+static uint16_t word_at(const uint8_t *b, int index)
+{
+    return (uint16_t)((b[index * 2] << 8) | b[index * 2 + 1]);
+}
+
+static void decode(const uint8_t *b, pms5003_frame_t *f)
+{
+    f->pm1_0_cf1 = word_at(b, 0);
+    f->pm2_5_cf1 = word_at(b, 1);
+    f->pm10_cf1  = word_at(b, 2);
+    f->pm1_0     = word_at(b, 3);
+    f->pm2_5     = word_at(b, 4);
+    f->pm10      = word_at(b, 5);
+    f->count_0_3 = word_at(b, 6);
+    f->count_0_5 = word_at(b, 7);
+    f->count_1_0 = word_at(b, 8);
+    f->count_2_5 = word_at(b, 9);
+    f->count_5_0 = word_at(b, 10);
+    f->count_10  = word_at(b, 11);
+}
+
+static void push_average(pms5003_parser_t *p, uint16_t pm25, uint16_t pm10)
+{
+    if (p->hist_count == PMS5003_AVG_WINDOW) {
+        p->sum_pm25 -= p->hist_pm25[p->hist_next];
+        p->sum_pm10 -= p->hist_pm10[p->hist_next];
+    } else {
+        p->hist_count++;
+    }
+    p->hist_pm25[p->hist_next] = pm25;
+    p->hist_pm10[p->hist_next] = pm10;
+    p->sum_pm25 += pm25;
+    p->sum_pm10 += pm10;
+    p->hist_next = (uint8_t)((p->hist_next + 1) % PMS5003_AVG_WINDOW);
+}
+
+int pms5003_feed(pms5003_parser_t *p, const uint8_t *data, size_t len, uint32_t now_ms)
+{
+    int frames = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = data[i];
+
+        switch (p->state) {
+        case PMS5003_WAIT_START1:
+            if (c == PMS5003_START1) {
+                p->sum = c;
+                p->state = PMS5003_WAIT_START2;
+            } else {
+                p->skipped_bytes++;
+            }
+            break;
+
+        case PMS5003_WAIT_START2:
+            if (c == PMS5003_START2) {
+                p->sum += c;
+                p->state = PMS5003_LEN_HI;
+            } else if (c == PMS5003_START1) {
+                p->skipped_bytes++;   // 0x42 0x42 0x4D: 두 번째 0x42부터 다시 시작
+                p->sum = c;
+            } else {
+                p->skipped_bytes += 2;
+                p->state = PMS5003_WAIT_START1;
+            }
+            break;
+
+        case PMS5003_LEN_HI:
+            p->sum += c;
+            p->state = (c == 0) ? PMS5003_LEN_LO : PMS5003_WAIT_START1;
+            if (c != 0) p->length_errors++;
+            break;
+
+        case PMS5003_LEN_LO:
+            p->sum += c;
+            if (c == PMS5003_PAYLOAD_LEN) {
+                p->body_pos = 0;
+                p->state = PMS5003_BODY;
+            } else {
+                p->length_errors++;
+                p->state = PMS5003_WAIT_START1;
+            }
+            break;
+
+        case PMS5003_BODY:
+            // 체크섬 자신(본문 마지막 2바이트)을 뺀 데이터 26바이트를 모두 더한다
+            if (p->body_pos < PMS5003_PAYLOAD_LEN - 2) {
+                p->sum += c;
+            }
+            p->body[p->body_pos++] = c;
+            if (p->body_pos == PMS5003_PAYLOAD_LEN) {
+                uint16_t expected = (uint16_t)((p->body[PMS5003_PAYLOAD_LEN - 2] << 8) |
+                                               p->body[PMS5003_PAYLOAD_LEN - 1]);
+                if (expected == p->sum) {
+                    decode(p->body, &p->last);
+                    p->last_frame_ms = now_ms;
+                    p->frames++;
+                    push_average(p, p->last.pm2_5, p->last.pm10);
+                    frames++;
+                } else {
+                    p->checksum_errors++;
+                }
+                p->state = PMS5003_WAIT_START1;
+            }
+            break;
+        }
+    }
+    return frames;
+}
+
+bool pms5003_average(const pms5003_parser_t *p, uint32_t now_ms, uint32_t max_age_ms, float *pm25, float *pm10)
+{
+    if (p->hist_count == 0 || now_ms - p->last_frame_ms > max_age_ms) {
+        return false;
+    }
+    *pm25 = (float)p->sum_pm25 / p->hist_count;
+    *pm10 = (float)p->sum_pm10 / p->hist_count;
+    return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// PMS5003 미세먼지 센서 UART 프레임 파서 (스트리밍 상태 기계)
+// 바이트가 도착하는 대로 pms5003_feed()에 넘기면 되고, 프레임 경계나 잡음 바이트가
+// 섞여 있어도 시작 바이트(0x42 0x4D)에서 다시 동기화한다.
+//
+// 프레임 (32B, 빅 엔디언):
+//   0x42 0x4D | 길이(2B)=28 | 데이터 13워드 | 체크섬(2B) = 앞의 모든 바이트 합
+
+#define PMS5003_FRAME_LEN   32
+#define PMS5003_PAYLOAD_LEN 28   // 길이 필드 값: 데이터 26B + 체크섬 2B
+
+#ifndef PMS5003_AVG_WINDOW
+#define PMS5003_AVG_WINDOW 10    // 이동 평균 프레임 수 (약 1초에 1프레임)
+#endif
+
+typedef struct {
+    uint16_t pm1_0_cf1;
+    uint16_t pm2_5_cf1;
+    uint16_t pm10_cf1;
+    uint16_t pm1_0;      // 대기 환경 기준 (µg/m³)
+    uint16_t pm2_5;
+    uint16_t pm10;
+    uint16_t count_0_3;  // 0.1L 당 입자 수
+    uint16_t count_0_5;
+    uint16_t count_1_0;
+    uint16_t count_2_5;
+    uint16_t count_5_0;
+    uint16_t count_10;
+} pms5003_frame_t;
+
+typedef enum {
+    PMS5003_WAIT_START1 = 0,
+    PMS5003_WAIT_START2,
+    PMS5003_LEN_HI,
+    PMS5003_LEN_LO,
+    PMS5003_BODY,
+} pms5003_state_t;
+
+typedef struct {
+    pms5003_state_t state;
+    uint8_t body[PMS5003_PAYLOAD_LEN];
+    uint8_t body_pos;
+    uint16_t sum;          // 체크섬 누적 (헤더 포함)
+
+    pms5003_frame_t last;
+    uint32_t last_frame_ms;
+
+    // 이동 평균 (PM2.5, PM10 대기 환경 기준)
+    uint16_t hist_pm25[PMS5003_AVG_WINDOW];
+    uint16_t hist_pm10[PMS5003_AVG_WINDOW];
+    uint32_t sum_pm25;
+    uint32_t sum_pm10;
+    uint8_t hist_next;
+    uint8_t hist_count;
+
+    // 통계
+    uint32_t frames;
+    uint32_t checksum_errors;
+    uint32_t length_errors;
+    uint32_t skipped_bytes;  // 동기화 전 버린 바이트
+} pms5003_parser_t;
+
+void pms5003_init(pms5003_parser_t *p);
+
+// 받은 바이트를 처리하고, 완성된(체크섬 통과) 프레임 수를 반환
+int pms5003_feed(pms5003_parser_t *p, const uint8_t *data, size_t len, uint32_t now_ms);
+
+// 이동 평균. 프레임을 아직 못 받았거나 max_age_ms보다 오래됐으면 false.
+bool pms5003_average(const pms5003_parser_t *p, uint32_t now_ms, uint32_t max_age_ms, float *pm25, float *pm10);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,86 @@
+#include <string.h>
+
+#include "power_manager.h"
+
+static uint32_t min_u32(uint32_t a, uint32_t b)
+{
+    return a < b ? a : b;
+}
+
+void pm_init(power_manager_t *pm, const pm_config_t *cfg, pm_mode_t mode, uint32_t now_ms)
+{
+    memset(pm, 0, sizeof(*pm));
+    pm->cfg = cfg;
+    pm->mode = mode;
+    pm->last_ms = now_ms;
+}
+
+pm_plan_t pm_plan(const power_manager_t *pm, uint32_t idle_ms, bool link_active)
+{
+    const pm_config_t *c = pm->cfg;
+    pm_plan_t p = { PM_STATE_WAIT, c->busy_wait_ms };
+
+    // PERFORMANCE: 할 일이 있어도 짧게 양보 (다른 태스크와 Wi-Fi 스택 몫)
+    if (pm->mode == PM_MODE_PERFORMANCE) {
+        return p;
+    }
+    if (idle_ms == 0) {
+        p.state = PM_STATE_ACTIVE;
+        p.ms = 0;
+        return p;
+    }
+    if (pm->locks) {
+        p.ms = min_u32(idle_ms, c->busy_wait_ms);
+        return p;
+    }
+    if (!link_active && idle_ms >= c->light_min_ms) {
+        p.state = PM_STATE_LIGHT;
+        p.ms = min_u32(idle_ms, c->light_max_ms);
+        return p;
+    }
+    p.ms = link_active ? min_u32(idle_ms, c->max_wait_ms) : idle_ms;
+    return p;
+}
+
+void pm_account(power_manager_t *pm, pm_plan_t plan, uint32_t slept_us, uint32_t now_ms)
+{
+    const uint32_t *ua = pm->cfg->ua[pm->mode];
+    uint32_t elapsed = now_ms - pm->last_ms;
+    uint32_t slept = min_u32(slept_us / 1000, elapsed);
+    uint32_t active = elapsed - slept;
+    pm->last_ms = now_ms;
+
+    pm->state_ms[PM_STATE_ACTIVE] += active;
+    pm->charge_ua_ms += (uint64_t)ua[PM_STATE_ACTIVE] * active;
+    if (plan.state == PM_STATE_ACTIVE || plan.ms == 0) {
+        return;
+    }
+    pm->state_ms[plan.state] += slept;
+    pm->charge_ua_ms += (uint64_t)ua[plan.state] * slept;
+
+    pm->wakeups++;
+    if (plan.state == PM_STATE_LIGHT) {
+        pm->light_sleeps++;
+    }
+    // 일찍 깨어난 경우(이벤트)는 0, 늦게 깨어난 만큼이 복귀 비용
+    uint32_t planned_us = plan.ms * 1000u;
+    pm->last_wake_latency_us = slept_us > planned_us ? slept_us - planned_us : 0;
+}
+
+uint32_t pm_avg_current_ua(const power_manager_t *pm)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < PM_STATE_COUNT; i++) {
+        total += pm->state_ms[i];
+    }
+    return total ? (uint32_t)(pm->charge_ua_ms / total) : pm->cfg->ua[pm->mode][PM_STATE_ACTIVE];
+}
+
+uint32_t pm_duty_permille(const power_manager_t *pm)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < PM_STATE_COUNT; i++) {
+        total += pm->state_ms[i];
+    }
+    return total ? (uint32_t)(pm->state_ms[PM_STATE_ACTIVE] * 1000u / total) : 1000u;
+}
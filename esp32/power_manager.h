@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 전력 관리자 (듀티 사이클 정책 + 전류 추정)
+// loop()가 스케줄러 패스를 마칠 때마다 pm_plan()에 다음 할 일까지 남은 시간을 넘기면
+// 이번 틈을 어떻게 쉴지(그냥 대기 / light sleep)와 얼마나 쉴지를 정해 준다.
+//   - PM_MODE_PERFORMANCE: 지금까지의 동작. 짧게 양보만 하고 라디오는 항상 켜 둔다.
+//   - PM_MODE_LOW_POWER:   다음 릴리스까지 CPU를 재우고 라디오는 modem-sleep.
+//     Wi-Fi가 연결(또는 연결 시도) 중이면 MQTT/HTTP 수신을 위해 max_wait_ms마다 깨어나고,
+//     링크가 끊겨 재시도를 기다리는 중이고 틈이 light_min_ms 이상이면 light sleep
+//     (타이머/GPIO로 깨어남. light sleep은 Wi-Fi 연결을 유지하지 못한다).
+//   - wake lock(창문 이동, 펌프 분사 등)이 하나라도 잡혀 있으면 모드와 무관하게 짧게만 쉰다.
+// 평균 전류는 상태별 체류 시간에 설정된 전류를 곱해 추정한다 (측정값이 아님).
+// 시간/하드웨어에 의존하지 않으며 loop() 컨텍스트(단일 태스크)에서만 호출한다.
+
+typedef enum {
+    PM_MODE_PERFORMANCE = 0,
+    PM_MODE_LOW_POWER,
+    PM_MODE_COUNT,
+} pm_mode_t;
+
+typedef enum {
+    PM_STATE_ACTIVE = 0,    // 태스크 실행 중
+    PM_STATE_WAIT,          // CPU 대기 (FreeRTOS idle), 라디오는 모드 설정대로
+    PM_STATE_LIGHT,         // light sleep (CPU 정지, 라디오 꺼짐)
+    PM_STATE_COUNT,
+} pm_state_t;
+
+// wake lock 비트: 비트마다 잡고 놓는 곳이 하나
+#define PM_LOCK_MOTION  (1u << 0)   // 서보 이동 중
+#define PM_LOCK_PUMP    (1u << 1)   // 펌프 분사 중
+
+typedef struct {
+    uint32_t busy_wait_ms;      // wake lock 중이거나 PERFORMANCE 모드일 때 한 번에 쉬는 시간
+    uint32_t max_wait_ms;       // LOW_POWER, 링크 연결 중: 수신 폴링을 위한 최대 대기
+    uint32_t light_min_ms;      // 이보다 짧은 틈은 light sleep 진입/복귀 비용이 더 크다
+    uint32_t light_max_ms;      // light sleep 한 번의 상한
+    uint32_t ua[PM_MODE_COUNT][PM_STATE_COUNT];     // 상태별 추정 전류 (uA)
+} pm_config_t;
+
+typedef struct {
+    pm_state_t state;
+    uint32_t ms;
+} pm_plan_t;
+
+typedef struct {
+    const pm_config_t *cfg;
+    pm_mode_t mode;
+    uint32_t locks;
+
+    // 계측 (pm_account()가 갱신)
+    uint32_t last_ms;           // 마지막으로 계산에 반영한 시각
+    uint64_t state_ms[PM_STATE_COUNT];
+    uint64_t charge_ua_ms;      // 누적 전하 (uA·ms)
+    uint32_t wakeups;           // 잠들었다 깨어난 횟수
+    uint32_t light_sleeps;
+    uint32_t last_wake_latency_us;  // 예정된 깨어남 이후 실행 재개까지 (light sleep 복귀 비용 포함)
+} power_manager_t;
+
+void pm_init(power_manager_t *pm, const pm_config_t *cfg, pm_mode_t mode, uint32_t now_ms);
+static inline void pm_set_mode(power_manager_t *pm, pm_mode_t mode) { pm->mode = mode; }
+
+static inline void pm_lock(power_manager_t *pm, uint32_t bits) { pm->locks |= bits; }
+static inline void pm_unlock(power_manager_t *pm, uint32_t bits) { pm->locks &= ~bits; }
+
+// idle_ms: 다음 태스크 릴리스/연결 재시도까지 남은 시간 (sched_idle_ms 등)
+// link_active: Wi-Fi가 연결되어 있거나 연결 시도 중이면 true (light sleep 금지, 수신 폴링)
+pm_plan_t pm_plan(const power_manager_t *pm, uint32_t idle_ms, bool link_active);
+
+// 한 번 쉬고 난 뒤 호출. 지난 호출 이후 시간 중 slept_us를 plan.state로, 나머지를 ACTIVE로 계산한다.
+// slept_us가 계획보다 길면 그 초과분을 깨어남 지연으로 기록한다.
+void pm_account(power_manager_t *pm, pm_plan_t plan, uint32_t slept_us, uint32_t now_ms);
+
+// 부팅 이후 평균 전류 추정치 (uA)
+uint32_t pm_avg_current_ua(const power_manager_t *pm);
+// 부팅 이후 ACTIVE 비율 (0.1% 단위)
+uint32_t pm_duty_permille(const power_manager_t *pm);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,53 @@
+#include <string.h>
+
+#include "rtt_estimator.h"
+
+#define RTT_MAX_BACKOFF 6
+
+void rtt_init(rtt_estimator_t *e, const rtt_config_t *cfg)
+{
+    memset(e, 0, sizeof(*e));
+    e->cfg = cfg;
+}
+
+void rtt_observe(rtt_estimator_t *e, uint32_t rtt_ms)
+{
+    if (rtt_ms == 0) {
+        rtt_ms = 1;
+    }
+    e->samples++;
+    e->last_rtt_ms = rtt_ms;
+    e->backoff = 0;
+
+    if (e->srtt_x8 == 0) {
+        // 첫 표본: srtt = rtt, rttvar = rtt / 2
+        e->srtt_x8 = rtt_ms << 3;
+        e->rttvar_x4 = rtt_ms << 1;
+        return;
+    }
+    int32_t err = (int32_t)rtt_ms - (int32_t)(e->srtt_x8 >> 3);
+    e->srtt_x8 += err;                              // srtt += err / 8
+    if (err < 0) {
+        err = -err;
+    }
+    e->rttvar_x4 += err - (int32_t)(e->rttvar_x4 >> 2);   // rttvar += (|err| - rttvar) / 4
+}
+
+void rtt_fail(rtt_estimator_t *e)
+{
+    e->failures++;
+    if (e->backoff < RTT_MAX_BACKOFF) {
+        e->backoff++;
+    }
+}
+
+uint32_t rtt_timeout_ms(const rtt_estimator_t *e)
+{
+    const rtt_config_t *c = e->cfg;
+    uint32_t t = e->srtt_x8 ? (e->srtt_x8 >> 3) + e->rttvar_x4 : c->initial_ms;
+    if (t < c->min_ms) {
+        t = c->min_ms;
+    }
+    t <<= e->backoff;
+    return t > c->max_ms ? c->max_ms : t;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 요청 왕복 시간(RTT) 추정과 적응형 타임아웃 (TCP RTO 계산 방식, RFC 6298)
+//   srtt   += (rtt - srtt) / 8
+//   rttvar += (|rtt - srtt| - rttvar) / 4
+//   timeout = srtt + 4 * rttvar  (min_ms..max_ms로 제한)
+// 요청이 실패(타임아웃/연결 오류)하면 표본 없이 타임아웃을 두 배로 늘리고(상한 max_ms),
+// 다음 성공 표본에서 원래 계산으로 돌아온다. 실패한 요청의 소요 시간은 표본으로 쓰지 않는다.
+// 고정 소수점(ms * 8, ms * 4)으로 계산해 부동소수점을 쓰지 않는다.
+
+typedef struct {
+    uint32_t initial_ms;    // 표본이 없을 때의 타임아웃 (예전 고정값)
+    uint32_t min_ms;
+    uint32_t max_ms;
+} rtt_config_t;
+
+typedef struct {
+    const rtt_config_t *cfg;
+    uint32_t srtt_x8;       // 0이면 표본 없음
+    uint32_t rttvar_x4;
+    uint8_t backoff;        // 연속 실패 횟수 (타임아웃 << backoff)
+
+    // 통계
+    uint32_t samples;
+    uint32_t failures;
+    uint32_t last_rtt_ms;
+} rtt_estimator_t;
+
+void rtt_init(rtt_estimator_t *e, const rtt_config_t *cfg);
+// 성공한 요청의 소요 시간
+void rtt_observe(rtt_estimator_t *e, uint32_t rtt_ms);
+// 실패한 요청 (타임아웃 백오프)
+void rtt_fail(rtt_estimator_t *e);
+// 다음 요청에 쓸 타임아웃
+uint32_t rtt_timeout_ms(const rtt_estimator_t *e);
+
+static inline uint32_t rtt_srtt_ms(const rtt_estimator_t *e) { return e->srtt_x8 >> 3; }
+
+#ifdef __cplusplus
+}
+#endif
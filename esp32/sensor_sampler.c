@@ -0,0 +1,93 @@
+#include <math.h>
+#include <string.h>
+
+#include "sensor_sampler.h"
+
+void sensor_sampler_init(sensor_sampler_t *s, sensor_read_fn read, void *ctx, float ema_alpha, uint8_t max_failures)
+{
+    memset(s, 0, sizeof(*s));
+    s->read = read;
+    s->ctx = ctx;
+    s->ema_alpha = ema_alpha;
+    s->max_failures = max_failures;
+    s->work.temperature = NAN;
+    s->work.humidity = NAN;
+    s->slots[0] = s->work;
+    s->slots[1] = s->work;
+}
+
+static float median3(const float *v, uint8_t n)
+{
+    if (n < 3) {
+        return v[n - 1];  // 아직 한 바퀴를 돌지 않았으면 최신 값
+    }
+    float a = v[0], b = v[1], c = v[2];
+    if ((a <= b && b <= c) || (c <= b && b <= a)) return b;
+    if ((b <= a && a <= c) || (c <= a && a <= b)) return a;
+    return c;
+}
+
+// seq가 짝수면 안정 상태이며 현재 슬롯은 (seq >> 1) & 1.
+// 쓰기 동안에는 seq를 홀수로 두고 현재가 아닌 슬롯에 쓴 뒤, 짝수로 올려 발행한다.
+static void publish(sensor_sampler_t *s)
+{
+    uint32_t seq = s->seq;
+    __atomic_store_n(&s->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    s->slots[((seq >> 1) + 1) & 1] = s->work;
+    __atomic_store_n(&s->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+bool sensor_sampler_sample(sensor_sampler_t *s, uint32_t now_ms)
+{
+    float t = NAN, h = NAN;
+    bool ok = s->read && s->read(s->ctx, &t, &h) && !isnan(t) && !isnan(h);
+
+    if (!ok) {
+        s->work.errors++;
+        if (s->failures < UINT8_MAX) {
+            s->failures++;
+        }
+        if (s->work.valid && s->failures >= s->max_failures) {
+            s->work.valid = false;
+            publish(s);
+            return true;
+        }
+        return false;
+    }
+    s->failures = 0;
+
+    // 최근 3개 원시값의 중앙값으로 튀는 값 제거
+    s->raw_t[s->raw_next] = t;
+    s->raw_h[s->raw_next] = h;
+    s->raw_next = (uint8_t)((s->raw_next + 1) % 3);
+    if (s->raw_count < 3) {
+        s->raw_count++;
+    }
+    float mt = median3(s->raw_t, s->raw_count);
+    float mh = median3(s->raw_h, s->raw_count);
+
+    if (isnan(s->work.temperature)) {
+        s->work.temperature = mt;
+        s->work.humidity = mh;
+    } else {
+        s->work.temperature += s->ema_alpha * (mt - s->work.temperature);
+        s->work.humidity += s->ema_alpha * (mh - s->work.humidity);
+    }
+    s->work.timestamp_ms = now_ms;
+    s->work.valid = true;
+    publish(s);
+    return true;
+}
+
+void sensor_sampler_get(const sensor_sampler_t *s, sensor_reading_t *out)
+{
+    uint32_t base, after;
+    do {
+        base = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) & ~1u;
+        *out = s->slots[(base >> 1) & 1];
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+        // 읽던 슬롯에 대한 다음 쓰기는 seq가 base + 3이 될 때 시작된다
+    } while (after - base >= 3);
+}
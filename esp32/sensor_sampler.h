@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 백그라운드 온습도 샘플러
+// 주기 태스크가 sensor_sampler_sample()로 센서를 한 번(온도+습도 동시 측정) 읽고,
+// 중앙값(3) + EMA 필터를 거쳐 이중 버퍼 스냅샷으로 발행한다.
+// HTTP 핸들러/판단 로직은 sensor_sampler_get()으로 락 없이 O(1)에 최신 값을 읽는다.
+// 드라이버는 함수 포인터로 주입하므로 가짜 I2C 드라이버로 대체할 수 있다.
+
+typedef bool (*sensor_read_fn)(void *ctx, float *temperature, float *humidity);
+
+typedef struct {
+    float temperature;      // 필터링된 값 (°C)
+    float humidity;         // 필터링된 값 (%)
+    uint32_t timestamp_ms;  // 마지막 유효 측정 시각
+    uint32_t errors;        // 누적 읽기 실패 수
+    bool valid;             // 유효 측정이 한 번이라도 있었고 최근 측정이 성공했는지
+} sensor_reading_t;
+
+typedef struct {
+    // 설정
+    sensor_read_fn read;
+    void *ctx;
+    float ema_alpha;        // 0~1, 클수록 새 값에 민감
+    uint8_t max_failures;   // 연속 실패가 이만큼 쌓이면 valid=false
+
+    // 필터 상태 (샘플링 태스크 전용)
+    float raw_t[3];
+    float raw_h[3];
+    uint8_t raw_count;
+    uint8_t raw_next;
+    uint8_t failures;
+    sensor_reading_t work;
+
+    // 발행된 스냅샷 (이중 버퍼, seq는 sensor_sampler.c의 publish() 참고)
+    sensor_reading_t slots[2];
+    volatile uint32_t seq;
+} sensor_sampler_t;
+
+void sensor_sampler_init(sensor_sampler_t *s, sensor_read_fn read, void *ctx, float ema_alpha, uint8_t max_failures);
+
+// 한 번 측정하고 스냅샷을 발행. 새 값이 발행되면 true.
+bool sensor_sampler_sample(sensor_sampler_t *s, uint32_t now_ms);
+
+// 어느 태스크에서든 호출 가능 (쓰기 도중이면 재시도)
+void sensor_sampler_get(const sensor_sampler_t *s, sensor_reading_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,108 @@
+#include <math.h>
+#include <string.h>
+
+#include "servo_motion.h"
+
+// 목표 도달 판정 오차 (deg)
+#define SERVO_MOTION_EPSILON 0.05f
+
+void servo_motion_init(servo_motion_t *m,
+                       const servo_motion_profile_t *profile,
+                       float position,
+                       uint32_t now_ms)
+{
+    memset(m, 0, sizeof(*m));
+    m->profile = *profile;
+    m->position = position;
+    m->target = position;
+    m->start = position;
+    m->last_tick_ms = now_ms;
+}
+
+void servo_motion_set_target(servo_motion_t *m, float target, uint32_t now_ms)
+{
+    if (!m->moving) {
+        // 정지 상태에서 시작하는 이동은 dt가 누적되지 않도록 기준 시각을 갱신
+        m->last_tick_ms = now_ms;
+    }
+    m->start = m->position;
+    m->target = target;
+    m->moving = fabsf(target - m->position) > SERVO_MOTION_EPSILON || m->velocity != 0.0f;
+}
+
+// dt(초)만큼 한 번 적분
+static void step(servo_motion_t *m, float dt)
+{
+    const float vmax = m->profile.max_velocity_dps;
+    const float accel = m->profile.acceleration_dps2;
+    float err = m->target - m->position;
+    float dir = (err >= 0.0f) ? 1.0f : -1.0f;
+
+    if (accel <= 0.0f) {
+        m->velocity = dir * vmax;
+    } else {
+        float along = m->velocity * dir;  // 목표 방향 성분 (음수면 반대로 가는 중)
+        float stop_dist = (m->velocity * m->velocity) / (2.0f * accel);
+        if (along < 0.0f) {
+            // 반전: 먼저 감속해서 멈춘 뒤 목표 쪽으로 가속
+            m->velocity += dir * accel * dt;
+        } else if (stop_dist + along * dt >= fabsf(err)) {
+            // 감속 구간 (이번 간격에 갈 거리까지 봐서 늦지 않게 시작).
+            // 완전히 멈춰서 목표 직전에 서지 않도록 최소 속도 유지
+            float speed = along - accel * dt;
+            float min_speed = accel * dt;
+            m->velocity = dir * (speed > min_speed ? speed : min_speed);
+        } else {
+            float speed = along + accel * dt;
+            m->velocity = dir * (speed < vmax ? speed : vmax);
+        }
+    }
+
+    m->position += m->velocity * dt;
+
+    // 목표를 지나쳤으면(또는 도달했으면) 목표에 맞추고 정지
+    if ((m->target - m->position) * dir <= SERVO_MOTION_EPSILON && m->velocity * dir >= 0.0f) {
+        m->position = m->target;
+        m->velocity = 0.0f;
+        m->moving = false;
+    }
+}
+
+bool servo_motion_tick(servo_motion_t *m, uint32_t now_ms)
+{
+    uint32_t elapsed = now_ms - m->last_tick_ms;
+    m->last_tick_ms = now_ms;
+    if (!m->moving) {
+        return false;
+    }
+    if (elapsed > SERVO_MOTION_MAX_GAP_MS) {
+        // loop가 멈춘 동안 서보는 마지막으로 쓴 각도에 멈춰 있었다. 밀린 이동을 한 번에 쓰면
+        // 서보가 최대 속도 이상으로 튀므로 버리고, 현재 위치에서 정지 상태로 다시 계획한다.
+        m->velocity = 0.0f;
+        elapsed = SERVO_MOTION_STEP_MS;
+    }
+    // 긴 간격은 SERVO_MOTION_STEP_MS 단위로 나눠 적분하고, 목표에 도달하면 남은 시간은 버린다.
+    while (elapsed > 0 && m->moving) {
+        uint32_t ms = elapsed < SERVO_MOTION_STEP_MS ? elapsed : SERVO_MOTION_STEP_MS;
+        step(m, (float)ms / 1000.0f);
+        elapsed -= ms;
+    }
+    return true;
+}
+
+int servo_motion_angle(const servo_motion_t *m)
+{
+    return (int)lroundf(m->position);
+}
+
+uint8_t servo_motion_progress(const servo_motion_t *m)
+{
+    float total = fabsf(m->target - m->start);
+    if (!m->moving || total <= SERVO_MOTION_EPSILON) {
+        return 100;
+    }
+    float done = 1.0f - fabsf(m->target - m->position) / total;
+    if (done < 0.0f) done = 0.0f;
+    if (done > 1.0f) done = 1.0f;
+    return (uint8_t)(done * 100.0f);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 창문 서보 비차단(non-blocking) 모션 엔진
+// loop()가 매 패스마다 servo_motion_tick()을 호출하면 경과 시간만큼만 이동한다.
+// 시간은 호출자가 넘겨주므로(ms) 하드웨어 없이도 가짜 시계로 구동할 수 있다.
+
+#ifndef SERVO_MOTION_STEP_MS
+#define SERVO_MOTION_STEP_MS 10     // 적분 간격 상한: 긴 tick 간격은 이 단위로 나눠 계산한다
+#endif
+
+#ifndef SERVO_MOTION_MAX_GAP_MS
+#define SERVO_MOTION_MAX_GAP_MS 100 // 이보다 긴 tick 간격은 loop가 멈췄던 것으로 보고 따라잡지 않는다
+#endif
+
+typedef struct {
+    float max_velocity_dps;   // 최대 각속도 (deg/s)
+    float acceleration_dps2;  // 가감속 (deg/s^2), 0 이하이면 등속 이동
+} servo_motion_profile_t;
+
+typedef struct {
+    servo_motion_profile_t profile;
+    float position;        // 현재 각도 (deg)
+    float velocity;        // 부호 있는 각속도 (deg/s)
+    float target;          // 목표 각도 (deg)
+    float start;           // 진행률 계산용: 현재 이동의 시작 각도
+    uint32_t last_tick_ms;
+    bool moving;
+} servo_motion_t;
+
+void servo_motion_init(servo_motion_t *m,
+                       const servo_motion_profile_t *profile,
+                       float position,
+                       uint32_t now_ms);
+
+// 이동 중에도 호출 가능: 현재 속도를 유지한 채 감속/반전하여 새 목표로 향한다.
+void servo_motion_set_target(servo_motion_t *m, float target, uint32_t now_ms);
+
+// 경과 시간만큼 위치를 갱신. 이동 중이었으면 true.
+// 간격이 SERVO_MOTION_MAX_GAP_MS를 넘으면(loop 멈춤) 그동안 서보는 마지막 각도에 서 있었으므로
+// 멈춘 시간을 한 번에 반영해 튀지 않고, 그 자리에서 정지 상태로 다시 가속한다.
+bool servo_motion_tick(servo_motion_t *m, uint32_t now_ms);
+
+int servo_motion_angle(const servo_motion_t *m);      // 서보에 쓸 정수 각도
+uint8_t servo_motion_progress(const servo_motion_t *m); // 0~100 %
+
+#ifdef __cplusplus
+}
+#endif
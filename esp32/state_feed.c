@@ -0,0 +1,144 @@
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "state_feed.h"
+
+// 필드 테이블: 비교와 인코딩에 같이 쓴다 (순서 = field_mask 비트 = 바이너리 순서)
+typedef struct {
+    uint8_t offset;
+    uint8_t size;
+} field_t;
+
+#define FIELD(name) { offsetof(state_sample_t, name), sizeof(((state_sample_t *)0)->name) }
+
+static const field_t s_fields[] = {
+    FIELD(pm25_x10),
+    FIELD(pm10_x10),
+    FIELD(pm25_outdoor_x10),
+    FIELD(pm10_outdoor_x10),
+    FIELD(temperature_x10),
+    FIELD(humidity_x10),
+    FIELD(di_x10),
+    FIELD(flags),
+    FIELD(window_position),
+    FIELD(window_progress),
+    FIELD(decision_reason),
+    FIELD(cmd_count),
+    FIELD(cmd_latency_p50_ms),
+    FIELD(cmd_latency_p99_ms),
+};
+
+#define FIELD_COUNT (sizeof(s_fields) / sizeof(s_fields[0]))
+
+static uint32_t field_get(const state_sample_t *s, const field_t *fd)
+{
+    const uint8_t *p = (const uint8_t *)s + fd->offset;
+    switch (fd->size) {
+    case 1: { uint8_t v;  memcpy(&v, p, 1); return v; }
+    case 2: { uint16_t v; memcpy(&v, p, 2); return v; }
+    default: { uint32_t v; memcpy(&v, p, 4); return v; }
+    }
+}
+
+static uint16_t diff_mask(const state_sample_t *a, const state_sample_t *b)
+{
+    uint16_t mask = 0;
+    for (unsigned i = 0; i < FIELD_COUNT; i++) {
+        if (field_get(a, &s_fields[i]) != field_get(b, &s_fields[i])) {
+            mask |= (uint16_t)(1u << i);
+        }
+    }
+    return mask;
+}
+
+static uint8_t *put_le(uint8_t *p, uint32_t v, uint8_t size)
+{
+    for (uint8_t i = 0; i < size; i++) {
+        *p++ = (uint8_t)(v >> (8 * i));
+    }
+    return p;
+}
+
+int16_t state_feed_x10(float v)
+{
+    if (isnan(v)) return 0;
+    float x = v * 10.0f;
+    if (x > 32767.0f) return 32767;
+    if (x < -32768.0f) return -32768;
+    return (int16_t)lroundf(x);
+}
+
+void state_feed_init(state_feed_t *f, uint32_t initial_version)
+{
+    memset(f, 0, sizeof(*f));
+    f->version = initial_version;
+}
+
+bool state_feed_update(state_feed_t *f, const state_sample_t *s, uint32_t now_ms)
+{
+    if (f->has_current && diff_mask(&f->current, s) == 0) {
+        return false;
+    }
+    if (f->has_current) {
+        f->history[f->history_next] = f->current;
+        f->history_version[f->history_next] = f->version;
+        f->history_next = (uint8_t)((f->history_next + 1) % STATE_FEED_HISTORY);
+        if (f->history_count < STATE_FEED_HISTORY) {
+            f->history_count++;
+        }
+    }
+    f->current = *s;
+    f->has_current = true;
+    f->version++;
+    f->changed_ms = now_ms;
+    return true;
+}
+
+bool state_feed_lookup(const state_feed_t *f, uint32_t version, state_sample_t *out)
+{
+    if (f->has_current && version == f->version) {
+        *out = f->current;
+        return true;
+    }
+    for (uint8_t i = 0; i < f->history_count; i++) {
+        if (f->history_version[i] == version) {
+            *out = f->history[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t state_feed_encode(const state_sample_t *s,
+                         const state_sample_t *base,
+                         uint32_t version,
+                         uint32_t uptime_ms,
+                         uint8_t *out,
+                         size_t cap)
+{
+    uint16_t mask = base ? diff_mask(base, s) : (uint16_t)((1u << FIELD_COUNT) - 1);
+
+    size_t need = STATE_FEED_HEADER;
+    for (unsigned i = 0; i < FIELD_COUNT; i++) {
+        if (mask & (1u << i)) {
+            need += s_fields[i].size;
+        }
+    }
+    if (need > cap) {
+        return 0;
+    }
+
+    uint8_t *p = out;
+    *p++ = STATE_FEED_MAGIC;
+    *p++ = STATE_FEED_FORMAT;
+    p = put_le(p, version, 4);
+    p = put_le(p, uptime_ms, 4);
+    p = put_le(p, mask, 2);
+    for (unsigned i = 0; i < FIELD_COUNT; i++) {
+        if (mask & (1u << i)) {
+            p = put_le(p, field_get(s, &s_fields[i]), s_fields[i].size);
+        }
+    }
+    return (size_t)(p - out);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 버전이 붙은 상태 피드 (/data)
+// 앱에 보여 줄 상태를 고정 소수점 값으로 모은 뒤, 이전과 하나라도 다르면 버전을 올린다.
+// 센서 잡음(EMA의 작은 흔들림)이나 시각/힙 같은 부가 정보만 바뀐 경우에는 버전이 그대로라서
+// 클라이언트는 ?since=<version> / If-None-Match로 304를 받는다.
+// 최근 STATE_FEED_HISTORY개 버전을 보관해 두고, 그 버전 기준으로는 바뀐 필드만 담은
+// 바이너리 델타를 만든다. 기준 버전이 없으면 전체 필드를 보낸다.
+//
+// 바이너리 형식 (리틀 엔디언):
+//   0xA7 | format(1) | version u32 | uptime_ms u32 | field_mask u16 | 필드들 (인덱스 순서)
+//   필드: pm25, pm10, pm25_outdoor, pm10_outdoor, temperature, humidity, di   (i16, x10)
+//         flags u8 (STATE_FLAG_*), window_position u8, window_progress u8,
+//         decision_reason i8 (규칙 인덱스, -1=기본 동작),
+//         cmd_count u32, cmd_latency_p50_ms u32, cmd_latency_p99_ms u32
+
+#ifndef STATE_FEED_HISTORY
+#define STATE_FEED_HISTORY 8
+#endif
+
+#define STATE_FEED_MAGIC      0xA7
+#define STATE_FEED_FORMAT     1
+#define STATE_FEED_HEADER     12
+#define STATE_FEED_MAX_BINARY 48   // 헤더 + 전체 필드
+
+enum {
+    STATE_FLAG_BUG              = 1 << 0,
+    STATE_FLAG_WINDOW_OPEN      = 1 << 1,
+    STATE_FLAG_WINDOW_MOVING    = 1 << 2,
+    STATE_FLAG_PM_LOCAL         = 1 << 3,
+    STATE_FLAG_SENSOR_VALID     = 1 << 4,
+    STATE_FLAG_DECISION_PENDING = 1 << 5,
+};
+
+typedef struct {
+    int16_t pm25_x10;
+    int16_t pm10_x10;
+    int16_t pm25_outdoor_x10;
+    int16_t pm10_outdoor_x10;
+    int16_t temperature_x10;
+    int16_t humidity_x10;
+    int16_t di_x10;
+    uint8_t flags;
+    uint8_t window_position;
+    uint8_t window_progress;
+    int8_t decision_reason;
+    uint32_t cmd_count;
+    uint32_t cmd_latency_p50_ms;
+    uint32_t cmd_latency_p99_ms;
+} state_sample_t;
+
+typedef struct {
+    state_sample_t current;
+    uint32_t version;
+    uint32_t changed_ms;    // 현재 버전이 된 시각
+    bool has_current;
+
+    // 이전 버전들 (기준 버전 델타용)
+    state_sample_t history[STATE_FEED_HISTORY];
+    uint32_t history_version[STATE_FEED_HISTORY];
+    uint8_t history_next;
+    uint8_t history_count;
+} state_feed_t;
+
+// 실수 -> x10 고정 소수점 (반올림, int16 범위로 제한, NaN은 0)
+int16_t state_feed_x10(float v);
+
+// initial_version은 부팅마다 달라야 이전 부팅의 버전과 섞이지 않는다 (예: 난수)
+void state_feed_init(state_feed_t *f, uint32_t initial_version);
+
+// 상태가 바뀌었으면 버전을 올리고 true
+bool state_feed_update(state_feed_t *f, const state_sample_t *s, uint32_t now_ms);
+
+// version의 상태를 찾는다 (현재 또는 보관 중인 이전 버전)
+bool state_feed_lookup(const state_feed_t *f, uint32_t version, state_sample_t *out);
+
+// base가 NULL이면 전체, 아니면 base와 다른 필드만 담는다. 쓴 바이트 수 (공간 부족이면 0)
+size_t state_feed_encode(const state_sample_t *s,
+                         const state_sample_t *base,
+                         uint32_t version,
+                         uint32_t uptime_ms,
+                         uint8_t *out,
+                         size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
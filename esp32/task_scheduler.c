@@ -0,0 +1,102 @@
+#include <string.h>
+
+#include "task_scheduler.h"
+
+void sched_init(scheduler_t *s, sched_task_t *tasks, uint8_t count, sched_clock_us_fn clock_us, uint32_t now_ms)
+{
+    memset(s, 0, sizeof(*s));
+    s->tasks = tasks;
+    s->count = count;
+    s->clock_us = clock_us;
+
+    // 우선순위 순으로 정렬 (삽입 정렬, 같은 우선순위는 등록 순서 유지)
+    for (uint8_t i = 1; i < count; i++) {
+        sched_task_t t = tasks[i];
+        uint8_t j = i;
+        while (j > 0 && tasks[j - 1].priority > t.priority) {
+            tasks[j] = tasks[j - 1];
+            j--;
+        }
+        tasks[j] = t;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        tasks[i].next_release_ms = now_ms;
+    }
+}
+
+void sched_run(scheduler_t *s, uint32_t now_ms)
+{
+    uint32_t pass_start = s->clock_us();
+
+    for (uint8_t i = 0; i < s->count; i++) {
+        sched_task_t *t = &s->tasks[i];
+        // 앞선 태스크가 쓴 시간만큼 시계를 다시 읽는다 (패스 시작 시각 기준)
+        uint32_t start = s->clock_us();
+        uint32_t task_now = now_ms + (start - pass_start) / 1000;
+        if ((int32_t)(task_now - t->next_release_ms) < 0) {
+            continue;
+        }
+
+        // period 0 태스크는 패스 시작마다 릴리스된다 (저전력 모드에서 잠든 시간은 지연이 아님)
+        uint32_t release = t->period_ms ? t->next_release_ms : now_ms;
+        t->fn(task_now);
+        uint32_t runtime = s->clock_us() - start;
+
+        t->runs++;
+        t->last_runtime_us = runtime;
+        t->total_runtime_us += runtime;
+        if (runtime > t->max_runtime_us) {
+            t->max_runtime_us = runtime;
+        }
+
+        // 완료 시각 = 시작 시각(task_now) + 실행 시간, 릴리스 기준으로 데드라인 판정
+        if (t->deadline_ms && (task_now - release) + runtime / 1000 > t->deadline_ms) {
+            t->deadline_misses++;
+        }
+
+        // 다음 릴리스: 주기를 유지하되, 밀렸으면 따라잡으려 연속 실행하지 않음
+        t->next_release_ms = release + t->period_ms;
+        if ((int32_t)(task_now - t->next_release_ms) >= 0) {
+            t->next_release_ms = task_now + t->period_ms;
+        }
+    }
+
+    s->passes++;
+    uint32_t pass_us = s->clock_us() - pass_start;
+    if (pass_us > s->max_pass_us) {
+        s->max_pass_us = pass_us;
+    }
+}
+
+uint32_t sched_idle_ms(const scheduler_t *s, uint32_t now_ms)
+{
+    uint32_t idle = UINT32_MAX;
+    for (uint8_t i = 0; i < s->count; i++) {
+        if (s->tasks[i].period_ms == 0) {
+            continue;
+        }
+        int32_t wait = (int32_t)(s->tasks[i].next_release_ms - now_ms);
+        if (wait <= 0) {
+            return 0;
+        }
+        if ((uint32_t)wait < idle) {
+            idle = (uint32_t)wait;
+        }
+    }
+    return idle;
+}
+
+void sched_set_period(scheduler_t *s, sched_task_fn fn, uint32_t period_ms, uint32_t now_ms)
+{
+    for (uint8_t i = 0; i < s->count; i++) {
+        sched_task_t *t = &s->tasks[i];
+        if (t->fn != fn) {
+            continue;
+        }
+        if ((int32_t)(t->next_release_ms - (now_ms + period_ms)) > 0) {
+            t->next_release_ms = now_ms + period_ms;
+        }
+        t->period_ms = period_ms;
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 협조형(cooperative) 주기 태스크 스케줄러
+// loop()가 매 패스마다 sched_run()을 호출하면, 주기가 된 태스크를 우선순위 순서로 실행한다.
+// 태스크는 블로킹하지 않아야 하며, 실행 시간과 데드라인 초과를 태스크별로 기록한다.
+
+typedef void (*sched_task_fn)(uint32_t now_ms);
+
+typedef struct {
+    // 설정
+    const char *name;
+    sched_task_fn fn;
+    uint32_t period_ms;     // 0이면 매 패스 실행
+    uint32_t deadline_ms;   // 릴리스 시각부터 완료까지 허용 시간 (0이면 검사 안 함)
+    uint8_t priority;       // 작을수록 먼저 실행
+
+    // 런타임 통계
+    uint32_t next_release_ms;
+    uint32_t runs;
+    uint32_t deadline_misses;
+    uint32_t last_runtime_us;
+    uint32_t max_runtime_us;
+    uint64_t total_runtime_us;
+} sched_task_t;
+
+typedef uint32_t (*sched_clock_us_fn)(void);
+
+typedef struct {
+    sched_task_t *tasks;    // sched_init()에서 우선순위 순으로 정렬됨
+    uint8_t count;
+    sched_clock_us_fn clock_us;
+    uint32_t passes;
+    uint32_t max_pass_us;   // 한 패스(모든 태스크) 최대 소요 시간
+} scheduler_t;
+
+void sched_init(scheduler_t *s, sched_task_t *tasks, uint8_t count, sched_clock_us_fn clock_us, uint32_t now_ms);
+// now_ms는 패스 시작 시각. 각 태스크의 릴리스/데드라인 판정과 fn 인자는
+// 그 태스크 차례의 시각(now_ms + 패스 안에서 지난 clock_us)을 쓴다.
+void sched_run(scheduler_t *s, uint32_t now_ms);
+
+// 다음 태스크 릴리스까지 남은 시간 (ms, 이미 도래했으면 0, 주기 태스크가 없으면 UINT32_MAX)
+// period 0 태스크는 매 패스(깨어날 때마다) 실행되므로 계산에서 뺀다.
+uint32_t sched_idle_ms(const scheduler_t *s, uint32_t now_ms);
+
+// 실행 중에 태스크 주기를 바꾼다 (전력 모드 전환 등). 새 주기가 더 짧으면 다음 릴리스를 당긴다.
+void sched_set_period(scheduler_t *s, sched_task_fn fn, uint32_t period_ms, uint32_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,60 @@
+#include <math.h>
+#include <string.h>
+
+#include "telemetry_policy.h"
+
+void tp_init(telemetry_policy_t *p, const tp_config_t *cfg)
+{
+    memset(p, 0, sizeof(*p));
+    p->cfg = cfg;
+}
+
+static bool pm_moved(const tp_config_t *c, int16_t last, int16_t cur)
+{
+    int32_t diff = (int32_t)cur - last;
+    int32_t band = (int32_t)last * c->pm_pct / 100;
+    if (band < c->pm_abs) {
+        band = c->pm_abs;
+    }
+    return diff > band || -diff > band;
+}
+
+static tp_reason_t classify(const telemetry_policy_t *p, const air_sample_t *s)
+{
+    const tp_config_t *c = p->cfg;
+    const air_sample_t *last = &p->last;
+    uint32_t since = s->timestamp_ms - last->timestamp_ms;
+
+    if (!p->has_last) {
+        return TP_SEND_FIRST;
+    }
+    if (s->bug != last->bug) {
+        return TP_SEND_EVENT;
+    }
+    if (since >= c->heartbeat_ms) {
+        return TP_SEND_HEARTBEAT;
+    }
+    if (since < c->min_interval_ms) {
+        return TP_SKIP;
+    }
+    // NaN(센서 오류)은 비교가 항상 거짓이므로 값이 돌아올 때까지 보고하지 않는다
+    if (fabsf(s->temperature - last->temperature) > c->temperature ||
+        fabsf(s->humidity - last->humidity) > c->humidity ||
+        pm_moved(c, last->pm25, s->pm25) ||
+        pm_moved(c, last->pm10, s->pm10)) {
+        return TP_SEND_CHANGE;
+    }
+    return TP_SKIP;
+}
+
+tp_reason_t tp_offer(telemetry_policy_t *p, const air_sample_t *s)
+{
+    tp_reason_t r = classify(p, s);
+    p->offered++;
+    p->sent[r]++;
+    if (r != TP_SKIP) {
+        p->last = *s;
+        p->has_last = true;
+    }
+    return r;
+}
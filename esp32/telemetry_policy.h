@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "air_sample_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 텔레메트리 보고 정책 (데드밴드 + 하트비트)
+// 매 샘플을 보내는 대신, 마지막으로 "보고한" 값과 비교해 의미 있게 바뀐 샘플만 보낸다.
+//   - 온도/습도/PM 중 하나라도 데드밴드를 넘으면 TP_SEND_CHANGE
+//     (직전 샘플이 아니라 마지막 보고값과 비교하므로 천천히 누적되는 변화도 놓치지 않는다)
+//   - 벌레 감지 여부가 바뀌면 TP_SEND_EVENT (min_interval_ms 무시, 즉시 전송 권장)
+//   - 변화가 없어도 heartbeat_ms가 지나면 TP_SEND_HEARTBEAT (서버가 장치 생존을 판단)
+//   - 변화가 있어도 min_interval_ms 안이면 보류. 다음 샘플에서 다시 비교되므로 따로 쌓아 두지 않는다.
+// 시간/하드웨어에 의존하지 않으며 한 태스크에서만 호출한다.
+
+typedef enum {
+    TP_SKIP = 0,
+    TP_SEND_FIRST,          // 부팅 후 첫 샘플
+    TP_SEND_CHANGE,
+    TP_SEND_EVENT,
+    TP_SEND_HEARTBEAT,
+    TP_REASON_COUNT,
+} tp_reason_t;
+
+typedef struct {
+    float temperature;          // °C
+    float humidity;             // %RH
+    uint16_t pm_abs;            // µg/m³. PM은 |변화| > max(pm_abs, 마지막 값 * pm_pct / 100)
+    uint16_t pm_pct;            // %
+    uint32_t heartbeat_ms;
+    uint32_t min_interval_ms;   // 0이면 제한 없음
+} tp_config_t;
+
+typedef struct {
+    const tp_config_t *cfg;
+    air_sample_t last;          // 마지막으로 보고한 샘플
+    bool has_last;
+
+    // 통계
+    uint32_t offered;
+    uint32_t sent[TP_REASON_COUNT];     // sent[TP_SKIP]은 건너뛴 샘플 수
+} telemetry_policy_t;
+
+void tp_init(telemetry_policy_t *p, const tp_config_t *cfg);
+
+// 샘플을 보낼지 결정한다. TP_SKIP이 아니면 s를 보고한 것으로 기록하므로,
+// 호출자는 그 샘플을 반드시 전송 버퍼에 넣어야 한다. s->timestamp_ms를 현재 시각으로 쓴다.
+tp_reason_t tp_offer(telemetry_policy_t *p, const air_sample_t *s);
+
+// 다음 하트비트 시각 (보고한 적이 없으면 바로)
+static inline uint32_t tp_heartbeat_due_ms(const telemetry_policy_t *p)
+{
+    return p->has_last ? p->last.timestamp_ms + p->cfg->heartbeat_ms : 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
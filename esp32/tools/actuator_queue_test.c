@@ -0,0 +1,221 @@
+// Host unit test of the actuator command queue (actuator_queue.c).
+//
+// Checks that:
+//   - a command for the current state is a no-op, and a repeat of the pending
+//     command coalesces into it (one slot per actuator, depth stays 1)
+//   - a new target replaces the pending one, and a command back to the
+//     current state cancels it; ACT_TOGGLE flips the pending target
+//   - a lower priority than the pending command or the hold is preempted,
+//     a higher one replaces it; actq_hold() drops pending commands below it
+//     until actq_release()
+//   - pop order is priority first, then arrival (a replaced command moves to
+//     the back), also across a wrap of the sequence counter; pop records the
+//     target as the new state
+//   - an on command with another value (opening angle, pump run time) is a
+//     new state: queued or replacing, not a no-op; off commands carry no value
+//   - over random pushes, pops and holds the depth always equals the pending
+//     slots and never exceeds ACT_COUNT, and the counters add up
+// Exit 1 on the first mismatch.
+//
+//   cc -std=gnu11 -O2 -I.. -o actuator_queue_test actuator_queue_test.c ../actuator_queue.c
+//   ./actuator_queue_test
+#include <stdio.h>
+
+#include "actuator_queue.h"
+
+static actq_t s_q;
+static int s_failures;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        s_failures++;
+    }
+}
+
+static void push_value(act_id_t a, int target, int32_t value, act_prio_t prio, act_push_result_t want,
+                       const char *what)
+{
+    act_push_result_t got = actq_push(&s_q, a, target, value, prio, 0);
+    if (got != want) {
+        printf("FAIL: %s: %s/%s\n", what, actq_push_result_name(got), actq_push_result_name(want));
+        s_failures++;
+    }
+}
+
+static void push(act_id_t a, int target, act_prio_t prio, act_push_result_t want, const char *what)
+{
+    push_value(a, target, 0, prio, want, what);
+}
+
+// 다음에 꺼낼 명령이 (a, target)인지
+static void pop(act_id_t a, int target, const char *what)
+{
+    act_cmd_t c;
+    check(actq_pop(&s_q, &c) && c.actuator == a && c.target == target, what);
+}
+
+static void test_coalescing(void)
+{
+    actq_init(&s_q);
+    push(ACT_WINDOW, 0, ACT_PRIO_USER, ACT_PUSH_NOOP, "already closed");
+    push(ACT_WINDOW, 1, ACT_PRIO_USER, ACT_PUSH_QUEUED, "open");
+    push(ACT_WINDOW, 1, ACT_PRIO_USER, ACT_PUSH_COALESCED, "open again");
+    check(s_q.depth == 1, "one slot per actuator");
+    push(ACT_WINDOW, 0, ACT_PRIO_USER, ACT_PUSH_COALESCED, "close before it ran");
+    act_cmd_t c;
+    check(!actq_pop(&s_q, &c) && s_q.depth == 0, "open + close cancel out");
+
+    push(ACT_PUMP, ACT_TOGGLE, ACT_PRIO_USER, ACT_PUSH_QUEUED, "toggle from off");
+    check(actq_effective(&s_q, ACT_PUMP) == 1, "toggle targets on");
+    push(ACT_PUMP, ACT_TOGGLE, ACT_PRIO_USER, ACT_PUSH_COALESCED, "toggle again");
+    check(!actq_pop(&s_q, &c), "double toggle cancels");
+
+    push(ACT_PUMP, 1, ACT_PRIO_USER, ACT_PUSH_QUEUED, "pump on");
+    pop(ACT_PUMP, 1, "pump on runs");
+    push(ACT_PUMP, 1, ACT_PRIO_USER, ACT_PUSH_NOOP, "pop records the state");
+    actq_set_state(&s_q, ACT_PUMP, 0, 0);     // 펌프 타이머 만료
+    push(ACT_PUMP, 1, ACT_PRIO_USER, ACT_PUSH_QUEUED, "on again after the timer");
+    check(s_q.pushed == 9 && s_q.applied == 1 && s_q.coalesced == 3 && s_q.noops == 2 && s_q.max_depth == 1,
+          "counters");
+}
+
+static void test_priority(void)
+{
+    actq_init(&s_q);
+    push(ACT_WINDOW, 1, ACT_PRIO_USER, ACT_PUSH_QUEUED, "user open");
+    push(ACT_WINDOW, 0, ACT_PRIO_AUTO, ACT_PUSH_PREEMPTED, "auto close under a user command");
+    check(actq_effective(&s_q, ACT_WINDOW) == 1, "user command kept");
+    push(ACT_WINDOW, 1, ACT_PRIO_SAFETY, ACT_PUSH_COALESCED, "safety open replaces it");
+    check(s_q.pending[ACT_WINDOW].priority == ACT_PRIO_SAFETY, "replacement takes the new priority");
+    push(ACT_WINDOW, 0, ACT_PRIO_USER, ACT_PUSH_PREEMPTED, "user close under the safety open");
+    push(ACT_WINDOW, 0, ACT_PRIO_SAFETY, ACT_PUSH_COALESCED, "safety close cancels it");
+    check(actq_effective(&s_q, ACT_WINDOW) == 0 && s_q.depth == 0, "nothing pending");
+
+    // 보류: 벌레 감지 동안 창문은 SAFETY만
+    actq_init(&s_q);
+    push(ACT_WINDOW, 1, ACT_PRIO_AUTO, ACT_PUSH_QUEUED, "auto open");
+    actq_hold(&s_q, ACT_WINDOW, ACT_PRIO_SAFETY);
+    act_cmd_t c;
+    check(!actq_pop(&s_q, &c) && s_q.depth == 0 && s_q.preempted == 1, "hold drops the pending open");
+    push(ACT_WINDOW, 1, ACT_PRIO_USER, ACT_PUSH_PREEMPTED, "user open during the hold");
+    push(ACT_PUMP, 1, ACT_PRIO_USER, ACT_PUSH_QUEUED, "other actuator not held");
+    push(ACT_WINDOW, 1, ACT_PRIO_SAFETY, ACT_PUSH_QUEUED, "safety during the hold");
+    pop(ACT_WINDOW, 1, "safety first");
+    pop(ACT_PUMP, 1, "then the user command");
+    actq_release(&s_q, ACT_WINDOW);
+    push(ACT_WINDOW, 0, ACT_PRIO_AUTO, ACT_PUSH_QUEUED, "auto after the release");
+}
+
+static void test_order(void)
+{
+    actq_init(&s_q);
+    push(ACT_PUMP, 1, ACT_PRIO_AUTO, ACT_PUSH_QUEUED, "pump auto");
+    push(ACT_WINDOW, 1, ACT_PRIO_USER, ACT_PUSH_QUEUED, "window user");
+    pop(ACT_WINDOW, 1, "higher priority first");
+    pop(ACT_PUMP, 1, "then lower");
+    push(ACT_WINDOW, 0, ACT_PRIO_AUTO, ACT_PUSH_QUEUED, "window auto");
+    push(ACT_PUMP, 0, ACT_PRIO_SAFETY, ACT_PUSH_QUEUED, "pump safety");
+    pop(ACT_PUMP, 0, "higher priority first, later slot");
+    pop(ACT_WINDOW, 0, "then lower, earlier slot");
+
+    // 같은 우선순위: 먼저 들어온 것부터. 대체된 명령은 뒤로 간다.
+    push(ACT_WINDOW, 1, ACT_PRIO_USER, ACT_PUSH_QUEUED, "window open");
+    push(ACT_PUMP, 1, ACT_PRIO_USER, ACT_PUSH_QUEUED, "pump on");
+    pop(ACT_WINDOW, 1, "first in, first out");
+    pop(ACT_PUMP, 1, "second");
+    push(ACT_WINDOW, 0, ACT_PRIO_USER, ACT_PUSH_QUEUED, "window close");
+    push(ACT_PUMP, 0, ACT_PRIO_USER, ACT_PUSH_QUEUED, "pump off");
+    push(ACT_WINDOW, 0, ACT_PRIO_USER, ACT_PUSH_COALESCED, "window close again");
+    pop(ACT_PUMP, 0, "replaced command moved back");
+    pop(ACT_WINDOW, 0, "replaced command last");
+
+    // 순번이 한 바퀴 돌아도 순서 유지
+    s_q.next_seq = UINT32_MAX;
+    push(ACT_PUMP, 1, ACT_PRIO_USER, ACT_PUSH_QUEUED, "pump on before the wrap");
+    push(ACT_WINDOW, 1, ACT_PRIO_USER, ACT_PUSH_QUEUED, "window open after the wrap");
+    pop(ACT_PUMP, 1, "order across the wrap");
+    pop(ACT_WINDOW, 1, "order across the wrap, second");
+}
+
+// 켜짐 명령의 value (열림 각도, 분사 시간)도 상태의 일부
+static void test_values(void)
+{
+    actq_init(&s_q);
+    act_cmd_t c;
+    push_value(ACT_WINDOW, 1, 45, ACT_PRIO_USER, ACT_PUSH_QUEUED, "open halfway");
+    check(actq_pop(&s_q, &c) && c.target == 1 && c.value == 45, "value carried to pop");
+    push_value(ACT_WINDOW, 1, 45, ACT_PRIO_USER, ACT_PUSH_NOOP, "same opening");
+    push_value(ACT_WINDOW, 1, 90, ACT_PRIO_USER, ACT_PUSH_QUEUED, "other opening");
+    push_value(ACT_WINDOW, 1, 30, ACT_PRIO_USER, ACT_PUSH_COALESCED, "replaced opening");
+    check(s_q.pending[ACT_WINDOW].value == 30, "replacement takes the new value");
+    push_value(ACT_WINDOW, 1, 45, ACT_PRIO_USER, ACT_PUSH_COALESCED, "back to the current opening");
+    check(!actq_pop(&s_q, &c), "back to the current opening cancels");
+    push_value(ACT_WINDOW, 0, 7, ACT_PRIO_USER, ACT_PUSH_QUEUED, "close");
+    check(actq_pop(&s_q, &c) && c.target == 0 && c.value == 0, "close carries no value");
+    push_value(ACT_WINDOW, 0, 9, ACT_PRIO_USER, ACT_PUSH_NOOP, "close again, other value");
+
+    actq_set_state(&s_q, ACT_PUMP, 1, 3000);
+    push_value(ACT_PUMP, 1, 3000, ACT_PRIO_USER, ACT_PUSH_NOOP, "same run");
+    push_value(ACT_PUMP, 1, 5000, ACT_PRIO_USER, ACT_PUSH_QUEUED, "longer run");
+    push_value(ACT_PUMP, ACT_TOGGLE, 5000, ACT_PRIO_USER, ACT_PUSH_COALESCED,
+               "toggle off the pending run");
+    check(actq_pop(&s_q, &c) && c.target == 0 && c.value == 0, "toggled to off");
+}
+
+static void test_random(void)
+{
+    uint64_t rng = 7;
+    actq_init(&s_q);
+    uint32_t preempted_by_hold = 0;
+    for (int i = 0; i < 100000; i++) {
+        rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+        uint32_t r = (uint32_t)(rng >> 33);
+        act_id_t a = (act_id_t)(r % ACT_COUNT);
+        act_cmd_t c;
+        switch ((r >> 4) % 8) {
+        case 0:
+            actq_pop(&s_q, &c);
+            break;
+        case 1: {
+            bool had = s_q.has_pending[a] && s_q.pending[a].priority < ACT_PRIO_SAFETY;
+            actq_hold(&s_q, a, ACT_PRIO_SAFETY);
+            preempted_by_hold += had;
+            break;
+        }
+        case 2:
+            actq_release(&s_q, a);
+            break;
+        default:
+            actq_push(&s_q, a, (int)((r >> 8) % 3) - 1, (int32_t)((r >> 16) % 3), (act_prio_t)((r >> 12) % 3), 0);
+            break;
+        }
+        uint8_t pending = 0;
+        for (int k = 0; k < ACT_COUNT; k++) {
+            pending += s_q.has_pending[k];
+        }
+        if (pending != s_q.depth || s_q.max_depth > ACT_COUNT) {
+            check(false, "depth matches the pending slots");
+            return;
+        }
+    }
+    // push는 정확히 하나로 끝나고, 대기했던 명령은 실행되거나 대체로 취소되거나 보류로 버려졌거나 아직 대기 중
+    uint32_t queued = s_q.pushed - s_q.coalesced - s_q.noops - (s_q.preempted - preempted_by_hold);
+    uint32_t cancelled = queued - s_q.applied - preempted_by_hold - s_q.depth;
+    check(s_q.applied + preempted_by_hold + s_q.depth <= queued, "counters add up");
+    printf("random: %u pushes, %u queued, %u applied, %u coalesced (%u cancelled), %u noops, %u preempted\n",
+           (unsigned)s_q.pushed, (unsigned)queued, (unsigned)s_q.applied, (unsigned)s_q.coalesced,
+           (unsigned)cancelled, (unsigned)s_q.noops, (unsigned)s_q.preempted);
+}
+
+int main(void)
+{
+    test_coalescing();
+    test_priority();
+    test_order();
+    test_values();
+    test_random();
+    printf("%s\n", s_failures ? "FAIL" : "ok");
+    return s_failures ? 1 : 0;
+}
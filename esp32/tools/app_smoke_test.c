@@ -0,0 +1,285 @@
+// Host smoke test of the whole firmware: air_app_setup() and air_app_loop()
+// (air_app.c, the same code the ESP32 runs from setup()/loop()) on hal_posix.c.
+//
+// A device thread calls air_app_loop() the way the Arduino core does; the main
+// thread plays the httpd task (/control through the handoff, /data and
+// /metrics from what air_app.c publishes) and the server side through the
+// in-process MQTT broker stub (stub_broker.c). In order:
+//   - CONFIG over /control points MQTT at the stub and speeds up the servo
+//   - the device connects and subscribes (device and broadcast topics; the
+//     shared legacy topics only with mqtt_legacy, off by default)
+//   - MQTT config: signed updates on the broadcast and legacy topics are
+//     ignored; on the device topic an unsigned one, one signed with another key
+//     and one with a network field are refused, a signed one for the current
+//     revision applies and its replay conflicts (checked on config/result)
+//   - WINDOW_OPEN with value 30 on s_window/smoke/command opens the window
+//     by 30 deg (servo at 60); "ON" on the legacy s_window/pump is ignored, so
+//     WINDOW_OPEN without a value then opens it fully (servo at 0)
+//   - "ON" on s_window/smoke/pump closes it again and runs the pump
+//   - WINDOW_OPEN over /control is preempted while the bug hold is on
+//   - /data reports the bug and /metrics counts loop() passes
+// Exit 1 on the first step that does not happen within its timeout.
+//
+//   cc -std=gnu11 -O2 -I.. -DAIR_MQTT_HOST='"127.0.0.1"' -DAIR_MQTT_PORT=1 -DAIR_MQTT_CONFIG_KEY='"smoke-key"'
+//      -o app_smoke_test app_smoke_test.c
+//      stub_broker.c ../air_app.c ../*.c (all modules but main.c, hal_esp32.cpp, esp_http_session.c) -lpthread -lm
+//   ./app_smoke_test
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "air_app.h"
+#include "control_handoff.h"
+#include "hal.h"
+#include "hmac_sha256.h"
+#include "metrics.h"
+#include "stub_broker.h"
+
+#define WATER_PUMP_PIN 33           // air_app.c와 같은 핀
+#define STEP_TIMEOUT_MS 5000
+#define CONFIG_KEY "smoke-key"      // AIR_MQTT_CONFIG_KEY (CMakeLists.txt)
+
+static volatile bool s_stop;
+static volatile uint32_t s_passes;
+
+static void sleep_ms(uint32_t ms)
+{
+    struct timespec ts = { (time_t)(ms / 1000), (long)(ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0) {
+    }
+}
+
+// Arduino 코어의 loopTask
+static void *device_main(void *arg)
+{
+    (void)arg;
+    while (!s_stop) {
+        air_app_loop();
+        s_passes++;
+    }
+    return NULL;
+}
+
+static bool fail(const char *step)
+{
+    printf("FAIL: %s\n", step);
+    return false;
+}
+
+static bool broker_subscribed(void *arg)
+{
+    (void)arg;
+    stub_broker_stats_t st;
+    stub_broker_get_stats(&st);
+    return st.subscribes >= 2;
+}
+
+static bool servo_at(void *arg)
+{
+    return hal_sim_servo_angle() == *(const int *)arg;
+}
+
+static bool pump_running(void *arg)
+{
+    (void)arg;
+    return hal_sim_gpio_level(WATER_PUMP_PIN);
+}
+
+static bool data_contains(void *arg)
+{
+    char body[AIR_DATA_MAX + 1];
+    uint32_t version;
+    size_t len = air_app_data_json(body, sizeof(body) - 1, &version);
+    body[len] = '\0';
+    return strstr(body, (const char *)arg) != NULL;
+}
+
+// s_window/smoke/config/result로 받은 응답을 한 줄씩 모은 것이 arg와 같은지
+static bool config_results_are(void *arg)
+{
+    static char log[8192];
+    char results[1024] = "";
+    static const char prefix[] = "s_window/smoke/config/result ";
+    stub_broker_received(log, sizeof(log));
+    for (char *line = strtok(log, "\n"); line; line = strtok(NULL, "\n")) {
+        if (strncmp(line, prefix, sizeof(prefix) - 1) == 0) {
+            snprintf(results + strlen(results), sizeof(results) - strlen(results), "%s\n", line + sizeof(prefix) - 1);
+        }
+    }
+    return strcmp(results, (const char *)arg) == 0;
+}
+
+static bool wait_for(bool (*cond)(void *), void *arg)
+{
+    for (uint32_t t0 = hal_millis(); hal_millis() - t0 < STEP_TIMEOUT_MS; sleep_ms(10)) {
+        if (cond(arg)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// POST /control 한 번 (main.c의 http_control에서 HTTP를 뺀 부분)
+static control_status_t control(const char *command, const char *body, control_reply_t *reply)
+{
+    control_request_t rq;
+    memset(&rq, 0, sizeof(rq));
+    snprintf(rq.command, sizeof(rq.command), "%s", command);
+    return control_submit(air_app_control(), &rq, body, strlen(body), 1000, reply);
+}
+
+static bool publish(const char *topic, const char *payload)
+{
+    return stub_broker_publish(topic, payload, strlen(payload));
+}
+
+// tools/config_sign.py와 같은 서명 메시지
+static void publish_config(const char *topic, const char *key, uint32_t rev, const char *cfg)
+{
+    char head[32], payload[256];
+    uint8_t mac[SHA256_SIZE];
+    hmac_sha256_t h;
+    int n = snprintf(head, sizeof(head), "smoke\n%u\n", (unsigned)rev);
+    hmac_sha256_init(&h, key, strlen(key));
+    hmac_sha256_update(&h, head, (size_t)n);
+    hmac_sha256_update(&h, cfg, strlen(cfg));
+    hmac_sha256_final(&h, mac);
+    n = snprintf(payload, sizeof(payload), "{\"config\":%s,\"rev\":%u,\"sig\":\"", cfg, (unsigned)rev);
+    for (int i = 0; i < SHA256_SIZE; i++) {
+        n += snprintf(payload + n, sizeof(payload) - n, "%02x", mac[i]);
+    }
+    snprintf(payload + n, sizeof(payload) - n, "\"}");
+    publish(topic, payload);
+}
+
+typedef struct {
+    char text[8192];
+    size_t len;
+} render_t;
+
+static int render_write(void *ctx, const char *data, size_t len)
+{
+    render_t *r = ctx;
+    if (r->len + len >= sizeof(r->text)) {
+        return -1;
+    }
+    memcpy(r->text + r->len, data, len);
+    r->len += len;
+    r->text[r->len] = '\0';
+    return 0;
+}
+
+static bool run(uint16_t port)
+{
+    control_reply_t reply;
+    char body[160];
+
+    snprintf(body, sizeof(body),
+             "{\"command\":\"CONFIG\",\"config\":{\"mqtt_port\":%u,\"servo_velocity_dps\":180,\"servo_accel_dps2\":0}}",
+             (unsigned)port);
+    if (control("CONFIG", body, &reply) != CONTROL_DONE || reply.config_result != CFG_OK) {
+        return fail("CONFIG over /control");
+    }
+    if (!wait_for(broker_subscribed, NULL)) {
+        return fail("MQTT connect and subscribe");
+    }
+
+    // 공유 토픽의 갱신은 서명이 맞아도 응답 없이 버린다
+    publish_config("s_window/all/config", CONFIG_KEY, 1, "{\"pump_ms\":1000}");
+    publish_config("s_window/config", CONFIG_KEY, 1, "{\"pump_ms\":1000}");
+    publish("s_window/smoke/config", "{\"config\":{\"pump_ms\":1000},\"rev\":1}");
+    publish_config("s_window/smoke/config", "other-key", 1, "{\"pump_ms\":1000}");
+    publish_config("s_window/smoke/config", CONFIG_KEY, 1, "{\"pump_ms\":1000,\"mqtt_host\":\"10.0.0.66\"}");
+    publish_config("s_window/smoke/config", CONFIG_KEY, 1, "{\"pump_ms\":2000}");
+    publish_config("s_window/smoke/config", CONFIG_KEY, 1, "{\"pump_ms\":2000}");
+    if (!wait_for(config_results_are,
+                  "{\"ok\":false,\"result\":\"UNAUTHORIZED\",\"rev\":1}\n"
+                  "{\"ok\":false,\"result\":\"UNAUTHORIZED\",\"rev\":1}\n"
+                  "{\"ok\":false,\"result\":\"LOCAL_ONLY\",\"rev\":1,\"field\":\"mqtt_host\"}\n"
+                  "{\"ok\":true,\"result\":\"OK\",\"rev\":2}\n"
+                  "{\"ok\":false,\"result\":\"CONFLICT\",\"rev\":2}\n") ||
+        !wait_for(data_contains, "\"config_rev\":2,")) {
+        return fail("signed config on the device topic only");
+    }
+
+    static const int OPEN = 0, CLOSED = 90, OPEN_30 = 60;
+    if (!publish("s_window/smoke/command", "{\"command\":\"WINDOW_OPEN\",\"value\":30}") ||
+        !wait_for(servo_at, (void *)&OPEN_30)) {
+        return fail("WINDOW_OPEN by 30 deg over MQTT");
+    }
+    // 공용 토픽의 벌레 감지가 들어갔다면 창문이 닫힌 채 보류되어 열리지 않는다
+    if (!publish("s_window/pump", "ON") || !publish("s_window/smoke/command", "WINDOW_OPEN") ||
+        !wait_for(servo_at, (void *)&OPEN)) {
+        return fail("legacy topic ignored, WINDOW_OPEN over MQTT");
+    }
+    if (!publish("s_window/smoke/pump", "ON") || !wait_for(pump_running, NULL) ||
+        !wait_for(servo_at, (void *)&CLOSED)) {
+        return fail("bug detected over MQTT");
+    }
+
+    if (control("WINDOW_OPEN", "{\"command\":\"WINDOW_OPEN\"}", &reply) != CONTROL_DONE ||
+        reply.result.status != CMD_RESULT_PREEMPTED) {
+        return fail("WINDOW_OPEN over /control while the bug hold is on");
+    }
+    if (!wait_for(data_contains, "\"bug\":true")) {
+        return fail("/data reports the bug");
+    }
+
+    static render_t metrics;
+    if (metrics_render(render_write, &metrics) != 0 || strstr(metrics.text, "air_loop_passes_total ") == NULL) {
+        return fail("/metrics");
+    }
+    return true;
+}
+
+// 상태/설정 파일을 쓴 임시 디렉터리를 지운다
+static void remove_dir(const char *dir)
+{
+    DIR *d = opendir(dir);
+    struct dirent *e;
+    char path[300];
+    while (d && (e = readdir(d)) != NULL) {
+        if (e->d_name[0] != '.') {
+            snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+            unlink(path);
+        }
+    }
+    if (d) {
+        closedir(d);
+    }
+    rmdir(dir);
+}
+
+int main(void)
+{
+    char dir[] = "/tmp/app_smoke_XXXXXX";
+    if (mkdtemp(dir) == NULL) {
+        return 2;
+    }
+    setenv("AIR_STORE_DIR", dir, 1);
+    setenv("AIR_DEVICE_ID", "smoke", 1);
+
+    uint16_t port = stub_broker_start();
+    if (port == 0) {
+        fprintf(stderr, "broker stub failed to start\n");
+        return 2;
+    }
+
+    air_app_setup();
+    pthread_t dev_th;
+    if (pthread_create(&dev_th, NULL, device_main, NULL) != 0) {
+        return 2;
+    }
+    bool ok = run(port);
+    s_stop = true;
+    pthread_join(dev_th, NULL);
+    remove_dir(dir);
+
+    printf("%s (%u loop passes)\n", ok ? "ok" : "FAIL", (unsigned)s_passes);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""Collect on-device benchmark results (firmware built with -DAIR_BENCH).
+
+Reads "BENCH {...}" lines from the serial port until "BENCH done" and writes
+them as JSON lines, tagged with the firmware version, so runs from different
+releases can be diffed.
+
+    python3 bench_capture.py /dev/ttyUSB0 --version v1.2.0 -o bench-v1.2.0.jsonl
+    python3 bench_capture.py --compare bench-v1.1.0.jsonl bench-v1.2.0.jsonl
+"""
+import argparse
+import json
+import sys
+import time
+
+PREFIX = "BENCH "
+
+
+def capture(port, baud, timeout_s, version):
+    import serial  # pyserial
+
+    results = []
+    deadline = time.time() + timeout_s
+    with serial.Serial(port, baud, timeout=1) as ser:
+        while time.time() < deadline:
+            line = ser.readline().decode("utf-8", errors="replace").strip()
+            if not line.startswith(PREFIX):
+                continue
+            body = line[len(PREFIX):]
+            if body == "done":
+                break
+            try:
+                rec = json.loads(body)
+            except json.JSONDecodeError:
+                print(f"skip malformed line: {line}", file=sys.stderr)
+                continue
+            rec["version"] = version
+            results.append(rec)
+            print(f"{rec['bench']:<22} {rec['ns_per_op']:>10} ns/op  p99 {rec['p99_ns']:>10} ns")
+    return results
+
+
+def load(path):
+    with open(path) as f:
+        return {r["bench"]: r for r in map(json.loads, filter(None, map(str.strip, f)))}
+
+
+def compare(old_path, new_path, threshold):
+    old, new = load(old_path), load(new_path)
+    regressed = False
+    for name, n in new.items():
+        o = old.get(name)
+        if not o or not o["ns_per_op"]:
+            continue
+        change = (n["ns_per_op"] - o["ns_per_op"]) / o["ns_per_op"]
+        flag = "REGRESSION" if change > threshold else ""
+        regressed |= bool(flag)
+        print(f"{name:<22} {o['ns_per_op']:>10} -> {n['ns_per_op']:>10} ns/op ({change:+.1%}) {flag}")
+    return 1 if regressed else 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port", nargs="?", help="serial port, e.g. /dev/ttyUSB0")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--timeout", type=float, default=120.0, help="seconds to wait for 'BENCH done'")
+    ap.add_argument("--version", default="dev", help="firmware version tag stored in each record")
+    ap.add_argument("-o", "--output", default="bench.jsonl")
+    ap.add_argument("--compare", nargs=2, metavar=("OLD", "NEW"), help="compare two result files")
+    ap.add_argument("--threshold", type=float, default=0.10, help="ns/op increase flagged as regression")
+    args = ap.parse_args()
+
+    if args.compare:
+        sys.exit(compare(*args.compare, args.threshold))
+    if not args.port:
+        ap.error("serial port required")
+
+    results = capture(args.port, args.baud, args.timeout, args.version)
+    with open(args.output, "w") as f:
+        for rec in results:
+            f.write(json.dumps(rec) + "\n")
+    print(f"wrote {len(results)} results to {args.output}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,352 @@
+// Host run of the firmware hot-path benchmarks (main.c's -DAIR_BENCH set).
+//
+// Times the portable parts of the same paths with bench.c on clock_gettime and
+// counts allocation calls with linker wraps of malloc/calloc/realloc, so a path
+// that allocates and frees on every call shows up (a net heap block count
+// would read 0 for it):
+//   - mqtt_callback:    topic classify, bounded payload copy, float parse
+//   - http_data_encode: state_feed_update() + binary encode of /data
+//   - poll_parse:       single command response through cmd_stream
+//   - poll_parse_batch: four commands in 64-byte pieces
+//   - poll_parse_strstr, poll_parse_batch_strstr: the same bodies through the
+//     parser cmd_stream replaced (copy into a 256-byte buffer, then strstr/
+//     strchr for the first "command" value; it cannot see the other three)
+//   - loop_pass:        sched_run() over the three paths above as tasks
+// The ArduinoJson parts (/data JSON, /control body) only run on the device.
+// An alloc_probe benchmark that mallocs once per call checks the counter.
+// Writes one JSON line per benchmark (same records as bench_capture.py, so
+// --compare works on them), then each old parser's ns/op against
+// cmd_stream's. Exit 1 if a hot path allocates, the probe is not counted, or
+// the two parsers disagree on the single-command body.
+//
+//   cc -std=gnu11 -O2 -I.. -o bench_host bench_host.c ../bench.c ../cmd_stream.c ../json_stream.c
+//      ../mqtt_ingress.c ../state_feed.c ../task_scheduler.c -lm -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc
+//   ./bench_host                          # prints the JSON lines
+//   ./bench_host --iterations 100000 -o bench-host.jsonl --version v1.2.0
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+#include "cmd_stream.h"
+#include "mqtt_ingress.h"
+#include "state_feed.h"
+#include "task_scheduler.h"
+
+// ---------- 할당 카운터 (-Wl,--wrap) ----------
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *p, size_t size);
+
+static uint32_t s_allocs;
+
+void *__wrap_malloc(size_t size)
+{
+    s_allocs++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    s_allocs++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *p, size_t size)
+{
+    s_allocs++;
+    return __real_realloc(p, size);
+}
+
+static uint32_t alloc_count(void)
+{
+    return s_allocs;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t clock_us(void)
+{
+    return (uint32_t)(now_ns() / 1000u);
+}
+
+// ---------- 벤치마크 (main.c의 bench_*와 같은 입력) ----------
+static volatile float s_sink;
+
+static void bench_mqtt_callback(void *ctx)
+{
+    (void)ctx;
+    static const uint8_t payload[] = "42.5";
+    char data[16];   // callback()과 같은 크기
+    float v;
+    if (mqtt_topic_classify("s_window/pm25") == MQTT_TOPIC_PM25 &&
+        mqtt_payload_copy(payload, sizeof(payload) - 1, data, sizeof(data)) && mqtt_parse_float(data, &v)) {
+        s_sink = v;
+    }
+}
+
+static state_feed_t s_feed;
+static uint32_t s_tick;
+
+static void bench_http_data(void *ctx)
+{
+    (void)ctx;
+    state_sample_t s;
+    memset(&s, 0, sizeof(s));
+    s.pm25_x10 = state_feed_x10(35.0f + (float)(s_tick % 4));
+    s.pm10_x10 = state_feed_x10(50.0f);
+    s.temperature_x10 = state_feed_x10(23.4f);
+    s.humidity_x10 = state_feed_x10(45.0f);
+    s.flags = STATE_FLAG_SENSOR_VALID;
+    s.decision_reason = -1;
+    state_feed_update(&s_feed, &s, s_tick++);
+    uint8_t out[STATE_FEED_MAX_BINARY];
+    s_sink = (float)state_feed_encode(&s_feed.current, NULL, s_feed.version, s_tick, out, sizeof(out));
+}
+
+static const char POLL_BODY[] = "{\"status\":\"ok\",\"command\":\"PUMP_ON\",\"ts\":1700000000000}";
+static const char POLL_BATCH_BODY[] =
+    "{\"status\":\"ok\",\"commands\":["
+    "{\"command\":\"WINDOW_OPEN\",\"seq\":41},"
+    "{\"command\":\"PUMP_ON\",\"value\":3000,\"seq\":42},"
+    "{\"command\":\"WINDOW_CLOSE\",\"seq\":43,\"id\":9001},"
+    "{\"command\":\"PUMP_OFF\",\"seq\":44}"
+    "],\"ts\":1700000000000}";
+
+static char s_stream_cmd[32];   // 마지막으로 파싱한 명령 (두 파서 비교용)
+
+static void bench_poll_count(const air_command_t *cmd, void *ctx)
+{
+    snprintf(s_stream_cmd, sizeof(s_stream_cmd), "%s", cmd->name);
+    (*(uint32_t *)ctx)++;
+}
+
+static void bench_poll_parse(void *ctx)
+{
+    (void)ctx;
+    static cmd_stream_t parser;
+    uint32_t n = 0;
+    cmd_stream_init(&parser, bench_poll_count, &n);
+    cmd_stream_feed(&parser, POLL_BODY, sizeof(POLL_BODY) - 1);
+    cmd_stream_finish(&parser);
+}
+
+static void bench_poll_parse_batch(void *ctx)
+{
+    (void)ctx;
+    static cmd_stream_t parser;
+    uint32_t n = 0;
+    cmd_stream_init(&parser, bench_poll_count, &n);
+    for (size_t off = 0; off < sizeof(POLL_BATCH_BODY) - 1; off += 64) {
+        size_t len = sizeof(POLL_BATCH_BODY) - 1 - off;
+        cmd_stream_feed(&parser, POLL_BATCH_BODY + off, len < 64 ? len : 64);
+    }
+    cmd_stream_finish(&parser);
+}
+
+// ---------- 이전 파서 (cmd_stream 이전의 poll_command_and_handle) ----------
+typedef struct {
+    char *buf;
+    int cap;
+    int len;
+} poll_body_t;
+
+static void poll_body_append(const char *data, int len, void *ctx)
+{
+    poll_body_t *body = (poll_body_t *)ctx;
+    int room = body->cap - 1 - body->len;
+    if (len > room) len = room;
+    if (len <= 0) return;
+    memcpy(body->buf + body->len, data, (size_t)len);
+    body->len += len;
+}
+
+// 매우 단순한 파싱: "command":"XXXX" 검색
+static bool air_command_parse(const char *body, char *cmd, size_t cap)
+{
+    const char *p = strstr(body, "\"command\"");
+    if (p == NULL) {
+        return false;
+    }
+    p = strchr(p, '"'); // 첫 따옴표
+    if (p) p = strchr(p + 1, '"'); // key 끝 따옴표
+    if (p) p = strchr(p + 1, '"'); // 값 시작 따옴표
+    if (p == NULL) {
+        return false;
+    }
+    const char *start = p + 1;
+    const char *end = strchr(start, '"');
+    if (end == NULL || end == start) {
+        return false;
+    }
+    size_t n = (size_t)(end - start);
+    if (n >= cap) n = cap - 1;
+    memcpy(cmd, start, n);
+    cmd[n] = '\0';
+    return true;
+}
+
+static char s_strstr_cmd[32];
+
+// 조각을 256바이트 버퍼에 모은 뒤 첫 명령만 찾는다
+static void strstr_parse(const char *body, size_t len, size_t piece)
+{
+    char buf[256];
+    poll_body_t b = { .buf = buf, .cap = sizeof(buf), .len = 0 };
+    for (size_t off = 0; off < len; off += piece) {
+        poll_body_append(body + off, (int)(len - off < piece ? len - off : piece), &b);
+    }
+    buf[b.len] = '\0';
+    if (!air_command_parse(buf, s_strstr_cmd, sizeof(s_strstr_cmd))) {
+        s_strstr_cmd[0] = '\0';
+    }
+}
+
+static void bench_poll_parse_strstr(void *ctx)
+{
+    (void)ctx;
+    strstr_parse(POLL_BODY, sizeof(POLL_BODY) - 1, sizeof(POLL_BODY) - 1);
+}
+
+static void bench_poll_parse_batch_strstr(void *ctx)
+{
+    (void)ctx;
+    strstr_parse(POLL_BATCH_BODY, sizeof(POLL_BATCH_BODY) - 1, 64);
+}
+
+static void task_mqtt(uint32_t now)
+{
+    (void)now;
+    bench_mqtt_callback(NULL);
+}
+
+static void task_snapshot(uint32_t now)
+{
+    (void)now;
+    bench_http_data(NULL);
+}
+
+static void task_poll(uint32_t now)
+{
+    (void)now;
+    bench_poll_parse_batch(NULL);
+}
+
+static scheduler_t s_sched;
+static sched_task_t s_tasks[] = {
+    { .name = "mqtt", .fn = task_mqtt, .period_ms = 0, .deadline_ms = 0, .priority = 0 },
+    { .name = "snapshot", .fn = task_snapshot, .period_ms = 0, .deadline_ms = 0, .priority = 1 },
+    { .name = "poll", .fn = task_poll, .period_ms = 0, .deadline_ms = 0, .priority = 2 },
+};
+
+static void bench_loop_pass(void *ctx)
+{
+    (void)ctx;
+    sched_run(&s_sched, clock_us() / 1000u);
+}
+
+// 카운터 자체 확인용: 호출마다 한 번 할당
+static void bench_alloc_probe(void *ctx)
+{
+    (void)ctx;
+    void *volatile p = malloc(32);
+    free(p);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = 20000;
+    const char *out_path = NULL;
+    const char *version = "host";
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--iterations") == 0) {
+            iterations = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        } else if (strcmp(argv[i], "-o") == 0) {
+            out_path = argv[i + 1];
+        } else if (strcmp(argv[i], "--version") == 0) {
+            version = argv[i + 1];
+        } else {
+            fprintf(stderr, "usage: %s [--iterations N] [-o FILE] [--version TAG]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (iterations == 0) {
+        fprintf(stderr, "need --iterations > 0\n");
+        return 2;
+    }
+    FILE *out = stdout;
+    if (out_path && (out = fopen(out_path, "w")) == NULL) {
+        perror(out_path);
+        return 2;
+    }
+
+    state_feed_init(&s_feed, 1);
+    sched_init(&s_sched, s_tasks, (uint8_t)(sizeof(s_tasks) / sizeof(s_tasks[0])), clock_us, clock_us() / 1000u);
+
+    static const struct {
+        const char *name;
+        bench_fn fn;
+        uint32_t allocs_per_op;     // 기대값
+        int baseline_of;            // 이전 파서면 비교할 벤치마크의 번호, 아니면 -1
+    } benches[] = {
+        { "mqtt_callback", bench_mqtt_callback, 0, -1 },
+        { "http_data_encode", bench_http_data, 0, -1 },
+        { "poll_parse", bench_poll_parse, 0, -1 },
+        { "poll_parse_batch", bench_poll_parse_batch, 0, -1 },
+        { "poll_parse_strstr", bench_poll_parse_strstr, 0, 2 },
+        { "poll_parse_batch_strstr", bench_poll_parse_batch_strstr, 0, 3 },
+        { "loop_pass", bench_loop_pass, 0, -1 },
+        { "alloc_probe", bench_alloc_probe, 1, -1 },
+    };
+    enum { BENCH_COUNT = sizeof(benches) / sizeof(benches[0]) };
+    double ns_per_op[BENCH_COUNT];
+    const bench_env_t env = { now_ns, alloc_count };
+    static bench_result_t result;
+    char line[320];
+    uint32_t violations = 0;
+
+    // 두 파서가 같은 명령을 읽는지 먼저 확인
+    bench_poll_parse(NULL);
+    bench_poll_parse_strstr(NULL);
+    if (strcmp(s_stream_cmd, "PUMP_ON") != 0 || strcmp(s_strstr_cmd, "PUMP_ON") != 0) {
+        fprintf(stderr, "violation: parsers disagree (cmd_stream \"%s\", strstr \"%s\")\n", s_stream_cmd,
+                s_strstr_cmd);
+        violations++;
+    }
+
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        bench_run(&env, benches[i].name, benches[i].fn, NULL, iterations, &result);
+        ns_per_op[i] = (double)result.total_ns / result.iterations;
+        int n = bench_format_json(&result, line, sizeof(line));
+        if (n <= 0) {
+            return 2;
+        }
+        // bench_capture.py가 저장하는 레코드와 같게 version을 붙인다
+        fprintf(out, "%.*s,\"version\":\"%s\"}\n", n - 1, line, version);
+        if ((uint32_t)result.allocs != benches[i].allocs_per_op * iterations) {
+            fprintf(stderr, "violation: %s made %d allocations in %u calls (want %u per call)\n", benches[i].name,
+                    (int)result.allocs, (unsigned)iterations, (unsigned)benches[i].allocs_per_op);
+            violations++;
+        }
+    }
+    // JSON을 stdout으로 쓸 때는 요약을 stderr로
+    if (out != stdout) {
+        fclose(out);
+    }
+    FILE *summary = out == stdout ? stderr : stdout;
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        int b = benches[i].baseline_of;
+        if (b >= 0) {
+            fprintf(summary, "%s: cmd_stream %.0f ns/op, old strstr parser %.0f ns/op (cmd_stream %.1fx)\n",
+                    benches[b].name, ns_per_op[b], ns_per_op[i], ns_per_op[b] / ns_per_op[i]);
+        }
+    }
+    fprintf(summary, "%s (%u violations)\n", violations ? "FAIL" : "ok", (unsigned)violations);
+    return violations ? 1 : 0;
+}
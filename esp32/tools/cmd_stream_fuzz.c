@@ -0,0 +1,804 @@
+// Host fuzz/replay test of the streaming command parser (cmd_stream.c).
+//
+// Generates poll response bodies in every documented form (single command
+// object, {"status":"ok","commands":[...]}, top-level array) with decoy
+// objects that carry a "command" member in nested values ({"meta":{...}},
+// arrays of arrays, "commands" inside a command, ...), arguments written as
+// fractions/exponents/out-of-range integers, bad names and nesting past
+// CMD_STREAM_MAX_DEPTH; a quarter of the bodies are then mutated byte-wise.
+// Each body goes to cmd_stream.c in one call and in random chunk sizes, as the
+// HTTP client hands them over. Checks:
+//   - the commands, their order and arguments, the dropped count and the
+//     accept/reject result equal those of a recursive reference parser of the
+//     rules in cmd_stream.h (also on the mutated bodies: commands delivered
+//     before an error must be the same)
+//   - no decoy command is ever delivered from an unmutated body
+//   - the result does not depend on how the body is chunked
+// With --replay it feeds a captured response body instead, in one call and one
+// byte at a time, checks both against the reference and prints the commands.
+// Exit 1 on any violation.
+//
+//   cc -std=gnu11 -O2 -I.. -o cmd_stream_fuzz cmd_stream_fuzz.c ../cmd_stream.c ../json_stream.c
+//   ./cmd_stream_fuzz                     # 20000 bodies
+//   ./cmd_stream_fuzz --trials 200000 --seed 7
+//   ./cmd_stream_fuzz --replay body.json
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmd_stream.h"
+
+#define MAX_BODY     16384
+#define MAX_COMMANDS 256
+
+static uint32_t s_rng = 1;
+
+static uint32_t rnd(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static uint32_t rnd_range(uint32_t lo, uint32_t hi)
+{
+    return lo + rnd() % (hi - lo + 1);
+}
+
+static uint32_t s_violations;
+
+static void violation(const char *what, unsigned long a, unsigned long b)
+{
+    if (s_violations++ < 20) {
+        fprintf(stderr, "violation: %s (%lu, %lu)\n", what, a, b);
+    }
+}
+
+// ---------- 결과 ----------
+typedef struct {
+    air_command_t cmds[MAX_COMMANDS];
+    uint32_t count;
+    uint32_t dropped;
+    bool ok;
+} result_t;
+
+static void collect(const air_command_t *cmd, void *ctx)
+{
+    result_t *r = (result_t *)ctx;
+    if (r->count < MAX_COMMANDS) {
+        r->cmds[r->count] = *cmd;
+    }
+    r->count++;
+}
+
+static bool same_result(const result_t *a, const result_t *b)
+{
+    if (a->ok != b->ok || a->count != b->count || a->dropped != b->dropped) {
+        return false;
+    }
+    uint32_t n = a->count < MAX_COMMANDS ? a->count : MAX_COMMANDS;
+    for (uint32_t i = 0; i < n; i++) {
+        const air_command_t *x = &a->cmds[i], *y = &b->cmds[i];
+        if (strcmp(x->name, y->name) != 0 || x->value != y->value || x->seq != y->seq || x->id != y->id ||
+            x->ts != y->ts) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void run_stream(const char *body, size_t len, size_t max_chunk, result_t *r)
+{
+    static cmd_stream_t s;
+    memset(r, 0, sizeof(*r));
+    cmd_stream_init(&s, collect, r);
+    bool ok = true;
+    size_t pos = 0;
+    while (pos < len) {
+        size_t chunk = max_chunk ? rnd_range(1, (uint32_t)max_chunk) : len;
+        if (chunk > len - pos) {
+            chunk = len - pos;
+        }
+        ok = cmd_stream_feed(&s, body + pos, chunk) && ok;
+        pos += chunk;
+    }
+    r->ok = cmd_stream_finish(&s) && ok;
+    r->dropped = s.dropped;
+    if (s.commands != r->count) {
+        violation("commands counter", s.commands, r->count);
+    }
+}
+
+// ---------- 참조 파서 ----------
+// cmd_stream.h의 규칙을 완결된 본문 위에서 재귀로 옮긴 것. 숫자/리터럴은 cmd_stream.c와 같이
+// 구분자(공백 , } ])까지를 한 토큰으로 보고, 느슨한 숫자 규칙도 그대로 따른다.
+enum { P_NONE, P_TOP, P_ELEMENT, P_COMMANDS };     // 값이 놓인 자리
+enum { F_NONE, F_COMMAND, F_VALUE, F_SEQ, F_ID, F_TS, F_COMMANDS };
+
+typedef struct {
+    air_command_t cmd;
+    bool has_name;
+    bool bad;
+} ref_object_t;
+
+typedef struct {
+    const char *b;
+    size_t len;
+    size_t pos;
+    int depth;
+    bool err;
+    result_t *out;
+} ref_t;
+
+static bool ref_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static void ref_skip(ref_t *r)
+{
+    while (r->pos < r->len && ref_space(r->b[r->pos])) {
+        r->pos++;
+    }
+}
+
+// 따옴표부터 닫는 따옴표까지. \uXXXX는 UTF-8 (NUL과 서로게이트 반쪽은 '?'). 앞 cap-1 바이트를 out에,
+// 바이트 수(0xFFFF까지)를 반환
+static int ref_string(ref_t *r, char *out, size_t cap)
+{
+    int n = 0;
+    r->pos++;
+    for (;;) {
+        if (r->pos >= r->len) {
+            r->err = true;
+            return 0;
+        }
+        char c = r->b[r->pos++];
+        if (c == '"') {
+            break;
+        }
+        if ((unsigned char)c < 0x20) {
+            r->err = true;
+            return 0;
+        }
+        if (c == '\\') {
+            if (r->pos >= r->len) {
+                r->err = true;
+                return 0;
+            }
+            char e = r->b[r->pos++];
+            static const char from[] = "\"\\/bfnrt", to[] = "\"\\/\b\f\n\r\t";
+            const char *k = strchr(from, e);
+            if (e != '\0' && k) {
+                c = to[k - from];
+            } else if (e == 'u') {
+                char hex[5] = "";
+                for (int h = 0; h < 4; h++) {
+                    char x = r->pos < r->len ? r->b[r->pos++] : 0;
+                    if (!((x >= '0' && x <= '9') || (x >= 'a' && x <= 'f') || (x >= 'A' && x <= 'F'))) {
+                        r->err = true;
+                        return 0;
+                    }
+                    hex[h] = x;
+                }
+                unsigned long cp = strtoul(hex, NULL, 16);
+                unsigned char u[3] = { '?' };
+                int m = 1;
+                if (cp != 0 && (cp < 0xd800 || cp > 0xdfff)) {
+                    if (cp < 0x80) {
+                        u[0] = (unsigned char)cp;
+                    } else if (cp < 0x800) {
+                        u[0] = (unsigned char)(0xc0 | cp >> 6);
+                        u[1] = (unsigned char)(0x80 | (cp & 0x3f));
+                        m = 2;
+                    } else {
+                        u[0] = (unsigned char)(0xe0 | cp >> 12);
+                        u[1] = (unsigned char)(0x80 | (cp >> 6 & 0x3f));
+                        u[2] = (unsigned char)(0x80 | (cp & 0x3f));
+                        m = 3;
+                    }
+                }
+                for (int k = 0; k < m; k++) {
+                    if ((size_t)n + 1 < cap) {
+                        out[n] = (char)u[k];
+                    }
+                    if (n < 0xFFFF) {
+                        n++;
+                    }
+                }
+                continue;
+            } else {
+                r->err = true;
+                return 0;
+            }
+        }
+        if ((size_t)n + 1 < cap) {
+            out[n] = c;
+        }
+        if (n < 0xFFFF) {
+            n++;
+        }
+    }
+    out[(size_t)n < cap ? (size_t)n : cap - 1] = '\0';
+    return n;
+}
+
+static bool ref_token_ok(const char *t, size_t n)
+{
+    if ((n == 4 && (memcmp(t, "true", 4) == 0 || memcmp(t, "null", 4) == 0)) || (n == 5 && memcmp(t, "false", 5) == 0)) {
+        return true;
+    }
+    if (t[0] != '-' && (t[0] < '0' || t[0] > '9')) {
+        return false;
+    }
+    for (size_t i = 1; i < n; i++) {
+        if (!strchr("0123456789.eE+-", t[i]) || t[i] == '\0') {
+            return false;
+        }
+    }
+    return t[n - 1] >= '0' && t[n - 1] <= '9';
+}
+
+static long long ref_clamp(const char *t, long long lo, long long hi)
+{
+    long long v = strtoll(t, NULL, 10);
+    return v < lo ? lo : v > hi ? hi : v;
+}
+
+static void ref_value(ref_t *r, int place, ref_object_t *o, int field);
+
+static void ref_object(ref_t *r, int place)
+{
+    ref_object_t obj;
+    memset(&obj, 0, sizeof(obj));
+    ref_object_t *o = place == P_TOP || place == P_ELEMENT ? &obj : NULL;
+    r->pos++;
+    ref_skip(r);
+    if (r->pos < r->len && r->b[r->pos] == '}') {
+        r->pos++;
+    } else {
+        for (;;) {
+            ref_skip(r);
+            if (r->pos >= r->len || r->b[r->pos] != '"') {
+                r->err = true;
+                return;
+            }
+            char key[16];
+            int n = ref_string(r, key, sizeof(key));
+            if (r->err) {
+                return;
+            }
+            ref_skip(r);
+            if (r->pos >= r->len || r->b[r->pos] != ':') {
+                r->err = true;
+                return;
+            }
+            r->pos++;
+            int field = F_NONE;
+            if (o && n < CMD_STREAM_KEY_MAX) {
+                field = strcmp(key, "command") == 0 ? F_COMMAND : strcmp(key, "value") == 0 ? F_VALUE
+                        : strcmp(key, "seq") == 0 ? F_SEQ : strcmp(key, "id") == 0 ? F_ID : strcmp(key, "ts") == 0 ? F_TS
+                        : strcmp(key, "commands") == 0 ? F_COMMANDS : F_NONE;
+            }
+            ref_value(r, place == P_TOP && field == F_COMMANDS ? P_COMMANDS : P_NONE, o, field);
+            if (r->err) {
+                return;
+            }
+            ref_skip(r);
+            if (r->pos < r->len && r->b[r->pos] == ',') {
+                r->pos++;
+                continue;
+            }
+            if (r->pos < r->len && r->b[r->pos] == '}') {
+                r->pos++;
+                break;
+            }
+            r->err = true;
+            return;
+        }
+    }
+    r->depth--;
+    if (o && o->has_name && !o->bad) {
+        collect(&o->cmd, r->out);
+    } else if (o && o->bad) {
+        r->out->dropped++;
+    }
+}
+
+static void ref_array(ref_t *r, int place)
+{
+    int element = place == P_TOP || place == P_COMMANDS ? P_ELEMENT : P_NONE;
+    r->pos++;
+    ref_skip(r);
+    if (r->pos < r->len && r->b[r->pos] == ']') {
+        r->pos++;
+    } else {
+        for (;;) {
+            ref_value(r, element, NULL, F_NONE);
+            if (r->err) {
+                return;
+            }
+            ref_skip(r);
+            if (r->pos < r->len && r->b[r->pos] == ',') {
+                r->pos++;
+                continue;
+            }
+            if (r->pos < r->len && r->b[r->pos] == ']') {
+                r->pos++;
+                break;
+            }
+            r->err = true;
+            return;
+        }
+    }
+    r->depth--;
+}
+
+// 값 하나. o/field는 이 값이 채울 명령 객체의 멤버 (없으면 NULL/F_NONE)
+static void ref_value(ref_t *r, int place, ref_object_t *o, int field)
+{
+    ref_skip(r);
+    if (r->pos >= r->len) {
+        r->err = true;
+        return;
+    }
+    char c = r->b[r->pos];
+    if (c == '{' || c == '[') {
+        if (o && field == F_COMMAND) {
+            o->bad = true;
+        }
+        if (r->depth >= CMD_STREAM_MAX_DEPTH) {
+            r->err = true;
+            return;
+        }
+        r->depth++;
+        if (c == '{') {
+            ref_object(r, place);
+        } else {
+            ref_array(r, place);
+        }
+        return;
+    }
+    if (c == '"') {
+        char name[CMD_STREAM_NAME_MAX];
+        int n = ref_string(r, name, sizeof(name));
+        if (!r->err && o && field == F_COMMAND) {
+            memcpy(o->cmd.name, name, sizeof(name));
+            if (n == 0 || n >= CMD_STREAM_NAME_MAX) {
+                o->bad = true;
+            } else {
+                o->has_name = true;
+            }
+        }
+        return;
+    }
+    if (c != '-' && (c < '0' || c > '9') && (c < 'a' || c > 'z')) {
+        r->err = true;
+        return;
+    }
+    size_t start = r->pos;
+    while (r->pos < r->len && !ref_space(r->b[r->pos]) && !strchr(",}]", r->b[r->pos])) {
+        r->pos++;
+    }
+    size_t n = r->pos - start;
+    char t[64];
+    // 최상위 숫자가 아니면 구분자가 와야 끝난다 (본문 끝에서 잘린 토큰은 오류)
+    if (n > CMD_STREAM_TOKEN_MAX - 1 || (r->pos >= r->len && r->depth > 0)) {
+        r->err = true;
+        return;
+    }
+    memcpy(t, r->b + start, n);
+    t[n] = '\0';
+    if (!ref_token_ok(t, n)) {
+        r->err = true;
+        return;
+    }
+    if (!o || field == F_NONE || field == F_COMMANDS) {
+        return;
+    }
+    bool number = t[0] == '-' || (t[0] >= '0' && t[0] <= '9');
+    if (field == F_COMMAND || (number && strpbrk(t, ".eE"))) {
+        o->bad = true;
+    } else if (number) {
+        if (field == F_VALUE) o->cmd.value = (int32_t)ref_clamp(t, INT32_MIN, INT32_MAX);
+        if (field == F_SEQ)   o->cmd.seq = (uint32_t)ref_clamp(t, 0, 0xFFFFFFFFLL);
+        if (field == F_ID)    o->cmd.id = (uint32_t)ref_clamp(t, 0, 0xFFFFFFFFLL);
+        if (field == F_TS)    o->cmd.ts = t[0] == '-' ? 0 : strtoull(t, NULL, 10);
+    }
+}
+
+static void reference(const char *body, size_t len, result_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    ref_t r = { body, len, 0, 0, false, out };
+    ref_value(&r, P_TOP, NULL, F_NONE);
+    if (!r.err) {
+        ref_skip(&r);
+        r.err = r.pos != r.len;
+    }
+    out->ok = !r.err;
+}
+
+// ---------- 본문 생성 ----------
+typedef struct {
+    char b[MAX_BODY];
+    size_t len;
+    bool overflow;
+    uint32_t decoys;
+    uint32_t next_name;
+    int max_depth;      // 생성할 최대 중첩 (CMD_STREAM_MAX_DEPTH를 넘기면 TOO_DEEP 확인)
+} gen_t;
+
+static void put(gen_t *g, const char *s)
+{
+    size_t n = strlen(s);
+    if (g->len + n >= sizeof(g->b)) {
+        g->overflow = true;
+        return;
+    }
+    memcpy(g->b + g->len, s, n);
+    g->len += n;
+}
+
+static void ws(gen_t *g)
+{
+    static const char *const spaces[] = { " ", "\n", "\t", "\r\n  " };
+    if (rnd() % 4 == 0) {
+        put(g, spaces[rnd() % 4]);
+    }
+}
+
+static void gen_number(gen_t *g)
+{
+    char t[32];
+    switch (rnd() % 10) {
+    case 0:  snprintf(t, sizeof(t), "-%u", (unsigned)rnd_range(1, 100000)); break;
+    case 1:  snprintf(t, sizeof(t), "%u.%u", (unsigned)rnd_range(0, 5000), (unsigned)rnd_range(0, 99)); break;
+    case 2:  snprintf(t, sizeof(t), "%ue%u", (unsigned)rnd_range(1, 9), (unsigned)rnd_range(0, 12)); break;
+    case 3:  snprintf(t, sizeof(t), "%uE+%u", (unsigned)rnd_range(1, 9), (unsigned)rnd_range(0, 3)); break;
+    case 4:  snprintf(t, sizeof(t), "%s%llu", rnd() % 2 ? "-" : "", 2147483647ULL + rnd_range(0, 3)); break;
+    case 5:  snprintf(t, sizeof(t), "%llu", 4294967295ULL + rnd_range(0, 2)); break;
+    case 6:  snprintf(t, sizeof(t), "%s", rnd() % 2 ? "-0" : "0"); break;
+    default: snprintf(t, sizeof(t), "%u", (unsigned)rnd_range(0, 5000)); break;
+    }
+    put(g, t);
+}
+
+static void gen_literal(gen_t *g)
+{
+    static const char *const lit[] = { "true", "false", "null" };
+    put(g, lit[rnd() % 3]);
+}
+
+static void gen_string(gen_t *g, const char *prefix)
+{
+    char t[80];
+    uint32_t kind = rnd() % 12;
+    if (kind == 0) {
+        put(g, "\"\"");
+        return;
+    }
+    if (kind == 1 || kind == 2) {
+        // 최대 길이 바로 아래/위 (NUL 포함 CMD_STREAM_NAME_MAX)
+        int n = CMD_STREAM_NAME_MAX - (kind == 1 ? 1 : 0) + (int)rnd_range(0, 8) * (kind == 2);
+        memset(t, 'X', (size_t)n);
+        memcpy(t, prefix, strlen(prefix));
+        t[n] = '\0';
+        put(g, "\"");
+        put(g, t);
+        put(g, "\"");
+        return;
+    }
+    static const char *const escapes[] = { "\\u0041", "\\u00e9", "\\uc548", "\\ud83d", "\\u0000",
+                                           "\\n", "\\\"", "\\\\", "\\/" };
+    snprintf(t, sizeof(t), "\"%s%u%s\"", prefix, (unsigned)g->next_name++, kind == 3 ? escapes[rnd() % 9] : "");
+    put(g, t);
+}
+
+static void gen_any(gen_t *g, int depth);
+
+// 중첩 자리의 미끼: 명령처럼 보이지만 실행되면 안 된다
+static void gen_decoy(gen_t *g, int depth)
+{
+    g->decoys++;
+    put(g, "{\"command\":");
+    gen_string(g, "DECOY_");
+    put(g, ",\"value\":1");
+    if (rnd() % 3 == 0 && depth + 2 <= g->max_depth) {
+        put(g, ",\"commands\":[");
+        gen_decoy(g, depth + 2);
+        put(g, "]");
+    }
+    put(g, "}");
+}
+
+static void gen_container(gen_t *g, int depth, bool object)
+{
+    put(g, object ? "{" : "[");
+    ws(g);
+    uint32_t n = rnd_range(0, 3);
+    static const char *const keys[] = { "status", "ts", "meta", "command", "commands", "value", "seq", "id",
+                                        "a_very_long_key_name", "comm\\u0061nd" };
+    for (uint32_t i = 0; i < n; i++) {
+        if (i) {
+            put(g, ",");
+            ws(g);
+        }
+        if (object) {
+            put(g, "\"");
+            put(g, keys[rnd() % 10]);
+            put(g, "\":");
+            ws(g);
+        }
+        gen_any(g, depth);
+        ws(g);
+    }
+    put(g, object ? "}" : "]");
+}
+
+static void gen_any(gen_t *g, int depth)
+{
+    uint32_t kind = rnd() % (depth < g->max_depth ? 8 : 3);
+    switch (kind) {
+    case 0:  gen_number(g); break;
+    case 1:  gen_string(g, "S"); break;
+    case 2:  gen_literal(g); break;
+    case 3:
+    case 4:  gen_decoy(g, depth + 1); break;
+    case 5:  gen_container(g, depth + 1, false); break;
+    default: gen_container(g, depth + 1, true); break;
+    }
+}
+
+// 명령 자리에 놓이는 명령 아닌 값: 객체가 오면 그 자체가 명령 자리이므로 스칼라나 배열만
+static void gen_filler(gen_t *g, int depth)
+{
+    switch (rnd() % 4) {
+    case 0:  gen_number(g); break;
+    case 1:  gen_string(g, "S"); break;
+    case 2:  gen_literal(g); break;
+    default: gen_container(g, depth, false); break;
+    }
+}
+
+static void member(gen_t *g, bool *first, const char *key)
+{
+    if (!*first) {
+        put(g, ",");
+        ws(g);
+    }
+    *first = false;
+    put(g, "\"");
+    put(g, key);
+    put(g, "\":");
+    ws(g);
+}
+
+// 명령 자리의 객체 (depth는 이 객체의 깊이)
+static void gen_command(gen_t *g, int depth)
+{
+    bool first = true;
+    put(g, "{");
+    ws(g);
+    uint32_t n = rnd_range(1, 6);
+    for (uint32_t i = 0; i < n; i++) {
+        switch (rnd() % 9) {
+        case 0:
+        case 1:
+            member(g, &first, "command");
+            if (rnd() % 16 == 0) {
+                gen_any(g, depth);     // 문자열이 아닌 command
+            } else {
+                gen_string(g, "CMD_");
+            }
+            break;
+        case 2: member(g, &first, "value"); rnd() % 8 ? gen_number(g) : gen_any(g, depth); break;
+        case 3: member(g, &first, "seq"); gen_number(g); break;
+        case 4: member(g, &first, "id"); gen_number(g); break;
+        case 5: member(g, &first, "meta"); gen_any(g, depth); break;
+        case 6:
+            // 최상위 객체의 "commands"는 진짜 명령 배열이라 원소 객체에서만 미끼로 쓴다
+            member(g, &first, depth > 1 ? "commands" : "list");
+            gen_container(g, depth + 1, false);
+            break;
+        case 7: member(g, &first, "status"); put(g, "\"ok\""); break;
+        default: member(g, &first, "x"); gen_decoy(g, depth + 1); break;
+        }
+        ws(g);
+    }
+    put(g, "}");
+}
+
+static void gen_body(gen_t *g)
+{
+    g->len = 0;
+    g->overflow = false;
+    g->decoys = 0;
+    g->max_depth = rnd() % 16 == 0 ? CMD_STREAM_MAX_DEPTH + 1 : CMD_STREAM_MAX_DEPTH;
+    ws(g);
+    switch (rnd() % 4) {
+    case 0:
+        gen_command(g, 1);
+        break;
+    case 1: {
+        // {"status":"ok","commands":[...]} (최상위 명령 멤버가 같이 올 수도 있다)
+        put(g, "{\"status\":\"ok\",");
+        if (rnd() % 4 == 0) {
+            put(g, "\"command\":");
+            gen_string(g, "CMD_");
+            put(g, ",");
+        }
+        put(g, "\"commands\":[");
+        uint32_t n = rnd_range(0, 6);
+        for (uint32_t i = 0; i < n; i++) {
+            if (i) {
+                put(g, ",");
+            }
+            ws(g);
+            if (rnd() % 8 == 0) {
+                gen_filler(g, 3);
+            } else {
+                gen_command(g, 3);
+            }
+        }
+        put(g, "],\"ts\":1700000000000}");
+        break;
+    }
+    case 2: {
+        put(g, "[");
+        uint32_t n = rnd_range(0, 6);
+        for (uint32_t i = 0; i < n; i++) {
+            if (i) {
+                put(g, ",");
+            }
+            ws(g);
+            if (rnd() % 8 == 0) {
+                gen_filler(g, 2);
+            } else {
+                gen_command(g, 2);
+            }
+        }
+        put(g, "]");
+        break;
+    }
+    default:
+        // 최상위 스칼라 ("42", "null" 등)
+        rnd() % 2 ? gen_number(g) : gen_literal(g);
+        break;
+    }
+    ws(g);
+}
+
+static void mutate(gen_t *g)
+{
+    static const char alphabet[] = "{}[]\",:\\ 0-1.eEnu";
+    uint32_t edits = rnd_range(1, 4);
+    for (uint32_t k = 0; k < edits && g->len > 0 && g->len + 1 < sizeof(g->b); k++) {
+        size_t at = rnd() % g->len;
+        char c = alphabet[rnd() % (sizeof(alphabet) - 1)];
+        switch (rnd() % 3) {
+        case 0:
+            memmove(g->b + at, g->b + at + 1, g->len - at - 1);
+            g->len--;
+            break;
+        case 1:
+            memmove(g->b + at + 1, g->b + at, g->len - at);
+            g->b[at] = c;
+            g->len++;
+            break;
+        default:
+            g->b[at] = c;
+            break;
+        }
+    }
+}
+
+typedef struct {
+    uint32_t bodies;
+    uint32_t rejected;
+    uint32_t commands;
+    uint32_t dropped;
+    uint32_t decoys;
+} totals_t;
+
+static void trial(totals_t *t)
+{
+    static gen_t g;
+    gen_body(&g);
+    if (g.overflow) {
+        return;
+    }
+    bool mutated = rnd() % 4 == 0;
+    if (mutated) {
+        mutate(&g);
+    }
+
+    static result_t ref, whole, chunked;
+    reference(g.b, g.len, &ref);
+    run_stream(g.b, g.len, 0, &whole);
+    run_stream(g.b, g.len, rnd() % 4 == 0 ? 1 : 64, &chunked);
+    if (!same_result(&whole, &ref)) {
+        violation("parser differs from the reference (commands, reference)", whole.count, ref.count);
+        if (s_violations <= 3) {
+            fprintf(stderr, "  ok %d/%d dropped %u/%u body: %.*s\n", whole.ok, ref.ok, (unsigned)whole.dropped,
+                    (unsigned)ref.dropped, (int)g.len, g.b);
+        }
+    }
+    if (!same_result(&chunked, &whole)) {
+        violation("chunked feed differs", chunked.count, whole.count);
+    }
+    if (!mutated) {
+        if (!ref.ok && g.max_depth <= CMD_STREAM_MAX_DEPTH) {
+            violation("generated body rejected by the reference", g.len, 0);
+        }
+        for (uint32_t i = 0; i < whole.count && i < MAX_COMMANDS; i++) {
+            if (strncmp(whole.cmds[i].name, "DECOY_", 6) == 0) {
+                violation("nested decoy command delivered", i, whole.count);
+            }
+        }
+        t->decoys += g.decoys;
+    }
+    t->bodies++;
+    t->rejected += !whole.ok;
+    t->commands += whole.count;
+    t->dropped += whole.dropped;
+}
+
+static int replay(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return 2;
+    }
+    static char data[1 << 20];
+    size_t len = fread(data, 1, sizeof(data), f);
+    fclose(f);
+
+    static result_t ref, whole, bytewise;
+    reference(data, len, &ref);
+    run_stream(data, len, 0, &whole);
+    run_stream(data, len, 1, &bytewise);
+    if (!same_result(&whole, &ref)) {
+        violation("parser differs from the reference", whole.count, ref.count);
+    }
+    if (!same_result(&bytewise, &whole)) {
+        violation("replay differs by chunking", bytewise.count, whole.count);
+    }
+    for (uint32_t i = 0; i < whole.count && i < MAX_COMMANDS; i++) {
+        const air_command_t *c = &whole.cmds[i];
+        printf("%s value=%d seq=%u id=%u\n", c->name, (int)c->value, (unsigned)c->seq, (unsigned)c->id);
+    }
+    printf("%zu bytes: %s, %u commands, %u dropped\n", len, whole.ok ? "complete" : "rejected", (unsigned)whole.count,
+           (unsigned)whole.dropped);
+    printf("%s (%u violations)\n", s_violations ? "FAIL" : "ok", (unsigned)s_violations);
+    return s_violations ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t trials = 20000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--trials") == 0) {
+            trials = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            s_rng = (uint32_t)strtoul(argv[i + 1], NULL, 10) | 1u;
+        } else if (strcmp(argv[i], "--replay") == 0) {
+            return replay(argv[i + 1]);
+        } else {
+            fprintf(stderr, "usage: %s [--trials N] [--seed S] [--replay FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    totals_t t;
+    memset(&t, 0, sizeof(t));
+    for (uint32_t i = 0; i < trials; i++) {
+        trial(&t);
+    }
+    printf("%u bodies (%u rejected): %u commands delivered, %u dropped, %u nested decoys skipped\n",
+           (unsigned)t.bodies, (unsigned)t.rejected, (unsigned)t.commands, (unsigned)t.dropped, (unsigned)t.decoys);
+    printf("%s (%u violations)\n", s_violations ? "FAIL" : "ok", (unsigned)s_violations);
+    return s_violations ? 1 : 0;
+}
@@ -0,0 +1,157 @@
+// Host unit test of the command registry's idempotency keys (esp_command_handler.c).
+//
+// The actuator hooks are stubs that count calls and can refuse (as the
+// actuator queue does while the bug hold is on). Checks that:
+//   - a repeated key from the same source is DUPLICATE and not executed
+//   - the same key from another source executes (keys are per source)
+//   - a PREEMPTED or NOT_ALLOWED command does not use up its key: the retry
+//     with the same key executes
+//   - key 0 never deduplicates, and the polling path keys by id, else seq
+//   - WINDOW_OPEN and PUMP_ON pass their value (opening angle, run time) to
+//     the actuator hook; a value out of range, or on a command that takes
+//     none, is BAD_VALUE, is not executed and does not use up its key
+//   - only the last CMD_RECENT_KEYS (16) executed keys are remembered
+// Exit 1 on the first mismatch.
+//
+//   cc -std=gnu11 -O2 -I.. -o command_handler_test command_handler_test.c ../esp_command_handler.c ../dlog.c
+//   ./command_handler_test
+#include <stdio.h>
+#include <string.h>
+
+#include "dlog.h"
+#include "esp_command_handler.h"
+
+static bool s_refuse;           // true면 액추에이터 큐가 거부 (선점)
+static uint32_t s_actuations;
+static int32_t s_last_value;    // 마지막으로 큐에 넣은 value
+static uint32_t s_bug_calls;
+static int s_failures;
+
+bool actuator_request(act_id_t actuator, int target, int32_t value, act_prio_t priority, cmd_source_t source)
+{
+    (void)actuator;
+    (void)target;
+    (void)priority;
+    (void)source;
+    if (s_refuse) {
+        return false;
+    }
+    s_actuations++;
+    s_last_value = value;
+    return true;
+}
+
+void bug_detected(bool spray)
+{
+    (void)spray;
+    s_bug_calls++;
+}
+
+void bug_cleared(uint32_t settle_ms)
+{
+    (void)settle_ms;
+    s_bug_calls++;
+}
+
+static uint32_t clock_ms(void)
+{
+    return 0;
+}
+
+// 명령 하나를 보내고 상태와 실행 여부를 확인한다
+static void check_value(int32_t want, const char *what)
+{
+    if (s_last_value != want) {
+        printf("FAIL: %s: %ld/%ld\n", what, (long)s_last_value, (long)want);
+        s_failures++;
+    }
+}
+
+static void expect_value(cmd_source_t source, const char *name, int32_t value, uint32_t key, cmd_status_t status,
+                         bool executes, const char *what)
+{
+    uint32_t before = s_actuations + s_bug_calls;
+    cmd_args_t args = { value, key };
+    cmd_status_t got = command_dispatch(source, name, strlen(name), &args, NULL);
+    bool executed = s_actuations + s_bug_calls != before;
+    if (got != status || executed != executes) {
+        printf("FAIL: %s: %s/%s, executed %d\n", what, command_status_name(got), command_status_name(status),
+               (int)executed);
+        s_failures++;
+    }
+}
+
+static void expect(cmd_source_t source, const char *name, uint32_t key, cmd_status_t status, bool executes,
+                   const char *what)
+{
+    expect_value(source, name, 0, key, status, executes, what);
+}
+
+int main(void)
+{
+    dlog_init(clock_ms);
+    for (int m = 0; m < DLOG_MOD_COUNT; m++) {
+        dlog_set_level((dlog_module_t)m, DLOG_NONE);
+    }
+
+    expect(CMD_SRC_HTTP, "WINDOW_OPEN", 5, CMD_RESULT_OK, true, "first");
+    expect(CMD_SRC_HTTP, "window_open", 5, CMD_RESULT_DUPLICATE, false, "repeat");
+    expect(CMD_SRC_HTTP, "WINDOW_CLOSE", 5, CMD_RESULT_DUPLICATE, false, "same key, other command");
+    expect(CMD_SRC_PULL, "WINDOW_OPEN", 5, CMD_RESULT_OK, true, "same key, other source");
+    expect(CMD_SRC_MQTT, "BUG_ON", 5, CMD_RESULT_OK, true, "same key, third source");
+
+    s_refuse = true;
+    expect(CMD_SRC_HTTP, "PUMP_ON", 9, CMD_RESULT_PREEMPTED, false, "preempted");
+    expect(CMD_SRC_HTTP, "PUMP_ON", 9, CMD_RESULT_PREEMPTED, false, "preempted again");
+    s_refuse = false;
+    expect(CMD_SRC_HTTP, "PUMP_ON", 9, CMD_RESULT_OK, true, "retry after preemption");
+    expect(CMD_SRC_HTTP, "PUMP_ON", 9, CMD_RESULT_DUPLICATE, false, "repeat after retry");
+
+    expect(CMD_SRC_MQTT, "ON", 11, CMD_RESULT_NOT_ALLOWED, false, "not allowed");
+    expect(CMD_SRC_MQTT, "NOPE", 11, CMD_RESULT_UNKNOWN, false, "unknown");
+    expect(CMD_SRC_MQTT, "WINDOW_CLOSE", 11, CMD_RESULT_OK, true, "key after a refusal");
+
+    expect(CMD_SRC_HTTP, "WINDOW_TOGGLE", 0, CMD_RESULT_OK, true, "no key");
+    expect(CMD_SRC_HTTP, "WINDOW_TOGGLE", 0, CMD_RESULT_OK, true, "no key again");
+
+    // 폴링 경로: id, 없으면 seq
+    air_command_t cmd = { .name = "PUMP_OFF", .seq = 40, .id = 0 };
+    uint32_t before = s_actuations;
+    esp_handle_command(&cmd);
+    esp_handle_command(&cmd);
+    cmd.id = 40;
+    cmd.seq = 41;
+    esp_handle_command(&cmd);
+    if (s_actuations != before + 1) {
+        printf("FAIL: pull keys by id, else seq (%u executions)\n", (unsigned)(s_actuations - before));
+        s_failures++;
+    }
+
+    // value: 열림 각도, 분사 시간만 받고 범위를 넘거나 받지 않는 명령이면 실행하지 않는다
+    expect_value(CMD_SRC_PULL, "PUMP_ON", 3000, 50, CMD_RESULT_OK, true, "pump run time");
+    check_value(3000, "pump run time passed through");
+    expect_value(CMD_SRC_HTTP, "WINDOW_OPEN", 45, 51, CMD_RESULT_OK, true, "opening angle");
+    check_value(45, "opening angle passed through");
+    expect_value(CMD_SRC_HTTP, "WINDOW_OPEN", CMD_WINDOW_MAX_OPEN_DEG + 1, 52, CMD_RESULT_BAD_VALUE, false,
+                 "opening beyond fully open");
+    expect_value(CMD_SRC_HTTP, "WINDOW_OPEN", 30, 52, CMD_RESULT_OK, true, "key kept after a bad value");
+    expect_value(CMD_SRC_MQTT, "PUMP_ON", -1, 53, CMD_RESULT_BAD_VALUE, false, "negative run time");
+    expect_value(CMD_SRC_MQTT, "PUMP_ON", CMD_PUMP_MAX_MS + 1, 54, CMD_RESULT_BAD_VALUE, false, "run time too long");
+    expect_value(CMD_SRC_MQTT, "WINDOW_CLOSE", 10, 55, CMD_RESULT_BAD_VALUE, false, "close takes no value");
+    expect_value(CMD_SRC_MQTT, "PUMP_OFF", 10, 56, CMD_RESULT_BAD_VALUE, false, "pump off takes no value");
+    expect_value(CMD_SRC_MQTT, "WINDOW_TOGGLE", 10, 57, CMD_RESULT_BAD_VALUE, false, "toggle takes no value");
+    expect(CMD_SRC_MQTT, "PUMP_ON", 58, CMD_RESULT_OK, true, "no value");
+    check_value(0, "no value is the default");
+
+    // 최근 16개만 기억한다
+    for (uint32_t k = 100; k < 116; k++) {
+        expect(CMD_SRC_HTTP, "WINDOW_OPEN", k, CMD_RESULT_OK, true, "fill");
+    }
+    expect(CMD_SRC_HTTP, "WINDOW_OPEN", 115, CMD_RESULT_DUPLICATE, false, "newest remembered");
+    expect(CMD_SRC_HTTP, "WINDOW_OPEN", 100, CMD_RESULT_DUPLICATE, false, "oldest remembered");
+    expect(CMD_SRC_HTTP, "WINDOW_OPEN", 116, CMD_RESULT_OK, true, "one more");
+    expect(CMD_SRC_HTTP, "WINDOW_OPEN", 100, CMD_RESULT_OK, true, "oldest forgotten");
+
+    printf("%s\n", s_failures ? "FAIL" : "ok");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,196 @@
+// Host unit test of the pieces that authenticate MQTT config updates.
+//
+//   - hmac_sha256.c: SHA-256 ("abc", one million 'a' fed in odd-sized chunks)
+//     and HMAC-SHA256 (RFC 4231 cases 1, 2 and 6, the last with a key longer
+//     than a block); the hex compare accepts upper case and refuses short,
+//     long or non-hex signatures
+//   - cfg_parse_update(): "config" is returned as the exact bytes sent and
+//     "sig" as written, a signature made by tools/config_sign.py verifies,
+//     fields outside the allowed mask are LOCAL_ONLY, a NULL staged only
+//     scans, \uXXXX escapes arrive as UTF-8, wrong types, ranges and unknown
+//     fields fail with the field's name, and a malformed "sig", "rev" or
+//     envelope is a format error
+// Exit 1 on the first mismatch.
+//
+//   cc -std=gnu11 -O2 -I.. -o config_auth_test config_auth_test.c ../hmac_sha256.c ../device_config.c ../durable_state.c
+//      ../json_stream.c -lm
+//   ./config_auth_test
+#include <stdio.h>
+#include <string.h>
+
+#include "device_config.h"
+#include "hmac_sha256.h"
+
+static int s_failures;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        s_failures++;
+    }
+}
+
+static void hex(const uint8_t *mac, char *out)
+{
+    for (int i = 0; i < SHA256_SIZE; i++) {
+        sprintf(out + 2 * i, "%02x", mac[i]);
+    }
+}
+
+static bool sha_is(const void *data, size_t len, size_t chunk, const char *expect)
+{
+    sha256_t s;
+    uint8_t md[SHA256_SIZE];
+    char text[2 * SHA256_SIZE + 1];
+    sha256_init(&s);
+    for (size_t off = 0; off < len; off += chunk) {
+        sha256_update(&s, (const uint8_t *)data + off, len - off < chunk ? len - off : chunk);
+    }
+    sha256_final(&s, md);
+    hex(md, text);
+    return strcmp(text, expect) == 0;
+}
+
+static bool hmac_is(const void *key, size_t key_len, const char *msg, const char *expect)
+{
+    hmac_sha256_t h;
+    uint8_t mac[SHA256_SIZE];
+    hmac_sha256_init(&h, key, key_len);
+    hmac_sha256_update(&h, msg, strlen(msg));
+    hmac_sha256_final(&h, mac);
+    return hmac_sha256_hex_equal(mac, expect, strlen(expect));
+}
+
+static void test_hmac(void)
+{
+    static char million[1000000];
+    memset(million, 'a', sizeof(million));
+    check(sha_is("abc", 3, 3, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"), "sha256 abc");
+    check(sha_is(million, sizeof(million), 997, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"),
+          "sha256 million a");
+
+    uint8_t k1[20], k6[131];
+    memset(k1, 0x0b, sizeof(k1));
+    memset(k6, 0xaa, sizeof(k6));
+    check(hmac_is(k1, sizeof(k1), "Hi There", "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7"),
+          "rfc4231 case 1");
+    check(hmac_is("Jefe", 4, "what do ya want for nothing?",
+                  "5BDCC146BF60754E6A042426089575C75A003F089D2739839DEC58B964EC3843"), "rfc4231 case 2 (upper case)");
+    check(hmac_is(k6, sizeof(k6), "Test Using Larger Than Block-Size Key - Hash Key First",
+                  "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54"), "rfc4231 case 6");
+
+    check(!hmac_is("Jefe", 4, "what do ya want for nothing?",
+                   "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec384"), "short signature");
+    check(!hmac_is("Jefe", 4, "what do ya want for nothing?",
+                   "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec38430"), "long signature");
+    check(!hmac_is("Jefe", 4, "what do ya want for nothing?",
+                   "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec384g"), "non-hex signature");
+    check(!hmac_is("Jefe", 4, "what do ya want for nothing!",
+                   "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843"), "other message");
+}
+
+// tools/config_sign.py --key test-key --device node1 --rev 4 '{"pump_ms":2000, "pm25_close":30}'
+static const char SIGNED[] =
+    "{\"config\":{\"pump_ms\":2000, \"pm25_close\":30},\"rev\":4,"
+    "\"sig\":\"e0f605ed2f0c5223a4004565a350e66db72cee562d58274f7a54c9f2e8f68ed0\"}";
+
+static void test_parse(void)
+{
+    static const air_config_t base = { .pump_ms = 3000, .mqtt_port = 1883 };
+    air_config_t staged = base;
+    cfg_update_t u;
+
+    check(cfg_parse_update(NULL, SIGNED, strlen(SIGNED), 0, &u) == CFG_OK, "scan");
+    check(u.rev == 4, "scan rev");
+    check(u.config_len == strlen("{\"pump_ms\":2000, \"pm25_close\":30}") &&
+          memcmp(u.config, "{\"pump_ms\":2000, \"pm25_close\":30}", u.config_len) == 0, "config span");
+
+    hmac_sha256_t h;
+    uint8_t mac[SHA256_SIZE];
+    hmac_sha256_init(&h, "test-key", 8);
+    hmac_sha256_update(&h, "node1\n4\n", 8);
+    hmac_sha256_update(&h, u.config, u.config_len);
+    hmac_sha256_final(&h, mac);
+    check(hmac_sha256_hex_equal(mac, u.sig, strlen(u.sig)), "config_sign.py signature");
+
+    uint32_t remote = CFG_APPLY_DECISION | CFG_APPLY_PUMP | CFG_APPLY_SERVO;
+    check(cfg_parse_update(&staged, SIGNED, strlen(SIGNED), remote, &u) == CFG_OK && staged.pump_ms == 2000 &&
+          staged.pm25_close == 30, "apply allowed fields");
+
+    static const char *const local[] = {
+        "{\"config\":{\"pump_ms\":2000,\"mqtt_host\":\"evil.example\"}}",
+        "{\"config\":{\"wifi_ssid\":\"x\"}}",
+        "{\"config\":{\"post_url\":\"http://evil.example/x\"}}",
+        "{\"config\":{\"topic_root\":\"x\"}}",
+    };
+    for (size_t i = 0; i < sizeof(local) / sizeof(local[0]); i++) {
+        staged = base;
+        check(cfg_parse_update(&staged, local[i], strlen(local[i]), remote, &u) == CFG_ERR_LOCAL_ONLY &&
+              u.field != NULL, local[i]);
+        check(staged.mqtt_port == 1883 && strcmp(staged.mqtt_host, base.mqtt_host) == 0, "local field untouched");
+    }
+    staged = base;
+    check(cfg_parse_update(&staged, local[0], strlen(local[0]), remote | CFG_APPLY_MQTT, &u) == CFG_OK &&
+          strcmp(staged.mqtt_host, "evil.example") == 0, "local path takes network fields");
+
+    // 구조만 읽을 때는 값 검사를 하지 않는다 (서명 확인이 먼저)
+    static const char bad_value[] = "{\"config\":{\"pump_ms\":1,\"nope\":[1,{}]},\"sig\":\"00\"}";
+    check(cfg_parse_update(NULL, bad_value, strlen(bad_value), 0, &u) == CFG_OK && strcmp(u.sig, "00") == 0,
+          "scan skips values");
+    // \uXXXX는 UTF-8로 ("안녕 é")
+    static const char escaped[] = "{\"config\":{\"wifi_ssid\":\"\\uc548\\ub155 \\u00e9\"}}";
+    staged = base;
+    check(cfg_parse_update(&staged, escaped, strlen(escaped), CFG_APPLY_WIFI, &u) == CFG_OK &&
+          strcmp(staged.wifi_ssid, "\xec\x95\x88\xeb\x85\x95 \xc3\xa9") == 0, "escaped text");
+
+    static const struct {
+        const char *json;
+        cfg_error_t error;
+        const char *field;
+    } field_cases[] = {
+        { "{\"config\":{\"pump_ms\":true}}", CFG_ERR_TYPE, "pump_ms" },
+        { "{\"config\":{\"pump_ms\":\"2000\"}}", CFG_ERR_TYPE, "pump_ms" },
+        { "{\"config\":{\"pump_ms\":[2000]}}", CFG_ERR_TYPE, "pump_ms" },
+        { "{\"config\":{\"pump_ms\":10}}", CFG_ERR_RANGE, "pump_ms" },
+        { "{\"config\":{\"pump_ms\":1.2.3}}", CFG_ERR_FORMAT, "pump_ms" },
+        { "{\"config\":{\"pump_ms\":2000,\"nope\":1}}", CFG_ERR_UNKNOWN, NULL },
+        { "{\"config\":{\"a_field_name_longer_than_any\":1}}", CFG_ERR_UNKNOWN, NULL },
+        { "{\"config\":{\"servo_velocity_dps\":90,\"pump_ms\":5}}", CFG_ERR_RANGE, "pump_ms" },
+    };
+    for (size_t i = 0; i < sizeof(field_cases) / sizeof(field_cases[0]); i++) {
+        staged = base;
+        cfg_error_t e = cfg_parse_update(&staged, field_cases[i].json, strlen(field_cases[i].json), remote, &u);
+        check(e == field_cases[i].error && (field_cases[i].field ? u.field && strcmp(u.field, field_cases[i].field) == 0
+                                                                 : u.field == NULL), field_cases[i].json);
+    }
+    char long_text[256];
+    snprintf(long_text, sizeof(long_text), "{\"config\":{\"post_url\":\"http://%0180d\"}}", 0);
+    check(cfg_parse_update(&staged, long_text, strlen(long_text), CFG_APPLY_HTTP, &u) == CFG_ERR_RANGE,
+          "text longer than any field");
+
+    static const char *const bad[] = {
+        "{\"config\":{},\"sig\":12}",
+        "{\"config\":{},\"sig\":\"0123456789012345678901234567890123456789012345678901234567890123x\"}",
+        "{\"config\":{\"pump_ms\":}}",
+        "{\"config\":[]}",
+        "{\"config\":{},\"rev\":-1}",
+        "{\"config\":{},\"rev\":1.5}",
+        "{\"config\":{},\"rev\":\"4\"}",
+        "{\"config\":{}} x",
+        "{\"config\":{}",
+        "{\"rev\":4}",
+        "[{\"config\":{}}]",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        check(cfg_parse_update(NULL, bad[i], strlen(bad[i]), 0, &u) == CFG_ERR_FORMAT, bad[i]);
+    }
+}
+
+int main(void)
+{
+    test_hmac();
+    test_parse();
+    printf("%s\n", s_failures ? "FAIL" : "ok");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,43 @@
+#!/usr/bin/env python3
+"""Build a signed config update for a node's s_window/<id>/config topic.
+
+The firmware (built with -DAIR_MQTT_CONFIG_KEY='"..."') accepts a config
+update over MQTT only with "rev" set to its current revision (0 while it runs
+on build defaults) and "sig", the hex HMAC-SHA256 with that key over
+"<device id>\\n<rev>\\n<config object>", where the config object is hashed
+exactly as it appears in the message.
+Wi-Fi, MQTT and URL fields are refused over MQTT (LOCAL_ONLY).
+
+    python3 config_sign.py --key "$AIR_CONFIG_KEY" --device air-1a2b3c --rev 4 '{"pump_ms":2000}'
+    python3 config_sign.py ... '{"pm25_close":30}' | mosquitto_pub -t s_window/air-1a2b3c/config -s
+
+The current revision is in /data ("config_rev") and /metrics (air_config_revision).
+"""
+import argparse
+import hashlib
+import hmac
+import json
+
+
+def sign(key, device, rev, config):
+    msg = b"%s\n%d\n%s" % (device.encode(), rev, config.encode())
+    return hmac.new(key.encode(), msg, hashlib.sha256).hexdigest()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--key", required=True, help="AIR_MQTT_CONFIG_KEY of the firmware build")
+    ap.add_argument("--device", required=True, help="device ID (MQTT client ID)")
+    ap.add_argument("--rev", type=int, required=True, help="current config revision of the node")
+    ap.add_argument("config", help='config object, e.g. \'{"pump_ms":2000}\'')
+    args = ap.parse_args()
+
+    if not isinstance(json.loads(args.config), dict):
+        ap.error("config must be a JSON object")
+    if args.rev < 0:
+        ap.error("rev must be the node's current revision")
+    print('{"config":%s,"rev":%d,"sig":"%s"}' % (args.config, args.rev, sign(args.key, args.device, args.rev, args.config)))
+
+
+if __name__ == "__main__":
+    main()
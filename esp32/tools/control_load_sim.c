@@ -0,0 +1,418 @@
+// Host load test of the HTTP /control handoff (httpd task -> loop()).
+//
+// One httpd thread serves an open-loop stream of requests (Poisson arrivals,
+// mostly GET /data, some POST /control commands and CONFIG updates) the way
+// esp_http_server's single task does: /data copies the pre-serialized snapshot
+// under its lock, /control goes through the real control_handoff.c on
+// hal_posix.c's queue and task notifications. A device thread runs air_app.c's
+// loop() mirror: control_drain() with command_dispatch() from
+// esp_command_handler.c into the actuator queue, the task_actuate mirror, the
+// snapshot rebuild, and control_wait() as the idle wait. Three setups:
+//   - performance: 2 ms idle wait between passes
+//   - low-power:   250 ms idle wait; an arriving request must cut it short
+//   - loop stalls: loop() blocks for 1.5 s twice (a long pass), with a 100 ms
+//                  /control timeout so the queue fills: 504 while the queued
+//                  requests wait, then 503 once the queue or the CONFIG slot is taken
+// Reports requests/s and the /data and /control latency from arrival to
+// response. Exit 1 if a reply is paired with the wrong request, a queued
+// request is not executed exactly once, a wait outlives its timeout, a 503/504
+// happens while loop() is not stalled, the stalls produce no 503 and 504, or
+// /control p99 exceeds 50 ms in the first two setups.
+//
+//   cc -std=gnu11 -O2 -I.. -o control_load_sim control_load_sim.c ../control_handoff.c ../hal_posix.c
+//      ../esp_command_handler.c ../actuator_queue.c ../dlog.c -lpthread -lm
+//   ./control_load_sim                    # 5 s per setup at 300 requests/s
+//   ./control_load_sim --rate 1000 --seconds 5 --seed 7
+#define _GNU_SOURCE
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include "actuator_queue.h"
+#include "control_handoff.h"
+#include "dlog.h"
+#include "esp_command_handler.h"
+#include "hal.h"
+
+static const uint32_t CONTROL_TIMEOUT_MS = 1000;   // main.c와 같은 값
+static const uint32_t TARGET_P99_US = 50000;
+static const uint32_t WAIT_SLACK_US = 20000;      // 타이머/스케줄링 오차
+
+static uint32_t s_rng = 1;
+
+static uint32_t rnd(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static void sleep_us(uint64_t us)
+{
+    struct timespec ts = { (time_t)(us / 1000000u), (long)(us % 1000000u) * 1000L };
+    while (nanosleep(&ts, &ts) != 0) {
+    }
+}
+
+static uint32_t s_violations;
+
+static void violation(const char *what, unsigned long a, unsigned long b)
+{
+    if (s_violations++ < 20) {
+        fprintf(stderr, "violation: %s (%lu, %lu)\n", what, a, b);
+    }
+}
+
+// ---------- Device (air_app.c mirror) ----------
+static control_handoff_t s_handoff;
+static actq_t s_actuators;
+static pthread_mutex_t s_snapshot_lock = PTHREAD_MUTEX_INITIALIZER;   // snapshotMux
+static char s_snapshot[512];
+static size_t s_snapshot_len;
+static bool s_dirty = true;
+static uint8_t s_executed[1 << 16];     // 요청 번호별 실행 횟수 (loop 스레드만 씀)
+static uint32_t s_id_base;              // 설정마다 멱등 키가 겹치지 않도록
+
+bool actuator_request(act_id_t actuator, int target, int32_t value, act_prio_t priority, cmd_source_t source)
+{
+    return actq_push(&s_actuators, actuator, target, value, priority, (uint8_t)source) != ACT_PUSH_PREEMPTED;
+}
+
+void bug_detected(bool spray)
+{
+    (void)spray;
+}
+
+void bug_cleared(uint32_t settle_ms)
+{
+    (void)settle_ms;
+}
+
+// control_execute()와 같은 흐름. 응답이 어느 요청의 것인지 config_json에 id를 남긴다.
+static void control_execute(const control_request_t *rq, const char *config, size_t config_len,
+                            control_reply_t *reply, void *ctx)
+{
+    (void)ctx;
+    uint32_t id = rq->args.idempotency_key;
+    s_executed[(id - s_id_base) & 0xffff]++;
+    if (config) {
+        reply->config_result = config_len > 0 ? CFG_OK : CFG_ERR_TYPE;
+    } else {
+        command_dispatch(CMD_SRC_HTTP, rq->command, strlen(rq->command), &rq->args, &reply->result);
+    }
+    snprintf(reply->config_json, sizeof(reply->config_json), "%u", (unsigned)id);
+    s_dirty = true;
+}
+
+static void task_actuate(void)
+{
+    act_cmd_t c;
+    while (actq_pop(&s_actuators, &c)) {
+        s_dirty = true;
+    }
+}
+
+static void build_data_snapshot(uint32_t pass)
+{
+    char buf[sizeof(s_snapshot)];
+    int n = snprintf(buf, sizeof(buf), "{\"version\":%u,\"window\":%s,\"pushed\":%u,\"timestamp\":%u}",
+                     (unsigned)pass, s_actuators.state[ACT_WINDOW] > 0 ? "true" : "false",
+                     (unsigned)s_actuators.pushed, (unsigned)hal_millis());
+    pthread_mutex_lock(&s_snapshot_lock);
+    memcpy(s_snapshot, buf, (size_t)n);
+    s_snapshot_len = (size_t)n;
+    pthread_mutex_unlock(&s_snapshot_lock);
+}
+
+typedef struct {
+    const char *name;
+    uint32_t idle_ms;               // power_idle()의 대기
+    uint32_t timeout_ms;            // /control 대기 시간
+    uint32_t stall_ms;              // 0이면 멈추지 않음
+    uint32_t stall_at_ms[2];        // 설정 시작 기준
+} setup_t;
+
+typedef struct {
+    const setup_t *setup;
+    uint64_t start_us;
+    volatile bool stop;
+    uint64_t stall_begin_us[2];     // 실제로 멈춘 구간
+    uint64_t stall_end_us[2];
+    uint32_t passes;
+} device_t;
+
+static void *device_main(void *arg)
+{
+    device_t *d = (device_t *)arg;
+    const setup_t *setup = d->setup;
+    int next_stall = 0;
+    while (!d->stop) {
+        // 스케줄러 패스: control → actuate → snapshot
+        control_drain(&s_handoff, control_execute, NULL);
+        task_actuate();
+        if (s_dirty) {
+            s_dirty = false;
+            build_data_snapshot(d->passes);
+        }
+        d->passes++;
+        uint64_t t = now_us();
+        if (setup->stall_ms && next_stall < 2 && t - d->start_us >= setup->stall_at_ms[next_stall] * 1000ULL) {
+            d->stall_begin_us[next_stall] = t;
+            sleep_us(setup->stall_ms * 1000ULL);
+            d->stall_end_us[next_stall] = now_us();
+            next_stall++;
+            continue;
+        }
+        // power_idle()
+        control_wait(&s_handoff, setup->idle_ms);
+    }
+    control_drain(&s_handoff, control_execute, NULL);
+    return NULL;
+}
+
+// ---------- httpd ----------
+typedef enum { REQ_DATA, REQ_COMMAND, REQ_CONFIG } req_kind_t;
+
+typedef struct {
+    uint64_t arrival_us;
+    uint32_t latency_us;            // 도착 → 응답
+    uint32_t wait_us;               // control_submit() 안에서 기다린 시간
+    req_kind_t kind;
+    control_status_t status;
+} request_t;
+
+static const char *const COMMANDS[] = {
+    "WINDOW_OPEN", "WINDOW_CLOSE", "window_toggle", "PUMP_ON", "PUMP_OFF", "SELF_DESTRUCT",
+};
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint32_t percentile(uint32_t *v, uint32_t n, uint32_t pct)
+{
+    if (n == 0) {
+        return 0;
+    }
+    qsort(v, n, sizeof(v[0]), cmp_u32);
+    return v[(uint64_t)(n - 1) * pct / 100];
+}
+
+// 요청 하나를 처리하고 응답을 검사한다
+static void serve(request_t *r, uint32_t id, uint32_t timeout_ms)
+{
+    if (r->kind == REQ_DATA) {
+        char body[sizeof(s_snapshot)];
+        pthread_mutex_lock(&s_snapshot_lock);
+        size_t len = s_snapshot_len;
+        memcpy(body, s_snapshot, len);
+        pthread_mutex_unlock(&s_snapshot_lock);
+        if (len == 0 || body[0] != '{') {
+            violation("empty /data snapshot", id, len);
+        }
+        r->status = CONTROL_DONE;
+        return;
+    }
+
+    // http_control()와 같은 흐름 (본문 파싱 결과부터)
+    control_request_t rq;
+    memset(&rq, 0, sizeof(rq));
+    const char *command = r->kind == REQ_CONFIG ? "CONFIG" : COMMANDS[rnd() % (sizeof(COMMANDS) / sizeof(COMMANDS[0]))];
+    snprintf(rq.command, sizeof(rq.command), "%s", command);
+    rq.args.idempotency_key = s_id_base + id;
+    char body[96];
+    int len = snprintf(body, sizeof(body), "{\"command\":\"CONFIG\",\"id\":%u,\"config\":{\"sensor_period_ms\":2000}}",
+                       (unsigned)id);
+    control_reply_t reply;
+    uint64_t t0 = now_us();
+    r->status = control_submit(&s_handoff, &rq, body, (size_t)len, timeout_ms, &reply);
+    r->wait_us = (uint32_t)(now_us() - t0);
+    if (r->status != CONTROL_DONE) {
+        return;
+    }
+    if ((uint32_t)strtoul(reply.config_json, NULL, 10) != s_id_base + id) {
+        violation("reply paired with another request", s_id_base + id, strtoul(reply.config_json, NULL, 10));
+    } else if (r->kind == REQ_CONFIG) {
+        if (reply.config_result != CFG_OK) {
+            violation("config result", id, reply.config_result);
+        }
+    } else if (strcmp(command, "SELF_DESTRUCT") == 0) {
+        if (reply.result.status != CMD_RESULT_UNKNOWN) {
+            violation("unknown command accepted", id, reply.result.status);
+        }
+    } else if (reply.result.name == NULL || strcasecmp(reply.result.name, command) != 0) {
+        violation("reply for another command", id, reply.result.status);
+    }
+}
+
+static uint32_t run(const setup_t *setup, double rate, uint32_t seconds)
+{
+    uint32_t violations_before = s_violations;
+    memset(s_executed, 0, sizeof(s_executed));
+    actq_init(&s_actuators);
+    uint32_t n = (uint32_t)(rate * seconds);
+    if (n > 0xffff) {
+        n = 0xffff;
+    }
+    request_t *reqs = calloc(n, sizeof(*reqs));
+    uint32_t *lat = calloc(n, sizeof(*lat));
+    if (reqs == NULL || lat == NULL) {
+        return 1;
+    }
+
+    // 열린 부하: 도착 시각은 응답과 무관하게 미리 정한다
+    double t = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        t += -log(((double)(rnd() % 1000000) + 0.5) / 1000000.0) * 1e6 / rate;
+        reqs[i].arrival_us = (uint64_t)t;
+        uint32_t k = rnd() % 100;
+        reqs[i].kind = k < 80 ? REQ_DATA : k < 97 ? REQ_COMMAND : REQ_CONFIG;
+    }
+
+    device_t dev;
+    memset(&dev, 0, sizeof(dev));
+    dev.setup = setup;
+    dev.start_us = now_us();
+    pthread_t th;
+    if (pthread_create(&th, NULL, device_main, &dev) != 0) {
+        return 1;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        uint64_t at = dev.start_us + reqs[i].arrival_us;
+        uint64_t cur = now_us();
+        if (cur < at) {
+            sleep_us(at - cur);
+        }
+        serve(&reqs[i], i + 1, setup->timeout_ms);
+        reqs[i].latency_us = (uint32_t)(now_us() - at);
+    }
+    uint64_t elapsed_us = now_us() - dev.start_us;
+    sleep_us(50000);
+    dev.stop = true;
+    pthread_join(th, NULL);
+
+    uint32_t busy = 0, timeouts = 0, controls = 0, data = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        const request_t *r = &reqs[i];
+        uint32_t id = i + 1;
+        if (r->kind == REQ_DATA) {
+            continue;
+        }
+        controls++;
+        busy += r->status == CONTROL_BUSY;
+        timeouts += r->status == CONTROL_TIMEOUT;
+        // 큐에 들어간 요청은 (시간 초과돼도) 정확히 한 번 실행된다
+        uint8_t want = r->status == CONTROL_BUSY ? 0 : 1;
+        if (s_executed[id] != want) {
+            violation("queued request not executed exactly once", id, s_executed[id]);
+        }
+        if (r->wait_us > setup->timeout_ms * 1000u + WAIT_SLACK_US) {
+            violation("control wait outlived its timeout", r->wait_us, setup->timeout_ms);
+        }
+        // 503/504는 loop()가 멈춘 동안(과 그 직전 timeout 구간)에만
+        if (r->status != CONTROL_DONE) {
+            uint64_t at = dev.start_us + r->arrival_us;
+            bool stalled = false;
+            for (int s = 0; s < 2; s++) {
+                if (dev.stall_begin_us[s] && at + setup->timeout_ms * 1000ULL + WAIT_SLACK_US >= dev.stall_begin_us[s] &&
+                    at <= dev.stall_end_us[s]) {
+                    stalled = true;
+                }
+            }
+            if (!stalled) {
+                violation(r->status == CONTROL_BUSY ? "503 while loop() runs" : "504 while loop() runs", id,
+                          r->arrival_us / 1000);
+            }
+        }
+    }
+    if (s_handoff.config_busy) {
+        violation("CONFIG slot still taken", 0, 0);
+    }
+    if (setup->stall_ms && (busy == 0 || timeouts == 0)) {
+        violation("stalls produced no 503/504", busy, timeouts);
+    }
+
+    uint32_t m = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (reqs[i].kind != REQ_DATA && reqs[i].status == CONTROL_DONE) {
+            lat[m++] = reqs[i].latency_us;
+        }
+    }
+    uint32_t c50 = percentile(lat, m, 50), c99 = percentile(lat, m, 99);
+    for (uint32_t i = 0; i < n; i++) {
+        if (reqs[i].kind == REQ_DATA) {
+            lat[data++] = reqs[i].latency_us;
+        }
+    }
+    uint32_t d50 = percentile(lat, data, 50), d99 = percentile(lat, data, 99);
+    if (!setup->stall_ms && c99 > TARGET_P99_US) {
+        violation("control p99 over target (us)", c99, TARGET_P99_US);
+    }
+
+    printf("%-12s %7u %7.0f %8.2f %8.2f %8u %8.2f %8.2f %5u %5u %7u  %s\n", setup->name, (unsigned)n,
+           n / (elapsed_us / 1e6), d50 / 1000.0, d99 / 1000.0, (unsigned)controls, c50 / 1000.0, c99 / 1000.0,
+           (unsigned)busy, (unsigned)timeouts, (unsigned)dev.passes, s_violations == violations_before ? "ok" : "FAIL");
+    free(reqs);
+    free(lat);
+    s_id_base += n;
+    return s_violations - violations_before;
+}
+
+int main(int argc, char **argv)
+{
+    double rate = 300;
+    uint32_t seconds = 5;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--rate") == 0) {
+            rate = strtod(argv[i + 1], NULL);
+        } else if (strcmp(argv[i], "--seconds") == 0) {
+            seconds = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            s_rng = (uint32_t)strtoul(argv[i + 1], NULL, 10) | 1u;
+        } else {
+            fprintf(stderr, "usage: %s [--rate R] [--seconds S] [--seed S]\n", argv[0]);
+            return 2;
+        }
+    }
+    // 멈춤 구간(1 s, 3.5 s에서 1.5 s씩)이 들어가야 한다
+    if (rate <= 0 || seconds < 5) {
+        fprintf(stderr, "need --rate > 0 and --seconds >= 5\n");
+        return 2;
+    }
+    dlog_init(hal_millis);
+    for (int m = 0; m < DLOG_MOD_COUNT; m++) {
+        dlog_set_level((dlog_module_t)m, DLOG_NONE);
+    }
+    if (!control_handoff_init(&s_handoff)) {
+        return 2;
+    }
+
+    const setup_t setups[] = {
+        { "performance", 2, CONTROL_TIMEOUT_MS, 0, { 0, 0 } },
+        { "low-power", 250, CONTROL_TIMEOUT_MS, 0, { 0, 0 } },
+        { "loop stalls", 2, 100, 1500, { 1000, 3500 } },
+    };
+    printf("%-12s %7s %7s %8s %8s %8s %8s %8s %5s %5s %7s\n", "setup", "reqs", "req/s", "data p50", "data p99",
+           "control", "ctl p50", "ctl p99", "503", "504", "passes");
+    printf("%-12s %7s %7s %8s %8s %8s %8s %8s\n", "", "", "", "ms", "ms", "", "ms", "ms");
+    uint32_t violations = 0;
+    for (size_t i = 0; i < sizeof(setups) / sizeof(setups[0]); i++) {
+        violations += run(&setups[i], rate, seconds);
+    }
+    printf("%s (%u violations)\n", violations ? "FAIL" : "ok", (unsigned)violations);
+    return violations ? 1 : 0;
+}
@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+"""Measure /data traffic under N polling clients, per polling mode.
+
+Each client polls at a fixed interval for the given duration; the script
+reports response bytes/s (body + status line and headers) and the share of
+304s for every mode:
+
+    full   GET /data                      (what the app does today)
+    etag   GET /data + If-None-Match      (JSON, 304 while unchanged)
+    bin    GET /data?format=bin&since=V   (binary delta, 304 while unchanged)
+
+Against a device:
+    python3 data_feed_load.py --url http://192.168.0.50:8000 --clients 8
+On the host, against a built-in simulator that mirrors the firmware's /data
+semantics (state_feed.h) with a state change every --change-interval seconds:
+    python3 data_feed_load.py --simulate --clients 8 --duration 20
+"""
+import argparse
+import http.client
+import json
+import random
+import struct
+import threading
+import time
+import urllib.parse
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+MAGIC, FORMAT = 0xA7, 1
+FIELDS = [  # state_feed.h order: (name, struct code, scale)
+    ("pm25", "h", 10), ("pm10", "h", 10), ("pm25_outdoor", "h", 10), ("pm10_outdoor", "h", 10),
+    ("temperature", "h", 10), ("humidity", "h", 10), ("di", "h", 10),
+    ("flags", "B", 1), ("window_position", "B", 1), ("window_progress", "B", 1),
+    ("decision_reason", "b", 1),
+    ("cmd_count", "I", 1), ("cmd_latency_p50_ms", "I", 1), ("cmd_latency_p99_ms", "I", 1),
+]
+
+
+def decode_binary(body, state=None):
+    """Applies a binary full/delta reply to state (dict); returns (version, state)."""
+    magic, fmt, version, _uptime, mask = struct.unpack_from("<BBIIH", body)
+    if magic != MAGIC or fmt != FORMAT:
+        raise ValueError("not a state feed frame")
+    state = dict(state or {})
+    off = 12
+    for i, (name, code, scale) in enumerate(FIELDS):
+        if mask & (1 << i):
+            (v,) = struct.unpack_from("<" + code, body, off)
+            off += struct.calcsize(code)
+            state[name] = v / scale if scale != 1 else v
+    return version, state
+
+
+def encode_binary(version, cur, base):
+    mask, payload = 0, b""
+    for i, (name, code, _scale) in enumerate(FIELDS):
+        if base is None or base[name] != cur[name]:
+            mask |= 1 << i
+            payload += struct.pack("<" + code, cur[name])
+    return struct.pack("<BBIIH", MAGIC, FORMAT, version, int(time.monotonic() * 1000) & 0xFFFFFFFF, mask) + payload
+
+
+class Simulator:
+    """State that changes one reading every change_interval seconds, with history like the firmware."""
+
+    HISTORY = 8
+
+    def __init__(self, change_interval):
+        self.lock = threading.Lock()
+        self.version = random.getrandbits(31)
+        self.state = {name: 0 for name, _, _ in FIELDS}
+        self.state.update(pm25=123, pm10=301, temperature=231, humidity=455, di=702, flags=0x12)
+        self.history = {}
+        self.interval = change_interval
+        self.next_change = time.monotonic() + change_interval
+
+    def current(self):
+        with self.lock:
+            now = time.monotonic()
+            while now >= self.next_change:
+                self.history[self.version] = dict(self.state)
+                if len(self.history) > self.HISTORY:
+                    del self.history[min(self.history)]
+                self.state["pm25"] += random.choice((-3, 3))
+                self.version += 1
+                self.next_change += self.interval
+            return self.version, dict(self.state), dict(self.history)
+
+    def json_body(self, version, state):
+        doc = {k: (v / 10 if k in ("pm25", "pm10", "temperature", "humidity", "di") else v) for k, v in state.items()}
+        doc.update(version=version, pm_source="local", decision_reason="ventilation needed", heap_free=182344,
+                   heap_min_free=171200, heap_max_alloc=110580, heap_frag_pct=39, sensor_age_ms=812,
+                   timestamp=int(time.monotonic() * 1000))
+        return json.dumps(doc, separators=(",", ":")).encode()
+
+
+def serve(sim):
+    class Handler(BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"
+
+        def log_message(self, *args):
+            pass
+
+        def do_GET(self):
+            url = urllib.parse.urlsplit(self.path)
+            q = urllib.parse.parse_qs(url.query)
+            version, state, history = sim.current()
+            since = q.get("since", [None])[0] or self.headers.get("If-None-Match")
+            since = int(since.replace("W/", "").strip('"')) if since else None
+            self.send_response(304 if since == version else 200)
+            self.send_header("ETag", 'W/"%d"' % version)
+            self.send_header("Cache-Control", "no-cache")
+            if since == version:
+                self.send_header("Content-Length", "0")
+                self.end_headers()
+                return
+            if q.get("format", [""])[0] == "bin":
+                body, ctype = encode_binary(version, state, history.get(since)), "application/octet-stream"
+            else:
+                body, ctype = sim.json_body(version, state), "application/json"
+            self.send_header("Content-Type", ctype)
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+
+    server = ThreadingHTTPServer(("127.0.0.1", 0), Handler)
+    server.daemon_threads = True
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    return server
+
+
+def client(host, port, mode, interval, stop, totals, lock):
+    conn = http.client.HTTPConnection(host, port, timeout=10)
+    version, state, n, nbytes, not_modified, errors = None, None, 0, 0, 0, 0
+    next_poll = time.monotonic() + random.uniform(0, interval)
+    while not stop.is_set():
+        delay = next_poll - time.monotonic()
+        if delay > 0:
+            stop.wait(delay)
+            continue
+        next_poll += interval
+        path, headers = "/data", {}
+        if mode == "bin":
+            path = "/data?format=bin" + ("&since=%d" % version if version is not None else "")
+        elif mode == "etag" and version is not None:
+            headers["If-None-Match"] = 'W/"%d"' % version
+        try:
+            conn.request("GET", path, headers=headers)
+            resp = conn.getresponse()
+            body = resp.read()
+        except (OSError, http.client.HTTPException):
+            errors += 1
+            conn.close()
+            continue
+        n += 1
+        head = len("HTTP/1.1 %d %s\r\n" % (resp.status, resp.reason)) + sum(
+            len(k) + len(v) + 4 for k, v in resp.getheaders()) + 2
+        nbytes += head + len(body)
+        if resp.status == 304:
+            not_modified += 1
+        elif mode == "bin":
+            version, state = decode_binary(body, state)
+        else:
+            etag = resp.getheader("ETag")
+            version = int(etag.replace("W/", "").strip('"')) if etag else None
+    with lock:
+        for k, v in (("requests", n), ("bytes", nbytes), ("not_modified", not_modified), ("errors", errors)):
+            totals[k] += v
+
+
+def run(host, port, mode, clients, interval, duration):
+    stop, lock = threading.Event(), threading.Lock()
+    totals = {"requests": 0, "bytes": 0, "not_modified": 0, "errors": 0}
+    threads = [threading.Thread(target=client, args=(host, port, mode, interval, stop, totals, lock))
+               for _ in range(clients)]
+    for t in threads:
+        t.start()
+    time.sleep(duration)
+    stop.set()
+    for t in threads:
+        t.join()
+    return totals
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--url", help="device base URL, e.g. http://192.168.0.50:8000")
+    ap.add_argument("--simulate", action="store_true", help="poll a local simulator instead of a device")
+    ap.add_argument("--change-interval", type=float, default=10.0, help="simulator: seconds between state changes")
+    ap.add_argument("--clients", type=int, default=4)
+    ap.add_argument("--interval", type=float, default=1.0, help="seconds between polls per client")
+    ap.add_argument("--duration", type=float, default=15.0, help="seconds per mode")
+    ap.add_argument("--mode", action="append", choices=("full", "etag", "bin"), help="repeatable; default all")
+    args = ap.parse_args()
+
+    if args.simulate:
+        server = serve(Simulator(args.change_interval))
+        host, port = server.server_address
+    elif args.url:
+        u = urllib.parse.urlsplit(args.url)
+        host, port = u.hostname, u.port or 80
+    else:
+        ap.error("--url or --simulate is required")
+
+    print("%-5s %8s %10s %10s %6s %6s" % ("mode", "requests", "bytes/s", "B/request", "304%", "errors"))
+    for mode in args.mode or ["full", "etag", "bin"]:
+        t = run(host, port, mode, args.clients, args.interval, args.duration)
+        req = max(t["requests"], 1)
+        print("%-5s %8d %10.0f %10.1f %5.1f%% %6d" % (
+            mode, t["requests"], t["bytes"] / args.duration, t["bytes"] / req,
+            100.0 * t["not_modified"] / req, t["errors"]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,308 @@
+// Host trace replay of the window decision engine.
+//
+// Replays sensor traces through decision_engine.c with air_app.c's rule table and
+// dwell time, the way task_decide does (one evaluation per changed reading),
+// and compares it with the same rules applied without hysteresis or dwell,
+// which is what the thresholds did before the engine. Traces are either
+// recorded CSV files (--trace) or synthetic days: PM2.5/PM10 drifting around
+// their thresholds with sensor noise, a day/night temperature and humidity
+// cycle that takes the discomfort index across its threshold, and SHT31
+// dropouts. Checks:
+//   - two window moves are never closer than the dwell time
+//   - once the inputs have been clear of every hysteresis band and the plain
+//     rules have agreed for a whole dwell time, the engine agrees with them
+//   - the engine never moves the window more often than the plain rules
+// Prints the window moves per day of both. Exit 1 on any violation.
+//
+// Trace CSV: one reading per line, "seconds,pm25,pm10,temperature,humidity";
+// an empty temperature/humidity field is an SHT31 read failure. Lines
+// starting with '#' are skipped.
+//
+//   cc -std=gnu11 -O2 -I.. -o decision_replay decision_replay.c ../decision_engine.c -lm
+//   ./decision_replay                     # 50 synthetic days
+//   ./decision_replay --days 2000 --seed 7
+//   ./decision_replay --trace balcony.csv
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "decision_engine.h"
+
+// air_app.c와 같은 값
+static const uint32_t DECISION_MIN_DWELL_MS = 120000;
+static const de_rule_t DECISION_RULES[] = {
+    { "pm25 bad", DE_INPUT_PM25, DE_ABOVE, 35.0f, 5.0f, DE_WINDOW_CLOSE, false },
+    { "pm10 bad", DE_INPUT_PM10, DE_ABOVE, 80.0f, 10.0f, DE_WINDOW_CLOSE, false },
+    { "di comfortable", DE_INPUT_DI, DE_BELOW, 76.0f, 1.0f, DE_WINDOW_CLOSE, true },
+};
+#define RULE_COUNT (sizeof(DECISION_RULES) / sizeof(DECISION_RULES[0]))
+
+static float di_calculation(float temp, float hum)
+{
+    return 0.81f * temp + 0.01f * hum * (0.99f * temp - 14.3f) + 46.3f;
+}
+
+static uint32_t s_rng = 1;
+
+static uint32_t rnd(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static double rnd_unit(void)
+{
+    return ((double)(rnd() % 1000000) + 0.5) / 1000000.0;
+}
+
+// 표준 정규분포 (Box-Muller)
+static double rnd_normal(void)
+{
+    return sqrt(-2.0 * log(rnd_unit())) * cos(2.0 * M_PI * rnd_unit());
+}
+
+static uint32_t s_violations;
+
+static void violation(const char *what, unsigned long a, unsigned long b)
+{
+    if (s_violations++ < 20) {
+        fprintf(stderr, "violation: %s (%lu, %lu)\n", what, a, b);
+    }
+}
+
+typedef struct {
+    uint32_t t_ms;
+    float pm25;
+    float pm10;
+    float temperature;
+    float humidity;
+    bool env_valid;
+} reading_t;
+
+// 히스테리시스 없는 규칙 (첫 번째 활성 규칙의 동작, 없으면 열기)
+static de_action_t plain_rules(const de_inputs_t *in)
+{
+    for (size_t i = 0; i < RULE_COUNT; i++) {
+        const de_rule_t *r = &DECISION_RULES[i];
+        bool active;
+        if (!in->valid[r->input]) {
+            active = r->active_when_missing;
+        } else if (r->compare == DE_ABOVE) {
+            active = in->value[r->input] > r->threshold;
+        } else {
+            active = in->value[r->input] < r->threshold;
+        }
+        if (active) {
+            return r->action;
+        }
+    }
+    return DE_WINDOW_OPEN;
+}
+
+// 모든 입력이 히스테리시스 밴드 밖이라 래치 상태가 이력과 무관하게 정해지는지
+static bool clear_of_bands(const de_inputs_t *in)
+{
+    for (size_t i = 0; i < RULE_COUNT; i++) {
+        const de_rule_t *r = &DECISION_RULES[i];
+        if (!in->valid[r->input]) {
+            continue;
+        }
+        float v = in->value[r->input];
+        float lo = r->compare == DE_ABOVE ? r->threshold - r->hysteresis : r->threshold;
+        float hi = r->compare == DE_ABOVE ? r->threshold : r->threshold + r->hysteresis;
+        if (v >= lo && v <= hi) {
+            return false;
+        }
+    }
+    return true;
+}
+
+typedef struct {
+    uint32_t engine_moves;
+    uint32_t plain_moves;
+    uint32_t seconds;
+} replay_t;
+
+// readings를 task_decide처럼 재생한다 (값이 바뀐 샘플마다 평가)
+static void replay(const reading_t *rd, size_t n, replay_t *out)
+{
+    decision_engine_t e;
+    decision_engine_init(&e, DECISION_RULES, RULE_COUNT, DE_WINDOW_OPEN, "default", DECISION_MIN_DWELL_MS);
+    bool has_plain = false;
+    de_action_t plain = DE_WINDOW_OPEN;
+    uint32_t last_move_ms = 0, steady_since_ms = 0;
+    bool moved = false;
+    memset(out, 0, sizeof(*out));
+
+    for (size_t i = 0; i < n; i++) {
+        de_inputs_t in;
+        in.value[DE_INPUT_PM25] = rd[i].pm25;
+        in.valid[DE_INPUT_PM25] = true;
+        in.value[DE_INPUT_PM10] = rd[i].pm10;
+        in.valid[DE_INPUT_PM10] = true;
+        in.value[DE_INPUT_DI] = rd[i].env_valid ? di_calculation(rd[i].temperature, rd[i].humidity) : 0.0f;
+        in.valid[DE_INPUT_DI] = rd[i].env_valid;
+        uint32_t now = rd[i].t_ms;
+
+        // 처음 출력은 이동으로 세지 않는다 (부팅 시 위치 잡기)
+        bool first = !e.has_output;
+        if (decision_engine_evaluate(&e, &in, now, false) && !first) {
+            if (moved && now - last_move_ms < DECISION_MIN_DWELL_MS) {
+                violation("moves closer than the dwell time (ms)", now - last_move_ms, DECISION_MIN_DWELL_MS);
+            }
+            moved = true;
+            last_move_ms = now;
+            out->engine_moves++;
+        }
+
+        de_action_t p = plain_rules(&in);
+        if (has_plain && p != plain) {
+            out->plain_moves++;
+        }
+        if (!has_plain || p != plain || !clear_of_bands(&in)) {
+            steady_since_ms = now;
+        }
+        has_plain = true;
+        plain = p;
+        // 밴드 밖에서 dwell 이상 같은 결론이면 엔진도 같아야 한다
+        if (now - steady_since_ms > DECISION_MIN_DWELL_MS && e.output != plain) {
+            violation("engine disagrees with settled inputs (s)", now / 1000, e.output);
+            steady_since_ms = now;
+        }
+    }
+    out->seconds = n > 0 ? (rd[n - 1].t_ms - rd[0].t_ms) / 1000 + 1 : 0;
+}
+
+// ---------- Synthetic day ----------
+#define DAY_S 86400
+
+static size_t synthetic_day(reading_t *rd)
+{
+    // PM: 임계값 근처를 떠도는 느린 변화 + 센서 잡음 (PMS5003 10프레임 평균 후에도 남는 정도)
+    double pm25 = 20 + rnd() % 30, pm10 = 50 + rnd() % 50;
+    double drift25 = 0, drift10 = 0;
+    double t_peak = 14 + (rnd() % 40) / 10.0, t_mean = 24 + (rnd() % 60) / 10.0, t_amp = 3 + (rnd() % 30) / 10.0;
+    uint32_t dropout_until = 0;
+    for (uint32_t s = 0; s < DAY_S; s++) {
+        drift25 = drift25 * 0.999 + rnd_normal() * 0.05;
+        drift10 = drift10 * 0.999 + rnd_normal() * 0.08;
+        pm25 += drift25 * 0.1 + (32 - pm25) * 0.0005;
+        pm10 += drift10 * 0.1 + (75 - pm10) * 0.0005;
+        double hour = s / 3600.0;
+        double temp = t_mean + t_amp * cos((hour - t_peak) / 24.0 * 2 * M_PI);
+        double hum = 60 - 1.5 * (temp - t_mean);
+
+        reading_t *r = &rd[s];
+        r->t_ms = s * 1000u;
+        r->pm25 = (float)fmax(0, pm25 + rnd_normal() * 1.5);
+        r->pm10 = (float)fmax(0, pm10 + rnd_normal() * 3.0);
+        if (dropout_until <= s && rnd() % 20000 == 0) {
+            dropout_until = s + 30 + rnd() % 300;
+        }
+        r->env_valid = s >= dropout_until;
+        r->temperature = (float)(temp + rnd_normal() * 0.15);
+        r->humidity = (float)(hum + rnd_normal() * 0.8);
+    }
+    return DAY_S;
+}
+
+// ---------- Recorded trace ----------
+static size_t load_trace(const char *path, reading_t *rd, size_t cap)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return 0;
+    }
+    char line[256];
+    size_t n = 0;
+    while (n < cap && fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        char *fields[5] = { 0 };
+        char *p = line;
+        for (int k = 0; k < 5 && p; k++) {
+            fields[k] = p;
+            p = strchr(p, ',');
+            if (p) {
+                *p++ = '\0';
+            }
+        }
+        if (fields[2] == NULL) {
+            continue;
+        }
+        reading_t *r = &rd[n++];
+        r->t_ms = (uint32_t)(strtod(fields[0], NULL) * 1000.0);
+        r->pm25 = strtof(fields[1], NULL);
+        r->pm10 = strtof(fields[2], NULL);
+        r->env_valid = fields[3] && fields[4] && *fields[3] && *fields[3] != '\n' && *fields[4] &&
+                       *fields[4] != '\n';
+        r->temperature = r->env_valid ? strtof(fields[3], NULL) : 0;
+        r->humidity = r->env_valid ? strtof(fields[4], NULL) : 0;
+    }
+    fclose(f);
+    return n;
+}
+
+static void report(const char *name, const replay_t *r)
+{
+    double days = r->seconds / (double)DAY_S;
+    printf("%-24s %8.2f %12.1f %12.1f\n", name, days, r->engine_moves / days, r->plain_moves / days);
+    if (r->engine_moves > r->plain_moves) {
+        violation("engine moved more than the plain rules", r->engine_moves, r->plain_moves);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static reading_t rd[DAY_S * 8];
+    uint32_t days = 50;
+    const char *trace = NULL;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--days") == 0) {
+            days = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            s_rng = (uint32_t)strtoul(argv[i + 1], NULL, 10) | 1u;
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            trace = argv[i + 1];
+        } else {
+            fprintf(stderr, "usage: %s [--days N] [--seed S] [--trace FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf("%-24s %8s %12s %12s\n", "trace", "days", "engine/day", "plain/day");
+    replay_t r;
+    if (trace) {
+        size_t n = load_trace(trace, rd, sizeof(rd) / sizeof(rd[0]));
+        if (n == 0) {
+            return 2;
+        }
+        replay(rd, n, &r);
+        report(trace, &r);
+    } else {
+        replay_t total = { 0, 0, 0 };
+        uint32_t worst = 0;
+        for (uint32_t d = 0; d < days; d++) {
+            size_t n = synthetic_day(rd);
+            replay(rd, n, &r);
+            total.engine_moves += r.engine_moves;
+            total.plain_moves += r.plain_moves;
+            total.seconds += r.seconds;
+            if (r.engine_moves > worst) {
+                worst = r.engine_moves;
+            }
+            if (r.engine_moves > r.plain_moves) {
+                violation("engine moved more than the plain rules", r.engine_moves, r.plain_moves);
+            }
+        }
+        report("synthetic", &total);
+        printf("worst synthetic day: %u engine moves\n", (unsigned)worst);
+    }
+    printf("%s (%u violations)\n", s_violations ? "FAIL" : "ok", (unsigned)s_violations);
+    return s_violations ? 1 : 0;
+}
@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""Decode binary log frames (firmware built with -DAIR_LOG_BINARY=1).
+
+Each frame carries the address of its format string instead of the text, so
+the firmware ELF is needed to turn frames back into lines. %s arguments are
+addresses of static strings and are resolved the same way.
+
+    python3 dlog_decode.py build/air.ino.elf /dev/ttyUSB0
+    python3 dlog_decode.py build/air.ino.elf capture.bin --level W --module NET
+
+Frame layout (little endian, see dlog.h):
+    A5 5A len | ts u32 | fmt u32 | module << 4 | level | nargs | args u32 x nargs
+"""
+import argparse
+import re
+import struct
+import sys
+
+LEVELS = "-EWID"
+MODULES = ["SYS", "NET", "HTTP", "CTRL", "SENSOR", "CMD"]
+SPEC = re.compile(r"%([-+ #0-9.]*)(hh|h|ll|l|z|j|t|L)?([diouxXcsfFeEgGp%])")
+
+
+class Strings:
+    """Reads NUL-terminated strings out of the allocated sections of an ELF."""
+
+    def __init__(self, path):
+        self._sections = []
+        with open(path, "rb") as f:
+            elf = f.read()
+        if elf[:4] != b"\x7fELF":
+            raise SystemExit("%s: not an ELF file" % path)
+        # section headers only, so no pyelftools: 32/64-bit, either byte order
+        wide, order = elf[4] == 2, "<" if elf[5] == 1 else ">"
+        if wide:
+            shoff, = struct.unpack_from(order + "Q", elf, 0x28)
+            shentsize, shnum = struct.unpack_from(order + "HH", elf, 0x3A)
+            header = order + "IIQQQQ"
+        else:
+            shoff, = struct.unpack_from(order + "I", elf, 0x20)
+            shentsize, shnum = struct.unpack_from(order + "HH", elf, 0x2E)
+            header = order + "IIIIII"
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = struct.unpack_from(header, elf, shoff + i * shentsize)
+            if flags & 0x2 and sh_type == 1 and size:  # SHF_ALLOC, SHT_PROGBITS
+                self._sections.append((addr, elf[offset:offset + size]))
+        self._cache = {}
+
+    def get(self, addr):
+        if addr in self._cache:
+            return self._cache[addr]
+        text = None
+        for base, data in self._sections:
+            if base <= addr < base + len(data):
+                end = data.find(b"\0", addr - base)
+                text = data[addr - base:end if end >= 0 else len(data)].decode("utf-8", "replace")
+                break
+        self._cache[addr] = text
+        return text
+
+
+def render(fmt, args, strings):
+    it = iter(args)
+
+    def one(m):
+        flags, _, conv = m.groups()
+        if conv == "%":
+            return "%"
+        raw = next(it, 0)
+        if conv in "fFeEgG":
+            return ("%" + flags + conv) % struct.unpack("<f", struct.pack("<I", raw))[0]
+        if conv == "s":
+            s = strings.get(raw)
+            return ("%" + flags + "s") % (s if s is not None else "<0x%08x>" % raw)
+        if conv == "p":
+            return "0x%08x" % raw
+        if conv in "di":
+            raw = raw - (1 << 32) if raw & 0x80000000 else raw
+            conv = "d"
+        return ("%" + flags + conv) % raw
+
+    return SPEC.sub(one, fmt)
+
+
+def frames(stream):
+    """Yields (ts, fmt_addr, module, level, args); resyncs on the A5 5A marker."""
+    buf = b""
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            return
+        buf += chunk
+        while True:
+            start = buf.find(b"\xa5\x5a")
+            if start < 0:
+                buf = buf[-1:]
+                break
+            if len(buf) < start + 3:
+                buf = buf[start:]
+                break
+            size = buf[start + 2]
+            end = start + 3 + size
+            if len(buf) < end:
+                buf = buf[start:]
+                break
+            body = buf[start + 3:end]
+            buf = buf[end:]
+            if size < 10:
+                continue
+            ts, fmt, modlvl, nargs = struct.unpack_from("<IIBB", body)
+            if size != 10 + 4 * nargs:
+                continue
+            args = struct.unpack_from("<%dI" % nargs, body, 10)
+            yield ts, fmt, modlvl >> 4, modlvl & 0x0F, args
+
+
+def open_source(src, baud):
+    if src == "-":
+        return sys.stdin.buffer
+    if src.startswith("/dev/") or src.upper().startswith("COM"):
+        import serial  # pyserial
+
+        return serial.Serial(src, baud, timeout=1)
+    return open(src, "rb")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("elf", help="firmware ELF matching the running build")
+    ap.add_argument("source", help="serial port, capture file, or - for stdin")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--level", default="D", choices=list("EWID"), help="most verbose level to print")
+    ap.add_argument("--module", action="append", choices=MODULES, help="only these modules (repeatable)")
+    args = ap.parse_args()
+
+    strings = Strings(args.elf)
+    max_level = LEVELS.index(args.level)
+    stream = open_source(args.source, args.baud)
+    for ts, fmt_addr, module, level, fargs in frames(stream):
+        mod = MODULES[module] if module < len(MODULES) else "?"
+        if level > max_level or (args.module and mod not in args.module):
+            continue
+        fmt = strings.get(fmt_addr)
+        text = render(fmt, fargs, strings) if fmt is not None else "<unknown format 0x%08x> %r" % (fmt_addr, fargs)
+        lvl = LEVELS[level] if level < len(LEVELS) else "?"
+        print("[%8d] %s %-6s %s" % (ts, lvl, mod, text), flush=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,220 @@
+// Host unit test of the deferred log ring (dlog.c) and its binary frames.
+//
+// On a fake clock that ticks once per record, checks that:
+//   - the ring keeps order while its indices wrap many times around
+//     DLOG_RING_SIZE
+//   - writing into a full ring drops the new records and counts each one in
+//     dlog_dropped(); the records already queued are untouched and writing
+//     works again once the consumer catches up
+//   - DLOG_NARGS() counts the arguments DLOG_AT() checks against DLOG_MAX_ARGS
+//     (at compile time)
+//   - dlog_set_level() filters per module, and levels above DLOG_LEVEL are
+//     compiled out whatever the runtime level (Release builds: WARN)
+//   - dlog_format() renders the integer, float, %s, %% and %x conversions
+//     and truncates to the buffer
+//   - frames from dlog_encode(), decoded by tools/dlog_decode.py with this
+//     executable as the ELF, give the same lines as dlog_format(). The target
+//     is linked without PIE so the format addresses fit the 32-bit frame
+//     fields, as on the ESP32.
+// Exit 1 on the first mismatch.
+//
+//   cc -std=gnu11 -O2 -fno-pie -no-pie -I.. -DDLOG_DECODE_PY='"dlog_decode.py"' -o dlog_test dlog_test.c ../dlog.c
+//   ./dlog_test
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "dlog.h"
+
+#ifndef DLOG_DECODE_PY
+#define DLOG_DECODE_PY "tools/dlog_decode.py"
+#endif
+
+_Static_assert(DLOG_NARGS() == 0 && DLOG_NARGS(1) == 1 && DLOG_NARGS(f(1, 2), "a,b") == 2 &&
+               DLOG_NARGS(1, 2, 3, 4, 5, 6, 7) == 7, "DLOG_NARGS");
+
+static uint32_t s_clock;
+static int s_failures;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        s_failures++;
+    }
+}
+
+static uint32_t tick_clock(void)
+{
+    return s_clock++;
+}
+
+static void reset(void)
+{
+    dlog_init(tick_clock);
+    for (int m = 0; m < DLOG_MOD_COUNT; m++) {
+        dlog_set_level((dlog_module_t)m, DLOG_DEBUG);
+    }
+}
+
+static void test_ring(void)
+{
+    reset();
+    dlog_record_t r;
+    check(!dlog_pop(&r), "empty ring");
+
+    // 인덱스가 링을 여러 번 돈다: 반쯤 채우고 비우기를 반복
+    uint32_t written = 0, read = 0;
+    bool ordered = true;
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < DLOG_RING_SIZE / 2 + 3; i++) {
+            dlog_write(DLOG_MOD_SYS, DLOG_WARN, "record %u", (unsigned)written++);
+        }
+        while (dlog_pop(&r)) {
+            ordered = ordered && r.nargs == 1 && r.args[0] == read;
+            read++;
+        }
+    }
+    check(ordered && read == written && dlog_dropped() == 0, "order kept across wraps");
+
+    // 가득 찬 링: 새 기록을 버리고 센다
+    for (uint32_t i = 0; i < DLOG_RING_SIZE + 10; i++) {
+        dlog_write(DLOG_MOD_NET, DLOG_ERROR, "overrun %u", (unsigned)i);
+    }
+    check(dlog_dropped() == 10, "overrun counted");
+    uint32_t n = 0;
+    ordered = true;
+    while (dlog_pop(&r)) {
+        ordered = ordered && r.args[0] == n;
+        n++;
+    }
+    check(ordered && n == DLOG_RING_SIZE, "queued records kept on overrun");
+    dlog_write(DLOG_MOD_NET, DLOG_ERROR, "after %u", 1u);
+    check(dlog_pop(&r) && r.args[0] == 1 && dlog_dropped() == 10, "writes again after the consumer caught up");
+}
+
+static void test_levels(void)
+{
+    reset();
+    dlog_record_t r;
+    dlog_set_level(DLOG_MOD_NET, DLOG_ERROR);
+    DLOG_W(NET, "filtered");
+    DLOG_E(NET, "kept");
+    DLOG_W(CTRL, "other module");
+    check(dlog_pop(&r) && strcmp(r.fmt, "kept") == 0 && r.module == DLOG_MOD_NET && r.level == DLOG_ERROR,
+          "module level filters");
+    check(dlog_pop(&r) && strcmp(r.fmt, "other module") == 0, "other module unaffected");
+
+    dlog_set_level(DLOG_MOD_NET, DLOG_NONE);
+    DLOG_E(NET, "off");
+    check(!dlog_pop(&r), "DLOG_NONE drops errors");
+
+    DLOG_I(SYS, "info");
+    DLOG_D(SYS, "debug");
+    int got = 0;
+    while (dlog_pop(&r)) {
+        got++;
+    }
+    int want = (DLOG_LEVEL >= DLOG_INFO) + (DLOG_LEVEL >= DLOG_DEBUG);
+    check(got == want, "compile-time level");
+}
+
+// 같은 기록 목록으로 format과 디코더 출력을 비교한다
+static const char LABEL[] = "pump";
+
+static void write_samples(void)
+{
+    dlog_write(DLOG_MOD_SYS, DLOG_ERROR, "boot %u, reset reason %d", 3u, -2);
+    dlog_write(DLOG_MOD_NET, DLOG_WARN, "rssi %d dBm, retry in %u ms", -71, 4000u);
+    dlog_write(DLOG_MOD_HTTP, DLOG_INFO, "100%% of %s done", "requests");
+    dlog_write(DLOG_MOD_CTRL, DLOG_WARN, "%s at %.1f C / %.2f %%", LABEL, 21.5, 48.25);
+    dlog_write(DLOG_MOD_SENSOR, DLOG_DEBUG, "crc 0x%02x != 0x%02X", 0x5au, 0xc3u);
+    dlog_write(DLOG_MOD_CMD, DLOG_ERROR, "%-8s|%5d|%-4u|", "queue", 42, 7u);
+}
+
+static void test_format(void)
+{
+    reset();
+    s_clock = 123456;
+    write_samples();
+    static const char *const expect[] = {
+        "[  123456] E SYS    boot 3, reset reason -2\n",
+        "[  123457] W NET    rssi -71 dBm, retry in 4000 ms\n",
+        "[  123458] I HTTP   100% of requests done\n",
+        "[  123459] W CTRL   pump at 21.5 C / 48.25 %\n",
+        "[  123460] D SENSOR crc 0x5a != 0xC3\n",
+        "[  123461] E CMD    queue   |   42|7   |\n",
+    };
+    dlog_record_t r;
+    char line[128];
+    for (size_t i = 0; i < sizeof(expect) / sizeof(expect[0]); i++) {
+        check(dlog_pop(&r) && dlog_format(&r, line, sizeof(line)) == (int)strlen(expect[i]) &&
+              strcmp(line, expect[i]) == 0, expect[i]);
+    }
+
+    dlog_write(DLOG_MOD_SYS, DLOG_ERROR, "a long message %u", 12345u);
+    check(dlog_pop(&r) && dlog_format(&r, line, 24) == 23 && strcmp(line, "[  123462] E SYS    a \n") == 0,
+          "truncated to the buffer");
+}
+
+static void test_decode(const char *self)
+{
+    char bin[] = "/tmp/dlog_test_XXXXXX";
+    int fd = mkstemp(bin);
+    if (fd < 0) {
+        check(false, "temp file");
+        return;
+    }
+    FILE *f = fdopen(fd, "wb");
+    reset();
+    s_clock = 4000000000u;
+    write_samples();
+
+    char expect[1024] = "";
+    dlog_record_t r;
+    uint8_t frame[DLOG_FRAME_MAX];
+    char line[128];
+    while (dlog_pop(&r)) {
+        int n = dlog_encode(&r, frame, sizeof(frame));
+        check(n > 0 && fwrite(frame, 1, (size_t)n, f) == (size_t)n, "encode");
+        fputs("noise\n", f);    // 디코더는 A5 5A에서 다시 맞춘다
+        dlog_format(&r, line, sizeof(line));
+        strncat(expect, line, sizeof(expect) - strlen(expect) - 1);
+    }
+    fclose(f);
+
+    char cmd[1024], got[1024];
+    snprintf(cmd, sizeof(cmd), "python3 %s %s %s", DLOG_DECODE_PY, self, bin);
+    FILE *p = popen(cmd, "r");
+    size_t len = p ? fread(got, 1, sizeof(got) - 1, p) : 0;
+    got[len] = '\0';
+    int status = p ? pclose(p) : -1;
+    unlink(bin);
+    if (status != 0) {
+        printf("FAIL: %s exited with %d\n", cmd, status);
+        s_failures++;
+        return;
+    }
+    if (strcmp(got, expect) != 0) {
+        printf("FAIL: decoded frames differ\n--- dlog_format\n%s--- dlog_decode.py\n%s", expect, got);
+        s_failures++;
+    }
+}
+
+int main(void)
+{
+    char self[512];
+    ssize_t n = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (n <= 0) {
+        return 2;
+    }
+    self[n] = '\0';
+
+    test_ring();
+    test_levels();
+    test_format();
+    test_decode(self);
+    printf("%s\n", s_failures ? "FAIL" : "ok");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,231 @@
+// In-process stand-in for ESP-IDF's esp_http_client; see http_client_stub.h.
+#include "http_client_stub.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BODY_CHUNK 5        // ON_DATA 한 번에 넘기는 바이트 수
+
+struct esp_http_client {
+    esp_http_client_config_t config;
+    char url[160];
+    esp_http_client_method_t method;
+    int timeout_ms;
+    char content_type[48];
+    const char *post;
+    int post_len;
+    bool connected;
+    int status;
+};
+
+static http_client_stub_stats_t s_stats;
+static http_client_stub_request_t s_last;
+static bool s_have_last;
+
+// 다음 응답
+static int s_status = 200;
+static char s_body[256];
+static bool s_close;
+static esp_err_t s_fail;
+static bool s_dropped;
+static bool s_refuse_init;
+
+void http_client_stub_respond(int status, const char *body, bool close)
+{
+    s_status = status;
+    snprintf(s_body, sizeof(s_body), "%s", body ? body : "");
+    s_close = close;
+}
+
+void http_client_stub_fail_next(esp_err_t err)
+{
+    s_fail = err;
+}
+
+void http_client_stub_drop(void)
+{
+    s_dropped = true;
+}
+
+void http_client_stub_refuse_init(bool refuse)
+{
+    s_refuse_init = refuse;
+}
+
+bool http_client_stub_last(http_client_stub_request_t *out)
+{
+    *out = s_last;
+    return s_have_last;
+}
+
+void http_client_stub_get_stats(http_client_stub_stats_t *out)
+{
+    *out = s_stats;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_HTTP_CONNECT:
+        return "ESP_ERR_HTTP_CONNECT";
+    case ESP_ERR_HTTP_WRITE_DATA:
+        return "ESP_ERR_HTTP_WRITE_DATA";
+    case ESP_ERR_HTTP_FETCH_HEADER:
+        return "ESP_ERR_HTTP_FETCH_HEADER";
+    case ESP_ERR_HTTP_CONNECTION_CLOSED:
+        return "ESP_ERR_HTTP_CONNECTION_CLOSED";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
+
+static void emit(esp_http_client_handle_t c, esp_http_client_event_id_t id, const char *data, int len)
+{
+    if (c->config.event_handler == NULL) {
+        return;
+    }
+    esp_http_client_event_t evt = {
+        .event_id = id,
+        .client = c,
+        .data = (void *)data,
+        .data_len = len,
+        .user_data = c->config.user_data,
+    };
+    c->config.event_handler(&evt);
+}
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config)
+{
+    if (s_refuse_init || config->url == NULL) {
+        return NULL;
+    }
+    esp_http_client_handle_t c = calloc(1, sizeof(*c));
+    if (c == NULL) {
+        return NULL;
+    }
+    c->config = *config;
+    snprintf(c->url, sizeof(c->url), "%s", config->url);
+    c->timeout_ms = config->timeout_ms;
+    s_stats.inits++;
+    return c;
+}
+
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *url)
+{
+    snprintf(client->url, sizeof(client->url), "%s", url);
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_method(esp_http_client_handle_t client, esp_http_client_method_t method)
+{
+    client->method = method;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_timeout_ms(esp_http_client_handle_t client, int timeout_ms)
+{
+    client->timeout_ms = timeout_ms;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char *key, const char *value)
+{
+    if (strcmp(key, "Content-Type") == 0) {
+        snprintf(client->content_type, sizeof(client->content_type), "%s", value ? value : "");
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_delete_header(esp_http_client_handle_t client, const char *key)
+{
+    if (strcmp(key, "Content-Type") == 0) {
+        client->content_type[0] = '\0';
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_post_field(esp_http_client_handle_t client, const char *data, int len)
+{
+    client->post = data;
+    client->post_len = data ? len : 0;
+    return ESP_OK;
+}
+
+static void disconnect(esp_http_client_handle_t c)
+{
+    if (c->connected) {
+        c->connected = false;
+        emit(c, HTTP_EVENT_DISCONNECTED, NULL, 0);
+    }
+}
+
+esp_err_t esp_http_client_perform(esp_http_client_handle_t client)
+{
+    s_stats.performs++;
+    client->status = 0;
+    if (client->connected && s_dropped) {
+        // 요청은 소켓에 써지지만 응답 대신 FIN이 온다
+        s_dropped = false;
+        disconnect(client);
+        return ESP_ERR_HTTP_FETCH_HEADER;
+    }
+    s_dropped = false;
+    if (s_fail != ESP_OK) {
+        esp_err_t err = s_fail;
+        s_fail = ESP_OK;
+        emit(client, HTTP_EVENT_ERROR, NULL, 0);
+        disconnect(client);
+        return err;
+    }
+    if (!client->connected) {
+        client->connected = true;
+        s_stats.connects++;
+        emit(client, HTTP_EVENT_ON_CONNECTED, NULL, 0);
+    }
+
+    // 서버가 받은 요청
+    s_last.method = client->method;
+    snprintf(s_last.url, sizeof(s_last.url), "%s", client->url);
+    snprintf(s_last.content_type, sizeof(s_last.content_type), "%s", client->content_type);
+    s_last.body_len = client->post_len < (int)sizeof(s_last.body) ? client->post_len : (int)sizeof(s_last.body) - 1;
+    memcpy(s_last.body, client->post ? client->post : "", (size_t)s_last.body_len);
+    s_last.body[s_last.body_len] = '\0';
+    s_last.timeout_ms = client->timeout_ms;
+    s_have_last = true;
+
+    emit(client, HTTP_EVENT_HEADERS_SENT, NULL, 0);
+    client->status = s_status;
+    int len = (int)strlen(s_body);
+    for (int off = 0; off < len; off += BODY_CHUNK) {
+        emit(client, HTTP_EVENT_ON_DATA, s_body + off, len - off < BODY_CHUNK ? len - off : BODY_CHUNK);
+    }
+    emit(client, HTTP_EVENT_ON_FINISH, NULL, 0);
+    if (s_close || !client->config.keep_alive_enable) {
+        disconnect(client);
+    }
+    http_client_stub_respond(200, "", false);
+    return ESP_OK;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client)
+{
+    return client->status;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
+{
+    if (client == NULL) {
+        return ESP_FAIL;
+    }
+    disconnect(client);
+    free(client);
+    s_stats.cleanups++;
+    return ESP_OK;
+}
@@ -0,0 +1,47 @@
+// In-process stand-in for ESP-IDF's esp_http_client (tools/idf_stub/esp_http_client.h)
+// so that esp_http_session.c runs on the host.
+//
+// One scripted server behind every handle: a connection is opened on the first
+// perform() (HTTP_EVENT_ON_CONNECTED) and kept while the responses allow it,
+// response bodies arrive as several HTTP_EVENT_ON_DATA chunks, and faults can
+// be injected: a failed request, a server that closed the idle connection, an
+// init that fails. The last request as the server saw it is kept for checks.
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_http_client.h"
+
+typedef struct {
+    esp_http_client_method_t method;
+    char url[160];
+    char content_type[48];      // 헤더가 없으면 ""
+    char body[256];
+    int body_len;
+    int timeout_ms;
+} http_client_stub_request_t;
+
+typedef struct {
+    uint32_t inits;
+    uint32_t cleanups;
+    uint32_t connects;          // 새로 연 연결
+    uint32_t performs;
+} http_client_stub_stats_t;
+
+// 다음 요청의 응답. close면 응답 후 서버가 연결을 닫는다 (Connection: close). 기본은 200, 빈 본문.
+void http_client_stub_respond(int status, const char *body, bool close);
+
+// 다음 요청이 err로 실패하고 연결이 끊긴다
+void http_client_stub_fail_next(esp_err_t err);
+
+// 서버가 유휴 연결을 닫았다: 그 연결로 보내는 다음 요청은 응답 헤더를 받지 못한다
+void http_client_stub_drop(void);
+
+// true면 esp_http_client_init()이 NULL을 반환한다
+void http_client_stub_refuse_init(bool refuse);
+
+// 마지막으로 서버에 도착한 요청. 아직 없으면 false.
+bool http_client_stub_last(http_client_stub_request_t *out);
+
+void http_client_stub_get_stats(http_client_stub_stats_t *out);
@@ -0,0 +1,311 @@
+// Host test of the keep-alive HTTP session against a local stub server.
+//
+// Runs telemetry cycles (POST a sample, then GET the command poll, as with
+// AIR_POLL_AFTER_POST) through hal_http_request() from hal_posix.c, the host
+// twin of the ESP32 esp_http_session, against an in-process stub HTTP/1.1
+// server on 127.0.0.1. Counts the TCP connections the server accepts per 1000
+// cycles in three setups:
+//   - close:     the server answers every request with Connection: close, the
+//                cost of the old init/perform/cleanup per request (2 per cycle)
+//   - keepalive: one connection carries every request
+//   - idle-drop: the server drops the connection after every 50 requests;
+//                the session reconnects lazily and no request fails
+// Poll responses alternate Content-Length, chunked and 204 bodies, and every
+// command body must arrive intact. Exit 1 if a request fails, a body is
+// corrupted, or the connection count differs from the expected one.
+//
+//   cc -std=gnu11 -O2 -I.. -o http_keepalive_sim http_keepalive_sim.c ../hal_posix.c -lpthread
+//   ./http_keepalive_sim                  # 1000 cycles per setup
+//   ./http_keepalive_sim --cycles 5000
+#define _GNU_SOURCE   // strcasestr
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "hal.h"
+
+static const uint32_t IDLE_DROP_EVERY = 50;
+static const int TIMEOUT_MS = 2000;
+
+// ---------- Stub server ----------
+typedef struct {
+    int listen_fd;
+    uint16_t port;
+    bool close_always;          // keep-alive를 지원하지 않는 서버
+    uint32_t drop_every;        // 0이 아니면 이 수의 요청마다 응답 후 연결을 닫는다
+    uint32_t accepted;
+    uint32_t requests;
+    uint32_t bad_requests;
+    uint32_t poll_seq;
+} stub_t;
+
+static stub_t s_stub;
+
+static bool send_str(int fd, const char *s, size_t len)
+{
+    while (len > 0) {
+        ssize_t w = send(fd, s, len, MSG_NOSIGNAL);
+        if (w <= 0) {
+            return false;
+        }
+        s += w;
+        len -= (size_t)w;
+    }
+    return true;
+}
+
+// 요청 n번째의 폴링 응답 본문 (클라이언트가 같은 함수로 검증한다)
+static int poll_body(uint32_t seq, char *buf, size_t cap)
+{
+    return snprintf(buf, cap, "{\"status\":\"ok\",\"commands\":[{\"command\":\"%s\",\"seq\":%u}]}",
+                    seq % 2 ? "WINDOW_OPEN" : "WINDOW_CLOSE", (unsigned)seq);
+}
+
+// 한 연결에서 요청을 차례로 처리. 계속 쓸 수 있으면 true.
+static bool serve_one(int fd, char *buf, size_t *have, size_t cap)
+{
+    // 헤더 끝까지
+    char *eoh;
+    while ((eoh = strstr(buf, "\r\n\r\n")) == NULL) {
+        if (*have + 1 >= cap) {
+            return false;
+        }
+        ssize_t r = recv(fd, buf + *have, cap - 1 - *have, 0);
+        if (r <= 0) {
+            return false;
+        }
+        *have += (size_t)r;
+        buf[*have] = '\0';
+    }
+    size_t head_len = (size_t)(eoh + 4 - buf);
+    long content_length = 0;
+    const char *cl = strcasestr(buf, "\r\nContent-Length:");
+    if (cl && cl < eoh) {
+        content_length = strtol(cl + 17, NULL, 10);
+    }
+    bool post = strncmp(buf, "POST ", 5) == 0;
+    bool get = strncmp(buf, "GET ", 4) == 0;
+    if ((!post && !get) || strstr(buf, " HTTP/1.1\r\n") == NULL || content_length < 0 ||
+        head_len + (size_t)content_length >= cap) {
+        s_stub.bad_requests++;
+        return false;
+    }
+    while (*have < head_len + (size_t)content_length) {
+        ssize_t r = recv(fd, buf + *have, cap - 1 - *have, 0);
+        if (r <= 0) {
+            return false;
+        }
+        *have += (size_t)r;
+    }
+    size_t used = head_len + (size_t)content_length;
+    memmove(buf, buf + used, *have - used);
+    *have -= used;
+    buf[*have] = '\0';
+
+    uint32_t n = ++s_stub.requests;
+    bool close_after = s_stub.close_always || (s_stub.drop_every && n % s_stub.drop_every == 0);
+    const char *conn = s_stub.close_always ? "Connection: close\r\n" : "";
+    char resp[512], body[160];
+    int len;
+    if (post) {
+        len = snprintf(resp, sizeof(resp), "HTTP/1.1 200 OK\r\n%sContent-Type: application/json\r\n"
+                       "Content-Length: 11\r\n\r\n{\"ok\":true}", conn);
+    } else {
+        uint32_t seq = ++s_stub.poll_seq;
+        int blen = poll_body(seq, body, sizeof(body));
+        switch (seq % 3) {
+        case 0:
+            len = snprintf(resp, sizeof(resp), "HTTP/1.1 204 No Content\r\n%s\r\n", conn);
+            break;
+        case 1:
+            len = snprintf(resp, sizeof(resp), "HTTP/1.1 200 OK\r\n%sContent-Type: application/json\r\n"
+                           "Content-Length: %d\r\n\r\n%s", conn, blen, body);
+            break;
+        default:
+            // 두 조각으로 나눈 chunked 본문
+            len = snprintf(resp, sizeof(resp), "HTTP/1.1 200 OK\r\n%sContent-Type: application/json\r\n"
+                           "Transfer-Encoding: chunked\r\n\r\n%x\r\n%.*s\r\n%x\r\n%s\r\n0\r\n\r\n",
+                           conn, blen / 2, blen / 2, body, blen - blen / 2, body + blen / 2);
+            break;
+        }
+    }
+    if (!send_str(fd, resp, (size_t)len)) {
+        return false;
+    }
+    return !close_after;
+}
+
+static void *stub_main(void *arg)
+{
+    (void)arg;
+    static char buf[4096];
+    for (;;) {
+        int fd = accept(s_stub.listen_fd, NULL, NULL);
+        if (fd < 0) {
+            return NULL;
+        }
+        s_stub.accepted++;
+        size_t have = 0;
+        buf[0] = '\0';
+        while (serve_one(fd, buf, &have, sizeof(buf))) {
+        }
+        close(fd);
+    }
+}
+
+static bool stub_start(void)
+{
+    s_stub.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t alen = sizeof(addr);
+    if (s_stub.listen_fd < 0 || bind(s_stub.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(s_stub.listen_fd, 8) != 0 || getsockname(s_stub.listen_fd, (struct sockaddr *)&addr, &alen) != 0) {
+        perror("stub server");
+        return false;
+    }
+    s_stub.port = ntohs(addr.sin_port);
+    pthread_t t;
+    return pthread_create(&t, NULL, stub_main, NULL) == 0 && pthread_detach(t) == 0;
+}
+
+// ---------- Client ----------
+typedef struct {
+    char data[256];
+    size_t len;
+    bool overflow;
+} body_t;
+
+static void collect(const char *data, int len, void *ctx)
+{
+    body_t *b = (body_t *)ctx;
+    if (b->len + (size_t)len >= sizeof(b->data)) {
+        b->overflow = true;
+        return;
+    }
+    memcpy(b->data + b->len, data, (size_t)len);
+    b->len += (size_t)len;
+}
+
+typedef struct {
+    const char *name;
+    bool close_always;
+    uint32_t drop_every;
+} setup_t;
+
+typedef struct {
+    uint32_t failures;
+    uint32_t corrupted;
+    uint32_t connections;
+    hal_http_stats_t stats;
+} run_result_t;
+
+static void run(const setup_t *setup, uint32_t cycles, run_result_t *out)
+{
+    char post_url[64], pull_url[64];
+    snprintf(post_url, sizeof(post_url), "http://127.0.0.1:%u/air-quality", (unsigned)s_stub.port);
+    snprintf(pull_url, sizeof(pull_url), "http://127.0.0.1:%u/esp/command", (unsigned)s_stub.port);
+
+    hal_http_stats_t before;
+    hal_http_get_stats(&before);
+    s_stub.close_always = setup->close_always;
+    s_stub.drop_every = setup->drop_every;
+    uint32_t accepted = s_stub.accepted;
+    uint32_t seq = s_stub.poll_seq;
+    memset(out, 0, sizeof(*out));
+
+    for (uint32_t i = 0; i < cycles; i++) {
+        char sample[128];
+        int n = snprintf(sample, sizeof(sample),
+                         "[{\"temperature\":%.1f,\"humidity\":%.1f,\"pm25\":%u,\"pm10\":%u,\"bug\":false,\"age_ms\":0}]",
+                         24.0 + (i % 10) * 0.1, 55.0, (unsigned)(i % 40), (unsigned)(i % 60));
+        int status = 0;
+        if (hal_http_request(HAL_HTTP_POST, post_url, sample, n, "application/json", TIMEOUT_MS,
+                             NULL, NULL, &status) != 0 || status != 200) {
+            out->failures++;
+        }
+
+        body_t body = { { 0 }, 0, false };
+        status = 0;
+        if (hal_http_request(HAL_HTTP_GET, pull_url, NULL, 0, NULL, TIMEOUT_MS, collect, &body, &status) != 0) {
+            out->failures++;
+            continue;
+        }
+        seq++;
+        char want[160];
+        int wlen = status == 204 ? 0 : poll_body(seq, want, sizeof(want));
+        if ((status != 200 && status != 204) || body.overflow || body.len != (size_t)wlen ||
+            memcmp(body.data, want, (size_t)wlen) != 0) {
+            out->corrupted++;
+        }
+    }
+    // 마지막 연결이 정리될 시간
+    usleep(20000);
+    out->connections = s_stub.accepted - accepted;
+    hal_http_get_stats(&out->stats);
+    out->stats.requests -= before.requests;
+    out->stats.handshakes -= before.handshakes;
+    out->stats.reused -= before.reused;
+    out->stats.resets -= before.resets;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t cycles = 1000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--cycles") == 0) {
+            cycles = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--cycles N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (cycles == 0 || !stub_start()) {
+        return 2;
+    }
+
+    const setup_t setups[] = {
+        { "close", true, 0 },
+        { "keepalive", false, 0 },
+        { "idle-drop", false, IDLE_DROP_EVERY },
+    };
+    uint32_t requests = cycles * 2;
+    uint32_t expect[] = { requests, 1, (requests + IDLE_DROP_EVERY - 1) / IDLE_DROP_EVERY };
+    uint32_t violations = 0;
+
+    printf("%-10s %8s %12s %10s %8s %8s %9s\n", "setup", "requests", "connections", "per 1000", "reused", "resets", "failures");
+    for (size_t i = 0; i < sizeof(setups) / sizeof(setups[0]); i++) {
+        // 이전 설정의 연결을 끊고 시작: 다른 포트로 가는 요청이 연결을 정리한다
+        hal_http_request(HAL_HTTP_GET, "http://127.0.0.1:1/", NULL, 0, NULL, 100, NULL, NULL, NULL);
+        run_result_t r;
+        run(&setups[i], cycles, &r);
+        printf("%-10s %8u %12u %10.1f %8u %8u %9u\n", setups[i].name, (unsigned)r.stats.requests,
+               (unsigned)r.connections, r.connections * 1000.0 / cycles, (unsigned)r.stats.reused,
+               (unsigned)r.stats.resets, (unsigned)(r.failures + r.corrupted));
+        if (r.failures || r.corrupted) {
+            fprintf(stderr, "%s: %u failed and %u corrupted requests\n", setups[i].name,
+                    (unsigned)r.failures, (unsigned)r.corrupted);
+            violations++;
+        }
+        if (r.connections != expect[i] || r.stats.handshakes != expect[i]) {
+            fprintf(stderr, "%s: %u connections (client counted %u handshakes), expected %u\n", setups[i].name,
+                    (unsigned)r.connections, (unsigned)r.stats.handshakes, (unsigned)expect[i]);
+            violations++;
+        }
+    }
+    if (s_stub.bad_requests) {
+        fprintf(stderr, "stub server saw %u malformed requests\n", (unsigned)s_stub.bad_requests);
+        violations++;
+    }
+    printf("%s (%u violations)\n", violations ? "FAIL" : "ok", (unsigned)violations);
+    return violations ? 1 : 0;
+}
@@ -0,0 +1,149 @@
+// Host unit test of the ESP32 keep-alive HTTP session (esp_http_session.c).
+//
+// esp_http_session.c is built against tools/idf_stub/ and http_client_stub.c,
+// an in-process esp_http_client with a scripted server (http_keepalive_sim
+// covers the hal_posix.c twin against a real socket). Checks that:
+//   - a POST and the following GET share one handle and one connection, and
+//     the stats count 1 handshake and 1 reused request
+//   - each request carries its own URL, method and timeout; the GET after a
+//     POST sends neither the POST body nor its Content-Type
+//   - the body arrives whole through on_body with ctx, the status code is
+//     returned, and on_body is not called for a later request
+//   - a Connection: close response makes the next request reconnect without
+//     a reset
+//   - a failed request and a connection the server closed while idle drop the
+//     handle (reset, cleanup) and the next request reconnects on a new one
+//   - a failed init returns ESP_FAIL without counting a request
+//   - air_http_close() frees the handle; no handle is leaked
+// Exit 1 on the first mismatch.
+//
+//   cc -std=gnu11 -O2 -I.. -Iidf_stub -o http_session_test http_session_test.c http_client_stub.c ../esp_http_session.c
+//   ./http_session_test
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_http_session.h"
+#include "http_client_stub.h"
+
+#define POST_URL "http://10.0.0.5:8000/air-quality"
+#define POLL_URL "http://10.0.0.5:8000/command/node1"
+
+static int s_failures;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        s_failures++;
+    }
+}
+
+typedef struct {
+    char text[256];
+    int len;
+    int calls;
+} body_t;
+
+static void collect(const char *data, int len, void *ctx)
+{
+    body_t *b = ctx;
+    if (b->len + len < (int)sizeof(b->text)) {
+        memcpy(b->text + b->len, data, (size_t)len);
+        b->len += len;
+        b->text[b->len] = '\0';
+    }
+    b->calls++;
+}
+
+static esp_err_t post(const char *json, int *status)
+{
+    return air_http_request(HTTP_METHOD_POST, POST_URL, json, (int)strlen(json), "application/json", 3000, NULL,
+                            NULL, status);
+}
+
+static esp_err_t poll(body_t *b, int *status)
+{
+    return air_http_request(HTTP_METHOD_GET, POLL_URL, NULL, 0, "application/json", 1500, b ? collect : NULL, b,
+                            status);
+}
+
+static bool stats_are(uint32_t requests, uint32_t handshakes, uint32_t reused, uint32_t resets)
+{
+    air_http_stats_t st;
+    air_http_get_stats(&st);
+    return st.requests == requests && st.handshakes == handshakes && st.reused == reused && st.resets == resets;
+}
+
+static uint32_t live_handles(void)
+{
+    http_client_stub_stats_t st;
+    http_client_stub_get_stats(&st);
+    return st.inits - st.cleanups;
+}
+
+int main(void)
+{
+    http_client_stub_request_t rq;
+    body_t body;
+    int status = 0;
+
+    // POST 다음 GET: 연결 하나
+    static const char SAMPLE[] = "[{\"temperature\":21.5,\"pm10\":12}]";
+    http_client_stub_respond(201, "", false);
+    check(post(SAMPLE, &status) == ESP_OK && status == 201, "post");
+    check(http_client_stub_last(&rq) && rq.method == HTTP_METHOD_POST && strcmp(rq.url, POST_URL) == 0 &&
+          strcmp(rq.content_type, "application/json") == 0 && strcmp(rq.body, SAMPLE) == 0 && rq.timeout_ms == 3000,
+          "post as sent");
+
+    memset(&body, 0, sizeof(body));
+    static const char CMDS[] = "[{\"command\":\"WINDOW_OPEN\",\"id\":7},{\"command\":\"PUMP_OFF\",\"id\":8}]";
+    http_client_stub_respond(200, CMDS, false);
+    check(poll(&body, &status) == ESP_OK && status == 200, "poll");
+    check(strcmp(body.text, CMDS) == 0 && body.calls > 1, "poll body through on_body");
+    check(http_client_stub_last(&rq) && rq.method == HTTP_METHOD_GET && strcmp(rq.url, POLL_URL) == 0 &&
+          rq.content_type[0] == '\0' && rq.body_len == 0 && rq.timeout_ms == 1500,
+          "get carries no post body or Content-Type");
+    check(stats_are(2, 1, 1, 0) && live_handles() == 1, "post and get share one connection");
+
+    // 콜백은 그 요청에만
+    int calls = body.calls;
+    http_client_stub_respond(200, "{\"command\":\"PUMP_ON\"}", false);
+    check(air_http_request(HTTP_METHOD_GET, POLL_URL, NULL, 0, NULL, 1500, NULL, NULL, NULL) == ESP_OK &&
+          body.calls == calls, "on_body not kept for the next request");
+    check(stats_are(3, 1, 2, 0), "third request reuses the connection");
+
+    // Connection: close
+    http_client_stub_respond(204, "", true);
+    check(poll(NULL, &status) == ESP_OK && status == 204, "poll, server closes");
+    check(post(SAMPLE, &status) == ESP_OK && stats_are(5, 2, 3, 0) && live_handles() == 1,
+          "reconnect after Connection: close, same handle");
+
+    // 서버가 유휴 연결을 닫았다
+    http_client_stub_drop();
+    check(post(SAMPLE, &status) == ESP_ERR_HTTP_FETCH_HEADER, "request on a dropped connection fails");
+    check(stats_are(6, 2, 3, 1) && live_handles() == 0, "failed request drops the handle");
+    check(poll(NULL, &status) == ESP_OK && stats_are(7, 3, 3, 1) && live_handles() == 1, "lazy reconnect");
+
+    // 요청 실패
+    http_client_stub_fail_next(ESP_ERR_TIMEOUT);
+    memset(&body, 0, sizeof(body));
+    check(poll(&body, &status) == ESP_ERR_TIMEOUT && body.calls == 0, "timeout");
+    check(stats_are(8, 3, 3, 2) && live_handles() == 0, "timeout drops the handle");
+
+    // 초기화 실패
+    http_client_stub_refuse_init(true);
+    check(post(SAMPLE, &status) == ESP_FAIL && stats_are(8, 3, 3, 2), "init failure");
+    http_client_stub_refuse_init(false);
+    check(post(SAMPLE, &status) == ESP_OK && stats_are(9, 4, 3, 2), "request after init failure");
+
+    // 명시적으로 닫기
+    air_http_close();
+    check(live_handles() == 0, "close frees the handle");
+    check(post(SAMPLE, &status) == ESP_OK && stats_are(10, 5, 3, 2), "reconnect after close, not a reset");
+    air_http_close();
+    air_http_close();
+    check(live_handles() == 0, "no handle leaked");
+
+    printf("%s\n", s_failures ? "FAIL" : "ok");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+// Host test of metrics_render() racing metric_observe() on another thread.
+//
+// A writer thread observes a fixed value into a histogram in a tight loop
+// (the 64-bit sum crosses 2^32 after two observations); the main thread
+// renders /metrics over and over the way the httpd task does and parses the
+// histogram back. Every rendering must be one consistent state of the
+// histogram: _sum == _count * value, the +Inf bucket == _count, and both only
+// grow between renderings. On one core the writer is often preempted in the
+// middle of an update; the reader then gives up on that histogram for one
+// rendering, which is allowed for up to 10% of the renderings. Exit 1 on any
+// violation.
+//
+//   cc -std=gnu11 -O2 -I.. -o metrics_race_test metrics_race_test.c ../metrics.c -lpthread
+//   ./metrics_race_test                   # 2000000 renderings
+//   ./metrics_race_test --renders 20000000
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "metrics.h"
+
+static const uint32_t VALUE = 3000000000u;   // sum이 두 번째 표본에서 32비트를 넘는다
+static const uint32_t BOUNDS[] = { 1000, 1000000 };
+
+static metric_t s_hist;
+static volatile int s_stop;
+static uint32_t s_violations;
+
+static void violation(const char *what, unsigned long long a, unsigned long long b)
+{
+    if (s_violations++ < 20) {
+        fprintf(stderr, "violation: %s (%llu, %llu)\n", what, a, b);
+    }
+}
+
+static void *writer(void *arg)
+{
+    (void)arg;
+    while (!s_stop) {
+        metric_observe(&s_hist, VALUE);
+        // 장치의 기록 태스크처럼 표본 사이에 다른 일을 한다
+        for (volatile int spin = 0; spin < 50; spin++) {
+        }
+    }
+    return NULL;
+}
+
+typedef struct {
+    char text[1024];
+    size_t len;
+} render_buf_t;
+
+static int collect(void *ctx, const char *data, size_t len)
+{
+    render_buf_t *b = (render_buf_t *)ctx;
+    if (b->len + len >= sizeof(b->text)) {
+        return -1;
+    }
+    memcpy(b->text + b->len, data, len);
+    b->len += len;
+    b->text[b->len] = '\0';
+    return 0;
+}
+
+// "name value" 줄에서 값 (없으면 false)
+static bool find_value(const char *text, const char *prefix, unsigned long long *out)
+{
+    const char *p = strstr(text, prefix);
+    if (p == NULL) {
+        return false;
+    }
+    *out = strtoull(p + strlen(prefix), NULL, 10);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t renders = 2000000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--renders") == 0) {
+            renders = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--renders N]\n", argv[0]);
+            return 2;
+        }
+    }
+    // METRIC_HISTOGRAM_INIT과 같은 설정 (-Wextra에서 나머지 필드 초기화 경고를 피해 직접 채움)
+    s_hist.name = "race_us";
+    s_hist.help = "Race test";
+    s_hist.type = METRIC_HISTOGRAM;
+    s_hist.bounds = BOUNDS;
+    s_hist.bucket_count = METRIC_BUCKET_COUNT(BOUNDS);
+    metrics_register(&s_hist);
+
+    pthread_t th;
+    if (pthread_create(&th, NULL, writer, NULL) != 0) {
+        return 2;
+    }
+    unsigned long long last_count = 0;
+    uint32_t skipped = 0;
+    static render_buf_t buf;
+    for (uint32_t r = 0; r < renders; r++) {
+        buf.len = 0;
+        buf.text[0] = '\0';
+        if (metrics_render(collect, &buf) != 0) {
+            violation("render failed", r, buf.len);
+            continue;
+        }
+        unsigned long long inf, sum, count;
+        if (!find_value(buf.text, "race_us_bucket{le=\"+Inf\"} ", &inf) || !find_value(buf.text, "race_us_sum ", &sum) ||
+            !find_value(buf.text, "race_us_count ", &count)) {
+            skipped++;   // 재시도가 다 떨어져 이번에는 건너뜀
+            continue;
+        }
+        if (sum != count * VALUE) {
+            violation("sum does not match count", sum, count);
+        }
+        if (inf != count) {
+            violation("+Inf bucket does not match count", inf, count);
+        }
+        if (count < last_count) {
+            violation("count went back", count, last_count);
+        }
+        last_count = count;
+    }
+    s_stop = 1;
+    pthread_join(th, NULL);
+    if (skipped > renders / 10) {
+        violation("too many renderings skipped the histogram", skipped, renders);
+    }
+
+    printf("%u renderings, %llu observations, %u skipped\n", (unsigned)renders, last_count, (unsigned)skipped);
+    printf("%s (%u violations)\n", s_violations ? "FAIL" : "ok", (unsigned)s_violations);
+    return s_violations ? 1 : 0;
+}
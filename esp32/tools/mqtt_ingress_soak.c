@@ -0,0 +1,279 @@
+// Host soak test of the zero-allocation MQTT ingress path.
+//
+// Pushes millions of messages through air_app.c's callback() path for readings
+// and pump states (mqtt_topic_classify, mqtt_payload_copy into the 16-byte
+// buffer, mqtt_parse_int/mqtt_parse_float) with malloc/calloc/realloc/free
+// interposed, and checks:
+//   - no heap allocation at all during the soak
+//   - every payload is accepted or rejected as a reference parser says:
+//     numbers with surrounding whitespace, garbage, empty and oversized
+//     payloads (which must be dropped, never cut to 15 bytes and parsed),
+//     out-of-range integers, nan/inf
+//   - accepted values are the ones the payload spelled
+// Exit 1 on any violation.
+//
+//   cc -std=gnu11 -O2 -I.. -o mqtt_ingress_soak mqtt_ingress_soak.c ../mqtt_ingress.c -lm
+//   ./mqtt_ingress_soak                   # 2,000,000 messages
+//   ./mqtt_ingress_soak --messages 20000000 --seed 7
+#define _GNU_SOURCE
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mqtt_ingress.h"
+
+// ---------- Allocation counter ----------
+// 실행 파일에서 정의한 malloc이 libc 것을 가린다 (glibc의 __libc_* 로 전달)
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+extern void __libc_free(void *);
+
+static volatile unsigned long s_allocs;
+static volatile int s_counting;
+
+void *malloc(size_t n)
+{
+    if (s_counting) s_allocs++;
+    return __libc_malloc(n);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    if (s_counting) s_allocs++;
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *p, size_t n)
+{
+    if (s_counting) s_allocs++;
+    return __libc_realloc(p, n);
+}
+
+void free(void *p)
+{
+    __libc_free(p);
+}
+
+// ---------- Messages ----------
+static uint32_t s_rng = 1;
+
+static uint32_t rnd(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static uint32_t s_violations;
+
+static void violation(const char *what, const char *payload, unsigned int len)
+{
+    if (s_violations++ < 20) {
+        fprintf(stderr, "violation: %s: \"%.*s\"\n", what, (int)len, payload);
+    }
+}
+
+static const char *const TOPICS[] = {
+    "s_window/esp-1/aqi", "s_window/esp-1/pm25", "s_window/esp-1/pm10", "s_window/all/pump",
+    "s_window/esp-1/status", "pm25", "s_window/esp-1/pm25x",
+};
+
+typedef enum { GEN_INT, GEN_FLOAT, GEN_PUMP, GEN_GARBAGE, GEN_LONG, GEN_SPECIAL } gen_t;
+
+// 종류별 payload와 기대 결과: 숫자라면 value, 거부해야 하면 *ok=false
+static unsigned int make_payload(char *buf, size_t cap, gen_t g, bool *ok, double *value)
+{
+    static const char *const SPECIAL[] = { "", "   ", "nan", "inf", "-inf", "1e999", "2147483648",
+                                           "-2147483649", "99999999999999", "12 34", "+", "-", "0x", "ON\n" };
+    const char *pad = (rnd() % 4 == 0) ? " \t" : "";
+    int n = 0;
+    *ok = true;
+    *value = 0;
+    switch (g) {
+    case GEN_INT: {
+        int v = (int)(rnd() % 2000) - 100;
+        n = snprintf(buf, cap, "%s%d%s", pad, v, pad);
+        *value = v;
+        break;
+    }
+    case GEN_FLOAT: {
+        double v = (double)(rnd() % 100000) / 100.0;
+        n = snprintf(buf, cap, "%s%.2f%s", pad, v, pad);
+        *value = v;
+        break;
+    }
+    case GEN_PUMP:
+        n = snprintf(buf, cap, "%s%s%s", pad, rnd() % 2 ? "ON" : "OFF", pad);
+        break;
+    case GEN_GARBAGE:
+        n = (int)(rnd() % 15);
+        for (int i = 0; i < n; i++) {
+            buf[i] = (char)('!' + rnd() % 90);
+        }
+        buf[n] = '\0';
+        *ok = false;    // 숫자/상태로 해석되면 안 됨 (드물게 숫자만 나오면 아래에서 판정)
+        break;
+    case GEN_LONG: {
+        // 16바이트 버퍼를 넘는 숫자: 앞 15자리만 읽으면 다른 값이 된다
+        int digits = 16 + (int)(rnd() % 40);
+        for (int i = 0; i < digits; i++) {
+            buf[i] = (char)('1' + rnd() % 9);
+        }
+        n = digits;
+        buf[n] = '\0';
+        *ok = false;
+        break;
+    }
+    case GEN_SPECIAL: {
+        const char *s = SPECIAL[rnd() % (sizeof(SPECIAL) / sizeof(SPECIAL[0]))];
+        n = snprintf(buf, cap, "%s", s);
+        *ok = false;
+        break;
+    }
+    }
+    return (unsigned int)n;
+}
+
+// ---------- callback() mirror ----------
+typedef struct {
+    int aqi;
+    float pm25;
+    float pm10;
+    uint32_t updates;
+    uint32_t pump_on;
+    uint32_t pump_off;
+    uint32_t rejected;
+} inputs_t;
+
+static inputs_t s_in;
+
+static void callback(const char *topic, const uint8_t *payload, unsigned int length)
+{
+    mqtt_topic_t kind = mqtt_topic_classify(topic);
+    if (kind == MQTT_TOPIC_COMMAND || kind == MQTT_TOPIC_CONFIG) {
+        return;     // JSON 경로 (여기서는 다루지 않음)
+    }
+    char data[16];
+    if (!mqtt_payload_copy(payload, length, data, sizeof(data))) {
+        s_in.rejected++;
+        return;
+    }
+    switch (kind) {
+    case MQTT_TOPIC_AQI:
+        if (mqtt_parse_int(data, &s_in.aqi)) s_in.updates++;
+        break;
+    case MQTT_TOPIC_PM25:
+        if (mqtt_parse_float(data, &s_in.pm25)) s_in.updates++;
+        break;
+    case MQTT_TOPIC_PM10:
+        if (mqtt_parse_float(data, &s_in.pm10)) s_in.updates++;
+        break;
+    case MQTT_TOPIC_PUMP:
+        if (strcmp(data, "ON") == 0) s_in.pump_on++;
+        else if (strcmp(data, "OFF") == 0) s_in.pump_off++;
+        break;
+    default:
+        break;
+    }
+}
+
+// 참조 판정: 공백 제거 후 15바이트 이하이고 전체가 유한한 숫자(정수 토픽은 int 범위의 10진수)
+static bool reference_accepts(const char *p, unsigned int len, bool integer, double *value)
+{
+    unsigned int a = 0, b = len;
+    while (a < b && strchr(" \t\r\n", p[a])) a++;
+    while (b > a && strchr(" \t\r\n", p[b - 1])) b--;
+    if (b - a == 0 || b - a > 15) {
+        return false;
+    }
+    char tmp[16];
+    memcpy(tmp, p + a, b - a);
+    tmp[b - a] = '\0';
+    char *end;
+    if (integer) {
+        long long v = strtoll(tmp, &end, 10);
+        if (*end != '\0' || end == tmp || v < INT_MIN || v > INT_MAX) return false;
+        *value = (double)v;
+        return true;
+    }
+    double v = strtod(tmp, &end);
+    if (*end != '\0' || end == tmp || !isfinite((float)v)) return false;
+    *value = v;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long messages = 2000000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--messages") == 0) {
+            messages = strtoul(argv[i + 1], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            s_rng = (uint32_t)strtoul(argv[i + 1], NULL, 10) | 1u;
+        } else {
+            fprintf(stderr, "usage: %s [--messages N] [--seed S]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // 첫 호출에서 내부 초기화가 할당할 수 있는 libc 경로를 미리 데운다
+    char warm[64];
+    snprintf(warm, sizeof(warm), "%f", 1.5);
+    (void)strtof("1.5", NULL);
+
+    unsigned long accepted = 0, rejected = 0;
+    s_counting = 1;
+    for (unsigned long m = 0; m < messages; m++) {
+        const char *topic = TOPICS[rnd() % (sizeof(TOPICS) / sizeof(TOPICS[0]))];
+        mqtt_topic_t kind = mqtt_topic_classify(topic);
+        gen_t g = (gen_t)(rnd() % 6);
+        char payload[64];
+        bool ok;
+        double value;
+        unsigned int len = make_payload(payload, sizeof(payload), g, &ok, &value);
+
+        inputs_t before = s_in;
+        callback(topic, (const uint8_t *)payload, len);
+
+        bool numeric = kind == MQTT_TOPIC_AQI || kind == MQTT_TOPIC_PM25 || kind == MQTT_TOPIC_PM10;
+        if (numeric) {
+            double ref;
+            bool want = reference_accepts(payload, len, kind == MQTT_TOPIC_AQI, &ref);
+            bool got = s_in.updates != before.updates;
+            if (got != want) {
+                violation(want ? "valid value not accepted" : "invalid value accepted", payload, len);
+            } else if (got) {
+                double v = kind == MQTT_TOPIC_AQI ? s_in.aqi : kind == MQTT_TOPIC_PM25 ? s_in.pm25 : s_in.pm10;
+                if (fabs(v - ref) > fabs(ref) * 1e-6 + 1e-3) {
+                    violation("value differs", payload, len);
+                }
+            } else if (!ok && g == GEN_LONG && s_in.rejected == before.rejected) {
+                violation("oversized payload not dropped", payload, len);
+            }
+            if (got) accepted++;
+            else rejected++;
+            if (ok && (g == GEN_INT || g == GEN_FLOAT) && !got && kind != MQTT_TOPIC_AQI) {
+                violation("number dropped", payload, len);
+            }
+        } else if (kind == MQTT_TOPIC_PUMP && g == GEN_PUMP) {
+            if (s_in.pump_on + s_in.pump_off == before.pump_on + before.pump_off) {
+                violation("pump state dropped", payload, len);
+            }
+        }
+    }
+    s_counting = 0;
+
+    printf("%lu messages: %lu values accepted, %lu rejected, %u oversized dropped, %u pump states, %lu allocations\n",
+           messages, accepted, rejected, (unsigned)s_in.rejected, (unsigned)(s_in.pump_on + s_in.pump_off),
+           (unsigned long)s_allocs);
+    if (s_allocs != 0) {
+        fprintf(stderr, "violation: %lu heap allocations during the soak\n", (unsigned long)s_allocs);
+        s_violations++;
+    }
+    printf("%s (%u violations)\n", s_violations ? "FAIL" : "ok", (unsigned)s_violations);
+    return s_violations ? 1 : 0;
+}
@@ -0,0 +1,295 @@
+// Host fault-injection test of the MQTT connection handling.
+//
+// Runs conn_manager.c with hal_posix.c's background MQTT connect against the
+// in-process broker stub (stub_broker.c). A device thread runs air_app.c's loop()
+// mirror (conn_manager_tick(), hal_mqtt_loop(), /data snapshot rebuild every
+// pass, idle wait bounded by conn_manager_idle_ms()); an httpd thread serves
+// /data from the snapshot the whole time. Broker faults, in order:
+//   - up:      connect and subscribe
+//   - refuse:  the session is dropped and new connections are closed at once
+//   - up:      reconnect
+//   - hang:    the session is dropped and new connections never get a CONNACK
+//              (the host connect gives up after 3 s)
+//   - up:      reconnect
+// Exit 1 if a loop() pass is late by more than 50 ms, /data serves a snapshot
+// older than 100 ms, the device does not reconnect after each fault, it does
+// not resubscribe exactly once per session, or an outage is not recorded.
+//
+//   cc -std=gnu11 -O2 -I.. -o net_fault_sim net_fault_sim.c stub_broker.c ../conn_manager.c ../hal_posix.c -lpthread
+//   ./net_fault_sim
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "conn_manager.h"
+#include "hal.h"
+#include "stub_broker.h"
+
+static const uint32_t LOOP_PERIOD_MS = 10;        // 센서/스냅샷 주기 대신
+static const uint32_t MAX_PASS_GAP_MS = 60;       // 주기 + 50 ms
+static const uint32_t MAX_SNAPSHOT_AGE_MS = 100;
+static const int TOPICS = 2;                      // 장치 + 방송 토픽
+
+static uint32_t s_violations;
+
+static void violation(const char *what, unsigned long a, unsigned long b)
+{
+    if (s_violations++ < 20) {
+        fprintf(stderr, "violation: %s (%lu, %lu)\n", what, a, b);
+    }
+}
+
+static void sleep_ms(uint32_t ms)
+{
+    struct timespec ts = { (time_t)(ms / 1000u), (long)(ms % 1000u) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0) {
+    }
+}
+
+// ---------- Device (air_app.c mirror) ----------
+static conn_manager_t s_net;
+static uint32_t s_sessions;         // on_mqtt_up 호출 수
+static uint32_t s_outages;          // 기록된 끊김 (last_outage_ms > 0)
+
+static pthread_mutex_t s_snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+static char s_snapshot[128];
+static uint32_t s_snapshot_ms;
+
+static void wifi_begin(void *ctx)
+{
+    (void)ctx;
+}
+
+static bool wifi_up(void *ctx)
+{
+    (void)ctx;
+    return true;
+}
+
+static bool mqtt_begin(void *ctx)
+{
+    (void)ctx;
+    return hal_mqtt_connect_start("sim-device", NULL, NULL, "s_window/sim-device/status", "offline");
+}
+
+static conn_attempt_t mqtt_poll(void *ctx)
+{
+    (void)ctx;
+    switch (hal_mqtt_connect_poll()) {
+    case HAL_MQTT_CONNECT_PENDING:
+        return CONN_ATTEMPT_PENDING;
+    case HAL_MQTT_CONNECT_OK:
+        return CONN_ATTEMPT_OK;
+    default:
+        return CONN_ATTEMPT_FAILED;
+    }
+}
+
+static bool mqtt_up(void *ctx)
+{
+    (void)ctx;
+    return hal_mqtt_connected();
+}
+
+// net_on_mqtt_up()과 같이 재구독은 세션마다 한 번
+static void on_mqtt_up(void *ctx, const conn_link_t *link)
+{
+    (void)ctx;
+    hal_mqtt_subscribe("s_window/sim-device/+");
+    hal_mqtt_subscribe("s_window/all/+");
+    s_sessions++;
+    if (link->last_outage_ms > 0) {
+        s_outages++;
+    }
+}
+
+static uint32_t sim_random(void *ctx)
+{
+    (void)ctx;
+    return (uint32_t)rand();
+}
+
+static void callback(const char *topic, const uint8_t *payload, unsigned int length)
+{
+    (void)topic;
+    (void)payload;
+    (void)length;
+}
+
+typedef struct {
+    volatile bool stop;
+    uint32_t passes;
+    uint32_t max_gap_ms;
+    uint32_t max_gap_at_ms;
+} device_t;
+
+static void *device_main(void *arg)
+{
+    device_t *d = (device_t *)arg;
+    uint32_t last = hal_millis();
+    while (!d->stop) {
+        uint32_t now = hal_millis();
+        if (now - last > d->max_gap_ms) {
+            d->max_gap_ms = now - last;
+            d->max_gap_at_ms = now;
+        }
+        last = now;
+        conn_manager_tick(&s_net, now);
+        if (conn_mqtt_up(&s_net)) {
+            hal_mqtt_loop();
+        }
+        char buf[sizeof(s_snapshot)];
+        snprintf(buf, sizeof(buf), "{\"pass\":%u,\"mqtt\":%s}", (unsigned)d->passes,
+                 conn_mqtt_up(&s_net) ? "true" : "false");
+        pthread_mutex_lock(&s_snapshot_lock);
+        memcpy(s_snapshot, buf, sizeof(buf));
+        s_snapshot_ms = hal_millis();
+        pthread_mutex_unlock(&s_snapshot_lock);
+        d->passes++;
+
+        // power_idle(): 다음 할 일까지, 길어도 한 주기
+        uint32_t idle = conn_manager_idle_ms(&s_net, hal_millis());
+        sleep_ms(idle < LOOP_PERIOD_MS ? idle : LOOP_PERIOD_MS);
+    }
+    return NULL;
+}
+
+// ---------- httpd ----------
+typedef struct {
+    volatile bool stop;
+    uint32_t requests;
+    uint32_t max_age_ms;
+    uint32_t max_age_at_ms;
+} httpd_t;
+
+static void *httpd_main(void *arg)
+{
+    httpd_t *h = (httpd_t *)arg;
+    while (!h->stop) {
+        char body[sizeof(s_snapshot)];
+        pthread_mutex_lock(&s_snapshot_lock);
+        memcpy(body, s_snapshot, sizeof(body));
+        uint32_t built = s_snapshot_ms;
+        pthread_mutex_unlock(&s_snapshot_lock);
+        uint32_t now = hal_millis();
+        if (body[0] == '{' && now - built > h->max_age_ms) {
+            h->max_age_ms = now - built;
+            h->max_age_at_ms = now;
+        }
+        h->requests++;
+        sleep_ms(2);
+    }
+    return NULL;
+}
+
+// ---------- Scenario ----------
+typedef struct {
+    const char *name;
+    stub_broker_mode_t mode;
+    bool drop;
+    uint32_t ms;
+} phase_t;
+
+static bool wait_connected(uint32_t timeout_ms)
+{
+    uint32_t t0 = hal_millis();
+    while (hal_millis() - t0 < timeout_ms) {
+        if (conn_mqtt_up(&s_net)) {
+            return true;
+        }
+        sleep_ms(10);
+    }
+    return false;
+}
+
+int main(void)
+{
+    srand(1);
+    uint16_t port = stub_broker_start();
+    if (port == 0) {
+        fprintf(stderr, "broker stub failed to start\n");
+        return 2;
+    }
+    hal_mqtt_setup("127.0.0.1", port, callback);
+    // air_app.c보다 짧은 백오프로 시나리오를 줄인다
+    static const conn_ops_t ops = {
+        wifi_begin, wifi_up, mqtt_begin, mqtt_poll, mqtt_up, NULL, on_mqtt_up, NULL, sim_random, NULL,
+    };
+    static const conn_config_t cfg = { 200, 2000, 15000, 20 };
+    conn_manager_init(&s_net, &ops, &cfg, hal_millis());
+
+    device_t dev;
+    httpd_t httpd;
+    memset(&dev, 0, sizeof(dev));
+    memset(&httpd, 0, sizeof(httpd));
+    pthread_t dev_th, httpd_th;
+    if (pthread_create(&dev_th, NULL, device_main, &dev) != 0 ||
+        pthread_create(&httpd_th, NULL, httpd_main, &httpd) != 0) {
+        return 2;
+    }
+
+    static const phase_t phases[] = {
+        { "up", STUB_BROKER_UP, false, 1000 },
+        { "refuse", STUB_BROKER_REFUSE, true, 3000 },
+        { "up", STUB_BROKER_UP, false, 0 },
+        { "hang", STUB_BROKER_HANG, true, 5000 },
+        { "up", STUB_BROKER_UP, false, 0 },
+    };
+    printf("%-7s %8s %8s %9s %9s %8s\n", "phase", "ms", "passes", "max_gap", "data_age", "attempts");
+    for (size_t i = 0; i < sizeof(phases) / sizeof(phases[0]); i++) {
+        const phase_t *p = &phases[i];
+        uint32_t t0 = hal_millis(), passes0 = dev.passes, attempts0 = s_net.mqtt.attempts;
+        dev.max_gap_ms = 0;
+        httpd.max_age_ms = 0;
+        stub_broker_set_mode(p->mode);
+        if (p->drop) {
+            stub_broker_drop();
+        }
+        if (p->mode == STUB_BROKER_UP) {
+            // 백오프 상한 + 연결 시도 하나 안에 다시 붙어야 한다
+            if (!wait_connected(cfg.max_ms + 3500)) {
+                violation("no reconnect after the broker came back", i, s_net.mqtt.attempts);
+            }
+        }
+        if (p->ms) {
+            sleep_ms(p->ms);
+        }
+        if (p->drop && conn_mqtt_up(&s_net)) {
+            violation("still connected during a broker fault", i, s_net.mqtt.connects);
+        }
+        if (dev.max_gap_ms > MAX_PASS_GAP_MS) {
+            violation("loop() pass late (ms, at)", dev.max_gap_ms, dev.max_gap_at_ms);
+        }
+        if (httpd.max_age_ms > MAX_SNAPSHOT_AGE_MS) {
+            violation("/data served a stale snapshot (ms, at)", httpd.max_age_ms, httpd.max_age_at_ms);
+        }
+        printf("%-7s %8u %8u %9u %9u %8u\n", p->name, (unsigned)(hal_millis() - t0), (unsigned)(dev.passes - passes0),
+               (unsigned)dev.max_gap_ms, (unsigned)httpd.max_age_ms, (unsigned)(s_net.mqtt.attempts - attempts0));
+    }
+
+    dev.stop = true;
+    httpd.stop = true;
+    pthread_join(dev_th, NULL);
+    pthread_join(httpd_th, NULL);
+
+    stub_broker_stats_t st;
+    stub_broker_get_stats(&st);
+    if (s_sessions != 3 || st.connects != s_sessions) {
+        violation("sessions (device, broker)", s_sessions, st.connects);
+    }
+    if (st.subscribes != s_sessions * TOPICS) {
+        violation("resubscribes (broker, sessions)", st.subscribes, s_sessions);
+    }
+    // 부팅도 첫 끊김으로 센다
+    if (s_outages != s_sessions || s_net.mqtt.max_outage_ms == 0) {
+        violation("outages recorded (count, max ms)", s_outages, s_net.mqtt.max_outage_ms);
+    }
+    printf("sessions %u, subscribes %u, failures %u, max outage %u ms, /data requests %u\n", (unsigned)s_sessions,
+           (unsigned)st.subscribes, (unsigned)s_net.mqtt.failures, (unsigned)s_net.mqtt.max_outage_ms,
+           (unsigned)httpd.requests);
+    printf("%s (%u violations)\n", s_violations ? "FAIL" : "ok", (unsigned)s_violations);
+    return s_violations ? 1 : 0;
+}
@@ -0,0 +1,332 @@
+// Host fuzz/replay test of the PMS5003 UART frame parser.
+//
+// Builds a byte stream of valid frames (checksum over all 30 leading bytes,
+// including the reserved word), corrupted frames (one byte flipped, or the
+// stream cut mid-frame) and line noise, then feeds it to pms5003.c in random
+// chunk sizes, as the UART driver hands bytes over. Checks:
+//   - every intact frame is decoded, in order, with the values it carried,
+//     exactly where a buffer-indexed reference parser of the datasheet rules
+//     finds it (a cut frame swallows the bytes that follow it)
+//   - no corrupted or cut frame is accepted
+//   - pms5003_average() equals the mean of the last PMS5003_AVG_WINDOW frames
+//   - the result does not depend on how the stream is chunked
+// With --replay it feeds a captured UART dump instead (e.g. from
+// `cat /dev/ttyUSB0 > pms.bin`) one byte at a time and in one call, checks both
+// give the same frames and prints the parser counters.
+// Exit 1 on any violation.
+//
+//   cc -std=gnu11 -O2 -I.. -o pms5003_fuzz pms5003_fuzz.c ../pms5003.c
+//   ./pms5003_fuzz                        # 2000 streams
+//   ./pms5003_fuzz --trials 20000 --seed 7
+//   ./pms5003_fuzz --replay pms.bin
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pms5003.h"
+
+#define MAX_FRAMES 64
+
+static uint32_t s_rng = 1;
+
+static uint32_t rnd(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static uint32_t rnd_range(uint32_t lo, uint32_t hi)
+{
+    return lo + rnd() % (hi - lo + 1);
+}
+
+static uint32_t s_violations;
+
+static void violation(const char *what, unsigned long a, unsigned long b)
+{
+    if (s_violations++ < 20) {
+        fprintf(stderr, "violation: %s (%lu, %lu)\n", what, a, b);
+    }
+}
+
+// 데이터시트대로 만든 프레임. 헤더 뒤에는 0x42가 나오지 않게 해서
+// 손상된 프레임 안에서 잘못 동기화될 여지를 없앤다 (기대 결과가 하나로 정해지도록).
+static void make_frame(uint8_t *f)
+{
+    for (;;) {
+        f[0] = 0x42;
+        f[1] = 0x4D;
+        f[2] = 0;
+        f[3] = PMS5003_PAYLOAD_LEN;
+        // PM 값, 입자 수, 예약 워드 (예약 워드도 체크섬에 들어간다)
+        for (int w = 0; w < 13; w++) {
+            uint16_t v = (uint16_t)(w < 6 ? rnd() % 1000 : w < 12 ? rnd() % 60000 : rnd());
+            f[4 + w * 2] = (uint8_t)(v >> 8);
+            f[5 + w * 2] = (uint8_t)v;
+        }
+        uint16_t sum = 0;
+        for (int i = 0; i < PMS5003_FRAME_LEN - 2; i++) {
+            sum = (uint16_t)(sum + f[i]);
+        }
+        f[30] = (uint8_t)(sum >> 8);
+        f[31] = (uint8_t)sum;
+        bool clean = true;
+        for (int i = 1; i < PMS5003_FRAME_LEN; i++) {
+            clean = clean && f[i] != 0x42;
+        }
+        if (clean) {
+            return;
+        }
+    }
+}
+
+static bool frame_matches(const pms5003_frame_t *f, const uint16_t w[13])
+{
+    return f->pm1_0_cf1 == w[0] && f->pm2_5_cf1 == w[1] && f->pm10_cf1 == w[2] && f->pm1_0 == w[3] &&
+           f->pm2_5 == w[4] && f->pm10 == w[5] && f->count_0_3 == w[6] && f->count_0_5 == w[7] &&
+           f->count_1_0 == w[8] && f->count_2_5 == w[9] && f->count_5_0 == w[10] && f->count_10 == w[11];
+}
+
+typedef struct {
+    uint8_t bytes[MAX_FRAMES * (PMS5003_FRAME_LEN + 8)];
+    size_t len;
+    size_t intact_end[MAX_FRAMES];      // 손상 없이 넣은 프레임이 끝나는 위치
+    int intact_count;
+    bool has_cuts;
+} stream_t;
+
+static void build_stream(stream_t *s)
+{
+    memset(s, 0, sizeof(*s));
+    int frames = (int)rnd_range(1, MAX_FRAMES);
+    bool cuts = rnd() % 2 == 0;
+    for (int i = 0; i < frames; i++) {
+        // 잡음 (0x42 없음)
+        uint32_t noise = rnd() % 4 == 0 ? rnd_range(1, 7) : 0;
+        for (uint32_t k = 0; k < noise; k++) {
+            uint8_t b = (uint8_t)rnd();
+            s->bytes[s->len++] = b == 0x42 ? 0x43 : b;
+        }
+        uint8_t f[PMS5003_FRAME_LEN];
+        make_frame(f);
+        uint32_t kind = rnd() % 10;
+        if (kind == 0) {
+            // 바이트 하나 손상 (0x42를 만들지 않는 값으로)
+            int at = (int)(rnd() % PMS5003_FRAME_LEN);
+            uint8_t b;
+            do {
+                b = (uint8_t)(f[at] ^ (uint8_t)rnd_range(1, 255));
+            } while (b == 0x42);
+            f[at] = b;
+        } else if (kind == 1 && cuts) {
+            // 중간에 끊긴 프레임: 뒤따르는 바이트가 본문으로 읽혀 체크섬에서 걸러진다
+            uint32_t cut = rnd_range(5, PMS5003_FRAME_LEN - 1);
+            memcpy(s->bytes + s->len, f, cut);
+            s->len += cut;
+            s->has_cuts = true;
+            continue;
+        }
+        memcpy(s->bytes + s->len, f, PMS5003_FRAME_LEN);
+        s->len += PMS5003_FRAME_LEN;
+        if (kind != 0) {
+            s->intact_end[s->intact_count] = s->len;
+            s->intact_count++;
+        }
+    }
+}
+
+// 데이터시트 규칙을 버퍼 인덱스로 그대로 옮긴 참조 파서.
+// 받아들인 프레임이 끝나는 위치를 ends에 채우고 그 수를 반환한다.
+static int reference_frames(const uint8_t *b, size_t len, size_t *ends, int max)
+{
+    int n = 0;
+    size_t i = 0;
+    while (i + 1 < len) {
+        if (b[i] != 0x42 || b[i + 1] != 0x4D) {
+            i++;
+            continue;
+        }
+        if (i + 2 >= len) {
+            break;
+        }
+        if (b[i + 2] != 0) {
+            i += 3;     // 길이 상위 바이트는 소비된다
+            continue;
+        }
+        if (i + 3 >= len) {
+            break;
+        }
+        if (b[i + 3] != PMS5003_PAYLOAD_LEN) {
+            i += 4;
+            continue;
+        }
+        if (i + PMS5003_FRAME_LEN > len) {
+            break;
+        }
+        uint16_t sum = 0;
+        for (size_t k = 0; k < PMS5003_FRAME_LEN - 2; k++) {
+            sum = (uint16_t)(sum + b[i + k]);
+        }
+        if (sum == (uint16_t)(b[i + 30] << 8 | b[i + 31]) && n < max) {
+            ends[n++] = i + PMS5003_FRAME_LEN;
+        }
+        i += PMS5003_FRAME_LEN;
+    }
+    return n;
+}
+
+static void feed_chunked(pms5003_parser_t *p, const uint8_t *data, size_t len)
+{
+    size_t pos = 0;
+    while (pos < len) {
+        size_t chunk = rnd_range(1, 64);
+        if (chunk > len - pos) {
+            chunk = len - pos;
+        }
+        pms5003_feed(p, data + pos, chunk, (uint32_t)pos);
+        pos += chunk;
+    }
+}
+
+static void trial(uint32_t *frames, uint32_t *rejected)
+{
+    static stream_t s;
+    build_stream(&s);
+    size_t ends[MAX_FRAMES];
+    int ref = reference_frames(s.bytes, s.len, ends, MAX_FRAMES);
+    // 끊긴 프레임이 없으면 손상 없이 넣은 프레임이 곧 기대 결과
+    if (!s.has_cuts) {
+        if (ref != s.intact_count) {
+            violation("reference parser", (unsigned long)ref, (unsigned long)s.intact_count);
+            return;
+        }
+        for (int k = 0; k < ref; k++) {
+            if (ends[k] != s.intact_end[k]) {
+                violation("reference parser frame end", ends[k], s.intact_end[k]);
+                return;
+            }
+        }
+    }
+
+    // 바이트 단위로 먹이면서 프레임이 끝나는 위치와 값을 확인
+    pms5003_parser_t p;
+    pms5003_init(&p);
+    int next = 0;
+    uint32_t window[PMS5003_AVG_WINDOW][2];
+    for (size_t i = 0; i < s.len; i++) {
+        int got = pms5003_feed(&p, &s.bytes[i], 1, (uint32_t)i);
+        bool want = next < ref && ends[next] == i + 1;
+        if (got != (want ? 1 : 0)) {
+            violation(want ? "intact frame rejected" : "corrupted frame accepted", (unsigned long)i,
+                      (unsigned long)p.checksum_errors);
+            return;
+        }
+        if (!want) {
+            continue;
+        }
+        // 값은 스트림의 원래 프레임과 비교 (참조 파서의 해석이 아니라)
+        const uint8_t *f = s.bytes + ends[next] - PMS5003_FRAME_LEN;
+        uint16_t words[13];
+        for (int w = 0; w < 13; w++) {
+            words[w] = (uint16_t)(f[4 + w * 2] << 8 | f[5 + w * 2]);
+        }
+        if (!frame_matches(&p.last, words)) {
+            violation("frame values", (unsigned long)next, p.last.pm2_5);
+        }
+        window[next % PMS5003_AVG_WINDOW][0] = words[4];
+        window[next % PMS5003_AVG_WINDOW][1] = words[5];
+        next++;
+    }
+    if (next != ref || p.frames != (uint32_t)ref) {
+        violation("frame count", p.frames, (unsigned long)ref);
+    }
+
+    // 이동 평균
+    float pm25, pm10;
+    if (ref == 0) {
+        if (pms5003_average(&p, (uint32_t)s.len, 1000000, &pm25, &pm10)) {
+            violation("average without frames", 0, 0);
+        }
+    } else {
+        uint32_t n = ref < PMS5003_AVG_WINDOW ? (uint32_t)ref : PMS5003_AVG_WINDOW;
+        uint32_t s25 = 0, s10 = 0;
+        for (uint32_t k = 0; k < n; k++) {
+            s25 += window[k][0];
+            s10 += window[k][1];
+        }
+        if (!pms5003_average(&p, (uint32_t)s.len, 1000000, &pm25, &pm10) || pm25 != (float)s25 / n ||
+            pm10 != (float)s10 / n) {
+            violation("moving average", s25 / n, (unsigned long)pm25);
+        }
+    }
+
+    // 조각 크기와 무관해야 한다
+    pms5003_parser_t q;
+    pms5003_init(&q);
+    feed_chunked(&q, s.bytes, s.len);
+    if (q.frames != p.frames || q.checksum_errors != p.checksum_errors || q.length_errors != p.length_errors ||
+        memcmp(&q.last, &p.last, sizeof(q.last)) != 0) {
+        violation("chunked feed differs", q.frames, p.frames);
+    }
+    *frames += p.frames;
+    *rejected += p.checksum_errors + p.length_errors;
+}
+
+static int replay(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return 2;
+    }
+    static uint8_t data[1 << 20];
+    size_t len = fread(data, 1, sizeof(data), f);
+    fclose(f);
+
+    pms5003_parser_t whole, bytewise;
+    pms5003_init(&whole);
+    pms5003_init(&bytewise);
+    pms5003_feed(&whole, data, len, 0);
+    for (size_t i = 0; i < len; i++) {
+        pms5003_feed(&bytewise, &data[i], 1, 0);
+    }
+    if (whole.frames != bytewise.frames || memcmp(&whole.last, &bytewise.last, sizeof(whole.last)) != 0) {
+        violation("replay differs by chunking", whole.frames, bytewise.frames);
+    }
+    float pm25 = 0, pm10 = 0;
+    pms5003_average(&whole, 0, 1000, &pm25, &pm10);
+    printf("%zu bytes: %u frames, %u checksum errors, %u length errors, %u skipped bytes; last pm2.5 %u pm10 %u, "
+           "average pm2.5 %.1f pm10 %.1f\n",
+           len, (unsigned)whole.frames, (unsigned)whole.checksum_errors, (unsigned)whole.length_errors,
+           (unsigned)whole.skipped_bytes, (unsigned)whole.last.pm2_5, (unsigned)whole.last.pm10, pm25, pm10);
+    printf("%s (%u violations)\n", s_violations ? "FAIL" : "ok", (unsigned)s_violations);
+    return s_violations ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t trials = 2000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--trials") == 0) {
+            trials = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            s_rng = (uint32_t)strtoul(argv[i + 1], NULL, 10) | 1u;
+        } else if (strcmp(argv[i], "--replay") == 0) {
+            return replay(argv[i + 1]);
+        } else {
+            fprintf(stderr, "usage: %s [--trials N] [--seed S] [--replay FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    uint32_t frames = 0, rejected = 0;
+    for (uint32_t i = 0; i < trials; i++) {
+        trial(&frames, &rejected);
+    }
+    printf("%u streams: %u frames accepted, %u rejected by checksum or length\n", (unsigned)trials, (unsigned)frames,
+           (unsigned)rejected);
+    printf("%s (%u violations)\n", s_violations ? "FAIL" : "ok", (unsigned)s_violations);
+    return s_violations ? 1 : 0;
+}
@@ -0,0 +1,339 @@
+// Host simulation of the power modes on a simulated clock.
+//
+// Drives the firmware's scheduler, power manager and connection manager with
+// air_app.c's task table and POWER_PROFILE on hal_posix.c's simulated clock, so
+// hours of operation run in milliseconds. Task bodies only advance the clock
+// by a typical runtime. The scenario, repeated every hour:
+//   - Wi-Fi associates 3 s after each attempt while the AP is up
+//   - the AP is down from minute 20 to 30 (light sleep between retries)
+//   - window commands at minute 10 and 40 (4 s motion), pump run at minute 15
+// For each mode it reports the estimated average current, awake share, wake-ups
+// and command latency, and fails (exit 1) if a wake lock was slept through, a
+// deadline was missed (MQTT connects run in the background and must not cause
+// any), a command waited longer than the poll interval or the sensor was
+// sampled off its period.
+//
+//   cc -std=gnu11 -O2 -I.. -o power_sim power_sim.c ../power_manager.c ../task_scheduler.c ../conn_manager.c ../hal_posix.c -lpthread
+//   ./power_sim                          # one hour per mode
+//   ./power_sim --minutes 240 --wake-latency-us 1500
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "conn_manager.h"
+#include "hal.h"
+#include "power_manager.h"
+#include "task_scheduler.h"
+
+#define MIN_MS 60000u
+
+// air_app.c와 같은 값
+static const pm_config_t POWER_CONFIG = {
+    2, 250, 100, 60000,
+    {
+        { 110000, 95000, 800 },
+        {  45000, 20000, 800 },
+    },
+};
+
+static const uint32_t WIFI_ASSOC_MS = 3000;
+static const uint32_t MQTT_CONNECT_MS = 50;      // 연결 태스크에서 걸리는 시간
+static const uint32_t MOTION_MS = 4000;
+static const uint32_t PUMP_MS = 3000;
+
+static scheduler_t s_sched;
+static power_manager_t s_pm;
+static conn_manager_t s_net;
+
+static uint32_t s_assoc_at;         // 연결이 완료되는 시각 (0이면 시도 없음)
+static bool s_assoc_pending;
+static uint32_t s_mqtt_done_at;     // 백그라운드 MQTT 연결이 끝나는 시각
+static uint32_t s_motion_until, s_pump_until;
+static bool s_motion, s_pump;
+
+typedef struct {
+    uint32_t runs_sensor;
+    uint32_t cmd_latency_max_ms;
+    uint32_t misses;                // 데드라인 초과
+    uint32_t lock_violations;
+    uint32_t wake_latency_max_us;
+} sim_stats_t;
+
+static sim_stats_t s_stats;
+
+static void cost(uint32_t us)
+{
+    hal_sim_clock_advance_us(us);
+}
+
+static bool ap_up(uint32_t now)
+{
+    uint32_t minute = (now / MIN_MS) % 60;
+    return minute < 20 || minute >= 30;
+}
+
+// ---------- Connection callbacks ----------
+static void wifi_begin(void *ctx)
+{
+    (void)ctx;
+    s_assoc_pending = ap_up(hal_millis());
+    s_assoc_at = hal_millis() + WIFI_ASSOC_MS;
+    cost(500);
+}
+
+static bool wifi_up(void *ctx)
+{
+    (void)ctx;
+    uint32_t now = hal_millis();
+    if (!ap_up(now)) {
+        s_assoc_pending = false;
+        return false;
+    }
+    return s_assoc_pending && (int32_t)(now - s_assoc_at) >= 0;
+}
+
+// 브로커는 Wi-Fi와 함께 끊긴다
+static bool mqtt_up(void *ctx)
+{
+    return wifi_up(ctx);
+}
+
+// 연결 태스크에 넘기기만 한다
+static bool mqtt_begin(void *ctx)
+{
+    (void)ctx;
+    cost(100);
+    s_mqtt_done_at = hal_millis() + MQTT_CONNECT_MS;
+    return true;
+}
+
+static conn_attempt_t mqtt_poll(void *ctx)
+{
+    (void)ctx;
+    return (int32_t)(hal_millis() - s_mqtt_done_at) >= 0 ? CONN_ATTEMPT_OK : CONN_ATTEMPT_PENDING;
+}
+
+static uint32_t sim_random(void *ctx)
+{
+    (void)ctx;
+    return (uint32_t)rand();
+}
+
+// ---------- Tasks (bodies only take time) ----------
+static void task_servo(uint32_t now)
+{
+    cost(20);
+    if (s_motion && (int32_t)(now - s_motion_until) >= 0) {
+        s_motion = false;
+        pm_unlock(&s_pm, PM_LOCK_MOTION);
+    }
+}
+
+static void task_pump(uint32_t now)
+{
+    cost(10);
+    if (s_pump && (int32_t)(now - s_pump_until) >= 0) {
+        s_pump = false;
+        pm_unlock(&s_pm, PM_LOCK_PUMP);
+    }
+}
+
+static void task_control(uint32_t now) { (void)now; cost(20); }
+static void task_net(uint32_t now) { conn_manager_tick(&s_net, now); cost(200); }
+static void task_snapshot(uint32_t now) { (void)now; cost(1500); }
+static void task_sensor(uint32_t now) { (void)now; s_stats.runs_sensor++; cost(15000); }
+static void task_pms(uint32_t now) { (void)now; cost(300); }
+static void task_decide(uint32_t now) { (void)now; cost(100); }
+static void task_actuate(uint32_t now) { (void)now; cost(20); }
+static void task_metrics(uint32_t now) { (void)now; cost(200); }
+static void task_status(uint32_t now) { (void)now; cost(500); }
+static void task_log(uint32_t now) { (void)now; cost(100); }
+static void task_store(uint32_t now) { (void)now; cost(5); }
+
+static const sched_task_t TASKS[] = {
+    { "servo",    task_servo,       0,   20,  0, 0, 0, 0, 0, 0, 0 },
+    { "pump",     task_pump,       10,   50,  1, 0, 0, 0, 0, 0, 0 },
+    { "control",  task_control,     0,  100,  2, 0, 0, 0, 0, 0, 0 },
+    { "net",      task_net,         0,  250,  3, 0, 0, 0, 0, 0, 0 },
+    { "snapshot", task_snapshot,  100,  200,  4, 0, 0, 0, 0, 0, 0 },
+    { "sensor",   task_sensor,   2000,  100,  5, 0, 0, 0, 0, 0, 0 },
+    { "pms",      task_pms,       100,   50,  6, 0, 0, 0, 0, 0, 0 },
+    { "decide",   task_decide,    200,   50,  7, 0, 0, 0, 0, 0, 0 },
+    { "actuate",  task_actuate,     0,   20,  8, 0, 0, 0, 0, 0, 0 },
+    { "metrics",  task_metrics,  1000,  100,  9, 0, 0, 0, 0, 0, 0 },
+    { "status",   task_status,  10000, 1000, 10, 0, 0, 0, 0, 0, 0 },
+    { "log",      task_log,         0,  100, 11, 0, 0, 0, 0, 0, 0 },
+    { "store",    task_store,       0,  100, 12, 0, 0, 0, 0, 0, 0 },
+};
+#define TASK_COUNT (sizeof(TASKS) / sizeof(TASKS[0]))
+
+static const struct {
+    sched_task_fn fn;
+    uint32_t period_ms[PM_MODE_COUNT];
+} POWER_PROFILE[] = {
+    { task_pump,     { 10,        0 } },
+    { task_sensor,   { 2000,  30000 } },
+    { task_pms,      { 100,    1000 } },
+    { task_snapshot, { 100,    1000 } },
+    { task_decide,   { 200,    1000 } },
+    { task_metrics,  { 1000,  10000 } },
+    { task_status,   { 10000, 60000 } },
+};
+
+// ---------- Scenario ----------
+typedef struct {
+    uint32_t at_ms;     // 시간(분 단위 주기 안의 오프셋)
+    bool pump;
+} sim_event_t;
+
+static const sim_event_t EVENTS[] = {
+    { 10 * MIN_MS, false },
+    { 15 * MIN_MS, true },
+    { 40 * MIN_MS, false },
+};
+
+// 명령은 큐로 들어오고 다음 패스에서 실행된다 (MQTT는 다음 수신 폴링, HTTP는 대기를 깨움)
+static void deliver_events(uint32_t now, uint32_t *next_event)
+{
+    while ((int32_t)(now - *next_event) >= 0) {
+        uint32_t hour = *next_event / (60 * MIN_MS);
+        uint32_t latency = now - *next_event;
+        if (latency > s_stats.cmd_latency_max_ms) {
+            s_stats.cmd_latency_max_ms = latency;
+        }
+        const sim_event_t *ev = NULL;
+        uint32_t next = UINT32_MAX;
+        for (size_t i = 0; i < sizeof(EVENTS) / sizeof(EVENTS[0]); i++) {
+            uint32_t at = hour * 60 * MIN_MS + EVENTS[i].at_ms;
+            if (at == *next_event) {
+                ev = &EVENTS[i];
+            } else if (at > *next_event && at < next) {
+                next = at;
+            }
+        }
+        if (next == UINT32_MAX) {
+            next = (hour + 1) * 60 * MIN_MS + EVENTS[0].at_ms;
+        }
+        if (ev && ev->pump) {
+            s_pump = true;
+            s_pump_until = now + PUMP_MS;
+            pm_lock(&s_pm, PM_LOCK_PUMP);
+        } else if (ev) {
+            s_motion = true;
+            s_motion_until = now + MOTION_MS;
+            pm_lock(&s_pm, PM_LOCK_MOTION);
+        }
+        *next_event = next;
+    }
+}
+
+// air_app.c power_idle()와 같은 결정, 대기는 시계만 앞당긴다
+static void power_idle(void)
+{
+    uint32_t now = hal_millis();
+    uint32_t idle = sched_idle_ms(&s_sched, now);
+    uint32_t net_idle = conn_manager_idle_ms(&s_net, now);
+    if (net_idle < idle) {
+        idle = net_idle;
+    }
+
+    pm_plan_t plan = pm_plan(&s_pm, idle, conn_wifi_active(&s_net));
+    if (s_pm.locks && plan.ms > s_pm.cfg->busy_wait_ms) {
+        s_stats.lock_violations++;
+    }
+    uint32_t slept = 0;
+    if (plan.state == PM_STATE_LIGHT) {
+        slept = hal_light_sleep(plan.ms, -1);
+    } else if (plan.ms > 0) {
+        hal_sim_clock_advance_us(plan.ms * 1000u);
+        slept = plan.ms * 1000u;
+    }
+    pm_account(&s_pm, plan, slept, hal_millis());
+    if (plan.ms > 0 && s_pm.last_wake_latency_us > s_stats.wake_latency_max_us) {
+        s_stats.wake_latency_max_us = s_pm.last_wake_latency_us;
+    }
+}
+
+static uint32_t total_misses(void)
+{
+    uint32_t n = 0;
+    for (uint8_t i = 0; i < s_sched.count; i++) {
+        n += s_sched.tasks[i].deadline_misses;
+    }
+    return n;
+}
+
+static bool run(pm_mode_t mode, uint32_t minutes, uint32_t wake_latency_us)
+{
+    static sched_task_t tasks[TASK_COUNT];
+    static const conn_ops_t net_ops = {
+        wifi_begin, wifi_up, mqtt_begin, mqtt_poll, mqtt_up, NULL, NULL, NULL, sim_random, NULL,
+    };
+    static const conn_config_t net_cfg = { 1000, 60000, 15000, 100 };
+
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_assoc_pending = s_motion = s_pump = false;
+    s_mqtt_done_at = 0;
+    srand(1);
+    hal_sim_clock_enable(0, wake_latency_us);
+
+    memcpy(tasks, TASKS, sizeof(tasks));
+    sched_init(&s_sched, tasks, TASK_COUNT, hal_micros, hal_millis());
+    conn_manager_init(&s_net, &net_ops, &net_cfg, hal_millis());
+    pm_init(&s_pm, &POWER_CONFIG, mode, hal_millis());
+    for (size_t i = 0; i < sizeof(POWER_PROFILE) / sizeof(POWER_PROFILE[0]); i++) {
+        sched_set_period(&s_sched, POWER_PROFILE[i].fn, POWER_PROFILE[i].period_ms[mode], hal_millis());
+    }
+
+    uint32_t end = minutes * MIN_MS;
+    uint32_t next_event = EVENTS[0].at_ms;
+    while ((int32_t)(hal_millis() - end) < 0) {
+        deliver_events(hal_millis(), &next_event);
+        sched_run(&s_sched, hal_millis());
+        power_idle();
+    }
+    s_stats.misses = total_misses();
+
+    uint32_t sensor_period = POWER_PROFILE[1].period_ms[mode];
+    uint32_t sensor_expected = end / sensor_period;
+    uint32_t cmd_limit = mode == PM_MODE_LOW_POWER ? POWER_CONFIG.max_wait_ms : POWER_CONFIG.busy_wait_ms;
+    // 사건이 AP 장애 중에 오지 않으므로 명령 지연은 수신 폴링 간격 이내여야 한다
+    bool ok = s_stats.lock_violations == 0 && s_stats.misses == 0 &&
+              s_stats.cmd_latency_max_ms <= cmd_limit + 1 &&
+              s_stats.runs_sensor + 1 >= sensor_expected && s_stats.runs_sensor <= sensor_expected + 1;
+
+    printf("%-11s %8.2f %7.1f %11.1f %7u %8u/%-5u %10u %8u %6u %9u  %s\n",
+           mode == PM_MODE_LOW_POWER ? "low_power" : "performance",
+           pm_avg_current_ua(&s_pm) / 1000.0, pm_duty_permille(&s_pm) / 10.0,
+           (double)s_pm.wakeups / minutes, (unsigned)s_pm.light_sleeps,
+           (unsigned)s_stats.runs_sensor, (unsigned)sensor_expected,
+           (unsigned)s_stats.cmd_latency_max_ms, (unsigned)s_stats.wake_latency_max_us,
+           (unsigned)s_stats.misses, (unsigned)s_stats.lock_violations, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t minutes = 60;
+    uint32_t wake_latency_us = 1000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--minutes") == 0) {
+            minutes = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        } else if (strcmp(argv[i], "--wake-latency-us") == 0) {
+            wake_latency_us = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--minutes N] [--wake-latency-us N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (minutes == 0 || minutes > 1000) {
+        fprintf(stderr, "--minutes must be 1..1000\n");
+        return 2;
+    }
+
+    printf("%-11s %8s %7s %11s %7s %14s %10s %8s %6s %9s\n", "mode", "avg_mA", "awake%",
+           "wakeups/min", "light", "sensor_runs", "cmd_max_ms", "wake_us", "misses", "lock_viol");
+    bool ok = run(PM_MODE_PERFORMANCE, minutes, wake_latency_us);
+    ok = run(PM_MODE_LOW_POWER, minutes, wake_latency_us) && ok;
+    return ok ? 0 : 1;
+}
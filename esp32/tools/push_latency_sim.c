@@ -0,0 +1,301 @@
+// Host measurement of push command latency, server timestamp to actuation.
+//
+// A server thread publishes {"command":...,"ts":<epoch ms>} on the device's
+// command topic through an in-process MQTT broker stub (stub_broker.c), 20 to
+// 200 ms apart, mostly window commands with some pump runs. The device side
+// runs air_app.c's push path on the real modules: hal_posix.c's MQTT client,
+// mqtt_topic_classify(), command_dispatch() from esp_command_handler.c and the
+// actuator queue; the timestamp travels with the queued command and
+// cmd_latency.c records it when the task_actuate mirror applies the command.
+// Between loop() passes the device waits as pm_plan() tells it (power_manager.c
+// with air_app.c's POWER_CONFIG), in two setups:
+//   - performance: 2 ms yield between passes
+//   - low-power:   idle device (no wake lock), MQTT polled every max_wait_ms
+// Opposite commands that reach the queue in the same pass cancel out there and
+// are not applied. Exit 1 if a command does not reach the actuator queue or is
+// applied without its latency recorded, or if p99 exceeds 100 ms in performance mode or
+// max_wait_ms + 50 ms in low-power mode.
+//
+//   cc -std=gnu11 -O2 -I.. -o push_latency_sim push_latency_sim.c stub_broker.c ../hal_posix.c
+//      ../esp_command_handler.c ../actuator_queue.c ../cmd_latency.c ../mqtt_ingress.c ../power_manager.c ../dlog.c -lpthread
+//   ./push_latency_sim                    # 100 commands per setup
+//   ./push_latency_sim --commands 500 --seed 7
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "actuator_queue.h"
+#include "cmd_latency.h"
+#include "dlog.h"
+#include "esp_command_handler.h"
+#include "hal.h"
+#include "mqtt_ingress.h"
+#include "power_manager.h"
+#include "stub_broker.h"
+
+static const char *COMMAND_TOPIC = "s_window/sim-device/command";
+static const uint32_t GAP_MIN_MS = 20;
+static const uint32_t GAP_MAX_MS = 200;
+static const uint32_t TARGET_P99_MS = 100;
+
+// air_app.c와 같은 값
+static const pm_config_t POWER_CONFIG = {
+    2, 250, 100, 60000,
+    { { 110000, 95000, 800 }, { 45000, 20000, 800 } },
+};
+
+static uint32_t s_rng = 1;
+
+static uint32_t rnd(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static uint32_t rnd_range(uint32_t lo, uint32_t hi)
+{
+    return lo + rnd() % (hi - lo + 1);
+}
+
+static uint64_t epoch_millis(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static void sleep_ms(uint32_t ms)
+{
+    struct timespec ts = { (time_t)(ms / 1000), (long)(ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0) {
+    }
+}
+
+// ---------- Device (air_app.c mirror) ----------
+static actq_t s_actuators;
+static cmd_latency_t s_latency;
+static uint64_t s_push_sent_ms;
+static uint64_t s_queued_sent_ms[ACT_COUNT];
+static uint32_t s_received;
+static uint32_t s_applied;
+
+bool actuator_request(act_id_t actuator, int target, int32_t value, act_prio_t priority, cmd_source_t source)
+{
+    act_push_result_t r = actq_push(&s_actuators, actuator, target, value, priority, (uint8_t)source);
+    if (r == ACT_PUSH_QUEUED || r == ACT_PUSH_COALESCED) {
+        s_queued_sent_ms[actuator] = s_actuators.has_pending[actuator] ? s_push_sent_ms : 0;
+    }
+    return r != ACT_PUSH_PREEMPTED;
+}
+
+void bug_detected(bool spray)
+{
+    (void)spray;
+}
+
+void bug_cleared(uint32_t settle_ms)
+{
+    (void)settle_ms;
+}
+
+static void record_command_latency(uint64_t sent_ms)
+{
+    if (sent_ms == 0) {
+        return;
+    }
+    uint64_t now = epoch_millis();
+    if (now >= sent_ms) {
+        cmd_latency_record(&s_latency, (uint32_t)(now - sent_ms));
+    }
+}
+
+static void task_actuate(void)
+{
+    act_cmd_t c;
+    while (actq_pop(&s_actuators, &c)) {
+        s_applied++;
+        record_command_latency(s_queued_sent_ms[c.actuator]);
+        s_queued_sent_ms[c.actuator] = 0;
+    }
+}
+
+// handle_push_command()와 같은 흐름 (JSON은 cmd_stream 대신 필드만 찾는다)
+static void handle_push_command(const uint8_t *payload, unsigned int length)
+{
+    char buf[128];
+    size_t n = length < sizeof(buf) - 1 ? length : sizeof(buf) - 1;
+    memcpy(buf, payload, n);
+    buf[n] = '\0';
+    const char *name = strstr(buf, "\"command\":\"");
+    const char *ts = strstr(buf, "\"ts\":");
+    if (name == NULL) {
+        return;
+    }
+    name += 11;
+    const char *end = strchr(name, '"');
+    if (end == NULL) {
+        return;
+    }
+    cmd_args_t args = { 0, 0 };
+    s_push_sent_ms = ts ? strtoull(ts + 5, NULL, 10) : 0;
+    command_dispatch(CMD_SRC_MQTT, name, (size_t)(end - name), &args, NULL);
+    s_push_sent_ms = 0;
+}
+
+static void callback(const char *topic, const uint8_t *payload, unsigned int length)
+{
+    if (mqtt_topic_classify(topic) == MQTT_TOPIC_COMMAND) {
+        s_received++;
+        handle_push_command(payload, length);
+    }
+}
+
+// ---------- Server ----------
+typedef struct {
+    uint32_t commands;
+    uint32_t published;
+    volatile bool done;
+} server_t;
+
+static void *server_main(void *arg)
+{
+    server_t *s = (server_t *)arg;
+    // 창문은 번갈아 열고 닫고, 펌프는 켜고 끈다 (같은 명령 반복은 큐가 흡수하므로 피한다)
+    bool window_open = false, pump_on = false;
+    for (uint32_t i = 0; i < s->commands; i++) {
+        sleep_ms(rnd_range(GAP_MIN_MS, GAP_MAX_MS));
+        const char *cmd;
+        if (rnd() % 5 == 0) {
+            pump_on = !pump_on;
+            cmd = pump_on ? "PUMP_ON" : "PUMP_OFF";
+        } else {
+            window_open = !window_open;
+            cmd = window_open ? "WINDOW_OPEN" : "WINDOW_CLOSE";
+        }
+        char payload[96];
+        int len = snprintf(payload, sizeof(payload), "{\"command\":\"%s\",\"ts\":%llu}", cmd,
+                           (unsigned long long)epoch_millis());
+        if (stub_broker_publish(COMMAND_TOPIC, payload, (size_t)len)) {
+            s->published++;
+        }
+    }
+    sleep_ms(POWER_CONFIG.max_wait_ms * 2);
+    s->done = true;
+    return NULL;
+}
+
+typedef struct {
+    const char *name;
+    pm_mode_t mode;
+    uint32_t limit_p99_ms;
+} setup_t;
+
+static uint32_t run(const setup_t *setup, uint32_t commands)
+{
+    memset(&s_latency, 0, sizeof(s_latency));
+    actq_init(&s_actuators);
+    s_received = 0;
+    s_applied = 0;
+    power_manager_t power;
+    pm_init(&power, &POWER_CONFIG, setup->mode, hal_millis());
+
+    server_t server = { commands, 0, false };
+    pthread_t t;
+    if (pthread_create(&t, NULL, server_main, &server) != 0) {
+        return 1;
+    }
+    uint32_t passes = 0;
+    while (!server.done) {
+        // loop(): 스케줄러 패스 (net → actuate), 그다음 power_idle()
+        hal_mqtt_loop();
+        task_actuate();
+        passes++;
+        pm_plan_t plan = pm_plan(&power, 1000, true);
+        sleep_ms(plan.ms);
+    }
+    pthread_join(t, NULL);
+
+    cmd_latency_summary_t sum;
+    cmd_latency_summary(&s_latency, &sum);
+    printf("%-12s %8u %8u %9u %8u %8u %8u %8u\n", setup->name, (unsigned)server.published, (unsigned)s_applied,
+           (unsigned)s_actuators.coalesced, (unsigned)sum.p50_ms, (unsigned)sum.p99_ms, (unsigned)sum.max_ms,
+           (unsigned)passes);
+
+    // 한 패스 안에 도착한 반대 명령끼리는 큐에서 상쇄되므로 적용 수는 더 적을 수 있다
+    uint32_t violations = 0;
+    if (server.published != commands || s_received != commands || s_actuators.pushed != commands ||
+        sum.count != s_applied) {
+        fprintf(stderr, "%s: %u commands, %u published, %u received, %u applied, %u coalesced, %u recorded\n",
+                setup->name, (unsigned)commands, (unsigned)server.published, (unsigned)s_received,
+                (unsigned)s_applied, (unsigned)s_actuators.coalesced, (unsigned)sum.count);
+        violations++;
+    }
+    if (sum.p99_ms > setup->limit_p99_ms) {
+        fprintf(stderr, "%s: p99 %u ms over %u ms\n", setup->name, (unsigned)sum.p99_ms,
+                (unsigned)setup->limit_p99_ms);
+        violations++;
+    }
+    return violations;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t commands = 100;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--commands") == 0) {
+            commands = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            s_rng = (uint32_t)strtoul(argv[i + 1], NULL, 10) | 1u;
+        } else {
+            fprintf(stderr, "usage: %s [--commands N] [--seed S]\n", argv[0]);
+            return 2;
+        }
+    }
+    // p99는 최근 CMD_LATENCY_WINDOW개 기준
+    if (commands == 0) {
+        return 2;
+    }
+    dlog_init(hal_millis);
+    for (int m = 0; m < DLOG_MOD_COUNT; m++) {
+        dlog_set_level((dlog_module_t)m, DLOG_NONE);
+    }
+
+    uint16_t port = stub_broker_start();
+    if (port == 0) {
+        return 2;
+    }
+    hal_mqtt_setup("127.0.0.1", port, callback);
+    if (!hal_mqtt_connect("sim-device", NULL, NULL, NULL, NULL) || !hal_mqtt_subscribe("s_window/sim-device/+")) {
+        fprintf(stderr, "cannot connect to the stub broker\n");
+        return 2;
+    }
+    // SUBACK을 받을 때까지
+    for (int i = 0; i < 100; i++) {
+        stub_broker_stats_t st;
+        stub_broker_get_stats(&st);
+        if (st.subscribes > 0) {
+            break;
+        }
+        sleep_ms(1);
+        hal_mqtt_loop();
+    }
+
+    const setup_t setups[] = {
+        { "performance", PM_MODE_PERFORMANCE, TARGET_P99_MS },
+        { "low-power", PM_MODE_LOW_POWER, POWER_CONFIG.max_wait_ms + 50 },
+    };
+    uint32_t violations = 0;
+    printf("%-12s %8s %8s %9s %8s %8s %8s %8s\n", "setup", "sent", "applied", "coalesced", "p50 ms", "p99 ms",
+           "max ms", "passes");
+    for (size_t i = 0; i < sizeof(setups) / sizeof(setups[0]); i++) {
+        violations += run(&setups[i], commands);
+    }
+    printf("%s (%u violations)\n", violations ? "FAIL" : "ok", (unsigned)violations);
+    return violations ? 1 : 0;
+}
@@ -0,0 +1,505 @@
+// Host unit test of the telemetry sample buffer, its encoders and the NVS spill.
+//
+// Checks air_sample_buffer.c against a plain reference queue and an in-memory
+// flash:
+//   - ring: random push/peek/consume sequences keep the order, the count and
+//     the dropped counter of the reference, including wrap-around and
+//     overwrite when full
+//   - json/binary: fixed samples encode to the expected bytes, NaN
+//     temperature/humidity become null (json) or INT16_MIN/0 (binary), and
+//     every output buffer one byte short of the frame is refused
+//   - spill: only a full buffer is written, at most once per
+//     AIR_SAMPLE_SPILL_INTERVAL_MS and never twice with the same content; a
+//     restore brings back the samples with their ages; a POST removes only
+//     the samples it delivered (not those overwritten in RAM since the spill);
+//     torn or corrupted records are ignored
+//   - reboots: random outages, recoveries and power cuts; a reboot restores
+//     exactly the samples of the last spill that no successful POST delivered
+// It also reports the flash writes over a 24 h outage. Exit 1 on any violation.
+//
+//   cc -std=gnu11 -O2 -I.. -o sample_buffer_test sample_buffer_test.c ../air_sample_buffer.c ../durable_state.c
+//   ./sample_buffer_test                  # 2000 reboot trials
+//   ./sample_buffer_test --trials 20000 --seed 7
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "air_sample_buffer.h"
+
+#define CAP AIR_SAMPLE_BUFFER_CAPACITY
+
+static const uint32_t SAMPLE_MS = 5000;
+
+static uint32_t s_violations;
+
+static void violation(const char *what, unsigned long a, unsigned long b)
+{
+    if (s_violations++ < 20) {
+        fprintf(stderr, "violation: %s (%lu, %lu)\n", what, a, b);
+    }
+}
+
+static uint32_t s_rng = 1;
+
+static uint32_t rnd(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static uint32_t rnd_range(uint32_t lo, uint32_t hi)
+{
+    return lo + rnd() % (hi - lo + 1);
+}
+
+// 샘플 번호를 pm25/pm10에 나눠 담는다 (복원된 샘플이 어느 것인지 알기 위해)
+static air_sample_t make_sample(uint32_t id, uint32_t t_ms)
+{
+    air_sample_t s;
+    memset(&s, 0, sizeof(s));
+    s.timestamp_ms = t_ms;
+    s.temperature = 20.0f + (float)(id % 100) * 0.01f;
+    s.humidity = 40.0f;
+    s.pm25 = (int16_t)(id & 0x7fff);
+    s.pm10 = (int16_t)((id >> 15) & 0x7fff);
+    s.bug = (id % 7) == 0;
+    return s;
+}
+
+static uint32_t sample_id(const air_sample_t *s)
+{
+    return (uint32_t)s->pm25 | ((uint32_t)s->pm10 << 15);
+}
+
+// ---------- In-memory flash ----------
+typedef struct {
+    uint8_t data[sizeof(air_sample_t) * CAP + 64];
+    int len;                    // -1이면 키 없음
+    uint32_t writes;
+    int tear_at;                // 0 이상이면 다음 쓰기를 이 길이에서 끊는다
+    bool fail;
+} flash_t;
+
+static flash_t s_flash;
+
+static int flash_read(void *ctx, const char *key, void *buf, size_t cap)
+{
+    (void)ctx;
+    (void)key;
+    if (s_flash.len < 0) {
+        return -1;
+    }
+    if ((size_t)s_flash.len > cap) {
+        return 0;
+    }
+    memcpy(buf, s_flash.data, (size_t)s_flash.len);
+    return s_flash.len;
+}
+
+static bool flash_write(void *ctx, const char *key, const void *data, size_t len)
+{
+    (void)ctx;
+    (void)key;
+    if (s_flash.fail || len > sizeof(s_flash.data)) {
+        return false;
+    }
+    s_flash.writes++;
+    if (s_flash.tear_at >= 0 && (size_t)s_flash.tear_at < len) {
+        memcpy(s_flash.data, data, (size_t)s_flash.tear_at);
+        s_flash.len = s_flash.tear_at;
+        s_flash.tear_at = -1;
+        return false;
+    }
+    memcpy(s_flash.data, data, len);
+    s_flash.len = (int)len;
+    return true;
+}
+
+static const ds_ops_t FLASH_OPS = { flash_read, flash_write, NULL };
+
+static void flash_erase(void)
+{
+    memset(&s_flash, 0, sizeof(s_flash));
+    s_flash.len = -1;
+    s_flash.tear_at = -1;
+}
+
+// ---------- Ring ----------
+static void test_ring(uint32_t ops)
+{
+    static air_sample_buffer_t b;
+    static uint32_t ref[1 << 16];       // 참조 큐 (샘플 번호)
+    uint32_t ref_head = 0, ref_count = 0, ref_dropped = 0, next_id = 0;
+    air_sample_buffer_init(&b);
+
+    for (uint32_t i = 0; i < ops; i++) {
+        uint32_t op = rnd() % 10;
+        if (op < 6) {
+            air_sample_t s = make_sample(next_id, i);
+            air_sample_buffer_push(&b, &s);
+            ref[(ref_head + ref_count) & 0xffff] = next_id++;
+            if (ref_count < CAP) {
+                ref_count++;
+            } else {
+                ref_head++;
+                ref_dropped++;
+            }
+        } else if (op < 9) {
+            air_sample_t out[CAP + 8];
+            uint16_t max = (uint16_t)rnd_range(0, CAP + 8);
+            uint16_t n = air_sample_buffer_peek(&b, out, max);
+            if (n != (ref_count < max ? ref_count : max)) {
+                violation("peek count", n, ref_count);
+            }
+            for (uint16_t k = 0; k < n; k++) {
+                if (sample_id(&out[k]) != ref[(ref_head + k) & 0xffff]) {
+                    violation("peek order", sample_id(&out[k]), ref[(ref_head + k) & 0xffff]);
+                    break;
+                }
+            }
+        } else {
+            uint16_t n = (uint16_t)rnd_range(0, 40);
+            air_sample_buffer_consume(&b, n);
+            n = n < ref_count ? n : (uint16_t)ref_count;
+            ref_head += n;
+            ref_count -= n;
+        }
+        if (air_sample_buffer_count(&b) != ref_count || b.dropped != ref_dropped) {
+            violation("count/dropped", air_sample_buffer_count(&b), ref_count);
+            return;
+        }
+    }
+}
+
+// ---------- Encoders ----------
+static void test_json(void)
+{
+    air_sample_t s[2];
+    memset(s, 0, sizeof(s));
+    s[0] = (air_sample_t){ 1000, 23.5f, 40.2f, 12, 25, false };
+    s[1] = (air_sample_t){ 4000, NAN, NAN, 3, 4, true };
+    const char *want = "[{\"temperature\":23.50,\"humidity\":40.20,\"pm25\":12,\"pm10\":25,\"bug\":false,\"age_ms\":4000},"
+                       "{\"temperature\":null,\"humidity\":null,\"pm25\":3,\"pm10\":4,\"bug\":true,\"age_ms\":1000}]";
+    char out[256];
+    int n = air_sample_encode_json(s, 2, 5000, out, sizeof(out));
+    if (n != (int)strlen(want) || strcmp(out, want) != 0) {
+        violation("json frame", (unsigned long)n, strlen(want));
+        fprintf(stderr, "  got  %s\n  want %s\n", n > 0 ? out : "", want);
+    }
+    // 종료 문자까지 들어가야 한다
+    for (size_t cap = 0; cap <= strlen(want); cap++) {
+        if (air_sample_encode_json(s, 2, 5000, out, cap) != -1) {
+            violation("json accepted short buffer", cap, strlen(want));
+            break;
+        }
+    }
+    if (air_sample_encode_json(s, 0, 5000, out, sizeof(out)) != 2 || strcmp(out, "[]") != 0) {
+        violation("json empty batch", 0, 0);
+    }
+}
+
+static uint32_t get_u32(const uint8_t *p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+static uint16_t get_u16(const uint8_t *p) { return (uint16_t)(p[0] | p[1] << 8); }
+
+static void test_binary(void)
+{
+    air_sample_t s[3];
+    memset(s, 0, sizeof(s));
+    s[0] = (air_sample_t){ 1000, 23.5f, 40.2f, 12, 25, false };
+    s[1] = (air_sample_t){ 4000, -5.25f, 99.99f, -1, 300, true };
+    s[2] = (air_sample_t){ 4900, NAN, NAN, 0, 0, false };
+    const struct { uint32_t age; int16_t temp; uint16_t hum, pm25, pm10; uint8_t flags; } want[3] = {
+        { 4000, 2350, 4020, 12, 25, 0 },
+        { 1000, -525, 9999, 0, 300, 1 },
+        { 100, INT16_MIN, 0, 0, 0, 0 },
+    };
+    uint8_t out[64];
+    int n = air_sample_encode_binary(s, 3, 5000, out, sizeof(out));
+    int need = AIR_SAMPLE_BINARY_HEADER + 3 * AIR_SAMPLE_BINARY_RECORD;
+    if (n != need || out[0] != 'A' || out[1] != 'Q' || out[2] != AIR_SAMPLE_BINARY_VERSION || out[3] != 3) {
+        violation("binary header", (unsigned long)n, (unsigned long)need);
+        return;
+    }
+    for (int i = 0; i < 3; i++) {
+        const uint8_t *r = out + AIR_SAMPLE_BINARY_HEADER + i * AIR_SAMPLE_BINARY_RECORD;
+        if (get_u32(r) != want[i].age || (int16_t)get_u16(r + 4) != want[i].temp || get_u16(r + 6) != want[i].hum ||
+            get_u16(r + 8) != want[i].pm25 || get_u16(r + 10) != want[i].pm10 || r[12] != want[i].flags) {
+            violation("binary record", (unsigned long)i, 0);
+        }
+    }
+    if (air_sample_encode_binary(s, 3, 5000, out, (size_t)need - 1) != -1) {
+        violation("binary accepted short buffer", (unsigned long)need - 1, (unsigned long)need);
+    }
+}
+
+// ---------- Spill ----------
+static void fill(air_sample_buffer_t *b, uint32_t *next_id, uint32_t n, uint32_t *t_ms)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        air_sample_t s = make_sample((*next_id)++, *t_ms);
+        air_sample_buffer_push(b, &s);
+        *t_ms += SAMPLE_MS;
+    }
+}
+
+static void test_spill(void)
+{
+    static air_sample_buffer_t b, r;
+    air_sample_spill_t sp;
+    uint32_t id = 0, t = 1000;
+    flash_erase();
+    air_sample_buffer_init(&b);
+    air_sample_spill_init(&sp, &FLASH_OPS);
+
+    // 가득 차기 전에는 쓰지 않는다
+    fill(&b, &id, CAP - 1, &t);
+    if (air_sample_spill_poll(&sp, &b, t) || s_flash.writes != 0) {
+        violation("spilled before overflow", s_flash.writes, 0);
+    }
+    fill(&b, &id, 1, &t);
+    if (!air_sample_spill_poll(&sp, &b, t) || s_flash.writes != 1) {
+        violation("no spill at overflow", s_flash.writes, 1);
+    }
+    // 간격 안에서는 새 샘플이 있어도 쓰지 않는다
+    fill(&b, &id, 10, &t);
+    if (air_sample_spill_poll(&sp, &b, t) || s_flash.writes != 1) {
+        violation("spill within interval", s_flash.writes, 1);
+    }
+    // 간격이 지났어도 내용이 그대로면 쓰지 않는다
+    t += AIR_SAMPLE_SPILL_INTERVAL_MS;
+    if (!air_sample_spill_poll(&sp, &b, t) || s_flash.writes != 2) {
+        violation("no spill after interval", s_flash.writes, 2);
+    }
+    t += AIR_SAMPLE_SPILL_INTERVAL_MS;
+    if (air_sample_spill_poll(&sp, &b, t) || s_flash.writes != 2) {
+        violation("spill of unchanged buffer", s_flash.writes, 2);
+    }
+
+    // 재부팅: 같은 샘플이 같은 age로 돌아온다
+    uint32_t boot_t = 50;
+    air_sample_t a[CAP], c[CAP];
+    air_sample_buffer_peek(&b, a, CAP);
+    air_sample_buffer_init(&r);
+    air_sample_spill_t sp2;
+    air_sample_spill_init(&sp2, &FLASH_OPS);
+    uint16_t n = air_sample_spill_restore(&sp2, &r, boot_t);
+    air_sample_buffer_peek(&r, c, CAP);
+    if (n != CAP) {
+        violation("restore count", n, CAP);
+    }
+    for (uint16_t i = 0; i < n; i++) {
+        // 보관 시점(t - interval) 기준 age가 재부팅 시점 기준 age가 된다
+        uint32_t age_then = (t - AIR_SAMPLE_SPILL_INTERVAL_MS) - a[i].timestamp_ms;
+        if (sample_id(&c[i]) != sample_id(&a[i]) || boot_t - c[i].timestamp_ms != age_then ||
+            c[i].temperature != a[i].temperature || c[i].bug != a[i].bug) {
+            violation("restored sample", i, sample_id(&c[i]));
+            break;
+        }
+    }
+    // 복원 직후에는 같은 내용을 다시 쓰지 않는다
+    if (air_sample_spill_poll(&sp2, &r, boot_t + SAMPLE_MS) || s_flash.writes != 2) {
+        violation("re-spill of restored buffer", s_flash.writes, 2);
+    }
+    // 배치 하나를 보내면 그 샘플만 저장본에서 빠진다
+    air_sample_buffer_consume(&r, 10);
+    air_sample_spill_sent(&sp2, &r, 10);
+    if (s_flash.writes != 3) {
+        violation("partial invalidate writes", s_flash.writes, 3);
+    }
+    air_sample_spill_t sp3;
+    air_sample_buffer_init(&r);
+    air_sample_spill_init(&sp3, &FLASH_OPS);
+    n = air_sample_spill_restore(&sp3, &r, boot_t);
+    air_sample_buffer_peek(&r, c, CAP);
+    if (n != CAP - 10 || sample_id(&c[0]) != sample_id(&a[10]) || sample_id(&c[n - 1]) != sample_id(&a[CAP - 1])) {
+        violation("restore after a partial send", n, CAP - 10);
+    }
+    // 나머지를 보내면 무효화, 그 뒤의 성공은 쓰지 않는다
+    air_sample_buffer_consume(&r, CAP - 10);
+    air_sample_spill_sent(&sp3, &r, CAP - 10);
+    air_sample_spill_sent(&sp3, &r, 10);
+    if (s_flash.writes != 4) {
+        violation("invalidate writes", s_flash.writes, 4);
+    }
+    air_sample_buffer_init(&r);
+    air_sample_spill_init(&sp2, &FLASH_OPS);
+    if (air_sample_spill_restore(&sp2, &r, boot_t) != 0) {
+        violation("restored an invalidated spill", air_sample_buffer_count(&r), 0);
+    }
+
+    // 끊긴 쓰기와 손상된 레코드는 복원하지 않는다
+    air_sample_spill_init(&sp, &FLASH_OPS);
+    s_flash.tear_at = 200;
+    air_sample_spill_poll(&sp, &b, t);
+    air_sample_buffer_init(&r);
+    if (air_sample_spill_restore(&sp2, &r, boot_t) != 0) {
+        violation("restored a torn spill", air_sample_buffer_count(&r), 0);
+    }
+    air_sample_spill_init(&sp, &FLASH_OPS);
+    air_sample_spill_poll(&sp, &b, t);
+    s_flash.data[s_flash.len / 2] ^= 0x40;
+    air_sample_buffer_init(&r);
+    if (air_sample_spill_restore(&sp2, &r, boot_t) != 0) {
+        violation("restored a corrupted spill", air_sample_buffer_count(&r), 0);
+    }
+
+    // 보관 뒤 덮어써진 샘플은 버퍼에 없으므로 보내도 저장본에 남는다
+    air_sample_buffer_init(&b);
+    air_sample_spill_init(&sp, &FLASH_OPS);
+    fill(&b, &id, CAP, &t);
+    air_sample_spill_poll(&sp, &b, t);
+    air_sample_buffer_peek(&b, a, CAP);
+    fill(&b, &id, 5, &t);
+    air_sample_buffer_consume(&b, 20);
+    air_sample_spill_sent(&sp, &b, 20);
+    air_sample_buffer_init(&r);
+    air_sample_spill_init(&sp2, &FLASH_OPS);
+    n = air_sample_spill_restore(&sp2, &r, t);
+    air_sample_buffer_peek(&r, c, CAP);
+    if (n != CAP - 20 || sample_id(&c[0]) != sample_id(&a[0]) || sample_id(&c[4]) != sample_id(&a[4]) ||
+        sample_id(&c[5]) != sample_id(&a[25])) {
+        violation("overwritten samples kept, sent ones removed", n, CAP - 20);
+    }
+}
+
+// 24시간 장애 동안의 플래시 쓰기 (5초 샘플, 백오프 최대 120초로 재시도)
+static uint32_t outage_writes(void)
+{
+    static air_sample_buffer_t b;
+    air_sample_spill_t sp;
+    flash_erase();
+    air_sample_buffer_init(&b);
+    air_sample_spill_init(&sp, &FLASH_OPS);
+    uint32_t id = 0, backoff = 0, next_retry = 0;
+    for (uint32_t t = 0; t < 24u * 3600u * 1000u; t += SAMPLE_MS) {
+        air_sample_t s = make_sample(id++, t);
+        air_sample_buffer_push(&b, &s);
+        if ((int32_t)(t - next_retry) >= 0) {
+            backoff = backoff ? (backoff * 2 > 120000 ? 120000 : backoff * 2) : 2000;
+            next_retry = t + backoff;
+            air_sample_spill_poll(&sp, &b, t);
+        }
+    }
+    return s_flash.writes;
+}
+
+// ---------- Reboots ----------
+// 마지막 보관 이후 보낸 샘플을 빼면 재부팅 때 정확히 그만큼이 돌아와야 한다
+#define MAX_IDS 200000
+
+static uint8_t s_sent[MAX_IDS];
+
+static void trial_reboots(void)
+{
+    static air_sample_buffer_t b;
+    static uint32_t spilled[CAP];       // 마지막으로 보관에 성공한 샘플 번호
+    uint32_t spilled_n = 0;
+    air_sample_spill_t sp;
+    flash_erase();
+    memset(s_sent, 0, sizeof(s_sent));
+    air_sample_buffer_init(&b);
+    air_sample_spill_init(&sp, &FLASH_OPS);
+
+    uint32_t id = 0, t = 0;
+    bool online = rnd() % 2;
+    for (int step = 0; step < 3000 && id < MAX_IDS; step++) {
+        t += SAMPLE_MS;
+        air_sample_t s = make_sample(id++, t);
+        air_sample_buffer_push(&b, &s);
+        uint32_t ev = rnd() % 1000;
+        if (ev < 5) {
+            online = !online;
+        }
+        // 보관 쓰기만 실패시킨다 (무효화가 실패하면 보낸 샘플이 다시 올라오는 것은 피할 수 없다)
+        s_flash.fail = false;
+
+        if (online) {
+            // 배치 몇 개 전송
+            for (int k = 0; k < 3 && air_sample_buffer_count(&b) > 0; k++) {
+                air_sample_t batch[10];
+                uint16_t n = air_sample_buffer_peek(&b, batch, 10);
+                for (uint16_t i = 0; i < n; i++) {
+                    s_sent[sample_id(&batch[i])] = 1;
+                }
+                air_sample_buffer_consume(&b, n);
+                air_sample_spill_sent(&sp, &b, n);
+            }
+        } else {
+            s_flash.fail = rnd() % 50 == 0;
+            uint32_t before = s_flash.writes;
+            if (air_sample_spill_poll(&sp, &b, t)) {
+                air_sample_t all[CAP];
+                spilled_n = air_sample_buffer_peek(&b, all, CAP);
+                for (uint32_t i = 0; i < spilled_n; i++) {
+                    spilled[i] = sample_id(&all[i]);
+                }
+            } else if (s_flash.writes != before && air_sample_buffer_count(&b) < CAP) {
+                violation("spill below capacity", air_sample_buffer_count(&b), CAP);
+            }
+        }
+
+        if (ev >= 995) {
+            // 전원 차단 후 재부팅
+            s_flash.fail = false;
+            air_sample_buffer_init(&b);
+            air_sample_spill_init(&sp, &FLASH_OPS);
+            t = rnd_range(0, 10000);
+            uint16_t n = air_sample_spill_restore(&sp, &b, t);
+            air_sample_t all[CAP];
+            air_sample_buffer_peek(&b, all, CAP);
+            for (uint16_t i = 0; i < n; i++) {
+                if (s_sent[sample_id(&all[i])]) {
+                    violation("restored an already sent sample", sample_id(&all[i]), i);
+                    break;
+                }
+            }
+            uint16_t k = 0;
+            bool same = true;
+            for (uint32_t i = 0; i < spilled_n && same; i++) {
+                if (!s_sent[spilled[i]]) {
+                    same = k < n && sample_id(&all[k++]) == spilled[i];
+                }
+            }
+            if (!same || k != n) {
+                violation("restore is not the unsent part of the last spill", n, k);
+            }
+            if (n == 0) {
+                spilled_n = 0;
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t trials = 2000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--trials") == 0) {
+            trials = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            s_rng = (uint32_t)strtoul(argv[i + 1], NULL, 10) | 1u;
+        } else {
+            fprintf(stderr, "usage: %s [--trials N] [--seed S]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    test_ring(200000);
+    test_json();
+    test_binary();
+    test_spill();
+    for (uint32_t i = 0; i < trials; i++) {
+        trial_reboots();
+    }
+    uint32_t writes = outage_writes();
+    printf("24 h outage: %u flash writes (capacity %u samples, interval %lu s)\n", (unsigned)writes,
+           (unsigned)CAP, (unsigned long)(AIR_SAMPLE_SPILL_INTERVAL_MS / 1000));
+    if (writes > 24u * 3600u * 1000u / AIR_SAMPLE_SPILL_INTERVAL_MS + 1) {
+        violation("outage writes", writes, 24u * 3600u * 1000u / AIR_SAMPLE_SPILL_INTERVAL_MS + 1);
+    }
+    printf("%s (%u violations)\n", s_violations ? "FAIL" : "ok", (unsigned)s_violations);
+    return s_violations ? 1 : 0;
+}
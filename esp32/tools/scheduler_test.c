@@ -0,0 +1,171 @@
+// Host unit test of the cooperative scheduler's clock handling.
+//
+// Runs task_scheduler.c on a fake microsecond clock where each task body
+// advances the clock by its simulated runtime, and checks that sched_run()
+// re-reads the clock before every task:
+//   - a task whose release falls inside the pass, after an earlier slow task,
+//     runs in that same pass and receives the later time
+//   - time spent waiting behind earlier tasks of the pass counts against a
+//     task's deadline
+//   - periodic tasks keep their phase when they run late within a pass
+// Then a random soak (random runtimes and periods) checks that every task
+// sees non-decreasing times, never runs before its release, and that the
+// deadline misses match an independent count. Exit 1 on any violation.
+//
+//   cc -std=gnu11 -O2 -I.. -o scheduler_test scheduler_test.c ../task_scheduler.c
+//   ./scheduler_test                      # 200000 passes
+//   ./scheduler_test --passes 2000000 --seed 7
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "task_scheduler.h"
+
+#define TASKS 4
+
+static uint64_t s_clock_us;    // 가짜 시계. sched에는 32비트 us로, 패스 시각은 ms로 넘긴다 (따로 넘어간다)
+static uint32_t s_violations;
+
+static uint32_t clock_us(void)
+{
+    return (uint32_t)s_clock_us;
+}
+
+static void violation(const char *what, unsigned long a, unsigned long b)
+{
+    if (s_violations++ < 20) {
+        fprintf(stderr, "violation: %s (%lu, %lu)\n", what, a, b);
+    }
+}
+
+static uint32_t s_rng = 1;
+
+static uint32_t rnd(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+// 태스크 본문: 실행 시간만큼 시계를 진행하고, 받은 시각을 기록
+typedef struct {
+    uint32_t runtime_us;
+    uint32_t last_now;
+    uint32_t calls;
+} body_t;
+
+static body_t s_body[TASKS];
+
+#define BODY(i) static void task##i(uint32_t now) { \
+        if (s_body[i].calls && (int32_t)(now - s_body[i].last_now) < 0) violation("time went back", i, now); \
+        s_body[i].last_now = now; s_body[i].calls++; s_clock_us += s_body[i].runtime_us; }
+BODY(0)
+BODY(1)
+BODY(2)
+BODY(3)
+
+static const sched_task_fn FNS[TASKS] = { task0, task1, task2, task3 };
+
+static void test_fixed(void)
+{
+    scheduler_t s;
+    sched_task_t tasks[TASKS] = {
+        { .name = "slow", .fn = task0, .period_ms = 0, .deadline_ms = 0, .priority = 0 },
+        { .name = "tick", .fn = task1, .period_ms = 10, .deadline_ms = 5, .priority = 1 },
+        { .name = "late", .fn = task2, .period_ms = 0, .deadline_ms = 5, .priority = 2 },
+    };
+    memset(s_body, 0, sizeof(s_body));
+    s_clock_us = 100000;
+    sched_init(&s, tasks, 3, clock_us, 100);
+    // 첫 패스: 모두 실행 (tick 다음 릴리스 110)
+    sched_run(&s, (uint32_t)(s_clock_us / 1000));
+    uint32_t tick_calls = s_body[1].calls;
+
+    // 105 ms에 시작한 패스에서 slow가 12 ms를 쓰면 tick(110)은 같은 패스의 117 ms에 실행된다
+    s_clock_us = 105000;
+    s_body[0].runtime_us = 12000;
+    sched_run(&s, (uint32_t)(s_clock_us / 1000));
+    if (s_body[1].calls != tick_calls + 1) {
+        violation("release inside the pass missed", s_body[1].calls, tick_calls + 1);
+    }
+    if (s_body[1].last_now != 117) {
+        violation("task got the stale pass time", s_body[1].last_now, 117);
+    }
+    // 주기 위상 유지: 다음 릴리스는 120 (117 + 10이 아님)
+    if (tasks[1].next_release_ms != 120) {
+        violation("periodic phase lost", tasks[1].next_release_ms, 120);
+    }
+    // tick: 릴리스 110, 시작 117 → 데드라인 5 ms 초과. late: 패스 시작 105에 릴리스, 117에 시작 → 초과
+    if (tasks[1].deadline_misses != 1 || tasks[2].deadline_misses != 1) {
+        violation("waiting behind a slow task not counted", tasks[1].deadline_misses, tasks[2].deadline_misses);
+    }
+}
+
+static void test_soak(uint32_t passes)
+{
+    scheduler_t s;
+    sched_task_t tasks[TASKS];
+    uint32_t expect_misses[TASKS] = { 0 };
+    memset(tasks, 0, sizeof(tasks));
+    memset(s_body, 0, sizeof(s_body));
+    for (int i = 0; i < TASKS; i++) {
+        tasks[i].name = "t";
+        tasks[i].fn = FNS[i];
+        tasks[i].period_ms = i == 0 ? 0 : 1 + rnd() % 50;
+        tasks[i].deadline_ms = 5 + rnd() % 20;
+        tasks[i].priority = (uint8_t)i;
+    }
+    s_clock_us = 0xfff00000u;   // 곧 32비트 us 시계가 넘어간다 (ms는 계속 증가)
+    sched_init(&s, tasks, TASKS, clock_us, (uint32_t)(s_clock_us / 1000));
+
+    for (uint32_t p = 0; p < passes; p++) {
+        for (int i = 0; i < TASKS; i++) {
+            s_body[i].runtime_us = rnd() % 8 == 0 ? rnd() % 20000 : rnd() % 500;
+        }
+        uint32_t now = (uint32_t)(s_clock_us / 1000);
+        uint32_t release[TASKS], calls[TASKS];
+        for (int i = 0; i < TASKS; i++) {
+            release[i] = tasks[i].period_ms ? tasks[i].next_release_ms : now;
+            calls[i] = s_body[i].calls;
+        }
+        sched_run(&s, now);
+        for (int i = 0; i < TASKS; i++) {
+            if (s_body[i].calls == calls[i]) {
+                continue;
+            }
+            uint32_t t = s_body[i].last_now;
+            if ((int32_t)(t - release[i]) < 0) {
+                violation("ran before its release", t, release[i]);
+            }
+            if ((t - release[i]) + s_body[i].runtime_us / 1000 > tasks[i].deadline_ms) {
+                expect_misses[i]++;
+            }
+        }
+        s_clock_us += rnd() % 3000;   // 패스 사이 대기
+    }
+    for (int i = 0; i < TASKS; i++) {
+        if (tasks[i].deadline_misses != expect_misses[i]) {
+            violation("deadline misses", tasks[i].deadline_misses, expect_misses[i]);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t passes = 200000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--passes") == 0) {
+            passes = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            s_rng = (uint32_t)strtoul(argv[i + 1], NULL, 10) | 1u;
+        } else {
+            fprintf(stderr, "usage: %s [--passes N] [--seed S]\n", argv[0]);
+            return 2;
+        }
+    }
+    test_fixed();
+    test_soak(passes);
+    printf("%s (%u violations)\n", s_violations ? "FAIL" : "ok", (unsigned)s_violations);
+    return s_violations ? 1 : 0;
+}
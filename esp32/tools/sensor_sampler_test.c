@@ -0,0 +1,192 @@
+// Host test of the background SHT31 sampler (sensor_sampler.c) on the fake
+// I2C bus of hal_posix.c.
+//
+// The sampler reads through hal_env_read() the way air_app.c's task_sensor
+// does, every SENSOR_PERIOD_MS on the simulated clock, which also advances by
+// the time each read spends on the bus. Checks that:
+//   - the SHT31 is found at 0x44 and a good read matches the set values to
+//     the sensor's resolution
+//   - a read with a flipped data bit (CRC error) is refused: the published
+//     value keeps its last good value and timestamp, and the error is counted
+//   - NACKs keep the last reading valid until SENSOR_MAX_FAILURES consecutive
+//     failures, then publish it as invalid with its old timestamp (stale);
+//     the first good read after that is valid and current again
+//   - a stuck bus costs at most the bus timeout per read, never more, so a
+//     failing sensor cannot hold loop()
+//   - a reader thread calling sensor_sampler_get() while the sampler publishes
+//     never sees a torn snapshot (humidity is always temperature + 30); on a
+//     single-core host a tear needs a preemption inside the copy, so this
+//     mostly bites on multi-core machines
+// Exit 1 on the first mismatch.
+//
+//   cc -std=gnu11 -O2 -I.. -o sensor_sampler_test sensor_sampler_test.c ../sensor_sampler.c ../hal_posix.c -lpthread
+//   ./sensor_sampler_test
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "hal.h"
+#include "sensor_sampler.h"
+
+// air_app.c와 같은 값
+#define SENSOR_PERIOD_MS    2000
+#define SENSOR_EMA_ALPHA    0.3f
+#define SENSOR_MAX_FAILURES 3
+#define SHT31_SDA_PIN       21
+#define SHT31_SCL_PIN       22
+
+#define READ_BUDGET_US      60000   // 읽기 한 번에 loop()를 붙잡을 수 있는 최대 시간 (버스 타임아웃 50 ms)
+#define RESOLUTION          0.01f
+#define RACE_SAMPLES        200000
+
+static sensor_sampler_t s_sampler;
+static uint32_t s_now;
+static uint32_t s_read_us_max;
+static int s_failures;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        s_failures++;
+    }
+}
+
+// air_app.c의 read_sht31
+static bool read_sht31(void *ctx, float *temperature, float *humidity)
+{
+    (void)ctx;
+    return hal_env_read(temperature, humidity);
+}
+
+// 주기가 되어 한 번 샘플링한다. 새 값이 발행되면 true.
+static bool sample(void)
+{
+    hal_sim_clock_advance_us(SENSOR_PERIOD_MS * 1000u - (hal_micros() - s_now * 1000u));
+    s_now = hal_millis();
+    uint32_t t0 = hal_micros();
+    bool published = sensor_sampler_sample(&s_sampler, s_now);
+    uint32_t us = hal_micros() - t0;
+    if (us > s_read_us_max) {
+        s_read_us_max = us;
+    }
+    return published;
+}
+
+static sensor_reading_t current(void)
+{
+    sensor_reading_t r;
+    sensor_sampler_get(&s_sampler, &r);
+    return r;
+}
+
+static void test_faults(void)
+{
+    hal_sim_set_env(0.0f, 0.0f, false);
+    check(!hal_env_begin(SHT31_SDA_PIN, SHT31_SCL_PIN), "no sensor on the bus");
+    hal_sim_set_env(21.5f, 48.0f, true);
+    check(hal_env_begin(SHT31_SDA_PIN, SHT31_SCL_PIN), "sensor found");
+
+    sensor_sampler_init(&s_sampler, read_sht31, NULL, SENSOR_EMA_ALPHA, SENSOR_MAX_FAILURES);
+    for (int i = 0; i < 3; i++) {
+        check(sample(), "good read published");
+    }
+    sensor_reading_t r = current();
+    check(r.valid && fabsf(r.temperature - 21.5f) < RESOLUTION && fabsf(r.humidity - 48.0f) < RESOLUTION &&
+          r.timestamp_ms == s_now && r.errors == 0, "good read matches the sensor");
+    uint32_t good_at = s_now;
+
+    // CRC 오류: 값이 바뀌지 않고 오류만 센다
+    hal_sim_set_env(22.0f, 50.0f, true);
+    hal_sim_env_fault(HAL_SIM_I2C_CRC, 2);
+    check(!sample() && !sample(), "CRC errors not published");
+    r = current();
+    check(r.valid && fabsf(r.temperature - 21.5f) < RESOLUTION && r.timestamp_ms == good_at,
+          "CRC errors keep the last good value");
+    check(sample(), "read after CRC errors");
+    r = current();
+    // 중앙값 필터가 새 값 하나는 아직 거른다. 뒤집힌 비트(+87.5 C)가 들어갔다면 여기서 드러난다.
+    check(r.errors == 2 && r.timestamp_ms == s_now && fabsf(r.temperature - 21.5f) < RESOLUTION,
+          "read after CRC errors is current");
+    good_at = s_now;
+
+    // NACK: SENSOR_MAX_FAILURES번째 실패에서 무효로 발행, 시각은 마지막 성공 그대로
+    hal_sim_env_fault(HAL_SIM_I2C_NACK, UINT32_MAX);
+    for (int i = 1; i < SENSOR_MAX_FAILURES; i++) {
+        check(!sample() && current().valid, "valid until max failures");
+    }
+    check(sample(), "invalid reading published");
+    r = current();
+    check(!r.valid && r.timestamp_ms == good_at && r.errors == 2 + SENSOR_MAX_FAILURES, "stale reading");
+    check(!sample() && !current().valid, "stays invalid");
+
+    // 멈춘 버스: 읽기마다 버스 타임아웃만큼만 걸린다
+    s_read_us_max = 0;
+    hal_sim_env_fault(HAL_SIM_I2C_STUCK, 5);
+    for (int i = 0; i < 5; i++) {
+        sample();
+    }
+    check(s_read_us_max >= 40000 && s_read_us_max <= READ_BUDGET_US, "stuck bus read bounded by the bus timeout");
+    check(current().timestamp_ms == good_at, "stuck bus keeps the old timestamp");
+
+    hal_sim_env_fault(HAL_SIM_I2C_OK, 0);
+    check(sample(), "recovered");
+    r = current();
+    check(r.valid && r.timestamp_ms == s_now && r.errors == 2 + SENSOR_MAX_FAILURES + 1 + 5,
+          "valid and current after recovery");
+    printf("faults: %u errors, longest read %u us (budget %u us)\n", (unsigned)r.errors, (unsigned)s_read_us_max,
+           (unsigned)READ_BUDGET_US);
+}
+
+// ---------- 다른 태스크에서 읽기 ----------
+static volatile bool s_stop;
+static uint64_t s_reads, s_torn;
+
+static void *reader(void *arg)
+{
+    (void)arg;
+    while (!s_stop) {
+        sensor_reading_t r;
+        sensor_sampler_get(&s_sampler, &r);
+        if (r.valid && fabsf(r.humidity - r.temperature - 30.0f) > 0.05f) {
+            s_torn++;
+        }
+        s_reads++;
+    }
+    return NULL;
+}
+
+static void test_race(void)
+{
+    hal_sim_env_fault(HAL_SIM_I2C_OK, 0);
+    sensor_sampler_init(&s_sampler, read_sht31, NULL, SENSOR_EMA_ALPHA, SENSOR_MAX_FAILURES);
+    pthread_t th;
+    if (pthread_create(&th, NULL, reader, NULL) != 0) {
+        check(false, "reader thread");
+        return;
+    }
+    for (uint32_t i = 0; i < RACE_SAMPLES; i++) {
+        float t = 10.0f + (float)(i % 20);
+        hal_sim_set_env(t, t + 30.0f, true);
+        if (i % 97 == 0) {
+            hal_sim_env_fault(HAL_SIM_I2C_NACK, SENSOR_MAX_FAILURES);   // 가끔 무효로 발행
+        }
+        sample();
+    }
+    s_stop = true;
+    pthread_join(th, NULL);
+    printf("race: %u samples, %llu reads, %llu torn\n", (unsigned)RACE_SAMPLES, (unsigned long long)s_reads,
+           (unsigned long long)s_torn);
+    check(s_torn == 0, "no torn snapshot");
+}
+
+int main(void)
+{
+    hal_sim_clock_enable(1000, 0);
+    s_now = hal_millis();
+    test_faults();
+    test_race();
+    printf("%s\n", s_failures ? "FAIL" : "ok");
+    return s_failures ? 1 : 0;
+}
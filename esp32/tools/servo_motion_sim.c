@@ -0,0 +1,409 @@
+// Host test of the window motion engine on a fake clock.
+//
+// Runs air_app.c's loop() shape (servo tick, MQTT keep-alive, HTTP, pump timer)
+// on a simulated millisecond clock with air_app.c's SERVO_VELOCITY_DPS/SERVO_ACCEL_DPS2 and checks:
+//   - a full 0 <-> 90 deg move takes the trapezoid time (v/a + d/v) and never
+//     exceeds the velocity or acceleration limit
+//   - servo_motion_tick() is cheap on every pass (99.9th percentile under 20 us
+//     on the host), so while a move runs the MQTT keep-alive, HTTP and the
+//     pump's 3000 ms window keep their timing; the measured tick time is added
+//     to the fake clock (the old open_window() held loop() for 91 x 40 ms = 3.6 s)
+//   - a retarget or reversal mid-move takes effect on the next tick without a
+//     velocity step larger than the acceleration allows, and ends on the new target
+//   - after a loop() stall mid-move the servo does not jump to where an
+//     unstalled run would be: it restarts from rest where it stopped (the
+//     velocity check above starts from 0 after a stall), no tick
+//     moves it further than the velocity limit allows, and the move ends on
+//     the target at most the stall plus one acceleration ramp later
+// Trials vary the loop period (1-20 ms), retarget times and stall lengths.
+// Exit 1 on any violation.
+//
+//   cc -std=gnu11 -O2 -I.. -o servo_motion_sim servo_motion_sim.c ../servo_motion.c -lm
+//   ./servo_motion_sim                    # 2000 trials
+//   ./servo_motion_sim --trials 20000 --seed 7
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "servo_motion.h"
+
+// air_app.c와 같은 값
+static const int SERVO_OPEN_DEG = 0;
+static const int SERVO_CLOSED_DEG = 90;
+static const servo_motion_profile_t SERVO_PROFILE = { 30.0f, 60.0f };
+static const uint32_t PUMP_RUN_MS = 3000;
+
+// loop()의 다른 작업 비용 (시뮬레이션 시계로 us)
+static const uint32_t MQTT_LOOP_US = 300;
+static const uint32_t HTTP_US = 500;
+static const uint32_t PUMP_US = 5;
+static const uint32_t TICK_BUDGET_NS = 20000;   // 호스트에서 servo_motion_tick()의 99.9 백분위 상한
+                                                // (최댓값은 선점/페이지 폴트 잡음이라 보고만 한다)
+
+static const float ARRIVE_SPEED_MAX = 7.5f;     // 목표에 닿아 멈추는 순간의 속도 (deg/s, 최대 속도의 25 %)
+static const float LIMIT_SLACK = 1.001f;
+
+// ---------- Random ----------
+static uint64_t s_rng;
+
+static uint32_t rnd(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return (uint32_t)(s_rng >> 32);
+}
+
+static uint32_t rnd_range(uint32_t lo, uint32_t hi)
+{
+    return lo + rnd() % (hi - lo + 1);
+}
+
+static uint64_t real_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// ---------- Checks ----------
+typedef struct {
+    uint32_t trials, moves, retargets, stalls;
+    uint32_t violations;
+    uint64_t ticks;
+    uint64_t tick_ns_total;
+    uint32_t tick_ns_max;
+    uint32_t tick_ns_hist[32];      // log2 버킷
+    float arrive_speed_max;
+    uint32_t loop_pass_max_us;      // 이동 중 가장 긴 loop() 패스 (시뮬레이션 시계)
+    uint32_t pump_overrun_max_ms;
+    float stall_step_max;           // 멈춤 뒤 tick 한 번의 최대 이동 (deg)
+    uint32_t stall_delay_max_ms;    // 멈춤이 없을 때보다 늦게 도착한 시간에서 멈춘 시간을 뺀 값
+    float move_ms_min, move_ms_max; // 0 -> 90 전체 이동 시간
+} sim_stats_t;
+
+static sim_stats_t s_stats;
+static bool s_short_stop;   // 새 목표가 정지 거리 안쪽: 감속할 수 있는 만큼 하고 목표에서 멈춘다
+
+static void violation(uint32_t trial, const char *what)
+{
+    s_stats.violations++;
+    if (s_stats.violations <= 10) {
+        fprintf(stderr, "trial %u: %s\n", (unsigned)trial, what);
+    }
+}
+
+// 정지 상태에서 d만큼 이동하는 사다리꼴(또는 삼각형) 프로파일 시간 (ms)
+static float trapezoid_ms(float d)
+{
+    float v = SERVO_PROFILE.max_velocity_dps;
+    float a = SERVO_PROFILE.acceleration_dps2;
+    if (d * a < v * v) {
+        return 2000.0f * sqrtf(d / a);
+    }
+    return 1000.0f * (v / a + d / v);
+}
+
+// 한 번의 tick: 실제 소요 시간을 재고, 속도/가속도 한계를 검사한다
+static bool tick(servo_motion_t *m, uint32_t now, uint32_t trial)
+{
+    float v0 = m->velocity;
+    uint32_t dt = now - m->last_tick_ms;
+    uint64_t t0 = real_ns();
+    bool moving = servo_motion_tick(m, now);
+    uint32_t ns = (uint32_t)(real_ns() - t0);
+
+    s_stats.ticks++;
+    s_stats.tick_ns_total += ns;
+    if (ns > s_stats.tick_ns_max) {
+        s_stats.tick_ns_max = ns;
+    }
+    int b = 0;
+    while (b < 31 && (1u << (b + 1)) <= ns) {
+        b++;
+    }
+    s_stats.tick_ns_hist[b]++;
+    if (!moving) {
+        return false;
+    }
+    if (fabsf(m->velocity) > SERVO_PROFILE.max_velocity_dps * LIMIT_SLACK) {
+        violation(trial, "velocity limit exceeded");
+    }
+    if (!m->moving) {
+        // 도착: 감속 끝의 잔여 속도에서 0으로 멈춘다 (멈춤 뒤 따라잡는 tick은 중간 속도를 볼 수 없다)
+        float v = fabsf(v0);
+        if (dt > 2 * SERVO_MOTION_STEP_MS || s_short_stop) {
+            return true;
+        }
+        if (v > s_stats.arrive_speed_max) {
+            s_stats.arrive_speed_max = v;
+        }
+        if (v > ARRIVE_SPEED_MAX) {
+            char msg[96];
+            snprintf(msg, sizeof(msg), "arrived at %.2f deg/s (limit %.2f)", v, ARRIVE_SPEED_MAX);
+            violation(trial, msg);
+        }
+        return true;
+    }
+    if (dt > SERVO_MOTION_MAX_GAP_MS) {
+        // loop가 멈췄었다: 서보는 그동안 서 있었으므로 정지 상태에서 적분 간격 하나만큼 가속한다
+        v0 = 0.0f;
+        dt = SERVO_MOTION_STEP_MS;
+    }
+    float dv_max = SERVO_PROFILE.acceleration_dps2 * (float)dt / 1000.0f * LIMIT_SLACK;
+    if (fabsf(m->velocity - v0) > dv_max + 1e-3f) {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "velocity stepped %.2f deg/s in %u ms (limit %.2f)",
+                 fabsf(m->velocity - v0), (unsigned)dt, dv_max);
+        violation(trial, msg);
+    }
+    return true;
+}
+
+// ---------- Trials ----------
+// air_app.c의 loop() 형태: 매 패스 servo -> MQTT -> HTTP -> pump. 시계는 각 작업의 비용만큼 간다.
+// 이동 시작과 함께 펌프를 켜고, 펌프가 제때 꺼지는지와 패스 길이를 본다.
+static void trial_loop(uint32_t n)
+{
+    uint32_t period_ms = rnd_range(1, 20);
+    uint64_t now_us = 1000000;
+    servo_motion_t m;
+    servo_motion_init(&m, &SERVO_PROFILE, SERVO_CLOSED_DEG, (uint32_t)(now_us / 1000));
+
+    uint32_t start = (uint32_t)(now_us / 1000);
+    servo_motion_set_target(&m, SERVO_OPEN_DEG, start);
+    bool pump = true;
+    uint32_t pump_start = start;
+    uint32_t last_mqtt = start;
+    int last_progress = -1;
+    s_stats.moves++;
+
+    for (uint32_t pass = 0; pass < 100000; pass++) {
+        uint64_t pass_start = now_us;
+
+        uint64_t t0 = real_ns();
+        bool moving = tick(&m, (uint32_t)(now_us / 1000), n);
+        now_us += (real_ns() - t0) / 1000;
+        if (moving) {
+            int progress = servo_motion_progress(&m);
+            if (progress < last_progress) {
+                violation(n, "progress went backwards");
+            }
+            last_progress = progress;
+        }
+
+        uint32_t now_ms = (uint32_t)(now_us / 1000);
+        if (now_ms - last_mqtt > 15000 / 2) {
+            violation(n, "MQTT keep-alive starved");
+        }
+        now_us += MQTT_LOOP_US;
+        last_mqtt = now_ms;
+        now_us += HTTP_US;
+
+        now_us += PUMP_US;
+        now_ms = (uint32_t)(now_us / 1000);
+        if (pump && now_ms - pump_start >= PUMP_RUN_MS) {
+            pump = false;
+            uint32_t overrun = now_ms - pump_start - PUMP_RUN_MS;
+            if (overrun > s_stats.pump_overrun_max_ms) {
+                s_stats.pump_overrun_max_ms = overrun;
+            }
+        }
+
+        uint32_t pass_us = (uint32_t)(now_us - pass_start);
+        if (moving && pass_us > s_stats.loop_pass_max_us) {
+            s_stats.loop_pass_max_us = pass_us;
+        }
+        if (!m.moving && !pump) {
+            break;
+        }
+        now_us += (uint64_t)period_ms * 1000;   // delay()/power_idle()
+    }
+
+    if (m.moving || servo_motion_angle(&m) != SERVO_OPEN_DEG) {
+        violation(n, "move did not end on the target");
+        return;
+    }
+    // 마지막 tick이 이동을 끝낸 시각 (한 패스 주기 안쪽)
+    float took = (float)(m.last_tick_ms - start);
+    float want = trapezoid_ms((float)(SERVO_CLOSED_DEG - SERVO_OPEN_DEG));
+    if (s_stats.move_ms_min == 0.0f || took < s_stats.move_ms_min) s_stats.move_ms_min = took;
+    if (took > s_stats.move_ms_max) s_stats.move_ms_max = took;
+    if (took < want * 0.97f - (float)period_ms || took > want * 1.03f + 2.0f * (float)period_ms) {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "full move took %.0f ms, profile says %.0f ms (tick %u ms)",
+                 took, want, (unsigned)period_ms);
+        violation(n, msg);
+    }
+}
+
+// 이동 중 임의 시점에 새 목표(반전 포함)를 준다
+static void trial_retarget(uint32_t n)
+{
+    uint32_t period_ms = rnd_range(1, 20);
+    uint32_t now = 1000;
+    servo_motion_t m;
+    bool open = rnd() & 1;
+    servo_motion_init(&m, &SERVO_PROFILE, open ? SERVO_CLOSED_DEG : SERVO_OPEN_DEG, now);
+    servo_motion_set_target(&m, open ? SERVO_OPEN_DEG : SERVO_CLOSED_DEG, now);
+    s_stats.moves++;
+
+    uint32_t at = now + rnd_range(50, 3400);
+    float target = (rnd() & 1) ? (float)(open ? SERVO_CLOSED_DEG : SERVO_OPEN_DEG) : (float)rnd_range(0, 90);
+    bool retargeted = false;
+    uint32_t retarget_at = 0;
+    float bound_ms = 0.0f;
+
+    for (uint32_t i = 0; i < 100000 && (m.moving || !retargeted); i++) {
+        now += period_ms;
+        if (!retargeted && (int32_t)(now - at) >= 0) {
+            // 정지 -> 새 목표까지 최악의 시간: 현재 속도에서 멈춘 뒤 정지 상태에서 출발
+            float stop_ms = 1000.0f * fabsf(m.velocity) / SERVO_PROFILE.acceleration_dps2;
+            float stop_deg = m.velocity * m.velocity / (2.0f * SERVO_PROFILE.acceleration_dps2);
+            bound_ms = stop_ms + trapezoid_ms(fabsf(target - m.position) + stop_deg) + 3.0f * (float)period_ms;
+            s_short_stop = (target - m.position) * m.velocity > 0.0f && fabsf(target - m.position) < stop_deg;
+            servo_motion_set_target(&m, target, now);
+            retargeted = true;
+            retarget_at = now;
+            s_stats.retargets++;
+        }
+        tick(&m, now, n);
+    }
+    s_short_stop = false;
+    if (m.moving || servo_motion_angle(&m) != (int)lroundf(target)) {
+        violation(n, "retargeted move did not end on the new target");
+    } else if ((float)(now - retarget_at) > bound_ms) {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "retargeted move took %u ms (bound %.0f)", (unsigned)(now - retarget_at), bound_ms);
+        violation(n, msg);
+    }
+}
+
+// loop()가 이동 중 멈췄다 돌아오면 그 자리에서 다시 출발한다: 기준 실행(2 ms tick) 위치로 튀지 않고,
+// 멈춘 시간과 가속 구간 하나만큼만 늦게 도착한다
+static void trial_stall(uint32_t n)
+{
+    const uint32_t ref_period = 2;
+    const float vmax = SERVO_PROFILE.max_velocity_dps;
+    uint32_t now = 1000;
+    servo_motion_t ref, m;
+    servo_motion_init(&ref, &SERVO_PROFILE, SERVO_CLOSED_DEG, now);
+    servo_motion_init(&m, &SERVO_PROFILE, SERVO_CLOSED_DEG, now);
+    servo_motion_set_target(&ref, SERVO_OPEN_DEG, now);
+    servo_motion_set_target(&m, SERVO_OPEN_DEG, now);
+    s_stats.moves++;
+    s_stats.stalls++;
+
+    uint32_t stall_at = now + rnd_range(0, 3000);
+    uint32_t stall_ms = rnd_range(20, 4000);
+    uint32_t end_ref = 0, end_m = 0;
+    char msg[96];
+
+    for (uint32_t i = 0; i < 100000 && (ref.moving || m.moving); i++) {
+        now += ref_period;
+        if (ref.moving) {
+            servo_motion_tick(&ref, now);
+            if (!ref.moving) {
+                end_ref = now;
+            }
+        }
+        bool stalled = (int32_t)(now - stall_at) >= 0 && (int32_t)(now - (stall_at + stall_ms)) < 0;
+        if (stalled || !m.moving) {
+            continue;
+        }
+        uint32_t dt = now - m.last_tick_ms;
+        float before = m.position;
+        tick(&m, now, n);
+        if (!m.moving && end_m == 0) {
+            end_m = now;
+        }
+        // 한 tick에 갈 수 있는 거리: 긴 간격은 적분 간격 하나로 줄어든다
+        uint32_t step_ms = dt > SERVO_MOTION_MAX_GAP_MS ? SERVO_MOTION_STEP_MS : dt;
+        float moved = fabsf(m.position - before);
+        if (dt > SERVO_MOTION_MAX_GAP_MS && moved > s_stats.stall_step_max) {
+            s_stats.stall_step_max = moved;
+        }
+        if (moved > vmax * LIMIT_SLACK * (float)step_ms / 1000.0f) {
+            snprintf(msg, sizeof(msg), "jumped %.1f deg in one tick after a %u ms stall", moved, (unsigned)stall_ms);
+            violation(n, msg);
+            return;
+        }
+    }
+    if (servo_motion_angle(&m) != SERVO_OPEN_DEG || end_m == 0) {
+        violation(n, "stalled move did not end on the target");
+        return;
+    }
+    // 멈춘 시간이 이동이 끝난 뒤였으면 늦을 이유가 없다
+    uint32_t paused = end_ref > stall_at ? stall_ms : 0;
+    uint32_t late = end_m > end_ref + paused ? end_m - end_ref - paused : 0;
+    if (late > s_stats.stall_delay_max_ms) {
+        s_stats.stall_delay_max_ms = late;
+    }
+    float ramp_ms = 1000.0f * vmax / SERVO_PROFILE.acceleration_dps2 + 2 * ref_period;
+    if ((float)late > ramp_ms) {
+        snprintf(msg, sizeof(msg), "ended %u ms after a %u ms stall (ramp bound %.0f)", (unsigned)late,
+                 (unsigned)stall_ms, ramp_ms);
+        violation(n, msg);
+    }
+}
+
+// log2 히스토그램에서 q 백분위가 속한 버킷의 상한 (ns)
+static uint32_t tick_ns_quantile(double q)
+{
+    uint64_t want = (uint64_t)(q * (double)s_stats.ticks);
+    uint64_t seen = 0;
+    for (int b = 0; b < 32; b++) {
+        seen += s_stats.tick_ns_hist[b];
+        if (seen >= want) {
+            return b >= 31 ? UINT32_MAX : (2u << b);
+        }
+    }
+    return UINT32_MAX;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t trials = 2000;
+    uint32_t seed = 1;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--trials") == 0) {
+            trials = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            seed = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--trials N] [--seed N]\n", argv[0]);
+            return 2;
+        }
+    }
+    s_rng = seed * 0x9E3779B97F4A7C15ull + 1;
+    for (uint32_t i = 0; i < trials; i++) {
+        s_stats.trials++;
+        trial_loop(i);
+        trial_retarget(i);
+        trial_stall(i);
+    }
+
+    const sim_stats_t *st = &s_stats;
+    uint32_t tick_p999 = tick_ns_quantile(0.999);
+    bool slow_tick = tick_p999 > TICK_BUDGET_NS;
+    printf("%u trials: %u moves, %u retargets, %u stalls\n",
+           (unsigned)st->trials, (unsigned)st->moves, (unsigned)st->retargets, (unsigned)st->stalls);
+    printf("full move: %.0f-%.0f ms (profile %.0f ms), old blocking loop 3640 ms\n",
+           st->move_ms_min, st->move_ms_max, trapezoid_ms((float)(SERVO_CLOSED_DEG - SERVO_OPEN_DEG)));
+    printf("servo_motion_tick: avg %.0f ns, p99.9 < %u ns (budget %u ns), max %u ns\n",
+           st->ticks ? (double)st->tick_ns_total / st->ticks : 0.0, (unsigned)tick_p999,
+           (unsigned)TICK_BUDGET_NS, (unsigned)st->tick_ns_max);
+    printf("arrival speed: max %.2f deg/s (limit %.2f)\n", st->arrive_speed_max, ARRIVE_SPEED_MAX);
+    printf("longest loop() pass during a move: %u us, pump overrun max %u ms\n",
+           (unsigned)st->loop_pass_max_us, (unsigned)st->pump_overrun_max_ms);
+    printf("after a stall: largest first step %.2f deg, arrival at most %u ms later than stall + reference\n",
+           st->stall_step_max, (unsigned)st->stall_delay_max_ms);
+    if (slow_tick) {
+        s_stats.violations++;
+        fprintf(stderr, "servo_motion_tick exceeded its budget\n");
+    }
+    printf("%s (%u violations)\n", st->violations ? "FAIL" : "ok", (unsigned)st->violations);
+    return st->violations ? 1 : 0;
+}
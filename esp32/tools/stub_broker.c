@@ -0,0 +1,269 @@
+// In-process MQTT 3.1.1 broker stub (see stub_broker.h)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "stub_broker.h"
+
+static int s_listen_fd = -1;
+static int s_client_fd = -1;            // 구독까지 마친 클라이언트
+static stub_broker_mode_t s_mode;
+static stub_broker_stats_t s_stats;
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static char s_received[8192];           // 클라이언트가 보낸 PUBLISH, "토픽 페이로드\n" 줄
+static size_t s_received_len;
+
+static bool send_all(int fd, const uint8_t *p, size_t len)
+{
+    while (len > 0) {
+        ssize_t w = send(fd, p, len, MSG_NOSIGNAL);
+        if (w <= 0) {
+            return false;
+        }
+        p += w;
+        len -= (size_t)w;
+    }
+    return true;
+}
+
+static bool recv_all(int fd, uint8_t *p, size_t len)
+{
+    while (len > 0) {
+        ssize_t r = recv(fd, p, len, 0);
+        if (r <= 0) {
+            return false;
+        }
+        p += r;
+        len -= (size_t)r;
+    }
+    return true;
+}
+
+// 패킷 하나를 읽는다. 가변부 길이, 실패 시 -1
+static long read_packet(int fd, uint8_t *type, uint8_t *body, size_t cap)
+{
+    uint8_t b;
+    if (!recv_all(fd, type, 1)) {
+        return -1;
+    }
+    size_t rem = 0, mult = 1;
+    for (int i = 0; i < 4; i++) {
+        if (!recv_all(fd, &b, 1)) {
+            return -1;
+        }
+        rem += (size_t)(b & 0x7f) * mult;
+        mult *= 128;
+        if ((b & 0x80) == 0) {
+            break;
+        }
+    }
+    if (rem > cap || !recv_all(fd, body, rem)) {
+        return -1;
+    }
+    return (long)rem;
+}
+
+static void client_close(int fd)
+{
+    pthread_mutex_lock(&s_lock);
+    if (s_client_fd == fd) {
+        s_client_fd = -1;
+    }
+    pthread_mutex_unlock(&s_lock);
+    close(fd);
+}
+
+static void serve(int fd)
+{
+    static uint8_t body[2048];
+    uint8_t type;
+    long len;
+    while ((len = read_packet(fd, &type, body, sizeof(body))) >= 0) {
+        uint8_t reply[5];
+        size_t reply_len = 0;
+        switch (type & 0xf0) {
+        case 0x10:      // CONNECT
+            if (s_mode == STUB_BROKER_HANG) {
+                // 답하지 않고 클라이언트가 포기할 때까지 붙잡는다
+                while (recv(fd, body, sizeof(body), 0) > 0) {
+                }
+                client_close(fd);
+                return;
+            }
+            reply[0] = 0x20;
+            reply[1] = 2;
+            reply[2] = 0;
+            reply[3] = 0;
+            reply_len = 4;
+            pthread_mutex_lock(&s_lock);
+            s_stats.connects++;
+            pthread_mutex_unlock(&s_lock);
+            break;
+        case 0x80:      // SUBSCRIBE
+            if (len < 2) {
+                client_close(fd);
+                return;
+            }
+            reply[0] = 0x90;
+            reply[1] = 3;
+            reply[2] = body[0];
+            reply[3] = body[1];
+            reply[4] = 0;
+            reply_len = 5;
+            pthread_mutex_lock(&s_lock);
+            s_stats.subscribes++;
+            s_client_fd = fd;
+            pthread_mutex_unlock(&s_lock);
+            break;
+        case 0xc0:      // PINGREQ
+            reply[0] = 0xd0;
+            reply[1] = 0;
+            reply_len = 2;
+            break;
+        case 0x30: {    // PUBLISH (QoS 0만 쓴다)
+            size_t tlen = len >= 2 ? (size_t)(body[0] << 8 | body[1]) : 0;
+            if (len < 2 || 2 + tlen > (size_t)len) {
+                client_close(fd);
+                return;
+            }
+            pthread_mutex_lock(&s_lock);
+            int n = snprintf(s_received + s_received_len, sizeof(s_received) - s_received_len, "%.*s %.*s\n",
+                             (int)tlen, (const char *)body + 2, (int)(len - 2 - tlen), (const char *)body + 2 + tlen);
+            if (n > 0 && (size_t)n < sizeof(s_received) - s_received_len) {
+                s_received_len += (size_t)n;
+            } else {
+                s_received[s_received_len] = '\0';    // 가득 차면 더 쌓지 않는다
+            }
+            s_stats.received++;
+            pthread_mutex_unlock(&s_lock);
+            break;
+        }
+        case 0xe0:      // DISCONNECT
+            client_close(fd);
+            return;
+        default:
+            break;
+        }
+        pthread_mutex_lock(&s_lock);
+        bool ok = reply_len == 0 || send_all(fd, reply, reply_len);
+        pthread_mutex_unlock(&s_lock);
+        if (!ok) {
+            break;
+        }
+    }
+    client_close(fd);
+}
+
+static void *broker_main(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        int fd = accept(s_listen_fd, NULL, NULL);
+        if (fd < 0) {
+            return NULL;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        pthread_mutex_lock(&s_lock);
+        s_stats.accepted++;
+        pthread_mutex_unlock(&s_lock);
+        if (s_mode == STUB_BROKER_REFUSE) {
+            close(fd);
+            continue;
+        }
+        // 클라이언트는 하나뿐이므로 이 스레드에서 차례로 처리
+        serve(fd);
+    }
+}
+
+uint16_t stub_broker_start(void)
+{
+    s_listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t alen = sizeof(addr);
+    if (s_listen_fd < 0 || bind(s_listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(s_listen_fd, 8) != 0 || getsockname(s_listen_fd, (struct sockaddr *)&addr, &alen) != 0) {
+        perror("stub broker");
+        return 0;
+    }
+    pthread_t t;
+    if (pthread_create(&t, NULL, broker_main, NULL) != 0 || pthread_detach(t) != 0) {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
+}
+
+void stub_broker_set_mode(stub_broker_mode_t mode)
+{
+    s_mode = mode;
+}
+
+void stub_broker_drop(void)
+{
+    pthread_mutex_lock(&s_lock);
+    if (s_client_fd >= 0) {
+        // 소켓은 serve()가 닫는다
+        shutdown(s_client_fd, SHUT_RDWR);
+        s_client_fd = -1;
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+bool stub_broker_publish(const char *topic, const void *payload, size_t len)
+{
+    uint8_t pkt[2048];
+    size_t tlen = strlen(topic);
+    size_t rem = 2 + tlen + len;
+    if (rem + 5 > sizeof(pkt)) {
+        return false;
+    }
+    size_t n = 0;
+    pkt[n++] = 0x30;
+    size_t r = rem;
+    do {
+        uint8_t b = (uint8_t)(r % 128);
+        r /= 128;
+        pkt[n++] = r ? (uint8_t)(b | 0x80) : b;
+    } while (r > 0);
+    pkt[n++] = (uint8_t)(tlen >> 8);
+    pkt[n++] = (uint8_t)tlen;
+    memcpy(pkt + n, topic, tlen);
+    n += tlen;
+    memcpy(pkt + n, payload, len);
+    n += len;
+
+    pthread_mutex_lock(&s_lock);
+    bool ok = s_client_fd >= 0 && send_all(s_client_fd, pkt, n);
+    if (ok) {
+        s_stats.published++;
+    } else {
+        s_stats.dropped++;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ok;
+}
+
+size_t stub_broker_received(char *buf, size_t cap)
+{
+    pthread_mutex_lock(&s_lock);
+    size_t n = s_received_len < cap ? s_received_len : cap - 1;
+    memcpy(buf, s_received, n);
+    buf[n] = '\0';
+    pthread_mutex_unlock(&s_lock);
+    return n;
+}
+
+void stub_broker_get_stats(stub_broker_stats_t *out)
+{
+    pthread_mutex_lock(&s_lock);
+    *out = s_stats;
+    pthread_mutex_unlock(&s_lock);
+}
@@ -0,0 +1,43 @@
+// In-process MQTT 3.1.1 broker stub for the host sims (one client, QoS 0).
+//
+// Answers CONNECT, SUBSCRIBE, PINGREQ and DISCONNECT on 127.0.0.1 from its own
+// thread, lets the sim publish to the connected client as the server would,
+// and keeps what the client publishes. Faults can be injected: drop the client connection, refuse new
+// connections, or accept them and never answer (a broker that hangs).
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    STUB_BROKER_UP = 0,     // 정상
+    STUB_BROKER_REFUSE,     // 연결 즉시 끊음 (브로커 프로세스가 죽은 경우)
+    STUB_BROKER_HANG,       // 연결은 받지만 CONNACK을 보내지 않음
+} stub_broker_mode_t;
+
+typedef struct {
+    uint32_t accepted;      // TCP 연결
+    uint32_t connects;      // CONNACK을 보낸 CONNECT
+    uint32_t subscribes;
+    uint32_t published;     // 클라이언트로 보낸 PUBLISH
+    uint32_t dropped;       // 구독자가 없어 버린 PUBLISH
+    uint32_t received;      // 클라이언트가 보낸 PUBLISH
+} stub_broker_stats_t;
+
+// 임의 포트로 시작하고 포트를 반환 (실패 시 0)
+uint16_t stub_broker_start(void);
+
+void stub_broker_set_mode(stub_broker_mode_t mode);
+
+// 연결된 클라이언트의 연결을 끊는다
+void stub_broker_drop(void);
+
+// 구독 중인 클라이언트에 보낸다 (토픽 필터는 확인하지 않음). 보냈으면 true.
+bool stub_broker_publish(const char *topic, const void *payload, size_t len);
+
+// 클라이언트가 보낸 PUBLISH를 받은 순서대로 "토픽 페이로드\n" 줄로 buf에 복사한다 (NUL 종료, 길이 반환).
+// 처음 8 KB까지만 보관한다.
+size_t stub_broker_received(char *buf, size_t cap);
+
+void stub_broker_get_stats(stub_broker_stats_t *out);
@@ -0,0 +1,610 @@
+// Host simulation of change-driven telemetry and adaptive HTTP timeouts.
+//
+// Replays sensor traces through the firmware's telemetry path, esp_http_pull.c's
+// send_air_quality_data() (telemetry_policy.c deadband + heartbeat, the sample
+// ring and air_telemetry_flush()) on a fake HAL whose hal_http_request()
+// counts the POSTs, and compares the number of POSTs and bytes against the
+// fixed-rate baselines:
+//   every_sample  one POST per sample (the old send-every-sample behaviour)
+//   batched       every sample, batched (10 samples or 60 s per POST)
+//   deadband      the firmware: only samples the policy reports, same batching,
+//                 bug-flag changes flushed at once
+// Traces are either a CSV file (t_ms,temperature,humidity,pm25,pm10,bug; one
+// row per sample, header optional) or synthetic indoor days: a diurnal
+// temperature swing, ventilation dips, cooking PM/humidity spikes and a few bug
+// episodes, with sensor noise. --devices N replays N synthetic devices with
+// different seeds to show the server-side message rate.
+//
+// An outage replay then cuts the link for 45 minutes (the ring overflows and
+// spills to the fake NVS) and restores it: every reported sample must be
+// POSTed at most once, and after the recovery the spill must hold exactly
+// the spilled samples that were overwritten in RAM and never POSTed.
+//
+// It then replays one request every sample period against a Wi-Fi RTT model
+// (lognormal, congestion episodes every 3 h, 1% of requests never answered)
+// with the old fixed 5000 ms timeout and with rtt_estimator.c, and reports
+// the timeouts that fired on requests which would still have been answered
+// (spurious) and the time spent waiting for requests that were lost.
+//
+// It fails (exit 1) if a reported value drifted past its deadband for longer
+// than the rate limit plus one sample period, a bug change was not reported
+// by the next sample, a reported sample was not POSTed exactly once, the
+// outage lost or repeated a sample, or the adaptive timeout fired spuriously
+// on more than 1% of requests.
+//
+//   cc -std=gnu11 -O2 -I.. -DAIR_SAMPLE_SPILL_NVS=1 -o telemetry_sim telemetry_sim.c ../esp_http_pull.c
+//      ../telemetry_policy.c ../rtt_estimator.c ../air_sample_buffer.c ../durable_state.c ../cmd_stream.c
+//      ../json_stream.c ../dlog.c -lm
+//   ./telemetry_sim                          # 20 devices, 24 h each
+//   ./telemetry_sim --hours 72 --devices 1
+//   ./telemetry_sim --trace recorded.csv
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "air_sample_buffer.h"
+#include "dlog.h"
+#include "esp_http_pull.h"
+#include "hal.h"
+#include "rtt_estimator.h"
+#include "telemetry_policy.h"
+
+#define HOUR_MS 3600000u
+
+// esp_http_pull.c와 같은 설정
+static const tp_config_t POLICY = {
+    AIR_TELEMETRY_DEADBAND_TEMP_C,
+    AIR_TELEMETRY_DEADBAND_HUM_PCT,
+    AIR_TELEMETRY_DEADBAND_PM,
+    AIR_TELEMETRY_DEADBAND_PM_PCT,
+    AIR_TELEMETRY_HEARTBEAT_MS,
+    AIR_TELEMETRY_MIN_INTERVAL_MS,
+};
+static const rtt_config_t RTT = { AIR_HTTP_TIMEOUT_INITIAL_MS, AIR_HTTP_TIMEOUT_MIN_MS, AIR_HTTP_TIMEOUT_MAX_MS };
+static const uint32_t FIXED_TIMEOUT_MS = 5000;
+#define BATCH_SIZE AIR_TELEMETRY_BATCH_SIZE
+static const uint32_t FLUSH_INTERVAL_MS = AIR_TELEMETRY_FLUSH_INTERVAL_MS;
+
+static const uint32_t SAMPLE_PERIOD_MS = 5000;
+
+// ---------- Random ----------
+static uint64_t s_rng;
+
+static uint32_t rnd(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return (uint32_t)(s_rng >> 32);
+}
+
+static double uniform(void)
+{
+    return (rnd() + 0.5) / 4294967296.0;
+}
+
+static double gauss(void)
+{
+    return sqrt(-2.0 * log(uniform())) * cos(2.0 * M_PI * uniform());
+}
+
+// ---------- Traces ----------
+typedef struct {
+    air_sample_t *s;
+    size_t n;
+} trace_t;
+
+static void trace_push(trace_t *t, size_t *cap, const air_sample_t *s)
+{
+    if (t->n == *cap) {
+        *cap = *cap ? *cap * 2 : 4096;
+        t->s = realloc(t->s, *cap * sizeof(*t->s));
+        if (!t->s) {
+            perror("realloc");
+            exit(2);
+        }
+    }
+    t->s[t->n++] = *s;
+}
+
+static bool trace_load(trace_t *t, const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    size_t cap = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long ms;
+        float temp, hum;
+        int pm25, pm10, bug;
+        if (sscanf(line, "%lu,%f,%f,%d,%d,%d", &ms, &temp, &hum, &pm25, &pm10, &bug) != 6) {
+            continue;   // 헤더/빈 줄
+        }
+        air_sample_t s = { (uint32_t)ms, temp, hum, (int16_t)pm25, (int16_t)pm10, bug != 0 };
+        trace_push(t, &cap, &s);
+    }
+    fclose(f);
+    return t->n > 0;
+}
+
+// 사건이 t(시 단위) 이후 tau 시간 상수로 감쇠하는 크기
+static double decay(double t, double at, double peak, double tau)
+{
+    return t >= at ? peak * exp(-(t - at) / tau) : 0.0;
+}
+
+static void trace_synth(trace_t *t, uint32_t hours, uint64_t seed)
+{
+    size_t cap = 0;
+    s_rng = seed * 0x9E3779B97F4A7C15ull + 1;
+    double drift = 0.0, ema_t = 0.0, ema_h = 0.0;
+    bool first = true;
+    for (uint32_t day = 0; day * 24 < hours; day++) {
+        // 날마다 사건 시각을 조금씩 흩뜨린다 (시 단위)
+        double vent = 8.0 + uniform() * 2.0;            // 환기 (창문 열림)
+        double lunch = 12.0 + uniform(), dinner = 18.5 + uniform();
+        double shower = 7.0 + uniform();
+        double bug_at[3], bug_len[3];
+        for (int i = 0; i < 3; i++) {
+            bug_at[i] = 6.0 + uniform() * 16.0;
+            bug_len[i] = (2.0 + uniform() * 8.0) / 60.0;
+        }
+        for (uint32_t ms = 0; ms < 24 * HOUR_MS && day * 24 * HOUR_MS + ms < hours * HOUR_MS; ms += SAMPLE_PERIOD_MS) {
+            double h = ms / (double)HOUR_MS;
+            double temp = 22.0 + 2.5 * sin(2.0 * M_PI * (h - 9.0) / 24.0)
+                        - (h >= vent && h < vent + 0.25 ? 3.0 * (h - vent) / 0.25 : decay(h, vent + 0.25, 3.0, 0.5));
+            double hum = 45.0 - 1.5 * (temp - 22.0) + decay(h, shower, 15.0, 0.4)
+                       + decay(h, lunch, 6.0, 0.3) + decay(h, dinner, 8.0, 0.3);
+            drift += gauss() * 0.02;
+            drift *= 0.999;
+            double pm = 8.0 + drift + decay(h, lunch, 45.0 + uniform() * 0.5, 0.35) + decay(h, dinner, 80.0, 0.35)
+                      - (h >= vent && h < vent + 1.0 ? 4.0 : 0.0);
+            // SHT31: 2초마다 측정, EMA(0.3)를 거친 값. PMS5003: 정수, 평균 후 ±1~2 흔들림
+            double raw_t = temp + gauss() * 0.1, raw_h = hum + gauss() * 0.8;
+            ema_t = first ? raw_t : ema_t + 0.6 * (raw_t - ema_t);   // 5초 = EMA 2.5회
+            ema_h = first ? raw_h : ema_h + 0.6 * (raw_h - ema_h);
+            first = false;
+            bool bug = false;
+            for (int i = 0; i < 3; i++) {
+                bug |= h >= bug_at[i] && h < bug_at[i] + bug_len[i];
+            }
+            double pm25 = pm + gauss() * 1.2;
+            air_sample_t s = {
+                day * 24 * HOUR_MS + ms,
+                (float)(round(ema_t * 100.0) / 100.0),
+                (float)(round(ema_h * 100.0) / 100.0),
+                (int16_t)(pm25 < 0 ? 0 : lround(pm25)),
+                (int16_t)(pm25 < 0 ? 0 : lround(pm25 * 1.4 + gauss() * 1.5)),
+                bug,
+            };
+            trace_push(t, &cap, &s);
+        }
+    }
+}
+
+// ---------- Fake HAL for esp_http_pull.c ----------
+typedef struct {
+    uint64_t samples;   // 서버로 간 샘플
+    uint64_t posts;
+    uint64_t bytes;     // JSON 본문
+    uint64_t heartbeats;
+} tx_stats_t;
+
+static uint32_t s_now;              // hal_millis()
+static bool s_link_up = true;
+static tx_stats_t *s_tx;            // POST를 셀 곳
+static uint16_t *s_posted;          // 정전 재생: 샘플 번호(pm10)별 POST 횟수
+
+static uint8_t s_nvs[sizeof(air_sample_t) * AIR_SAMPLE_BUFFER_CAPACITY + 64];
+static int s_nvs_len = -1;
+static uint32_t s_nvs_writes;
+
+uint32_t hal_millis(void)
+{
+    return s_now;
+}
+
+const char *hal_device_id(void)
+{
+    return "sim";
+}
+
+// 저장소는 텔레메트리 보관 키 하나뿐이다
+int hal_store_read(const char *key, void *buf, size_t cap)
+{
+    (void)key;
+    if (s_nvs_len < 0) {
+        return -1;
+    }
+    if ((size_t)s_nvs_len > cap) {
+        return 0;
+    }
+    memcpy(buf, s_nvs, (size_t)s_nvs_len);
+    return s_nvs_len;
+}
+
+bool hal_store_write(const char *key, const void *data, size_t len)
+{
+    (void)key;
+    if (len > sizeof(s_nvs)) {
+        return false;
+    }
+    memcpy(s_nvs, data, len);
+    s_nvs_len = (int)len;
+    s_nvs_writes++;
+    return true;
+}
+
+static int nvs_read(void *ctx, const char *key, void *buf, size_t cap)
+{
+    (void)ctx;
+    return hal_store_read(key, buf, cap);
+}
+
+static bool nvs_write(void *ctx, const char *key, const void *data, size_t len)
+{
+    (void)ctx;
+    return hal_store_write(key, data, len);
+}
+
+// POST는 본문의 샘플을 세고 200, 명령 폴링 GET은 204. 링크가 끊겼으면 전송 오류.
+int hal_http_request(hal_http_method_t method, const char *url, const char *body, int body_len,
+                     const char *content_type, int timeout_ms, hal_http_body_cb on_body, void *ctx,
+                     int *status_code)
+{
+    (void)url;
+    (void)content_type;
+    (void)timeout_ms;
+    (void)on_body;
+    (void)ctx;
+    if (!s_link_up) {
+        return -1;
+    }
+    if (method == HAL_HTTP_GET) {
+        *status_code = 204;
+        return 0;
+    }
+    static const char key[] = "\"pm10\":";
+    for (const char *p = body, *end = body + body_len; (p = memmem(p, (size_t)(end - p), key, sizeof(key) - 1));) {
+        p += sizeof(key) - 1;
+        s_tx->samples++;
+        if (s_posted) {
+            s_posted[strtoul(p, NULL, 10)]++;
+        }
+    }
+    s_tx->posts++;
+    s_tx->bytes += (uint64_t)body_len;
+    *status_code = 200;
+    return 0;
+}
+
+void hal_http_get_stats(hal_http_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+}
+
+// ---------- Telemetry replay ----------
+enum { ST_EVERY, ST_BATCHED, ST_DEADBAND, ST_COUNT };
+static const char *const ST_NAMES[ST_COUNT] = { "every_sample", "batched", "deadband" };
+
+typedef struct {
+    float max_err_temp, max_err_hum;
+    int max_err_pm;
+    uint32_t max_stale_ms;          // 데드밴드 밖에 머문 최장 시간
+    uint32_t bug_late;              // 다음 샘플까지 보고되지 않은 벌레 변화
+} fidelity_t;
+
+typedef struct {
+    air_sample_t pending[BATCH_SIZE * 2];
+    uint16_t count;
+    uint32_t last_flush;
+} batcher_t;
+
+static char s_json[4096];
+
+static void flush(batcher_t *b, tx_stats_t *tx, uint32_t now, uint16_t per_post)
+{
+    uint16_t off = 0;
+    while (off < b->count) {
+        uint16_t n = b->count - off < per_post ? b->count - off : per_post;
+        int len = air_sample_encode_json(b->pending + off, n, now, s_json, sizeof(s_json));
+        tx->posts++;
+        tx->bytes += len > 0 ? (uint64_t)len : 0;
+        tx->samples += n;
+        off += n;
+    }
+    b->count = 0;
+    b->last_flush = now;
+}
+
+// 기준선: 고정 주기 배치 (POST는 항상 성공)
+static void offer(batcher_t *b, tx_stats_t *tx, const air_sample_t *s, bool force, uint16_t per_post)
+{
+    b->pending[b->count++] = *s;
+    if (force || b->count >= per_post || s->timestamp_ms - b->last_flush >= FLUSH_INTERVAL_MS) {
+        flush(b, tx, s->timestamp_ms, per_post);
+    }
+}
+
+// esp_http_pull.c 안의 정책과 같은 입력을 받는 사본: 서버가 보고 있는 값(마지막 보고값)을 알려 준다.
+// 장치들은 한 펌웨어 인스턴스에서 차례로 돌므로 사본도 하나를 이어 쓴다.
+static telemetry_policy_t s_mirror;
+static uint32_t s_clock_offset;     // 트레이스 시각 -> hal_millis()
+
+static void replay(const trace_t *t, tx_stats_t tx[ST_COUNT], fidelity_t *fid)
+{
+    batcher_t b[ST_COUNT];
+    memset(b, 0, sizeof(b));
+    for (int i = 0; i < ST_COUNT; i++) {
+        b[i].last_flush = t->s[0].timestamp_ms;
+    }
+    // 앞 장치와 하트비트 간격 이상 떨어뜨린다 (첫 샘플은 하트비트로 보고된다)
+    s_clock_offset = s_now + POLICY.heartbeat_ms - t->s[0].timestamp_ms;
+    s_tx = &tx[ST_DEADBAND];
+    uint32_t beyond_since = 0;
+    bool beyond = false;
+
+    for (size_t i = 0; i < t->n; i++) {
+        const air_sample_t *s = &t->s[i];
+        offer(&b[ST_EVERY], &tx[ST_EVERY], s, true, 1);
+        offer(&b[ST_BATCHED], &tx[ST_BATCHED], s, false, BATCH_SIZE);
+
+        air_sample_t now = *s;
+        now.timestamp_ms = s_now = s->timestamp_ms + s_clock_offset;
+        bool bug_changed = s_mirror.has_last && s->bug != s_mirror.last.bug;
+        tp_reason_t r = tp_offer(&s_mirror, &now);
+        send_air_quality_data(s->temperature, s->humidity, s->pm25, s->pm10, s->bug);
+        if (r == TP_SEND_HEARTBEAT) {
+            tx[ST_DEADBAND].heartbeats++;
+        }
+        if (bug_changed && r == TP_SKIP) {
+            fid->bug_late++;
+        }
+
+        // 서버가 보고 있는 값(마지막 보고값)과 실제 값의 차이
+        const air_sample_t *seen = &s_mirror.last;
+        float et = fabsf(s->temperature - seen->temperature);
+        float eh = fabsf(s->humidity - seen->humidity);
+        int ep = abs(s->pm25 - seen->pm25);
+        if (et > fid->max_err_temp) fid->max_err_temp = et;
+        if (eh > fid->max_err_hum) fid->max_err_hum = eh;
+        if (ep > fid->max_err_pm) fid->max_err_pm = ep;
+        int pm_band = seen->pm25 * POLICY.pm_pct / 100 > POLICY.pm_abs ? seen->pm25 * POLICY.pm_pct / 100 : POLICY.pm_abs;
+        bool out = et > POLICY.temperature || eh > POLICY.humidity || ep > pm_band;
+        if (out && !beyond) {
+            beyond_since = s->timestamp_ms;
+        }
+        beyond = out;
+        if (out && s->timestamp_ms - beyond_since > fid->max_stale_ms) {
+            fid->max_stale_ms = s->timestamp_ms - beyond_since;
+        }
+    }
+}
+
+// ---------- Outage replay ----------
+#define OUTAGE_IDS 1000
+
+// 15초마다 온도가 데드밴드 넘게 바뀌는 샘플 (모두 보고된다). 샘플 번호는 pm10에 싣는다.
+static void outage_sample(uint16_t id)
+{
+    s_now += POLICY.min_interval_ms;
+    send_air_quality_data(id % 2 ? 25.0f : 20.0f, 40.0f, 10, id, false);
+}
+
+// 링크가 45분 끊겼다가 돌아온다. 보고한 샘플은 모두 한 번씩 POST되거나 NVS 저장본에 남아야 한다.
+static bool replay_outage(void)
+{
+    static uint16_t posted[OUTAGE_IDS];
+    static air_sample_buffer_t restored;
+    tx_stats_t tx;
+    memset(&tx, 0, sizeof(tx));
+    memset(posted, 0, sizeof(posted));
+    s_now += POLICY.heartbeat_ms;
+    air_telemetry_flush(true);          // 앞선 재생에서 남은 샘플
+    s_tx = &tx;
+    s_posted = posted;
+    uint32_t writes0 = s_nvs_writes;
+
+    uint16_t id = 0;
+    for (; id < 10; id++) {             // 연결된 상태로 시작
+        outage_sample(id);
+    }
+    s_link_up = false;
+    for (uint32_t end = s_now + 45 * 60000u; (int32_t)(s_now - end) < 0; id++) {
+        outage_sample(id);
+    }
+    uint32_t spill_writes = s_nvs_writes - writes0;
+    s_link_up = true;
+    for (uint16_t last = id + 40; id < last; id++) {
+        outage_sample(id);
+    }
+    s_now += FLUSH_INTERVAL_MS;
+    air_telemetry_flush(true);
+    s_posted = NULL;
+
+    // 재부팅했다면 돌아올 샘플
+    air_sample_spill_t sp;
+    air_sample_buffer_init(&restored);
+    static const ds_ops_t NVS_OPS = { nvs_read, nvs_write, NULL };
+    air_sample_spill_init(&sp, &NVS_OPS);
+    uint16_t n = air_sample_spill_restore(&sp, &restored, s_now);
+    air_sample_t all[AIR_SAMPLE_BUFFER_CAPACITY];
+    air_sample_buffer_peek(&restored, all, n);
+
+    uint32_t twice = 0, lost = 0, kept_posted = 0;
+    static uint8_t in_spill[OUTAGE_IDS];
+    memset(in_spill, 0, sizeof(in_spill));
+    for (uint16_t i = 0; i < n; i++) {
+        in_spill[all[i].pm10] = 1;
+        kept_posted += posted[all[i].pm10] != 0;
+    }
+    for (uint16_t i = 0; i < id; i++) {
+        twice += posted[i] > 1;
+        lost += posted[i] == 0 && !in_spill[i];
+    }
+    printf("outage: %u samples, %u POSTed, %u only in the NVS spill, %u lost, %u POSTed twice, "
+           "%u spilled after POST; %u NVS writes (%u during the outage)\n",
+           (unsigned)id, (unsigned)tx.samples, (unsigned)n, (unsigned)lost, (unsigned)twice,
+           (unsigned)kept_posted, (unsigned)(s_nvs_writes - writes0), (unsigned)spill_writes);
+    return n > 0 && lost == 0 && twice == 0 && kept_posted == 0;
+}
+
+// ---------- Timeout replay ----------
+typedef struct {
+    uint64_t requests;
+    uint64_t lost;
+    uint64_t spurious;          // 응답이 오고 있었는데 타임아웃
+    uint64_t timeout_sum_ms;
+    uint64_t blocked_lost_ms;   // 잃어버린 요청을 기다린 시간
+    uint64_t blocked_ms;        // 전체 대기 시간
+} net_stats_t;
+
+static double rtt_model_ms(uint32_t now)
+{
+    // 3시간마다 10분간 혼잡 (AP 채널 혼잡, 백엔드 부하)
+    bool congested = now % (3 * HOUR_MS) < 600000u;
+    double median = congested ? 700.0 : 60.0;
+    double sigma = congested ? 0.5 : 0.45;
+    return median * exp(sigma * gauss());
+}
+
+static void replay_network(uint32_t hours, uint64_t seed, net_stats_t *fixed, net_stats_t *adaptive)
+{
+    rtt_estimator_t e;
+    rtt_init(&e, &RTT);
+    s_rng = seed * 0xD1B54A32D192ED03ull + 7;
+    for (uint32_t now = 0; now < hours * HOUR_MS; now += SAMPLE_PERIOD_MS) {
+        bool lost = uniform() < 0.01;
+        double rtt = rtt_model_ms(now);
+        uint32_t timeouts[2] = { FIXED_TIMEOUT_MS, rtt_timeout_ms(&e) };
+        net_stats_t *st[2] = { fixed, adaptive };
+        for (int k = 0; k < 2; k++) {
+            net_stats_t *n = st[k];
+            bool answered = !lost && rtt <= timeouts[k];
+            n->requests++;
+            n->timeout_sum_ms += timeouts[k];
+            if (lost) {
+                n->lost++;
+                n->blocked_lost_ms += timeouts[k];
+            } else if (!answered) {
+                n->spurious++;
+            }
+            n->blocked_ms += answered ? (uint64_t)rtt : timeouts[k];
+            if (k == 1) {
+                if (answered) {
+                    rtt_observe(&e, (uint32_t)rtt);
+                } else {
+                    rtt_fail(&e);
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t hours = 24;
+    uint32_t devices = 20;
+    const char *trace_path = NULL;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--hours") == 0) {
+            hours = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        } else if (strcmp(argv[i], "--devices") == 0) {
+            devices = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            trace_path = argv[i + 1];
+        } else {
+            fprintf(stderr, "usage: %s [--hours N] [--devices N] [--trace file.csv]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (hours == 0 || hours > 24 * 365 || devices == 0 || devices > 10000) {
+        fprintf(stderr, "--hours must be 1..8760, --devices 1..10000\n");
+        return 2;
+    }
+    if (trace_path) {
+        devices = 1;
+    }
+
+    dlog_init(hal_millis);
+    for (int m = 0; m < DLOG_MOD_COUNT; m++) {
+        dlog_set_level((dlog_module_t)m, DLOG_NONE);
+    }
+    tp_init(&s_mirror, &POLICY);
+
+    tx_stats_t tx[ST_COUNT];
+    fidelity_t fid;
+    memset(tx, 0, sizeof(tx));
+    memset(&fid, 0, sizeof(fid));
+    double span_h = 0.0;
+    for (uint32_t d = 0; d < devices; d++) {
+        trace_t t = { NULL, 0 };
+        if (trace_path) {
+            if (!trace_load(&t, trace_path)) {
+                fprintf(stderr, "%s: no samples\n", trace_path);
+                return 2;
+            }
+        } else {
+            trace_synth(&t, hours, d + 1);
+        }
+        span_h += (t.s[t.n - 1].timestamp_ms - t.s[0].timestamp_ms + SAMPLE_PERIOD_MS) / (double)HOUR_MS;
+        replay(&t, tx, &fid);
+        free(t.s);
+    }
+    s_now += FLUSH_INTERVAL_MS;
+    air_telemetry_flush(true);
+    air_telemetry_stats_t st;
+    air_telemetry_get_stats(&st);
+    bool all_posted = st.reported == tx[ST_DEADBAND].samples &&
+                      st.reported == s_mirror.offered - s_mirror.sent[TP_SKIP];
+
+    printf("%u device(s), %.1f device-hours\n", (unsigned)devices, span_h);
+    printf("%-13s %10s %10s %12s %11s %10s\n", "strategy", "samples", "posts", "posts/dev/h", "KiB/dev/day", "vs_every");
+    for (int i = 0; i < ST_COUNT; i++) {
+        printf("%-13s %10llu %10llu %12.1f %11.1f %9.1f%%\n", ST_NAMES[i],
+               (unsigned long long)tx[i].samples, (unsigned long long)tx[i].posts,
+               tx[i].posts / span_h, tx[i].bytes / span_h * 24.0 / 1024.0,
+               100.0 * tx[i].posts / tx[ST_EVERY].posts);
+    }
+    printf("deadband: %llu heartbeats, posts -%.1f%% vs batched, bytes -%.1f%% vs batched\n",
+           (unsigned long long)tx[ST_DEADBAND].heartbeats,
+           100.0 - 100.0 * tx[ST_DEADBAND].posts / tx[ST_BATCHED].posts,
+           100.0 - 100.0 * tx[ST_DEADBAND].bytes / tx[ST_BATCHED].bytes);
+    uint32_t stale_limit = POLICY.min_interval_ms + SAMPLE_PERIOD_MS;
+    if (!all_posted) {
+        printf("deadband: firmware reported %u samples, POSTed %llu, policy kept %u\n", (unsigned)st.reported,
+               (unsigned long long)tx[ST_DEADBAND].samples,
+               (unsigned)(s_mirror.offered - s_mirror.sent[TP_SKIP]));
+    }
+    printf("fidelity: max error %.2f C / %.2f %%RH / %d ug/m3, longest outside deadband %u ms (limit %u), late bug changes %u\n",
+           fid.max_err_temp, fid.max_err_hum, fid.max_err_pm,
+           (unsigned)fid.max_stale_ms, (unsigned)stale_limit, (unsigned)fid.bug_late);
+
+    net_stats_t fixed, adaptive;
+    memset(&fixed, 0, sizeof(fixed));
+    memset(&adaptive, 0, sizeof(adaptive));
+    replay_network(hours, 1, &fixed, &adaptive);
+    printf("\n%-9s %9s %10s %6s %9s %14s %12s\n", "timeout", "requests", "mean_to_ms", "lost", "spurious",
+           "wait_lost_s", "wait_total_s");
+    const net_stats_t *rows[2] = { &fixed, &adaptive };
+    const char *names[2] = { "fixed", "adaptive" };
+    for (int k = 0; k < 2; k++) {
+        const net_stats_t *n = rows[k];
+        printf("%-9s %9llu %10.0f %6llu %9llu %14.1f %12.1f\n", names[k],
+               (unsigned long long)n->requests, (double)n->timeout_sum_ms / n->requests,
+               (unsigned long long)n->lost, (unsigned long long)n->spurious,
+               n->blocked_lost_ms / 1000.0, n->blocked_ms / 1000.0);
+    }
+
+    printf("\n");
+    bool outage_ok = replay_outage();
+    bool ok = all_posted && fid.max_stale_ms <= stale_limit && fid.bug_late == 0 &&
+              adaptive.spurious * 100 <= adaptive.requests && outage_ok;
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
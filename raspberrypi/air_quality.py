@@ -20,7 +20,8 @@ settings = {
 # MQTT 설정
 mqtt_broker = os.getenv('MQTT_BROKER', 'broker.hivemq.com')
 mqtt_port = int(os.getenv('MQTT_PORT', '1883'))
-esp32_topic_prefix = os.getenv('ESP32_TOPIC_PREFIX', 's_window')
+# 모든 ESP32가 구독하는 브로드캐스트 토픽 (gateway.py와 같은 체계). 특정 장치만: s_window/<device_id>
+esp32_topic_prefix = os.getenv('ESP32_TOPIC_PREFIX', 's_window/all')
 
 # OpenWeatherMap Air Quality API의 기본 URL
 BASE_URL = "http://api.openweathermap.org/data/2.5/air_pollution?lat={0}&lon={1}&appid={2}"
@@ -0,0 +1,348 @@
+#!/usr/bin/python
+# 벌레 감지 파이프라인: 캡처 → 전처리(움직임 게이트) → 추론 → 디바운스/발행
+#
+# 단계마다 스레드 하나를 두고 단계 사이는 크기가 제한된 큐로 잇는다.
+# - 캡처: 카메라는 최신 프레임만 의미가 있으므로 큐가 차면 가장 오래된 프레임을 버린다.
+#         녹화 파일(벤치마크)은 기본적으로 모든 프레임을 처리하도록 기다린다.
+# - 전처리: 축소한 흑백 영상을 배경과 비교해 움직임이 없으면 추론을 건너뛴다.
+#           가만히 있는 벌레도 놓치지 않도록 idle_infer_s마다 한 번은 추론한다.
+# - 추론: detector(frame) -> [(label, conf, (x1, y1, x2, y2)), ...]
+# - 발행: on_hits번 연속 감지되면 ON, clear_s 동안 감지가 없으면 OFF. 상태가 바뀔 때만 publish(state).
+# 지표(Stats): 캡처/추론 fps, 건너뛴 프레임, 추론 시간 p50/p95/max, 큐 드롭, 캡처→판단 지연.
+import collections
+import queue
+import threading
+import time
+
+import cv2
+
+_END = object()   # 스트림 끝 표시
+
+
+class Frame:
+    __slots__ = ("index", "t_capture", "t_media", "image", "motion", "detections", "infer_ms")
+
+    def __init__(self, index, t_capture, t_media, image):
+        self.index = index
+        self.t_capture = t_capture    # 읽은 시각 (지연 측정용, monotonic)
+        self.t_media = t_media        # 영상 시간축: 카메라는 t_capture, 최대 속도로 읽는 파일은 index / fps
+        self.image = image
+        self.motion = 0.0
+        self.detections = None    # None이면 추론을 건너뛴 프레임
+        self.infer_ms = 0.0
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(round(p / 100.0 * (len(values) - 1))))]
+
+
+class Stats:
+    """단계들이 함께 쓰는 지표. 추론 시간과 지연은 최근 window개만 보관한다."""
+
+    def __init__(self, window=500):
+        self.lock = threading.Lock()
+        self.started = time.monotonic()
+        self.captured = 0
+        self.dropped = 0
+        self.skipped = 0
+        self.inferred = 0
+        self.publishes = 0
+        self.infer_ms = collections.deque(maxlen=window)
+        self.latency_ms = collections.deque(maxlen=window)
+
+    def add(self, **counts):
+        with self.lock:
+            for k, v in counts.items():
+                setattr(self, k, getattr(self, k) + v)
+
+    def observe(self, infer_ms=None, latency_ms=None):
+        with self.lock:
+            if infer_ms is not None:
+                self.infer_ms.append(infer_ms)
+            if latency_ms is not None:
+                self.latency_ms.append(latency_ms)
+
+    def snapshot(self):
+        with self.lock:
+            elapsed = max(time.monotonic() - self.started, 1e-6)
+            infer, lat = list(self.infer_ms), list(self.latency_ms)
+            frames = self.skipped + self.inferred
+            return {
+                "elapsed_s": round(elapsed, 2),
+                "capture_fps": round(self.captured / elapsed, 2),
+                "inference_fps": round(self.inferred / elapsed, 2),
+                "frames": self.captured,
+                "dropped": self.dropped,
+                "skipped": self.skipped,
+                "skipped_pct": round(100.0 * self.skipped / frames, 1) if frames else 0.0,
+                "inferences": self.inferred,
+                "publishes": self.publishes,
+                "infer_ms_p50": round(percentile(infer, 50), 1),
+                "infer_ms_p95": round(percentile(infer, 95), 1),
+                "infer_ms_max": round(max(infer), 1) if infer else 0.0,
+                "latency_ms_p50": round(percentile(lat, 50), 1),
+                "latency_ms_p95": round(percentile(lat, 95), 1),
+            }
+
+    def line(self):
+        s = self.snapshot()
+        return (f"📊 캡처 {s['capture_fps']:.1f} fps, 추론 {s['inference_fps']:.1f} fps "
+                f"(건너뜀 {s['skipped_pct']:.0f}%, 드롭 {s['dropped']}), "
+                f"추론 p50 {s['infer_ms_p50']:.0f} ms / p95 {s['infer_ms_p95']:.0f} ms, "
+                f"지연 p95 {s['latency_ms_p95']:.0f} ms, 발행 {s['publishes']}회")
+
+
+class MotionGate:
+    """배경(이동 평균)과 달라진 화소 비율이 threshold를 넘으면 움직임으로 본다."""
+
+    def __init__(self, threshold=0.0005, width=320, idle_infer_s=2.0, learn_rate=0.05, pixel_delta=25):
+        self.threshold = threshold
+        self.width = width
+        self.idle_infer_s = idle_infer_s
+        self.learn_rate = learn_rate
+        self.pixel_delta = pixel_delta
+        self.background = None
+        self.last_infer = None
+
+    def motion(self, image):
+        h, w = image.shape[:2]
+        small = cv2.resize(image, (self.width, max(1, h * self.width // w)), interpolation=cv2.INTER_AREA)
+        gray = cv2.GaussianBlur(cv2.cvtColor(small, cv2.COLOR_BGR2GRAY), (5, 5), 0).astype("float32")
+        if self.background is None:
+            self.background = gray
+            return 1.0
+        diff = cv2.absdiff(gray, self.background)
+        cv2.accumulateWeighted(gray, self.background, self.learn_rate)
+        return float((diff > self.pixel_delta).mean())
+
+    def should_infer(self, frame, now):
+        frame.motion = self.motion(frame.image)
+        if frame.motion >= self.threshold or self.last_infer is None or now - self.last_infer >= self.idle_infer_s:
+            self.last_infer = now
+            return True
+        return False
+
+
+class Debouncer:
+    """감지 결과를 ON/OFF 상태로 바꾼다. 상태가 바뀔 때만 새 상태를 돌려준다."""
+
+    def __init__(self, threshold=1, on_hits=2, clear_s=5.0):
+        self.threshold = threshold      # 한 프레임에서 벌레로 볼 최소 개수
+        self.on_hits = on_hits          # ON으로 바꾸기 위한 연속 감지 횟수
+        self.clear_s = clear_s          # 마지막 감지 후 OFF까지 시간
+        self.state = "OFF"
+        self.changed_at = None          # 마지막 전이 시각 (프레임 시간축)
+        self.hits = 0
+        self.last_seen = None
+
+    def update(self, bug_count, now):
+        if bug_count >= self.threshold:
+            self.hits += 1
+            self.last_seen = now
+            if self.state == "OFF" and self.hits >= self.on_hits:
+                self.state = "ON"
+                self.changed_at = now
+                return self.state
+            return None
+        self.hits = 0
+        if self.state == "ON" and (self.last_seen is None or now - self.last_seen >= self.clear_s):
+            self.state = "OFF"
+            self.changed_at = now
+            return self.state
+        return None
+
+
+class YoloDetector:
+    """ultralytics YOLO (NCNN 내보내기 포함) 래퍼."""
+
+    def __init__(self, model_path, conf=0.5):
+        from ultralytics import YOLO
+
+        self.model = YOLO(model_path, task="detect")
+        self.labels = self.model.names
+        self.conf = conf
+
+    def __call__(self, image):
+        out = []
+        for det in self.model(image, verbose=False)[0].boxes:
+            conf = det.conf.item()
+            if conf >= self.conf:
+                x1, y1, x2, y2 = map(int, det.xyxy.cpu().numpy().squeeze())
+                out.append((self.labels[int(det.cls.item())], conf, (x1, y1, x2, y2)))
+        return out
+
+
+def open_source(source, width=1280, height=720):
+    """숫자면 카메라 인덱스, 아니면 파일 경로. (capture, live)"""
+    live = str(source).isdigit()
+    cap = cv2.VideoCapture(int(source) if live else source)
+    if live:
+        cap.set(cv2.CAP_PROP_FRAME_WIDTH, width)
+        cap.set(cv2.CAP_PROP_FRAME_HEIGHT, height)
+        cap.set(cv2.CAP_PROP_BUFFERSIZE, 1)   # 드라이버 버퍼에 묵은 프레임이 쌓이지 않게
+    return cap, live
+
+
+class Pipeline:
+    """
+    cap: cv2.VideoCapture 호환 객체 (read()/release())
+    publish(state): 디바운스된 상태가 바뀔 때 발행 단계에서 호출
+    drop_frames: 큐가 차면 오래된 프레임을 버린다 (카메라). False면 기다린다 (파일 벤치마크).
+    realtime_fps: 파일을 카메라처럼 이 속도로 읽는다 (0이면 최대 속도)
+    media_fps: 최대 속도로 읽을 때 움직임 게이트/디바운스에 쓸 영상 fps (0이면 실제 시각 사용)
+    display: 화면에 그릴 최신 결과를 받을 큐 (헤드리스면 None)
+    """
+
+    def __init__(self, cap, detector, publish, *, gate=None, debouncer=None, queue_size=2,
+                 drop_frames=True, realtime_fps=0.0, media_fps=0.0, display=None, stats=None):
+        self.cap = cap
+        self.detector = detector
+        self.publish = publish
+        self.gate = gate or MotionGate()
+        self.debouncer = debouncer or Debouncer()
+        self.drop_frames = drop_frames
+        self.realtime_fps = realtime_fps
+        self.media_fps = media_fps if not realtime_fps else 0.0
+        self.display = display
+        self.stats = stats or Stats()
+        self.q_pre = queue.Queue(maxsize=queue_size)
+        self.q_infer = queue.Queue(maxsize=queue_size)
+        self.q_pub = queue.Queue(maxsize=queue_size * 4)
+        self.stop_event = threading.Event()
+        self.threads = []
+
+    # ---------- queue helpers ----------
+    def _put(self, q, item, drop):
+        if item is _END or not drop:
+            while not self.stop_event.is_set():
+                try:
+                    q.put(item, timeout=0.1)
+                    return
+                except queue.Full:
+                    continue
+            return
+        while True:
+            try:
+                q.put_nowait(item)
+                return
+            except queue.Full:
+                try:
+                    q.get_nowait()
+                    self.stats.add(dropped=1)
+                except queue.Empty:
+                    pass
+
+    def _get(self, q):
+        while not self.stop_event.is_set():
+            try:
+                return q.get(timeout=0.1)
+            except queue.Empty:
+                continue
+        return _END
+
+    # ---------- stages ----------
+    def _capture(self):
+        index = 0
+        period = 1.0 / self.realtime_fps if self.realtime_fps > 0 else 0.0
+        next_t = time.monotonic()
+        while not self.stop_event.is_set():
+            ok, image = self.cap.read()
+            if not ok:
+                break
+            now = time.monotonic()
+            self.stats.add(captured=1)
+            t_media = index / self.media_fps if self.media_fps else now
+            self._put(self.q_pre, Frame(index, now, t_media, image), self.drop_frames)
+            index += 1
+            if period:
+                next_t += period
+                delay = next_t - time.monotonic()
+                if delay > 0:
+                    time.sleep(delay)
+        self._put(self.q_pre, _END, False)
+
+    def _preprocess(self):
+        while True:
+            frame = self._get(self.q_pre)
+            if frame is _END:
+                break
+            if self.gate.should_infer(frame, frame.t_media):
+                self._put(self.q_infer, frame, self.drop_frames)
+            else:
+                self.stats.add(skipped=1)
+                if self.display is not None:
+                    try:
+                        self.q_pub.put_nowait(frame)   # 화면 갱신용. 자리가 없으면 그냥 버린다
+                    except queue.Full:
+                        pass
+        self._put(self.q_infer, _END, False)
+
+    def _infer(self):
+        while True:
+            frame = self._get(self.q_infer)
+            if frame is _END:
+                break
+            t0 = time.perf_counter()
+            frame.detections = self.detector(frame.image)
+            frame.infer_ms = (time.perf_counter() - t0) * 1000.0
+            self.stats.add(inferred=1)
+            self.stats.observe(infer_ms=frame.infer_ms)
+            self._put(self.q_pub, frame, False)
+        self._put(self.q_pub, _END, False)
+
+    def _decide(self):
+        last = []
+        while True:
+            frame = self._get(self.q_pub)
+            if frame is _END:
+                break
+            if frame.detections is not None:
+                last = frame.detections
+                now = time.monotonic()
+                self.stats.observe(latency_ms=(now - frame.t_capture) * 1000.0)
+                state = self.debouncer.update(len(frame.detections), frame.t_media)
+                if state is not None:
+                    self.stats.add(publishes=1)
+                    self.publish(state)
+            if self.display is not None:
+                item = (frame.image, last, self.debouncer.state)
+                try:
+                    self.display.put_nowait(item)
+                except queue.Full:
+                    try:
+                        self.display.get_nowait()
+                    except queue.Empty:
+                        pass
+                    self.display.put_nowait(item)
+
+    def start(self):
+        for fn in (self._capture, self._preprocess, self._infer, self._decide):
+            t = threading.Thread(target=fn, name=fn.__name__.strip("_"), daemon=True)
+            t.start()
+            self.threads.append(t)
+
+    def running(self):
+        return any(t.is_alive() for t in self.threads)
+
+    def stop(self):
+        self.stop_event.set()
+
+    def join(self, timeout=None):
+        for t in self.threads:
+            t.join(timeout)
+        self.cap.release()
+
+
+def draw(image, detections, state, stats_line=None):
+    for label, conf, (x1, y1, x2, y2) in detections:
+        cv2.rectangle(image, (x1, y1), (x2, y2), (0, 255, 255), 2)
+        cv2.putText(image, f"{label}: {int(conf * 100)}%", (x1, y1 - 5),
+                    cv2.FONT_HERSHEY_SIMPLEX, 0.5, (0, 255, 255), 2)
+    cv2.putText(image, f"Bug count: {len(detections)}  Pump: {state}",
+                (10, 30), cv2.FONT_HERSHEY_SIMPLEX, 0.7, (255, 0, 255), 2)
+    if stats_line:
+        cv2.putText(image, stats_line, (10, 60), cv2.FONT_HERSHEY_SIMPLEX, 0.6, (0, 255, 0), 2)
+    return image
@@ -0,0 +1,131 @@
+#!/usr/bin/python
+# 녹화 영상으로 벌레 감지 처리량을 비교하는 벤치마크.
+#   sync      예전 main_tester.py 방식: 한 스레드에서 매 프레임 읽기 → 추론
+#   pipeline  bug_detector.Pipeline: 단계별 스레드 + 움직임 게이트 + 디바운스
+#
+#   python3 detector_bench.py bugs.mp4                          # YOLO 모델로
+#   python3 detector_bench.py bugs.mp4 --fake-ms 80             # 모델 없이 (어두운 물체 = 벌레, 추론 80 ms 가정)
+#   python3 detector_bench.py bugs.mp4 --realtime --json out.json
+#
+# --realtime은 파일을 원래 fps로 읽어 카메라처럼 다룬다 (밀리면 프레임을 버림). 없으면 최대 속도로 모든 프레임 처리.
+import argparse
+import json
+import time
+
+import cv2
+
+from bug_detector import Debouncer, MotionGate, Pipeline, Stats, YoloDetector, open_source
+
+CONF_THRESH = 0.5
+
+
+class FakeDetector:
+    """모델 없이 파이프라인만 재기 위한 감지기: 어두운 덩어리를 벌레로 보고 cost_ms만큼 더 기다린다."""
+
+    def __init__(self, cost_ms, dark=50, min_area=30):
+        self.cost = cost_ms / 1000.0
+        self.dark = dark
+        self.min_area = min_area
+
+    def __call__(self, image):
+        t_end = time.perf_counter() + self.cost
+        gray = cv2.cvtColor(image, cv2.COLOR_BGR2GRAY)
+        _, mask = cv2.threshold(gray, self.dark, 255, cv2.THRESH_BINARY_INV)
+        contours, _ = cv2.findContours(mask, cv2.RETR_EXTERNAL, cv2.CHAIN_APPROX_SIMPLE)
+        out = []
+        for c in contours:
+            if cv2.contourArea(c) >= self.min_area:
+                x, y, w, h = cv2.boundingRect(c)
+                out.append(("bug", 0.9, (x, y, x + w, y + h)))
+        delay = t_end - time.perf_counter()
+        if delay > 0:
+            time.sleep(delay)
+        return out
+
+
+def run_sync(path, detector, realtime):
+    """예전 루프: 읽기와 추론이 번갈아 실행. 5초마다 상태 발행."""
+    cap, _ = open_source(path)
+    fps = cap.get(cv2.CAP_PROP_FPS) or 30.0
+    stats = Stats()
+    last_mqtt = 0.0
+    t_video = time.monotonic()
+    frame_no = 0
+    while True:
+        ok, image = cap.read()
+        if not ok:
+            break
+        stats.add(captured=1)
+        if realtime:
+            # 추론이 밀린 만큼 카메라 프레임은 이미 지나갔다
+            due = int((time.monotonic() - t_video) * fps)
+            while frame_no < due:
+                ok, image = cap.read()
+                if not ok:
+                    break
+                frame_no += 1
+                stats.add(dropped=1)
+            if not ok:
+                break
+        frame_no += 1
+        t0 = time.perf_counter()
+        detector(image)
+        stats.add(inferred=1)
+        stats.observe(infer_ms=(time.perf_counter() - t0) * 1000.0, latency_ms=(time.perf_counter() - t0) * 1000.0)
+        if time.monotonic() - last_mqtt >= 5:
+            stats.add(publishes=1)
+            last_mqtt = time.monotonic()
+    cap.release()
+    return stats.snapshot()
+
+
+def run_pipeline(path, detector, realtime):
+    cap, _ = open_source(path)
+    fps = cap.get(cv2.CAP_PROP_FPS) or 30.0
+    stats = Stats()
+    states = []
+    debouncer = Debouncer()
+    t0 = time.monotonic()
+    # 상태 전이는 영상 시각(초)으로 기록
+    pipeline = Pipeline(cap, detector,
+                        lambda s: states.append((round(debouncer.changed_at - (t0 if realtime else 0.0), 1), s)),
+                        gate=MotionGate(), debouncer=debouncer,
+                        drop_frames=realtime, realtime_fps=fps if realtime else 0.0, media_fps=fps, stats=stats)
+    pipeline.start()
+    while pipeline.running():
+        time.sleep(0.05)
+    pipeline.join()
+    result = stats.snapshot()
+    result["transitions"] = states
+    return result
+
+
+def main():
+    ap = argparse.ArgumentParser(description="녹화 영상으로 sync/pipeline 감지 처리량 비교")
+    ap.add_argument("video")
+    ap.add_argument("--model", default="yolo11s_ncnn_model")
+    ap.add_argument("--fake-ms", type=float, help="YOLO 대신 가짜 감지기 사용 (추론 시간 ms)")
+    ap.add_argument("--mode", choices=("sync", "pipeline", "both"), default="both")
+    ap.add_argument("--realtime", action="store_true", help="원래 fps로 읽기 (카메라처럼 프레임 드롭)")
+    ap.add_argument("--json", help="결과를 JSON으로 저장")
+    args = ap.parse_args()
+
+    detector = FakeDetector(args.fake_ms) if args.fake_ms is not None else YoloDetector(args.model, CONF_THRESH)
+    results = {}
+    for mode in (("sync", "pipeline") if args.mode == "both" else (args.mode,)):
+        results[mode] = (run_sync if mode == "sync" else run_pipeline)(args.video, detector, args.realtime)
+
+    cols = ("elapsed_s", "frames", "capture_fps", "inferences", "skipped_pct", "dropped",
+            "infer_ms_p50", "infer_ms_p95", "latency_ms_p95", "publishes")
+    print(f"{'mode':9s} " + " ".join(f"{c:>14s}" for c in cols))
+    for mode, r in results.items():
+        print(f"{mode:9s} " + " ".join(f"{r[c]:>14}" for c in cols))
+    if "pipeline" in results:
+        print(f"pipeline 상태 전이: {results['pipeline']['transitions'] or '(없음)'}")
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump({"video": args.video, "realtime": args.realtime, "fake_ms": args.fake_ms, "results": results}, f, indent=2)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,177 @@
+#!/usr/bin/python
+# 여러 ESP32 창문 노드를 묶는 라즈베리파이 게이트웨이.
+#
+# - 노드는 s_window/<device_id>/status 에 retain "online"/"offline"(last will)을 남기므로
+#   s_window/+/status 구독만으로 노드 목록을 유지한다.
+# - OpenWeatherMap 대기질은 주기마다 한 번만 조회하고 s_window/all/{aqi,pm25,pm10} 에
+#   retain으로 발행한다. 브로커가 모든 노드에 나눠 주므로 노드가 N개여도 API 호출은 1번이며,
+#   나중에 연결된 노드도 즉시 마지막 값을 받는다.
+# - 조회가 실패하면 마지막 값을 유지하고 간격을 늘려 재시도한다 (API 제한 보호).
+# - 브로커 연결은 네트워크 스레드가 맡는다. 부팅 직후 브로커가 아직 없거나 중간에 끊겨도
+#   RECONNECT_MIN~RECONNECT_MAX초 지수 백오프로 계속 재연결하고, 다시 붙으면 마지막 값을 재발행한다.
+#
+#   python3 gateway.py            # 계속 실행
+#   python3 gateway.py --once     # 한 번 조회/발행 후 종료
+import argparse
+import os
+import threading
+import time
+
+import paho.mqtt.client as mqtt
+from dotenv import load_dotenv
+
+load_dotenv()
+
+MQTT_BROKER = os.getenv('MQTT_BROKER', 'broker.hivemq.com')
+MQTT_PORT = int(os.getenv('MQTT_PORT', '1883'))
+TOPIC_ROOT = os.getenv('TOPIC_ROOT', 's_window')
+BROADCAST = 'all'
+FETCH_INTERVAL = float(os.getenv('FETCH_INTERVAL', '600'))   # OpenWeatherMap은 약 10분~1시간 단위로 갱신
+RETRY_MIN = 30.0
+RECONNECT_MIN = 1
+RECONNECT_MAX = 120
+
+
+def make_client(client_id):
+    """paho-mqtt 1.x/2.x 모두 지원."""
+    try:
+        return mqtt.Client(mqtt.CallbackAPIVersion.VERSION2, client_id=client_id, protocol=mqtt.MQTTv311)
+    except AttributeError:
+        return mqtt.Client(client_id=client_id, protocol=mqtt.MQTTv311)
+
+
+def fetch_outdoor():
+    """OpenWeatherMap 응답에서 (aqi, pm25, pm10)을 꺼낸다. 실패하면 None."""
+    from air_quality import get_air_quality
+
+    data = get_air_quality()
+    if not data:
+        return None
+    try:
+        item = data["list"][0]
+        return item["main"]["aqi"], item["components"].get("pm2_5"), item["components"].get("pm10")
+    except (KeyError, IndexError) as e:
+        print(f"오류: 대기질 데이터를 파싱하는 데 실패했습니다. 누락된 키: {e}")
+        return None
+
+
+class Gateway:
+    def __init__(self, broker, port, fetcher=fetch_outdoor, root=TOPIC_ROOT, client_id=None):
+        self.root = root
+        self.fetcher = fetcher
+        self.lock = threading.Lock()
+        self.nodes = {}          # device_id -> {"online": bool, "since": time}
+        self.last_reading = None
+        self.api_calls = 0
+        self.publishes = 0
+        self.client = make_client(client_id or f"gateway-{os.getpid()}")
+        self.connected = threading.Event()
+        self.stopping = False
+        self.client.on_connect = self._on_connect
+        self.client.on_disconnect = self._on_disconnect
+        self.client.on_message = self._on_message
+        # 실제 연결(과 실패 시 재시도)은 start()의 네트워크 스레드에서 한다
+        self.client.reconnect_delay_set(min_delay=RECONNECT_MIN, max_delay=RECONNECT_MAX)
+        self.client.connect_async(broker, port, 60)
+
+    def _on_connect(self, client, userdata, flags, *rest):
+        rc = rest[0] if rest else 0     # 1.x: (rc,), 2.x: (reason_code, properties)
+        if rc != 0:
+            print(f"❌ 브로커 연결 거부: {rc}")
+            return
+        self.connected.set()
+        client.subscribe(f"{self.root}/+/status", qos=0)
+        with self.lock:
+            reading = self.last_reading
+        if reading is not None:
+            self._publish(reading)   # 브로커가 재시작되어 retain 값을 잃었을 수 있음
+
+    def _on_disconnect(self, client, userdata, *rest):
+        self.connected.clear()
+        if not self.stopping:
+            print("⚠️ 브로커 연결 끊김, 재연결 시도 중 (마지막 값은 재연결 후 재발행)")
+
+    def _on_message(self, client, userdata, msg):
+        parts = msg.topic.split('/')
+        if len(parts) != 3 or parts[1] == BROADCAST:
+            return
+        online = msg.payload == b"online"
+        with self.lock:
+            node = self.nodes.get(parts[1])
+            if node is None or node["online"] != online:
+                self.nodes[parts[1]] = {"online": online, "since": time.time()}
+
+    def online_nodes(self):
+        with self.lock:
+            return sorted(k for k, v in self.nodes.items() if v["online"])
+
+    def _publish(self, reading):
+        aqi, pm25, pm10 = reading
+        for leaf, value in (("aqi", aqi), ("pm25", pm25), ("pm10", pm10)):
+            if value is not None:
+                self.client.publish(f"{self.root}/{BROADCAST}/{leaf}", str(value), qos=0, retain=True)
+                self.publishes += 1
+
+    def refresh(self):
+        """한 번 조회해서 모든 노드에 발행. 성공하면 True."""
+        self.api_calls += 1
+        reading = self.fetcher()
+        if reading is None:
+            return False
+        with self.lock:
+            self.last_reading = reading
+        self._publish(reading)
+        return True
+
+    def start(self):
+        self.client.loop_start()
+
+    def stop(self):
+        self.stopping = True
+        self.client.loop_stop()
+        self.client.disconnect()
+
+    def run(self, interval=FETCH_INTERVAL):
+        self.start()
+        retry = RETRY_MIN
+        try:
+            while True:
+                if self.refresh():
+                    aqi, pm25, pm10 = self.last_reading
+                    print(f"✅ AQI {aqi}, PM2.5 {pm25}, PM10 {pm10} → {self.root}/{BROADCAST}/* "
+                          f"(노드 {len(self.online_nodes())}개 온라인, API 호출 {self.api_calls}회)")
+                    delay, retry = interval, RETRY_MIN
+                else:
+                    delay, retry = retry, min(retry * 2, interval)
+                    print(f"❌ 대기질 조회 실패, {delay:.0f}초 후 재시도 (마지막 값 유지)")
+                time.sleep(delay)
+        except KeyboardInterrupt:
+            pass
+        finally:
+            self.stop()
+
+
+def main():
+    ap = argparse.ArgumentParser(description="ESP32 창문 노드용 대기질 게이트웨이")
+    ap.add_argument("--once", action="store_true", help="한 번 조회/발행 후 종료")
+    ap.add_argument("--interval", type=float, default=FETCH_INTERVAL, help="조회 간격 (초)")
+    args = ap.parse_args()
+
+    gw = Gateway(MQTT_BROKER, MQTT_PORT)
+    if args.once:
+        gw.start()
+        if not gw.connected.wait(30):
+            print(f"❌ 브로커 {MQTT_BROKER}:{MQTT_PORT}에 연결하지 못했습니다")
+            gw.stop()
+            return
+        time.sleep(2)   # 노드 status 수신 대기
+        ok = gw.refresh()
+        print(f"{'✅' if ok else '❌'} 온라인 노드: {', '.join(gw.online_nodes()) or '(없음)'}")
+        time.sleep(1)   # 발행 완료 대기
+        gw.stop()
+        return
+    gw.run(args.interval)
+
+
+if __name__ == "__main__":
+    main()
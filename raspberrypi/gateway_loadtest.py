@@ -0,0 +1,106 @@
+#!/usr/bin/python
+# gateway.py 부하 테스트: 로컬 브로커에 시뮬레이션 노드 N개를 붙이고 게이트웨이를 돌린다.
+# 노드는 펌웨어와 같은 토픽 체계를 쓴다 (status retain + last will, s_window/<id>/+ 와
+# s_window/all/+ 구독). OpenWeatherMap 대신 가짜 조회 함수를 써서 API 호출 수를 센다.
+#
+#   mosquitto -p 1883 &
+#   python3 gateway_loadtest.py --nodes 300 --rounds 5
+#
+# 출력: 게이트웨이가 찾은 노드 수, 라운드별 전달률과 팬아웃 지연(p50/p99/max), API 호출 수
+import argparse
+import threading
+import time
+
+from gateway import BROADCAST, Gateway, make_client
+
+
+class SimNode:
+    def __init__(self, broker, port, device_id, root):
+        self.id = device_id
+        self.received = {}      # pm25 값 -> 수신 시각
+        self.lock = threading.Lock()
+        self.client = make_client(device_id)
+        self.client.will_set(f"{root}/{device_id}/status", "offline", qos=0, retain=True)
+        self.client.on_connect = lambda c, *a: (
+            c.subscribe([(f"{root}/{device_id}/+", 0), (f"{root}/{BROADCAST}/+", 0)]),
+            c.publish(f"{root}/{device_id}/status", "online", qos=0, retain=True))
+        self.client.on_message = self._on_message
+        self.status_topic = f"{root}/{device_id}/status"
+        self.client.connect_async(broker, port, 60)
+        self.client.loop_start()
+
+    def _on_message(self, client, userdata, msg):
+        if msg.topic.endswith("/pm25"):
+            with self.lock:
+                self.received.setdefault(msg.payload.decode(), time.monotonic())
+
+    def stop(self):
+        self.client.publish(self.status_topic, "offline", qos=0, retain=True)
+        self.client.loop_stop()
+        self.client.disconnect()
+
+
+def percentile(values, p):
+    if not values:
+        return float("nan")
+    values = sorted(values)
+    return values[min(len(values) - 1, int(round(p / 100.0 * (len(values) - 1))))]
+
+
+def main():
+    ap = argparse.ArgumentParser(description="gateway.py 부하 테스트")
+    ap.add_argument("--broker", default="localhost")
+    ap.add_argument("--port", type=int, default=1883)
+    ap.add_argument("--nodes", type=int, default=100)
+    ap.add_argument("--rounds", type=int, default=5)
+    ap.add_argument("--wait", type=float, default=5.0, help="라운드마다 전달을 기다리는 최대 시간 (초)")
+    ap.add_argument("--root", default="s_window_loadtest", help="실제 장치와 섞이지 않도록 별도 루트 사용")
+    args = ap.parse_args()
+
+    calls = {"n": 0}
+
+    def fake_fetch():
+        calls["n"] += 1
+        return 2, 10.0 + calls["n"], 20.0 + calls["n"]
+
+    print(f"노드 {args.nodes}개 연결 중...")
+    t0 = time.monotonic()
+    nodes = [SimNode(args.broker, args.port, f"sim-{i:04d}", args.root) for i in range(args.nodes)]
+    gw = Gateway(args.broker, args.port, fetcher=fake_fetch, root=args.root, client_id="gateway-loadtest")
+    gw.start()
+
+    deadline = time.monotonic() + 30
+    while len(gw.online_nodes()) < args.nodes and time.monotonic() < deadline:
+        time.sleep(0.1)
+    print(f"게이트웨이가 찾은 노드: {len(gw.online_nodes())}/{args.nodes} ({time.monotonic() - t0:.1f}초)")
+
+    print("round delivered   p50_ms   p99_ms   max_ms")
+    for r in range(args.rounds):
+        sent = time.monotonic()
+        gw.refresh()
+        key = str(10.0 + calls["n"])
+        end = sent + args.wait
+        while time.monotonic() < end:
+            if all(key in n.received for n in nodes):
+                break
+            time.sleep(0.01)
+        lat = [(n.received[key] - sent) * 1000 for n in nodes if key in n.received]
+        print(f"{r + 1:5d} {len(lat):5d}/{args.nodes:<5d} {percentile(lat, 50):8.1f} "
+              f"{percentile(lat, 99):8.1f} {max(lat) if lat else float('nan'):8.1f}")
+
+    print(f"API 호출: {calls['n']}회 (노드별 조회였다면 {calls['n'] * args.nodes}회), "
+          f"게이트웨이 발행: {gw.publishes}건")
+
+    for n in nodes:
+        n.stop()
+    # retain 정리: 다음 실행에 이전 노드가 남지 않도록
+    for n in nodes:
+        gw.client.publish(n.status_topic, b"", retain=True)
+    for leaf in ("aqi", "pm25", "pm10"):
+        gw.client.publish(f"{args.root}/{BROADCAST}/{leaf}", b"", retain=True)
+    time.sleep(1)
+    gw.stop()
+
+
+if __name__ == "__main__":
+    main()
@@ -1,142 +1,142 @@
 #라즈베리 파이 Ai 학습 코드 . AI 벌레 감지 코드.
-import cv2
-import numpy as np
-import time
+# 캡처/전처리/추론/발행을 단계별 스레드로 나눈 파이프라인(bug_detector.py)으로 돌린다.
+# 움직임이 없는 프레임은 추론을 건너뛰고, 펌프 ON/OFF는 디바운스된 상태가 바뀔 때만 발행한다.
+#
+#   DEVICE_ID=esp-1a2b3c python3 main_tester.py  # 카메라 0, 화면 표시
+#   python3 main_tester.py --headless            # 화면 없이 (서비스/SSH)
+#   python3 main_tester.py --source bugs.mp4 --no-mqtt
+import argparse
 import os
+import queue
 import sys
-from ultralytics import YOLO
-import paho.mqtt.client as mqtt
+import time
+
+import cv2
+
+from bug_detector import Debouncer, MotionGate, Pipeline, Stats, YoloDetector, draw, open_source
 
 # ---------------- CONFIG ----------------
-MODEL_PATH = "yolo11s_ncnn_model"  
+MODEL_PATH = "yolo11s_ncnn_model"
 USB_INDEX = 0
 CONF_THRESH = 0.5
-BUG_THRESHOLD = 0
-INFERENCE_INTERVAL = 0   # seconds between YOLO inferences
-FPS_LIMIT = 30           # cap display at 30 FPS
+BUG_THRESHOLD = 1        # 한 프레임에서 벌레로 볼 최소 개수 (0이면 항상 ON이던 문제 수정)
+ON_HITS = 2              # ON으로 바꾸기 위한 연속 감지 횟수
+CLEAR_SECONDS = 5.0      # 마지막 감지 후 OFF까지
+MOTION_THRESHOLD = 0.0005 # 움직임으로 볼 변화 화소 비율 (320px 폭 기준, 작은 벌레도 잡히도록)
+IDLE_INFER_SECONDS = 2.0 # 움직임이 없어도 이 간격마다 한 번은 추론
+STATS_INTERVAL = 10      # 지표 출력 간격 (초)
 # ----------------------------------------
 
 # ---------MQTT Info-----------------------
 BROKER = "broker.hivemq.com"
 PORT = 1883
-USERNAME = ""  
+USERNAME = ""
 PASSWORD = ""
 CLIENT_ID = "raspi_pump"
-TOPIC = "s_window/pump"
+# 이 카메라가 지키는 창문의 ESP32 장치 ID (ESP32 /data의 device_id). 발행하려면 반드시 지정한다:
+# 공용 토픽(s_window/pump)은 같은 브로커의 모든 창문을 움직인다.
+DEVICE_ID = os.getenv("DEVICE_ID", "")
+TOPIC_ROOT = os.getenv("TOPIC_ROOT", "s_window")
 #------------------------------------------
 
-# MQTT setup
-client = mqtt.Client(client_id=CLIENT_ID, protocol=mqtt.MQTTv311)
-client.username_pw_set(USERNAME, PASSWORD)
-client.connect(BROKER, PORT, 60)
-
-# Check model file
-if not os.path.exists(MODEL_PATH):
-    print("ERROR: Model path not found.")
-    sys.exit(0)
-
-# Load YOLO model
-model = YOLO(MODEL_PATH, task="detect")
-labels = model.names
-
-# Open webcam
-cap = cv2.VideoCapture(USB_INDEX)
-if not cap.isOpened():
-    print("ERROR: Could not open webcam.")
-    sys.exit(0)
-
-# Try wider resolution
-cap.set(cv2.CAP_PROP_FRAME_WIDTH, 1280)
-cap.set(cv2.CAP_PROP_FRAME_HEIGHT, 720)
-
-# FPS tracking (stable, update every 1 sec)
-last_fps_time = time.time()
-frames_counted = 0
-display_fps = 0
-
-# Inference timing
-last_inference = 0
-bug_count = 0
-last_detections = []  # store last detections for stable drawing
-
-#MQTT Interval
-MQTT_INTERVAL = 5  # seconds between sending MQTT messages
-last_mqtt = 0
-
-
-while True:
-    loop_start = time.perf_counter()
-    current_time = time.time()
-
-    # Grab frame
-    ret, frame = cap.read()
-    if not ret:
-        print("ERROR: Webcam frame not available.")
-        break
-
-    # ---------- YOLO Inference ----------
-    if current_time - last_inference >= INFERENCE_INTERVAL:
-        results = model(frame, verbose=False)
-        detections = results[0].boxes
-
-        bug_count = 0
-        last_detections = []
-
-        for det in detections:
-            conf = det.conf.item()
-            if conf >= CONF_THRESH:
-                bug_count += 1
-                x1, y1, x2, y2 = map(int, det.xyxy.cpu().numpy().squeeze())
-                classidx = int(det.cls.item())
-                classname = labels[classidx]
-                label = f"{classname}: {int(conf*100)}%"
-                last_detections.append((x1, y1, x2, y2, label))
-
-        last_inference = current_time
-
-    # ---------- MQTT Publish (throttled) ----------
-    if current_time - last_mqtt >= MQTT_INTERVAL:
-        if bug_count >= BUG_THRESHOLD:
-            client.publish(TOPIC, "ON")
-            print(f"[MQTT] Sent Pump ON")
-        else:
-            client.publish(TOPIC, "OFF")
-            print(f"[MQTT] Sent Pump OFF")
-        last_mqtt = current_time
-
-    # ---------- Draw detections ----------
-    for (x1, y1, x2, y2, label) in last_detections:
-        cv2.rectangle(frame, (x1, y1), (x2, y2), (0, 255, 255), 2)
-        cv2.putText(frame, label, (x1, y1 - 5),
-                    cv2.FONT_HERSHEY_SIMPLEX, 0.5, (0, 255, 255), 2)
-
-    # Display bug count
-    cv2.putText(frame, f"Bug count: {bug_count}",
-                (10, 30), cv2.FONT_HERSHEY_SIMPLEX, 0.7, (255, 0, 255), 2)
-
-    # ---------- FPS calculation ----------
-    frames_counted += 1
-    if current_time - last_fps_time >= 1.0:
-        display_fps = frames_counted / (current_time - last_fps_time)
-        frames_counted = 0
-        last_fps_time = current_time
-
-    cv2.putText(frame, f"FPS: {display_fps:.2f}",
-                (10, 60), cv2.FONT_HERSHEY_SIMPLEX, 0.6, (0, 255, 0), 2)
-
-    # Show camera feed
-    cv2.imshow("Bug Detection", frame)
-
-    # Quit with 'q'
-    key = cv2.waitKey(1) & 0xFF
-    if key == ord("q"):
-        break
-
-    # ---------- Cap FPS ----------
-    elapsed = time.perf_counter() - loop_start
-    frame_time = 1.0 / FPS_LIMIT
-    if elapsed < frame_time:
-        time.sleep(frame_time - elapsed)
-
-cap.release()
-cv2.destroyAllWindows()
+
+def mqtt_publisher(topic):
+    """상태 변화만 발행. 재연결되면 마지막 상태를 한 번 다시 보낸다 (ESP32가 전이만 처리하므로 안전)."""
+    if topic is None:
+        return (lambda state: print(f"[MQTT] (비활성) Pump {state}")), None
+
+    from gateway import make_client
+
+    client = make_client(CLIENT_ID)
+    client.username_pw_set(USERNAME, PASSWORD)
+    last = {"state": None}
+
+    def on_connect(c, *args):
+        if last["state"] is not None:
+            c.publish(topic, last["state"])
+
+    def publish(state):
+        last["state"] = state
+        client.publish(topic, state)
+        print(f"[MQTT] Sent Pump {state} → {topic}")
+
+    client.on_connect = on_connect
+    client.connect_async(BROKER, PORT, 60)
+    client.loop_start()
+    return publish, client
+
+
+def main():
+    ap = argparse.ArgumentParser(description="파이프라인 벌레 감지 + 펌프 MQTT 발행")
+    ap.add_argument("--source", default=str(USB_INDEX), help="카메라 인덱스 또는 영상 파일")
+    ap.add_argument("--model", default=MODEL_PATH)
+    ap.add_argument("--conf", type=float, default=CONF_THRESH)
+    ap.add_argument("--headless", action="store_true", help="화면 표시 없이 실행 (DISPLAY가 없으면 자동)")
+    ap.add_argument("--no-mqtt", action="store_true", help="발행하지 않고 상태 변화만 출력")
+    ap.add_argument("--device-id", default=DEVICE_ID, help="발행할 ESP32 장치 ID (기본: 환경변수 DEVICE_ID)")
+    ap.add_argument("--no-motion-gate", action="store_true", help="모든 프레임 추론")
+    args = ap.parse_args()
+    if not args.no_mqtt and not args.device_id:
+        ap.error("장치 ID가 필요합니다: --device-id 또는 DEVICE_ID (발행하지 않으려면 --no-mqtt)")
+    topic = None if args.no_mqtt else f"{TOPIC_ROOT}/{args.device_id}/pump"
+
+    # Check model file
+    if not os.path.exists(args.model):
+        print("ERROR: Model path not found.")
+        sys.exit(0)
+
+    cap, live = open_source(args.source)
+    if not cap.isOpened():
+        print("ERROR: Could not open video source.")
+        sys.exit(0)
+
+    headless = args.headless or not os.environ.get("DISPLAY")
+    display = None if headless else queue.Queue(maxsize=1)
+    publish, client = mqtt_publisher(topic)
+    stats = Stats()
+    gate = MotionGate(threshold=0.0 if args.no_motion_gate else MOTION_THRESHOLD, idle_infer_s=IDLE_INFER_SECONDS)
+    pipeline = Pipeline(
+        cap, YoloDetector(args.model, args.conf), publish,
+        gate=gate,
+        debouncer=Debouncer(BUG_THRESHOLD, ON_HITS, CLEAR_SECONDS),
+        drop_frames=live,
+        display=display,
+        stats=stats,
+    )
+    pipeline.start()
+    print(f"✅ 감지 시작: {args.source} ({'헤드리스' if headless else '화면 표시'}), 발행 토픽 {topic or '(없음)'}")
+
+    last_stats = time.monotonic()
+    try:
+        while pipeline.running():
+            if display is not None:
+                try:
+                    image, detections, state = display.get(timeout=0.1)
+                    s = stats.snapshot()
+                    cv2.imshow("Bug Detection", draw(image, detections, state,
+                                                     f"FPS: {s['capture_fps']:.1f} / infer {s['inference_fps']:.1f}"))
+                except queue.Empty:
+                    pass
+                # Quit with 'q'
+                if cv2.waitKey(1) & 0xFF == ord("q"):
+                    break
+            else:
+                time.sleep(0.2)
+            if time.monotonic() - last_stats >= STATS_INTERVAL:
+                print(stats.line())
+                last_stats = time.monotonic()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        pipeline.stop()
+        pipeline.join(2.0)
+        print(stats.line())
+        if client is not None:
+            client.loop_stop()
+            client.disconnect()
+        if display is not None:
+            cv2.destroyAllWindows()
+
+
+if __name__ == "__main__":
+    main()